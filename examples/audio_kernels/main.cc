@@ -0,0 +1,126 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+// Measures the Gst::AudioKernels sample loops with each instruction set
+// supported by the CPU, on 10 ms periods of 48 kHz stereo audio.
+//
+// The numbers are the time per period, so they can be compared with the
+// 10 ms real time budget of the period.
+
+#include <gstreamermm.h>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+static const int rate = 48000;
+static const int channels = 2;
+static const int period_frames = rate / 100;
+static const int n_sources = 4;
+static const int default_periods = 20000;
+
+static void report(const char* what, gint64 usec, int periods)
+{
+  std::cout << "  " << what << ": " << (usec * 1000.0 / periods) << " ns per period" << std::endl;
+}
+
+static void benchmark(Gst::AudioFormat format, Gst::AudioKernelsIsa isa, int periods)
+{
+  const Gst::AudioKernels kernels(format, channels, isa);
+  const gsize width = format == Gst::AUDIO_FORMAT_S16 ? sizeof(gint16) : sizeof(float);
+  const gsize size = period_frames * channels * width;
+
+  // A sine in the source format for each input.
+  std::vector<float> sine(period_frames * channels);
+  for(gsize i = 0; i < sine.size(); ++i)
+    sine[i] = 0.5f * std::sin(i * 0.01f);
+
+  std::vector<std::vector<guint8> > sources(n_sources, std::vector<guint8>(size));
+  std::vector<gconstpointer> source_data;
+  for(std::vector<guint8>& source : sources)
+  {
+    Gst::AudioKernels(Gst::AUDIO_FORMAT_F32, channels).convert(sine.data(), format,
+      source.data(), period_frames);
+    source_data.push_back(source.data());
+  }
+
+  std::vector<guint8> dest(size);
+  std::vector<float> converted(period_frames * channels);
+  std::vector<gint16> converted_s16(period_frames * channels);
+  double peak = 0.0, rms = 0.0;
+
+  std::cout << Gst::AudioKernels::get_isa_name(kernels.get_isa()) << ", "
+    << (format == Gst::AUDIO_FORMAT_S16 ? "S16" : "F32") << ":" << std::endl;
+
+  gint64 start = g_get_monotonic_time();
+  for(int i = 0; i < periods; ++i)
+    kernels.apply_gain(dest.data(), period_frames, 0.999);
+  report("gain", g_get_monotonic_time() - start, periods);
+
+  start = g_get_monotonic_time();
+  for(int i = 0; i < periods; ++i)
+    kernels.mix(dest.data(), source_data.data(), n_sources, period_frames);
+  report("mix of 4", g_get_monotonic_time() - start, periods);
+
+  start = g_get_monotonic_time();
+  for(int i = 0; i < periods; ++i)
+  {
+    if(format == Gst::AUDIO_FORMAT_S16)
+      kernels.convert(source_data[0], Gst::AUDIO_FORMAT_F32, converted.data(), period_frames);
+    else
+      kernels.convert(source_data[0], Gst::AUDIO_FORMAT_S16, converted_s16.data(), period_frames);
+  }
+  report(format == Gst::AUDIO_FORMAT_S16 ? "convert to F32" : "convert to S16",
+    g_get_monotonic_time() - start, periods);
+
+  start = g_get_monotonic_time();
+  for(int i = 0; i < periods; ++i)
+    kernels.measure(source_data[0], period_frames, peak, rms);
+  report("peak and RMS", g_get_monotonic_time() - start, periods);
+}
+
+int main(int argc, char** argv)
+{
+  Gst::init(argc, argv);
+
+  const int periods = argc > 1 ? std::atoi(argv[1]) : default_periods;
+  if(periods <= 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [periods]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << periods << " periods of " << period_frames << " frames, "
+    << channels << " channels at " << rate << " Hz" << std::endl;
+
+  const Gst::AudioKernelsIsa isas[] = {
+    Gst::AUDIO_KERNELS_ISA_SCALAR, Gst::AUDIO_KERNELS_ISA_SSE2,
+    Gst::AUDIO_KERNELS_ISA_AVX2, Gst::AUDIO_KERNELS_ISA_NEON
+  };
+
+  for(Gst::AudioKernelsIsa isa : isas)
+  {
+    if(!Gst::AudioKernels::is_isa_supported(isa))
+      continue;
+
+    benchmark(Gst::AUDIO_FORMAT_S16, isa, periods);
+    benchmark(Gst::AUDIO_FORMAT_F32, isa, periods);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+// Compares the stock audioresample element, through Gst::AudioResample, with
+// Gst::PolyphaseResample, converting many 44.1 kHz stereo streams to 48 kHz
+// in parallel pipelines, as fast as possible.
+//
+// The numbers are the times needed to convert one second of audio of all
+// the streams; the lower, the more streams a host can resample in real time.
+
+#include <gstreamermm.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+static const int in_rate = 44100;
+static const int out_rate = 48000;
+static const int seconds = 10;
+static const int default_streams = 32;
+
+static Glib::RefPtr<Gst::Caps> create_caps(int rate)
+{
+  return Gst::Caps::create_simple("audio/x-raw",
+    "format", Glib::ustring(GST_AUDIO_NE(F32)), "layout", Glib::ustring("interleaved"),
+    "rate", rate, "channels", 2);
+}
+
+static Glib::RefPtr<Gst::Element> create_resampler(bool polyphase, int quality)
+{
+  if(polyphase)
+  {
+    Glib::RefPtr<Gst::Element> resampler = Gst::ElementFactory::create_element("mmpolyphaseresample");
+    resampler->set_property("quality", quality);
+    return resampler;
+  }
+
+  Glib::RefPtr<Gst::AudioResample> resampler = Gst::AudioResample::create();
+  resampler->property_quality() = quality;
+  return resampler;
+}
+
+static Glib::RefPtr<Gst::Pipeline> create_pipeline(bool polyphase, int quality)
+{
+  Glib::RefPtr<Gst::Pipeline> pipeline = Gst::Pipeline::create();
+  Glib::RefPtr<Gst::Element> source = Gst::ElementFactory::create_element("audiotestsrc");
+  Glib::RefPtr<Gst::Element> sink = Gst::ElementFactory::create_element("fakesink");
+
+  // 100 ms buffers.
+  source->set_property("num-buffers", seconds * 10);
+  source->set_property("samplesperbuffer", in_rate / 10);
+  sink->set_property("sync", false);
+
+  Glib::RefPtr<Gst::Element> resampler = create_resampler(polyphase, quality);
+  pipeline->add(source)->add(resampler)->add(sink);
+  source->link(resampler, create_caps(in_rate));
+  resampler->link(sink, create_caps(out_rate));
+
+  return pipeline;
+}
+
+static void benchmark(bool polyphase, int quality, int streams)
+{
+  std::vector<Glib::RefPtr<Gst::Pipeline> > pipelines;
+  for(int i = 0; i < streams; ++i)
+    pipelines.push_back(create_pipeline(polyphase, quality));
+
+  const gint64 start = g_get_monotonic_time();
+  for(const Glib::RefPtr<Gst::Pipeline>& pipeline : pipelines)
+    pipeline->set_state(Gst::STATE_PLAYING);
+
+  bool failed = false;
+  for(const Glib::RefPtr<Gst::Pipeline>& pipeline : pipelines)
+  {
+    Glib::RefPtr<Gst::Message> message = pipeline->get_bus()->poll(
+      Gst::MessageType(Gst::MESSAGE_EOS | Gst::MESSAGE_ERROR), Gst::CLOCK_TIME_NONE);
+    failed |= message->get_message_type() == Gst::MESSAGE_ERROR;
+  }
+  const gint64 usec = g_get_monotonic_time() - start;
+
+  for(const Glib::RefPtr<Gst::Pipeline>& pipeline : pipelines)
+    pipeline->set_state(Gst::STATE_NULL);
+
+  std::cout << "  " << (polyphase ? "mmpolyphaseresample" : "audioresample") << ", quality "
+    << quality << ": ";
+  if(failed)
+    std::cout << "failed" << std::endl;
+  else
+    std::cout << (usec / 1000.0 / seconds) << " ms per second of audio" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  Gst::init(argc, argv);
+
+  Gst::Plugin::register_static(GST_VERSION_MAJOR, GST_VERSION_MINOR, "mmpolyphaseresample",
+    "Polyphase audio resampler", sigc::ptr_fun(&Gst::PolyphaseResample::register_element),
+    "0.1", "LGPL", "gstreamermm", "gstreamermm", "http://gstreamer.freedesktop.org");
+
+  const int streams = argc > 1 ? std::atoi(argv[1]) : default_streams;
+  if(streams <= 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [streams]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << streams << " stereo streams of " << seconds << " s, " << in_rate << " Hz to "
+    << out_rate << " Hz, polyphase filters using "
+    << Gst::AudioKernels::get_isa_name(Gst::AudioKernels::get_best_isa()) << std::endl;
+
+  for(int quality : { 0, Gst::PolyphaseFilterBank::QUALITY_DEFAULT, Gst::PolyphaseFilterBank::QUALITY_MAX })
+  {
+    benchmark(false, quality, streams);
+    benchmark(true, quality, streams);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+// Measures the cost of committing and reading 1 ms periods of 48 kHz stereo
+// audio through Gst::AudioRingBuffer, comparing the std::vector based
+// methods with the methods taking raw and typed sample pointers.
+//
+// The ringbuffers belong to a sink and a source which discard and produce
+// silence without waiting, so the numbers show the per-period overhead of
+// the API and not the timing of a real device.
+
+#include <gstreamermm.h>
+#include <gst/audio/gstaudiobasesink.h>
+#include <gst/audio/gstaudiobasesrc.h>
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+static const int rate = 48000;
+static const int channels = 2;
+static const int period_frames = rate / 1000;
+static const int default_periods = 100000;
+
+class NullAudioSink : public Gst::AudioSink
+{
+public:
+  static void class_init(Gst::ElementClass<NullAudioSink> *klass)
+  {
+    klass->set_metadata("Null audio sink", "Sink/Audio",
+      "Discards audio without waiting", "gstreamermm");
+    klass->add_pad_template(Gst::PadTemplate::create("sink", Gst::PAD_SINK,
+      Gst::PAD_ALWAYS, Gst::Caps::create_from_string("audio/x-raw")));
+  }
+
+  explicit NullAudioSink(GstAudioSink *gobj)
+  : Glib::ObjectBase(typeid (NullAudioSink)),
+    Gst::AudioSink(gobj)
+  {
+  }
+
+  bool open_vfunc() override { return true; }
+  bool prepare_audiosink_vfunc(Gst::AudioRingBufferSpec&) override { return true; }
+  bool unprepare_vfunc() override { return true; }
+  bool close_vfunc() override { return true; }
+  int write_vfunc(gpointer, guint length) override { return length; }
+};
+
+class SilenceAudioSrc : public Gst::AudioSrc
+{
+public:
+  static void class_init(Gst::ElementClass<SilenceAudioSrc> *klass)
+  {
+    klass->set_metadata("Silence audio source", "Source/Audio",
+      "Produces silence without waiting", "gstreamermm");
+    klass->add_pad_template(Gst::PadTemplate::create("src", Gst::PAD_SRC,
+      Gst::PAD_ALWAYS, Gst::Caps::create_from_string("audio/x-raw")));
+  }
+
+  explicit SilenceAudioSrc(GstAudioSrc *gobj)
+  : Glib::ObjectBase(typeid (SilenceAudioSrc)),
+    Gst::AudioSrc(gobj)
+  {
+  }
+
+  bool open_vfunc() override { return true; }
+  bool prepare_vfunc(Gst::AudioRingBufferSpec&) override { return true; }
+  bool unprepare_vfunc() override { return true; }
+  bool close_vfunc() override { return true; }
+
+  guint read_vfunc(const void*, guint length, Gst::ClockTime& timestamp) override
+  {
+    // The ringbuffer memory is cleared to silence already.
+    timestamp = Gst::CLOCK_TIME_NONE;
+    return length;
+  }
+};
+
+static Glib::RefPtr<Gst::AudioRingBuffer> acquire(GstAudioRingBuffer* c_ring_buffer)
+{
+  Glib::RefPtr<Gst::AudioRingBuffer> ring_buffer = Glib::wrap(c_ring_buffer, true);
+
+  Glib::RefPtr<Gst::Caps> caps = Gst::Caps::create_simple("audio/x-raw",
+    "format", Glib::ustring(GST_AUDIO_NE(S16)), "layout", Glib::ustring("interleaved"),
+    "rate", rate, "channels", channels);
+
+  // Like the base classes, configure the spec of the ringbuffer itself: one
+  // segment per millisecond, 20 segments. Gst::AudioRingBuffer::parse_caps()
+  // computes the segment size and count from the times.
+  GstAudioRingBufferSpec* c_spec = &c_ring_buffer->spec;
+  gst_caps_replace(&c_spec->caps, caps->gobj());
+  c_spec->latency_time = 1000;
+  c_spec->buffer_time = 20000;
+
+  Gst::AudioRingBufferSpec spec(*c_spec);
+  if(!Gst::AudioRingBuffer::parse_caps(spec, caps) || !ring_buffer->acquire(spec))
+  {
+    std::cerr << "Could not acquire the ringbuffer." << std::endl;
+    return Glib::RefPtr<Gst::AudioRingBuffer>();
+  }
+
+  ring_buffer->activate(true);
+  ring_buffer->set_may_start(true);
+  ring_buffer->start();
+  return ring_buffer;
+}
+
+static void report(const char* what, gint64 usec, int periods)
+{
+  std::cout << what << ": " << (usec * 1000.0 / periods) << " ns per period" << std::endl;
+}
+
+static void benchmark_commit(const Glib::RefPtr<Gst::AudioRingBuffer>& ring_buffer, int periods)
+{
+  std::vector<gint16> samples(period_frames * channels);
+  const guint8* bytes = reinterpret_cast<const guint8*>(samples.data());
+  const gsize size = samples.size() * sizeof(gint16);
+  guint64 sample = 0;
+  int accum = 0;
+
+  gint64 start = g_get_monotonic_time();
+  for(int i = 0; i < periods; ++i)
+  {
+    // The copy callers had to make to use the std::vector method.
+    std::vector<guint8> data(bytes, bytes + size);
+    sample += ring_buffer->commit(sample, data, period_frames, period_frames, accum);
+  }
+  report("commit, std::vector", g_get_monotonic_time() - start, periods);
+
+  start = g_get_monotonic_time();
+  for(int i = 0; i < periods; ++i)
+    sample += ring_buffer->commit(sample, bytes, period_frames, period_frames, accum);
+  report("commit, raw pointer", g_get_monotonic_time() - start, periods);
+
+  start = g_get_monotonic_time();
+  for(int i = 0; i < periods; ++i)
+    sample += ring_buffer->commit(sample, samples.data(), period_frames, period_frames, accum);
+  report("commit, S16 pointer", g_get_monotonic_time() - start, periods);
+}
+
+static void benchmark_read(const Glib::RefPtr<Gst::AudioRingBuffer>& ring_buffer, int periods)
+{
+  std::vector<gint16> samples(period_frames * channels);
+  guint8* bytes = reinterpret_cast<guint8*>(samples.data());
+  const gsize size = samples.size() * sizeof(gint16);
+  Gst::ClockTime timestamp = Gst::CLOCK_TIME_NONE;
+  guint64 sample = 0;
+
+  gint64 start = g_get_monotonic_time();
+  for(int i = 0; i < periods; ++i)
+  {
+    std::vector<guint8> data(size);
+    sample += ring_buffer->read(sample, data, period_frames, timestamp);
+  }
+  report("read, std::vector", g_get_monotonic_time() - start, periods);
+
+  start = g_get_monotonic_time();
+  for(int i = 0; i < periods; ++i)
+    sample += ring_buffer->read(sample, bytes, period_frames, timestamp);
+  report("read, raw pointer", g_get_monotonic_time() - start, periods);
+
+  start = g_get_monotonic_time();
+  for(int i = 0; i < periods; ++i)
+    sample += ring_buffer->read(sample, samples.data(), period_frames, timestamp);
+  report("read, S16 pointer", g_get_monotonic_time() - start, periods);
+}
+
+int main(int argc, char** argv)
+{
+  Gst::init(argc, argv);
+
+  const int periods = argc > 1 ? std::atoi(argv[1]) : default_periods;
+  if(periods <= 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [periods]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Gst::ElementFactory::register_element(Glib::RefPtr<Gst::Plugin>(), "nullaudiosink",
+    GST_RANK_NONE, Gst::register_mm_type<NullAudioSink>("nullaudiosink"));
+  Gst::ElementFactory::register_element(Glib::RefPtr<Gst::Plugin>(), "silenceaudiosrc",
+    GST_RANK_NONE, Gst::register_mm_type<SilenceAudioSrc>("silenceaudiosrc"));
+
+  // The base classes create the ringbuffers and open the devices when going
+  // to the READY state.
+  Glib::RefPtr<Gst::Element> sink = Gst::ElementFactory::create_element("nullaudiosink");
+  Glib::RefPtr<Gst::Element> src = Gst::ElementFactory::create_element("silenceaudiosrc");
+  if(!sink || !src ||
+    sink->set_state(Gst::STATE_READY) == Gst::STATE_CHANGE_FAILURE ||
+    src->set_state(Gst::STATE_READY) == Gst::STATE_CHANGE_FAILURE)
+  {
+    std::cerr << "Could not create the audio elements." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << periods << " periods of " << period_frames << " frames, "
+    << channels << " channels at " << rate << " Hz" << std::endl;
+
+  Glib::RefPtr<Gst::AudioRingBuffer> sink_ring_buffer =
+    acquire(GST_AUDIO_BASE_SINK(sink->gobj())->ringbuffer);
+  if(sink_ring_buffer)
+  {
+    benchmark_commit(sink_ring_buffer, periods);
+    sink_ring_buffer->stop();
+    sink_ring_buffer->activate(false);
+    sink_ring_buffer->release();
+  }
+
+  Glib::RefPtr<Gst::AudioRingBuffer> src_ring_buffer =
+    acquire(GST_AUDIO_BASE_SRC(src->gobj())->ringbuffer);
+  if(src_ring_buffer)
+  {
+    benchmark_read(src_ring_buffer, periods);
+    src_ring_buffer->stop();
+    src_ring_buffer->activate(false);
+    src_ring_buffer->release();
+  }
+
+  sink->set_state(Gst::STATE_NULL);
+  src->set_state(Gst::STATE_NULL);
+
+  return sink_ring_buffer && src_ring_buffer ? EXIT_SUCCESS : EXIT_FAILURE;
+}
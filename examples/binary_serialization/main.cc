@@ -0,0 +1,123 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+// Compares the binary format of Gst::BinaryEncoder with the text format of
+// Gst::Structure::to_string() and Gst::Caps::to_string() by round-tripping
+// typical per-frame metadata and caps many times.
+
+#include <gstreamermm.h>
+#include <iostream>
+#include <cstdlib>
+
+static const int default_iterations = 100000;
+
+static void report(const char* what, const char* format, gsize size, gint64 usec, int iterations)
+{
+  std::cout << what << " (" << format << "): " << size << " bytes, "
+    << (usec * 1000.0 / iterations) << " ns per round trip" << std::endl;
+}
+
+static void benchmark_structure(const Gst::Structure& structure, int iterations)
+{
+  gsize size = 0;
+
+  gint64 start = g_get_monotonic_time();
+  for(int i = 0; i < iterations; ++i)
+  {
+    Glib::ustring text = structure.to_string();
+    Gst::Structure decoded = Gst::Structure::create_from_string(text);
+    size = text.bytes();
+  }
+  report("structure", "text", size, g_get_monotonic_time() - start, iterations);
+
+  guint8 buffer[1024];
+  start = g_get_monotonic_time();
+  for(int i = 0; i < iterations; ++i)
+  {
+    Gst::BinaryEncoder encoder(buffer, sizeof(buffer));
+    encoder.encode(structure);
+    Gst::BinaryDecoder decoder(buffer, encoder.get_size());
+    Gst::Structure decoded = decoder.decode_structure();
+    size = encoder.get_size();
+  }
+  report("structure", "binary", size, g_get_monotonic_time() - start, iterations);
+
+  start = g_get_monotonic_time();
+  for(int i = 0; i < iterations; ++i)
+  {
+    Gst::BinaryEncoder encoder(buffer, sizeof(buffer));
+    encoder.encode(structure);
+    Gst::BinaryDecoder decoder(buffer, encoder.get_size(), Gst::BINARY_DECODE_BORROW_STRINGS);
+    Gst::Structure decoded = decoder.decode_structure();
+  }
+  report("structure", "binary, borrowed strings", size, g_get_monotonic_time() - start, iterations);
+}
+
+static void benchmark_caps(const Glib::RefPtr<Gst::Caps>& caps, int iterations)
+{
+  gsize size = 0;
+
+  gint64 start = g_get_monotonic_time();
+  for(int i = 0; i < iterations; ++i)
+  {
+    Glib::ustring text = caps->to_string();
+    Glib::RefPtr<Gst::Caps> decoded = Gst::Caps::create_from_string(text);
+    size = text.bytes();
+  }
+  report("caps", "text", size, g_get_monotonic_time() - start, iterations);
+
+  guint8 buffer[1024];
+  start = g_get_monotonic_time();
+  for(int i = 0; i < iterations; ++i)
+  {
+    Gst::BinaryEncoder encoder(buffer, sizeof(buffer));
+    encoder.encode(caps);
+    Gst::BinaryDecoder decoder(buffer, encoder.get_size());
+    Glib::RefPtr<Gst::Caps> decoded = decoder.decode_caps();
+    size = encoder.get_size();
+  }
+  report("caps", "binary", size, g_get_monotonic_time() - start, iterations);
+}
+
+int main(int argc, char** argv)
+{
+  Gst::init(argc, argv);
+
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : default_iterations;
+  if(iterations <= 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [iterations]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Gst::Structure metadata("frame-metadata",
+    "frame-number", 1234,
+    "pts", guint64(41708333333),
+    "score", 0.87,
+    "label", std::string("person"),
+    "framerate", Gst::Fraction(30000, 1001));
+  benchmark_structure(metadata, iterations);
+
+  Glib::RefPtr<Gst::Caps> caps = Gst::Caps::create_from_string(
+    "video/x-raw, format=(string)NV12, width=(int)1920, height=(int)1080, "
+    "framerate=(fraction)30000/1001, interlace-mode=(string)progressive, "
+    "pixel-aspect-ratio=(fraction)1/1, colorimetry=(string)bt709");
+  benchmark_caps(caps, iterations);
+
+  return EXIT_SUCCESS;
+}
@@ -69,10 +69,14 @@
 #include <gstreamermm/allocator.h>
 #include <gstreamermm/atomicqueue.h>
 #include <gstreamermm/bin.h>
+#include <gstreamermm/binaryformat.h>
+#include <gstreamermm/borrowedref.h>
 #include <gstreamermm/buffer.h>
 #include <gstreamermm/bufferlist.h>
 #include <gstreamermm/bus.h>
 #include <gstreamermm/caps.h>
+#include <gstreamermm/capscache.h>
+#include <gstreamermm/capsdescription.h>
 #include <gstreamermm/capsfeatures.h>
 #include <gstreamermm/childproxy.h>
 #include <gstreamermm/clock.h>
@@ -83,6 +87,7 @@
 #include <gstreamermm/enums.h>
 #include <gstreamermm/error.h>
 #include <gstreamermm/event.h>
+#include <gstreamermm/fieldkey.h>
 #include <gstreamermm/format.h>
 #include <gstreamermm/ghostpad.h>
 #include <gstreamermm/iterator.h>
@@ -123,25 +128,45 @@
 #include <gstreamermm/pushsrc.h>
 
 // Base library includes
+#include <gstreamermm/aggregator.h>
 #include <gstreamermm/audiobasesink.h>
 #include <gstreamermm/audiobasesrc.h>
 #include <gstreamermm/audioclock.h>
 #include <gstreamermm/audiofilter.h>
 #include <gstreamermm/audioformat.h>
 #include <gstreamermm/audioinfo.h>
+#include <gstreamermm/audiokernels.h>
+#include <gstreamermm/audiolatencytuner.h>
 #include <gstreamermm/audioringbuffer.h>
 #include <gstreamermm/audiosink.h>
 #include <gstreamermm/audiosrc.h>
+#include <gstreamermm/callbackaudioringbuffer.h>
 #include <gstreamermm/colorbalancechannel.h>
 #include <gstreamermm/discoverer.h>
 #include <gstreamermm/discovererinfo.h>
 #include <gstreamermm/encodingprofile.h>
+#include <gstreamermm/loudnessmeter.h>
+#include <gstreamermm/mappedaudiobuffer.h>
 #include <gstreamermm/netclientclock.h>
+#include <gstreamermm/polyphaseresampler.h>
 #include <gstreamermm/videosink.h>
 #include <gstreamermm/videochroma.h>
+#include <gstreamermm/videocodecframe.h>
+#include <gstreamermm/videocodecworkers.h>
+#include <gstreamermm/videocompositor.h>
+#include <gstreamermm/videodecoder.h>
+#include <gstreamermm/videodedup.h>
+#include <gstreamermm/videoencoder.h>
 #include <gstreamermm/videoformat.h>
 #include <gstreamermm/videoframe.h>
 #include <gstreamermm/videoinfo.h>
+#include <gstreamermm/videokernels.h>
+#include <gstreamermm/videolayout.h>
+#include <gstreamermm/videoplane.h>
+#include <gstreamermm/videorectangle.h>
+#include <gstreamermm/videoregionfilter.h>
+#include <gstreamermm/videoregionofinterest.h>
+#include <gstreamermm/videoscenedetect.h>
 
 // Base inteface includes
 #include <gstreamermm/colorbalance.h>
@@ -180,6 +205,7 @@
 #include <gstreamermm/appsrc.h>
 #include <gstreamermm/audioconvert.h>
 #include <gstreamermm/audiorate.h>
+#include <gstreamermm/audioresample.h>
 #include <gstreamermm/audiotestsrc.h>
 #include <gstreamermm/cdparanoiasrc.h>
 #include <gstreamermm/clockoverlay.h>
@@ -0,0 +1,860 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/aggregator.h>
+#include <gstreamermm/handle_error.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+
+// Adds latencies, Gst::CLOCK_TIME_NONE being infinite.
+Gst::ClockTime add_latency(Gst::ClockTime a, Gst::ClockTime b)
+{
+  if(a == Gst::CLOCK_TIME_NONE || b == Gst::CLOCK_TIME_NONE)
+    return Gst::CLOCK_TIME_NONE;
+  return a + b;
+}
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+Glib::RefPtr<AggregatorPad> AggregatorPad::create(const Glib::RefPtr<const Gst::PadTemplate>& templ,
+  const Glib::ustring& name)
+{
+  return Glib::RefPtr<AggregatorPad>(new AggregatorPad(templ, name));
+}
+
+AggregatorPad::AggregatorPad(const Glib::RefPtr<const Gst::PadTemplate>& templ, const Glib::ustring& name)
+: Gst::Pad(templ, name),
+  eos_(false),
+  flushing_(false),
+  aggregator_(nullptr)
+{
+  gst_segment_init(&segment_, GST_FORMAT_TIME);
+}
+
+Glib::RefPtr<Gst::Buffer> AggregatorPad::pop_buffer()
+{
+  g_return_val_if_fail(aggregator_, Glib::RefPtr<Gst::Buffer>());
+  std::lock_guard<std::mutex> lock(aggregator_->mutex_);
+  Glib::RefPtr<Gst::Buffer> buffer;
+  buffer.swap(buffer_);
+  consumed_.notify_one();
+  return buffer;
+}
+
+Glib::RefPtr<Gst::Buffer> AggregatorPad::peek_buffer()
+{
+  g_return_val_if_fail(aggregator_, Glib::RefPtr<Gst::Buffer>());
+  std::lock_guard<std::mutex> lock(aggregator_->mutex_);
+  return buffer_;
+}
+
+bool AggregatorPad::has_buffer() const
+{
+  g_return_val_if_fail(aggregator_, false);
+  std::lock_guard<std::mutex> lock(aggregator_->mutex_);
+  return static_cast<bool>(buffer_);
+}
+
+bool AggregatorPad::drop_buffer()
+{
+  return static_cast<bool>(pop_buffer());
+}
+
+bool AggregatorPad::is_eos() const
+{
+  g_return_val_if_fail(aggregator_, false);
+  std::lock_guard<std::mutex> lock(aggregator_->mutex_);
+  return eos_ && !buffer_;
+}
+
+Gst::Segment AggregatorPad::get_segment() const
+{
+  g_return_val_if_fail(aggregator_, Gst::Segment());
+  GstSegment segment;
+  {
+    std::lock_guard<std::mutex> lock(aggregator_->mutex_);
+    segment = segment_;
+  }
+  return Gst::Segment(&segment, true);
+}
+
+Gst::ClockTime AggregatorPad::get_running_time() const
+{
+  g_return_val_if_fail(aggregator_, Gst::CLOCK_TIME_NONE);
+  std::lock_guard<std::mutex> lock(aggregator_->mutex_);
+  if(!buffer_ || !GST_BUFFER_PTS_IS_VALID(buffer_->gobj()))
+    return Gst::CLOCK_TIME_NONE;
+
+  return gst_segment_to_running_time(&segment_, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer_->gobj()));
+}
+
+void AggregatorPad::flush_vfunc()
+{
+}
+
+Aggregator::Aggregator(GstElement* gobj)
+: Gst::Element(gobj),
+  latency_property_(*this, "latency", 0),
+  next_pad_index_(0),
+  active_(false),
+  flushing_(false),
+  flushing_pads_(0),
+  flow_return_(Gst::FLOW_OK),
+  clock_id_(nullptr),
+  live_(false),
+  latency_known_(false),
+  upstream_min_latency_(0),
+  upstream_max_latency_(Gst::CLOCK_TIME_NONE),
+  sub_min_latency_(0),
+  sub_max_latency_(0),
+  send_stream_start_(true),
+  send_segment_(true),
+  tags_(gst_tag_list_new_empty()),
+  send_tags_(false),
+  position_(0)
+{
+  gst_segment_init(&src_segment_, GST_FORMAT_TIME);
+
+  Glib::RefPtr<Gst::PadTemplate> templ = get_pad_template("src");
+  if(!templ)
+    gstreamermm_handle_error("Gst::Aggregator needs a \"src\" pad template");
+
+  src_pad_ = Gst::Pad::create(templ, "src");
+  src_pad_->set_event_function(sigc::mem_fun(*this, &Aggregator::on_src_event));
+  src_pad_->set_query_function(sigc::mem_fun(*this, &Aggregator::on_src_query));
+  src_pad_->set_activatemode_function(sigc::mem_fun(*this, &Aggregator::on_src_activate_mode));
+  add_pad(src_pad_);
+}
+
+Aggregator::~Aggregator()
+{
+  if(clock_id_)
+    gst_clock_id_unref(clock_id_);
+  gst_tag_list_unref(tags_);
+}
+
+Glib::PropertyProxy<guint64> Aggregator::property_latency()
+{
+  return latency_property_.get_proxy();
+}
+
+Glib::RefPtr<Gst::Pad> Aggregator::get_src_pad()
+{
+  return src_pad_;
+}
+
+std::vector<Glib::RefPtr<Gst::AggregatorPad>> Aggregator::get_sink_pads() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return sink_pads_;
+}
+
+void Aggregator::set_src_caps(const Glib::RefPtr<Gst::Caps>& caps)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_caps_ = caps;
+}
+
+void Aggregator::set_latency(Gst::ClockTime min_latency, Gst::ClockTime max_latency)
+{
+  bool changed;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    changed = min_latency != sub_min_latency_ || max_latency != sub_max_latency_;
+    sub_min_latency_ = min_latency;
+    sub_max_latency_ = max_latency;
+  }
+
+  if(changed)
+    gst_element_post_message(gobj(), gst_message_new_latency(GST_OBJECT_CAST(gobj())));
+}
+
+Gst::ClockTime Aggregator::get_latency() const
+{
+  const Gst::ClockTime extra = latency_property_.get_value();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(!latency_known_ || !live_)
+    return Gst::CLOCK_TIME_NONE;
+
+  return upstream_min_latency_ + sub_min_latency_ + extra;
+}
+
+Gst::FlowReturn Aggregator::finish_buffer(const Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  push_pending_events();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    GstBuffer* const gst_buffer = buffer->gobj();
+    if(GST_BUFFER_PTS_IS_VALID(gst_buffer))
+    {
+      position_ = GST_BUFFER_PTS(gst_buffer);
+      if(GST_BUFFER_DURATION_IS_VALID(gst_buffer))
+        position_ += GST_BUFFER_DURATION(gst_buffer);
+      src_segment_.position = position_;
+    }
+  }
+
+  return static_cast<Gst::FlowReturn>(gst_pad_push(src_pad_->gobj(), gst_buffer_ref(buffer->gobj())));
+}
+
+Glib::RefPtr<Gst::Buffer> Aggregator::clip_vfunc(const Glib::RefPtr<Gst::AggregatorPad>&,
+  const Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  return buffer;
+}
+
+bool Aggregator::sink_event_vfunc(const Glib::RefPtr<Gst::AggregatorPad>& pad,
+  const Glib::RefPtr<Gst::Event>& event)
+{
+  GstEvent* const gst_event = event->gobj();
+
+  switch(GST_EVENT_TYPE(gst_event))
+  {
+    case GST_EVENT_FLUSH_START:
+    {
+      bool first = false;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(!pad->flushing_)
+        {
+          pad->flushing_ = true;
+          ++flushing_pads_;
+        }
+        pad->buffer_.reset();
+        first = !flushing_;
+        flushing_ = true;
+        wake_up();
+      }
+
+      // The first flush-start goes downstream and stops the streaming
+      // thread; the others are dropped.
+      if(first)
+      {
+        gst_pad_push_event(src_pad_->gobj(), gst_event_ref(gst_event));
+        src_pad_->pause_task();
+      }
+      return true;
+    }
+
+    case GST_EVENT_FLUSH_STOP:
+    {
+      bool last = false;
+      bool active = false;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(pad->flushing_)
+        {
+          pad->flushing_ = false;
+          --flushing_pads_;
+        }
+        pad->eos_ = false;
+        gst_segment_init(&pad->segment_, GST_FORMAT_TIME);
+        last = flushing_ && !flushing_pads_;
+        active = active_;
+      }
+
+      pad->flush_vfunc();
+      if(!last)
+        return true;
+
+      flush_vfunc();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushing_ = false;
+        flow_return_ = Gst::FLOW_OK;
+        send_segment_ = true;
+        gst_segment_init(&src_segment_, GST_FORMAT_TIME);
+        position_ = 0;
+      }
+
+      // The last flush-stop goes downstream and restarts the streaming
+      // thread.
+      gst_pad_push_event(src_pad_->gobj(), gst_event_ref(gst_event));
+      if(active)
+        gst_pad_start_task(src_pad_->gobj(), &Aggregator::loop_callback, this, nullptr);
+      return true;
+    }
+
+    case GST_EVENT_SEGMENT:
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      gst_event_copy_segment(gst_event, &pad->segment_);
+      return true;
+    }
+
+    case GST_EVENT_EOS:
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pad->eos_ = true;
+      wake_up();
+      return true;
+    }
+
+    case GST_EVENT_GAP:
+    {
+      // The input is covered until the end of the gap, like with a buffer.
+      GstClockTime timestamp, duration;
+      gst_event_parse_gap(gst_event, &timestamp, &duration);
+      Glib::RefPtr<Gst::Buffer> gap = Gst::Buffer::create(0);
+      GstBuffer* const gst_buffer = gap->gobj();
+      GST_BUFFER_PTS(gst_buffer) = timestamp;
+      GST_BUFFER_DURATION(gst_buffer) = duration;
+      GST_BUFFER_FLAG_SET(gst_buffer, GST_BUFFER_FLAG_GAP);
+      GST_BUFFER_FLAG_SET(gst_buffer, GST_BUFFER_FLAG_DROPPABLE);
+      return queue_buffer(pad, gap) == Gst::FLOW_OK;
+    }
+
+    case GST_EVENT_TAG:
+    {
+      GstTagList* tags = nullptr;
+      gst_event_parse_tag(gst_event, &tags);
+      std::lock_guard<std::mutex> lock(mutex_);
+      gst_tag_list_insert(tags_, tags, GST_TAG_MERGE_REPLACE);
+      send_tags_ = true;
+      return true;
+    }
+
+    case GST_EVENT_STREAM_START:
+    case GST_EVENT_CAPS:
+      // The aggregator sends its own stream-start and caps.
+      return true;
+
+    default:
+      return gst_pad_event_default(pad->gobj(), GST_OBJECT_CAST(gobj()), gst_event_ref(gst_event));
+  }
+}
+
+bool Aggregator::sink_query_vfunc(const Glib::RefPtr<Gst::AggregatorPad>& pad,
+  const Glib::RefPtr<Gst::Query>& query)
+{
+  return gst_pad_query_default(pad->gobj(), GST_OBJECT_CAST(gobj()), query->gobj());
+}
+
+bool Aggregator::src_event_vfunc(const Glib::RefPtr<Gst::Event>& event)
+{
+  bool result = false;
+  for(const Glib::RefPtr<Gst::AggregatorPad>& pad : get_sink_pads())
+    result |= static_cast<bool>(gst_pad_push_event(pad->gobj(), gst_event_ref(event->gobj())));
+
+  return result;
+}
+
+bool Aggregator::src_query_vfunc(const Glib::RefPtr<Gst::Query>& query)
+{
+  if(GST_QUERY_TYPE(query->gobj()) != GST_QUERY_LATENCY)
+    return gst_pad_query_default(src_pad_->gobj(), GST_OBJECT_CAST(gobj()), query->gobj());
+
+  query_upstream_latency();
+
+  const Gst::ClockTime extra = latency_property_.get_value();
+  std::lock_guard<std::mutex> lock(mutex_);
+  gst_query_set_latency(query->gobj(), live_, upstream_min_latency_ + sub_min_latency_ + extra,
+    add_latency(add_latency(upstream_max_latency_, sub_max_latency_), extra));
+  return true;
+}
+
+Gst::FlowReturn Aggregator::flush_vfunc()
+{
+  return Gst::FLOW_OK;
+}
+
+bool Aggregator::start_vfunc()
+{
+  return true;
+}
+
+bool Aggregator::stop_vfunc()
+{
+  return true;
+}
+
+Gst::ClockTime Aggregator::get_next_time_vfunc()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return position_;
+}
+
+Glib::RefPtr<Gst::AggregatorPad> Aggregator::create_new_pad_vfunc(const Glib::RefPtr<Gst::PadTemplate>& templ,
+  const Glib::ustring& name, const Glib::RefPtr<const Gst::Caps>&)
+{
+  return AggregatorPad::create(templ, name);
+}
+
+Glib::RefPtr<Gst::Pad> Aggregator::request_new_pad_vfunc(Glib::RefPtr<Gst::PadTemplate> templ,
+  const Glib::ustring& name, const Glib::RefPtr<const Gst::Caps>& caps)
+{
+  if(!templ || templ->get_direction() != Gst::PAD_SINK)
+    return Glib::RefPtr<Gst::Pad>();
+
+  // Requested names follow the name template, such as "sink_%u", and the
+  // indexes of unnamed requests follow the highest one.
+  const Glib::ustring name_template = templ->get_name_template();
+  const Glib::ustring::size_type conversion = name_template.find("%u");
+  Glib::ustring pad_name = name;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(conversion != Glib::ustring::npos)
+    {
+      guint index = 0;
+      const Glib::ustring prefix = name_template.substr(0, conversion);
+      if(name.empty())
+      {
+        index = next_pad_index_;
+        pad_name = prefix + Glib::ustring::format(index);
+      }
+      else if(name.compare(0, prefix.size(), prefix) ||
+        std::sscanf(name.c_str() + prefix.bytes(), "%u", &index) != 1)
+        return Glib::RefPtr<Gst::Pad>();
+
+      next_pad_index_ = std::max(next_pad_index_, index + 1);
+    }
+  }
+
+  Glib::RefPtr<Gst::AggregatorPad> pad = create_new_pad_vfunc(templ, pad_name, caps);
+  if(!pad)
+    return Glib::RefPtr<Gst::Pad>();
+
+  pad->aggregator_ = this;
+  pad->set_chain_function(sigc::mem_fun(*this, &Aggregator::on_chain));
+  pad->set_event_function(sigc::mem_fun(*this, &Aggregator::on_sink_event));
+  pad->set_query_function(sigc::mem_fun(*this, &Aggregator::on_sink_query));
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_pads_.push_back(pad);
+    latency_known_ = false;
+  }
+
+  if(!add_pad(pad))
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_pads_.erase(std::find(sink_pads_.begin(), sink_pads_.end(), pad));
+    return Glib::RefPtr<Gst::Pad>();
+  }
+
+  return pad;
+}
+
+void Aggregator::release_pad_vfunc(const Glib::RefPtr<Gst::Pad>& pad)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find(sink_pads_.begin(), sink_pads_.end(), pad);
+    if(it == sink_pads_.end())
+      return;
+
+    // The removed input may have been the one the aggregator waited for.
+    if((*it)->flushing_)
+      --flushing_pads_;
+    (*it)->flushing_ = true;
+    (*it)->buffer_.reset();
+    (*it)->consumed_.notify_all();
+    // The accessors of a pad still held by the application no longer use
+    // the lock of the aggregator, which may go away.
+    (*it)->aggregator_ = nullptr;
+    sink_pads_.erase(it);
+    if(flushing_ && !flushing_pads_)
+      flushing_ = false;
+    latency_known_ = false;
+    wake_up();
+  }
+
+  remove_pad(pad);
+}
+
+Gst::StateChangeReturn Aggregator::change_state_vfunc(Gst::StateChange transition)
+{
+  if(transition == Gst::STATE_CHANGE_READY_TO_PAUSED)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      flushing_ = false;
+      flushing_pads_ = 0;
+      flow_return_ = Gst::FLOW_OK;
+      live_ = false;
+      latency_known_ = false;
+      send_stream_start_ = true;
+      send_segment_ = true;
+      gst_segment_init(&src_segment_, GST_FORMAT_TIME);
+      position_ = 0;
+      gst_tag_list_unref(tags_);
+      tags_ = gst_tag_list_new_empty();
+      send_tags_ = false;
+
+      for(const Glib::RefPtr<Gst::AggregatorPad>& pad : sink_pads_)
+      {
+        pad->buffer_.reset();
+        pad->eos_ = false;
+        pad->flushing_ = false;
+        gst_segment_init(&pad->segment_, GST_FORMAT_TIME);
+      }
+    }
+
+    if(!start_vfunc())
+      return Gst::STATE_CHANGE_FAILURE;
+  }
+
+  Gst::StateChangeReturn result = Gst::Element::change_state_vfunc(transition);
+  if(result == Gst::STATE_CHANGE_FAILURE)
+    return result;
+
+  if(transition == Gst::STATE_CHANGE_PAUSED_TO_READY)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_caps_.reset();
+      for(const Glib::RefPtr<Gst::AggregatorPad>& pad : sink_pads_)
+        pad->buffer_.reset();
+    }
+
+    if(!stop_vfunc())
+      result = Gst::STATE_CHANGE_FAILURE;
+  }
+
+  return result;
+}
+
+void Aggregator::loop_callback(gpointer data)
+{
+  static_cast<Aggregator*>(data)->loop();
+}
+
+void Aggregator::loop()
+{
+  bool timeout = false;
+  bool eos = false;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(true)
+    {
+      if(!active_ || flushing_)
+      {
+        lock.unlock();
+        src_pad_->pause_task();
+        return;
+      }
+
+      eos = is_eos();
+      if(eos || is_ready())
+        break;
+
+      if(!latency_known_)
+      {
+        lock.unlock();
+        query_upstream_latency();
+        lock.lock();
+        continue;
+      }
+
+      GstClock* const clock = live_ ? gst_element_get_clock(gobj()) : nullptr;
+      if(!clock)
+      {
+        data_.wait(lock);
+        continue;
+      }
+
+      // Wait for the inputs until the clock reaches the next output time
+      // plus the latency.
+      const Gst::ClockTime min_latency = upstream_min_latency_ + sub_min_latency_;
+      lock.unlock();
+      const Gst::ClockTime next_time = get_next_time_vfunc();
+      const Gst::ClockTime deadline = next_time == Gst::CLOCK_TIME_NONE ? Gst::CLOCK_TIME_NONE :
+        gst_element_get_base_time(gobj()) + next_time + min_latency + latency_property_.get_value();
+      lock.lock();
+
+      if(deadline == Gst::CLOCK_TIME_NONE || !active_ || flushing_ || is_ready() || is_eos())
+      {
+        gst_object_unref(clock);
+        if(deadline == Gst::CLOCK_TIME_NONE)
+          data_.wait(lock);
+        continue;
+      }
+
+      // New data unschedules the wait, even if it comes before it starts.
+      GstClockID id = gst_clock_new_single_shot_id(clock, deadline);
+      clock_id_ = gst_clock_id_ref(id);
+      gst_object_unref(clock);
+
+      lock.unlock();
+      const GstClockReturn clock_return = gst_clock_id_wait(id, nullptr);
+      lock.lock();
+
+      gst_clock_id_unref(clock_id_);
+      clock_id_ = nullptr;
+      gst_clock_id_unref(id);
+
+      if(clock_return == GST_CLOCK_OK || clock_return == GST_CLOCK_EARLY)
+      {
+        timeout = true;
+        break;
+      }
+    }
+  }
+
+  if(eos)
+  {
+    push_eos();
+    return;
+  }
+
+  const Gst::FlowReturn result = aggregate_vfunc(timeout);
+  if(result == Gst::FLOW_OK)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flow_return_ = result;
+    wake_up();
+  }
+
+  if(result == Gst::FLOW_EOS)
+    push_eos();
+  else
+  {
+    src_pad_->pause_task();
+    if(result == Gst::FLOW_NOT_LINKED || result < Gst::FLOW_EOS)
+    {
+      GST_ELEMENT_FLOW_ERROR(gobj(), static_cast<GstFlowReturn>(result));
+      gst_pad_push_event(src_pad_->gobj(), gst_event_new_eos());
+    }
+  }
+}
+
+bool Aggregator::is_ready() const
+{
+  if(sink_pads_.empty())
+    return false;
+
+  for(const Glib::RefPtr<Gst::AggregatorPad>& pad : sink_pads_)
+  {
+    if(!pad->buffer_ && !pad->eos_)
+      return false;
+  }
+
+  return true;
+}
+
+bool Aggregator::is_eos() const
+{
+  if(sink_pads_.empty())
+    return false;
+
+  for(const Glib::RefPtr<Gst::AggregatorPad>& pad : sink_pads_)
+  {
+    if(!pad->eos_ || pad->buffer_)
+      return false;
+  }
+
+  return true;
+}
+
+void Aggregator::wake_up()
+{
+  data_.notify_all();
+  for(const Glib::RefPtr<Gst::AggregatorPad>& pad : sink_pads_)
+    pad->consumed_.notify_all();
+
+  if(clock_id_)
+    gst_clock_id_unschedule(clock_id_);
+}
+
+void Aggregator::query_upstream_latency()
+{
+  bool live = false;
+  Gst::ClockTime min_latency = 0;
+  Gst::ClockTime max_latency = Gst::CLOCK_TIME_NONE;
+
+  // Live inputs are all waited for: the highest minimum latency, and the
+  // lowest maximum one.
+  for(const Glib::RefPtr<Gst::AggregatorPad>& pad : get_sink_pads())
+  {
+    GstQuery* const query = gst_query_new_latency();
+    if(gst_pad_peer_query(pad->gobj(), query))
+    {
+      gboolean pad_live = FALSE;
+      GstClockTime pad_min = 0, pad_max = GST_CLOCK_TIME_NONE;
+      gst_query_parse_latency(query, &pad_live, &pad_min, &pad_max);
+      if(pad_live)
+      {
+        live = true;
+        min_latency = std::max(min_latency, pad_min);
+        if(pad_max != GST_CLOCK_TIME_NONE)
+          max_latency = max_latency == Gst::CLOCK_TIME_NONE ? pad_max : std::min(max_latency, pad_max);
+      }
+    }
+    gst_query_unref(query);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  live_ = live;
+  upstream_min_latency_ = min_latency;
+  upstream_max_latency_ = max_latency;
+  latency_known_ = true;
+}
+
+void Aggregator::push_pending_events()
+{
+  bool stream_start, segment;
+  Glib::RefPtr<Gst::Caps> caps;
+  GstSegment src_segment;
+  GstTagList* tags = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stream_start = send_stream_start_;
+    segment = send_segment_;
+    caps.swap(pending_caps_);
+    src_segment = src_segment_;
+    if(send_tags_)
+      tags = gst_tag_list_copy(tags_);
+    send_stream_start_ = false;
+    send_segment_ = false;
+    send_tags_ = false;
+  }
+
+  if(stream_start)
+  {
+    gchar* const stream_id = gst_pad_create_stream_id(src_pad_->gobj(), gobj(), nullptr);
+    GstEvent* const event = gst_event_new_stream_start(stream_id);
+    gst_event_set_group_id(event, gst_util_group_id_next());
+    g_free(stream_id);
+    gst_pad_push_event(src_pad_->gobj(), event);
+  }
+
+  if(caps)
+    gst_pad_push_event(src_pad_->gobj(), gst_event_new_caps(caps->gobj()));
+
+  if(segment)
+    gst_pad_push_event(src_pad_->gobj(), gst_event_new_segment(&src_segment));
+
+  if(tags)
+    gst_pad_push_event(src_pad_->gobj(), gst_event_new_tag(tags));
+}
+
+void Aggregator::push_eos()
+{
+  push_pending_events();
+  gst_pad_push_event(src_pad_->gobj(), gst_event_new_eos());
+  src_pad_->pause_task();
+}
+
+Gst::FlowReturn Aggregator::on_chain(const Glib::RefPtr<Gst::Pad>& pad, Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  const Glib::RefPtr<Gst::AggregatorPad> aggregator_pad = Glib::RefPtr<Gst::AggregatorPad>::cast_static(pad);
+
+  const Glib::RefPtr<Gst::Buffer> clipped = clip_vfunc(aggregator_pad, buffer);
+  buffer.reset();
+  if(!clipped)
+    return Gst::FLOW_OK;
+
+  return queue_buffer(aggregator_pad, clipped);
+}
+
+Gst::FlowReturn Aggregator::queue_buffer(const Glib::RefPtr<Gst::AggregatorPad>& aggregator_pad,
+  const Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while(aggregator_pad->buffer_ && active_ && !flushing_ && !aggregator_pad->flushing_ &&
+    flow_return_ == Gst::FLOW_OK)
+    aggregator_pad->consumed_.wait(lock);
+
+  if(!active_ || flushing_ || aggregator_pad->flushing_)
+    return Gst::FLOW_FLUSHING;
+  if(flow_return_ != Gst::FLOW_OK)
+    return flow_return_;
+  if(aggregator_pad->eos_)
+    return Gst::FLOW_EOS;
+
+  aggregator_pad->buffer_ = buffer;
+  if(is_ready())
+  {
+    data_.notify_one();
+    if(clock_id_)
+      gst_clock_id_unschedule(clock_id_);
+  }
+
+  return Gst::FLOW_OK;
+}
+
+gboolean Aggregator::on_sink_event(const Glib::RefPtr<Gst::Pad>& pad, Glib::RefPtr<Gst::Event>& event)
+{
+  const Glib::RefPtr<Gst::AggregatorPad> aggregator_pad = Glib::RefPtr<Gst::AggregatorPad>::cast_static(pad);
+  const GstEventType type = GST_EVENT_TYPE(event->gobj());
+
+  // Serialized events apply to the buffers after them: wait until the
+  // queued buffer is consumed. EOS only marks the pad, and flush-stop comes
+  // after the queue was emptied.
+  if(GST_EVENT_IS_SERIALIZED(event->gobj()) && type != GST_EVENT_EOS && type != GST_EVENT_FLUSH_STOP)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(aggregator_pad->buffer_ && active_ && !flushing_ && !aggregator_pad->flushing_)
+      aggregator_pad->consumed_.wait(lock);
+
+    if(aggregator_pad->buffer_)
+      return false;
+  }
+
+  return sink_event_vfunc(aggregator_pad, event);
+}
+
+gboolean Aggregator::on_sink_query(const Glib::RefPtr<Gst::Pad>& pad, Glib::RefPtr<Gst::Query>& query)
+{
+  return sink_query_vfunc(Glib::RefPtr<Gst::AggregatorPad>::cast_static(pad), query);
+}
+
+gboolean Aggregator::on_src_event(const Glib::RefPtr<Gst::Pad>&, Glib::RefPtr<Gst::Event>& event)
+{
+  return src_event_vfunc(event);
+}
+
+gboolean Aggregator::on_src_query(const Glib::RefPtr<Gst::Pad>&, Glib::RefPtr<Gst::Query>& query)
+{
+  return src_query_vfunc(query);
+}
+
+bool Aggregator::on_src_activate_mode(const Glib::RefPtr<Gst::Pad>&, Gst::PadMode mode, bool active)
+{
+  if(mode != Gst::PAD_MODE_PUSH)
+    return false;
+
+  if(active)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      active_ = true;
+    }
+    return gst_pad_start_task(src_pad_->gobj(), &Aggregator::loop_callback, this, nullptr);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_ = false;
+    wake_up();
+  }
+  return gst_pad_stop_task(src_pad_->gobj());
+}
+
+} // namespace Gst
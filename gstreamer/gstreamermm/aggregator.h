@@ -0,0 +1,347 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_AGGREGATOR_H
+#define _GSTREAMERMM_AGGREGATOR_H
+
+#include <gstreamermm/buffer.h>
+#include <gstreamermm/caps.h>
+#include <gstreamermm/clockutils.h>
+#include <gstreamermm/element.h>
+#include <gstreamermm/event.h>
+#include <gstreamermm/pad.h>
+#include <gstreamermm/padtemplate.h>
+#include <gstreamermm/query.h>
+#include <gstreamermm/segment.h>
+#include <glibmm/property.h>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace Gst
+{
+
+class Aggregator;
+
+/**
+ * Gst::AggregatorPad is a sink pad of a Gst::Aggregator. It holds the next
+ * buffer of its input until the aggregator consumes it, and the segment of
+ * its input.
+ *
+ * The aggregator creates its pads on request; subclasses needing more state
+ * per input derive from Gst::AggregatorPad and create their pads in
+ * Gst::Aggregator::create_new_pad_vfunc().
+ *
+ * All methods are thread-safe. They can only be used while the pad
+ * belongs to an aggregator; before it is added and after it is released,
+ * they warn and return an empty value.
+ */
+class AggregatorPad : public Gst::Pad
+{
+public:
+  /** Creates a pad from @a templ, which has to be a sink pad template.
+   */
+  static Glib::RefPtr<AggregatorPad> create(const Glib::RefPtr<const Gst::PadTemplate>& templ,
+    const Glib::ustring& name);
+
+  /** Takes the queued buffer, which lets the upstream element push the next
+   * one.
+   *
+   * @return The buffer, or an empty pointer if none is queued.
+   */
+  Glib::RefPtr<Gst::Buffer> pop_buffer();
+
+  /** Returns the queued buffer, which stays queued.
+   *
+   * @return The buffer, or an empty pointer if none is queued.
+   */
+  Glib::RefPtr<Gst::Buffer> peek_buffer();
+
+  /** Checks whether a buffer is queued.
+   */
+  bool has_buffer() const;
+
+  /** Drops the queued buffer.
+   *
+   * @return true if a buffer was dropped.
+   */
+  bool drop_buffer();
+
+  /** Checks whether the input reached the end of the stream: it received
+   * EOS and its last buffer was consumed.
+   */
+  bool is_eos() const;
+
+  /** Returns the segment of the input, in which the queued buffer is
+   * timestamped.
+   */
+  Gst::Segment get_segment() const;
+
+  /** Returns the running time of the start of the queued buffer, or
+   * Gst::CLOCK_TIME_NONE if no buffer is queued or it has no timestamp.
+   */
+  Gst::ClockTime get_running_time() const;
+
+protected:
+  AggregatorPad(const Glib::RefPtr<const Gst::PadTemplate>& templ, const Glib::ustring& name);
+
+  /** Called when the input is flushed, after the queued buffer was dropped.
+   * The default implementation does nothing.
+   */
+  virtual void flush_vfunc();
+
+private:
+  friend class Aggregator;
+
+  Glib::RefPtr<Gst::Buffer> buffer_;
+  GstSegment segment_;
+  bool eos_;
+  bool flushing_;
+  // Signaled when the queued buffer is consumed.
+  std::condition_variable consumed_;
+  Aggregator* aggregator_;
+};
+
+/**
+ * Gst::Aggregator is a base class for elements combining N inputs into one
+ * output, such as mixers, compositors and muxers.
+ *
+ * The subclass adds a "src" always pad template and a sink request pad
+ * template, such as "sink_%u", in its class_init(); the aggregator creates
+ * a Gst::AggregatorPad for each requested sink pad. Each input queues one
+ * buffer; once all inputs have a buffer or are at the end of the stream,
+ * aggregate_vfunc() is called from the streaming thread of the source pad.
+ * It takes the buffers with Gst::AggregatorPad::pop_buffer(), and pushes
+ * its output with finish_buffer():
+ * @code
+ * Gst::FlowReturn MyMixer::aggregate_vfunc(bool timeout)
+ * {
+ *   for(const Glib::RefPtr<Gst::AggregatorPad>& pad : get_sink_pads())
+ *   {
+ *     Glib::RefPtr<Gst::Buffer> buffer = pad->pop_buffer();
+ *     ...
+ *   }
+ *   return finish_buffer(output);
+ * }
+ * @endcode
+ *
+ * When all inputs are at the end of the stream, the aggregator pushes EOS.
+ *
+ * A gap event on an input is queued like a buffer: an empty buffer with
+ * the Gst::BUFFER_FLAG_GAP and Gst::BUFFER_FLAG_DROPPABLE flags, covering
+ * the time of the gap. Sparse inputs, such as subtitles, thus do not stall
+ * the aggregator; subclasses skip these buffers.
+ *
+ * In live pipelines, the aggregator does not wait for late inputs beyond
+ * the latency: aggregate_vfunc() is called with @a timeout set once the
+ * clock reaches get_next_time_vfunc() plus the latency, with the buffers
+ * which arrived in time. The latency is the one of the upstream elements,
+ * plus the one of the subclass (see set_latency()), plus the "latency"
+ * property.
+ *
+ * The aggregator sends the stream-start event, the caps set with
+ * set_src_caps() and a time segment before its first buffer. The tags of
+ * all inputs are merged and sent before the next buffer. It handles
+ * flushing seeks by forwarding them to all inputs.
+ *
+ * All inputs share one lock and one condition for new data, so the
+ * aggregator scales to many inputs without a thread handoff per input.
+ *
+ * This class follows the GstAggregator API of GStreamer 1.14, in C++.
+ */
+class Aggregator : public Gst::Element
+{
+public:
+  /** The extra latency added to the upstream latency in live pipelines, in
+   * nanoseconds, to let late inputs arrive before timing out.
+   */
+  Glib::PropertyProxy<guint64> property_latency();
+
+  /** Returns the source pad.
+   */
+  Glib::RefPtr<Gst::Pad> get_src_pad();
+
+  /** Returns the sink pads, in the order they were requested.
+   */
+  std::vector<Glib::RefPtr<Gst::AggregatorPad>> get_sink_pads() const;
+
+  /** Sets the caps of the output, which are sent before the next buffer.
+   */
+  void set_src_caps(const Glib::RefPtr<Gst::Caps>& caps);
+
+  /** Sets the latency added by the subclass, which is reported in latency
+   * queries and used for the live timeout. A latency message is posted if
+   * it changes.
+   */
+  void set_latency(Gst::ClockTime min_latency, Gst::ClockTime max_latency);
+
+  /** Returns the total latency: the upstream one, the one of the subclass
+   * and the "latency" property, or Gst::CLOCK_TIME_NONE if the pipeline is
+   * not live or the latency is not known yet.
+   */
+  Gst::ClockTime get_latency() const;
+
+  /** Pushes @a buffer on the source pad, after the pending stream-start,
+   * caps and segment events. The output position advances to the end of
+   * @a buffer.
+   */
+  Gst::FlowReturn finish_buffer(const Glib::RefPtr<Gst::Buffer>& buffer);
+
+protected:
+  explicit Aggregator(GstElement* gobj);
+  virtual ~Aggregator();
+
+  /** Combines the queued buffers of the inputs into an output buffer,
+   * pushed with finish_buffer().
+   *
+   * @param timeout true if called because the live timeout expired, in
+   * which case some inputs may have no buffer.
+   * @return Gst::FLOW_OK to go on, Gst::FLOW_EOS to end the stream, or an
+   * error.
+   */
+  virtual Gst::FlowReturn aggregate_vfunc(bool timeout) = 0;
+
+  /** Called with each buffer before it is queued on @a pad, to clip it to
+   * the segment of the pad. The default implementation returns @a buffer.
+   *
+   * @return The clipped buffer, or an empty pointer to drop it.
+   */
+  virtual Glib::RefPtr<Gst::Buffer> clip_vfunc(const Glib::RefPtr<Gst::AggregatorPad>& pad,
+    const Glib::RefPtr<Gst::Buffer>& buffer);
+
+  /** Handles an event received on @a pad. Serialized events are handled
+   * after the buffers received before them were consumed.
+   *
+   * The default implementation handles flushing, the segment, gaps, tags
+   * and the end of the stream, drops the stream-start and caps events, and
+   * forwards the other events downstream; subclasses have to chain up.
+   */
+  virtual bool sink_event_vfunc(const Glib::RefPtr<Gst::AggregatorPad>& pad,
+    const Glib::RefPtr<Gst::Event>& event);
+
+  /** Answers a query received on @a pad. The default implementation is the
+   * default of Gst::Pad.
+   */
+  virtual bool sink_query_vfunc(const Glib::RefPtr<Gst::AggregatorPad>& pad,
+    const Glib::RefPtr<Gst::Query>& query);
+
+  /** Handles an event received on the source pad. The default
+   * implementation forwards it to all inputs.
+   */
+  virtual bool src_event_vfunc(const Glib::RefPtr<Gst::Event>& event);
+
+  /** Answers a query received on the source pad. The default
+   * implementation answers latency queries and uses the default of
+   * Gst::Pad for the others.
+   */
+  virtual bool src_query_vfunc(const Glib::RefPtr<Gst::Query>& query);
+
+  /** Called after a flush, to reset the state of the subclass. The default
+   * implementation does nothing.
+   */
+  virtual Gst::FlowReturn flush_vfunc();
+
+  /** Called when the element goes from READY to PAUSED.
+   */
+  virtual bool start_vfunc();
+
+  /** Called when the element goes from PAUSED to READY.
+   */
+  virtual bool stop_vfunc();
+
+  /** Returns the running time of the next output buffer, until which a
+   * live aggregator waits for its inputs. The default implementation
+   * returns the output position, which starts at 0.
+   */
+  virtual Gst::ClockTime get_next_time_vfunc();
+
+  /** Creates the pad for a request of @a templ. The default implementation
+   * creates a Gst::AggregatorPad.
+   */
+  virtual Glib::RefPtr<Gst::AggregatorPad> create_new_pad_vfunc(const Glib::RefPtr<Gst::PadTemplate>& templ,
+    const Glib::ustring& name, const Glib::RefPtr<const Gst::Caps>& caps);
+
+  Glib::RefPtr<Gst::Pad> request_new_pad_vfunc(Glib::RefPtr<Gst::PadTemplate> templ,
+    const Glib::ustring& name, const Glib::RefPtr<const Gst::Caps>& caps) override;
+  void release_pad_vfunc(const Glib::RefPtr<Gst::Pad>& pad) override;
+  Gst::StateChangeReturn change_state_vfunc(Gst::StateChange transition) override;
+
+private:
+  friend class AggregatorPad;
+
+  static void loop_callback(gpointer data);
+  void loop();
+  bool is_ready() const;
+  bool is_eos() const;
+  void wake_up();
+  void query_upstream_latency();
+  void push_pending_events();
+  void push_eos();
+  Gst::FlowReturn queue_buffer(const Glib::RefPtr<Gst::AggregatorPad>& pad,
+    const Glib::RefPtr<Gst::Buffer>& buffer);
+
+  Gst::FlowReturn on_chain(const Glib::RefPtr<Gst::Pad>& pad, Glib::RefPtr<Gst::Buffer>& buffer);
+  gboolean on_sink_event(const Glib::RefPtr<Gst::Pad>& pad, Glib::RefPtr<Gst::Event>& event);
+  gboolean on_sink_query(const Glib::RefPtr<Gst::Pad>& pad, Glib::RefPtr<Gst::Query>& query);
+  gboolean on_src_event(const Glib::RefPtr<Gst::Pad>& pad, Glib::RefPtr<Gst::Event>& event);
+  gboolean on_src_query(const Glib::RefPtr<Gst::Pad>& pad, Glib::RefPtr<Gst::Query>& query);
+  bool on_src_activate_mode(const Glib::RefPtr<Gst::Pad>& pad, Gst::PadMode mode, bool active);
+
+  Glib::Property<guint64> latency_property_;
+  Glib::RefPtr<Gst::Pad> src_pad_;
+
+  // Protects the state below, and the state of the pads.
+  mutable std::mutex mutex_;
+  // Signaled when a pad gets a buffer or an event which may make the
+  // aggregator ready, and when flushing.
+  std::condition_variable data_;
+  std::vector<Glib::RefPtr<Gst::AggregatorPad>> sink_pads_;
+  guint next_pad_index_;
+  // Whether the source pad is active.
+  bool active_;
+  // Whether a flush is in progress, from the first flush-start received on
+  // a sink pad to the last flush-stop.
+  bool flushing_;
+  guint flushing_pads_;
+  // The last result of the streaming thread, returned to the inputs.
+  Gst::FlowReturn flow_return_;
+  // The single-shot clock id of the live timeout being waited for.
+  GstClockID clock_id_;
+
+  bool live_;
+  bool latency_known_;
+  Gst::ClockTime upstream_min_latency_;
+  Gst::ClockTime upstream_max_latency_;
+  Gst::ClockTime sub_min_latency_;
+  Gst::ClockTime sub_max_latency_;
+
+  bool send_stream_start_;
+  bool send_segment_;
+  Glib::RefPtr<Gst::Caps> pending_caps_;
+  // The merged tags of the inputs, sent before the next buffer if they
+  // changed.
+  GstTagList* tags_;
+  bool send_tags_;
+  GstSegment src_segment_;
+  Gst::ClockTime position_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_AGGREGATOR_H */
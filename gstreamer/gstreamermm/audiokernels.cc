@@ -0,0 +1,1151 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/audiokernels.h>
+#include <gstreamermm/handle_error.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define GSTREAMERMM_AUDIO_KERNELS_SSE2 1
+#include <emmintrin.h>
+// AVX2 code is compiled with a target attribute and selected at run time,
+// which needs GCC or Clang.
+#if defined(__GNUC__)
+#define GSTREAMERMM_AUDIO_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__)
+#define GSTREAMERMM_AUDIO_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+
+// The scalar kernels define the results; the SIMD kernels perform the same
+// operations in the same precision, and round to nearest even like lrint()
+// in the default rounding mode.
+
+// Clamps like _mm_max_ps() and _mm_min_ps(): a NaN becomes @a lo.
+template<typename T>
+inline T clamp(T x, T lo, T hi)
+{
+  x = x > lo ? x : lo;
+  return x < hi ? x : hi;
+}
+
+const float s16_scale = 32768.0f;
+const double s32_scale = 2147483648.0;
+
+inline gint16 s16_from_float(float x)
+{
+  // The scaled value is in [-32768, 32768], saturate the top like
+  // _mm_packs_epi32().
+  return static_cast<gint16>(std::min(std::lrint(clamp(x, -1.0f, 1.0f) * s16_scale), 32767L));
+}
+
+inline gint32 s32_from_double(double x)
+{
+  return static_cast<gint32>(std::min(std::llrint(clamp(x, -1.0, 1.0) * s32_scale), 2147483647LL));
+}
+
+/* Scalar kernels */
+
+void gain_s16_scalar(gpointer data, gsize samples, double gain)
+{
+  gint16* const p = static_cast<gint16*>(data);
+  const float g = static_cast<float>(gain);
+
+  for(gsize i = 0; i < samples; ++i)
+    p[i] = static_cast<gint16>(std::lrint(clamp(p[i] * g, -32768.0f, 32767.0f)));
+}
+
+void gain_s32_scalar(gpointer data, gsize samples, double gain)
+{
+  gint32* const p = static_cast<gint32*>(data);
+
+  for(gsize i = 0; i < samples; ++i)
+    p[i] = static_cast<gint32>(std::llrint(clamp(p[i] * gain, -2147483648.0, 2147483647.0)));
+}
+
+template<typename T>
+void gain_float_scalar(gpointer data, gsize samples, double gain)
+{
+  T* const p = static_cast<T*>(data);
+  const T g = static_cast<T>(gain);
+
+  for(gsize i = 0; i < samples; ++i)
+    p[i] *= g;
+}
+
+// Mixes the samples from @a begin to @a end, also used for the tails of the
+// SIMD kernels.
+template<typename T, typename Acc>
+void mix_int_range(gpointer dest, const gconstpointer* sources, guint n_sources, gsize begin, gsize end)
+{
+  T* const out = static_cast<T*>(dest);
+
+  for(gsize i = begin; i < end; ++i)
+  {
+    Acc acc = 0;
+    for(guint s = 0; s < n_sources; ++s)
+      acc += static_cast<const T*>(sources[s])[i];
+
+    out[i] = static_cast<T>(clamp<Acc>(acc, std::numeric_limits<T>::min(), std::numeric_limits<T>::max()));
+  }
+}
+
+template<typename T>
+void mix_float_range(gpointer dest, const gconstpointer* sources, guint n_sources, gsize begin, gsize end)
+{
+  T* const out = static_cast<T*>(dest);
+
+  for(gsize i = begin; i < end; ++i)
+  {
+    T acc = static_cast<const T*>(sources[0])[i];
+    for(guint s = 1; s < n_sources; ++s)
+      acc += static_cast<const T*>(sources[s])[i];
+
+    out[i] = clamp<T>(acc, -1, 1);
+  }
+}
+
+template<typename T, typename Acc>
+void mix_int_scalar(gpointer dest, const gconstpointer* sources, guint n_sources, gsize samples)
+{
+  mix_int_range<T, Acc>(dest, sources, n_sources, 0, samples);
+}
+
+template<typename T>
+void mix_float_scalar(gpointer dest, const gconstpointer* sources, guint n_sources, gsize samples)
+{
+  mix_float_range<T>(dest, sources, n_sources, 0, samples);
+}
+
+void measure_s16_scalar(gconstpointer data, gsize samples, double& peak, double& sum_squares)
+{
+  const gint16* const p = static_cast<const gint16*>(data);
+  int max = 0;
+  guint64 sum = 0;
+
+  for(gsize i = 0; i < samples; ++i)
+  {
+    const int s = p[i];
+    max = std::max(max, std::abs(s));
+    sum += static_cast<guint64>(s * s);
+  }
+
+  peak = max;
+  sum_squares = static_cast<double>(sum);
+}
+
+template<typename T>
+void measure_scalar(gconstpointer data, gsize samples, double& peak, double& sum_squares)
+{
+  const T* const p = static_cast<const T*>(data);
+  double max = 0.0;
+  double sum = 0.0;
+
+  for(gsize i = 0; i < samples; ++i)
+  {
+    const double s = p[i];
+    max = std::max(max, std::fabs(s));
+    sum += s * s;
+  }
+
+  peak = max;
+  sum_squares = sum;
+}
+
+void convert_s16_f32_scalar(gconstpointer src, gpointer dest, gsize samples)
+{
+  const gint16* const in = static_cast<const gint16*>(src);
+  float* const out = static_cast<float*>(dest);
+
+  for(gsize i = 0; i < samples; ++i)
+    out[i] = in[i] * (1.0f / s16_scale);
+}
+
+void convert_f32_s16_scalar(gconstpointer src, gpointer dest, gsize samples)
+{
+  const float* const in = static_cast<const float*>(src);
+  gint16* const out = static_cast<gint16*>(dest);
+
+  for(gsize i = 0; i < samples; ++i)
+    out[i] = s16_from_float(in[i]);
+}
+
+// The conversions without an optimized kernel go through a normalized
+// double.
+double load_sample(GstAudioFormat format, gconstpointer data, gsize i)
+{
+  switch(format)
+  {
+    case GST_AUDIO_FORMAT_S16:
+      return static_cast<const gint16*>(data)[i] / static_cast<double>(s16_scale);
+    case GST_AUDIO_FORMAT_S32:
+      return static_cast<const gint32*>(data)[i] / s32_scale;
+    case GST_AUDIO_FORMAT_F32:
+      return static_cast<const float*>(data)[i];
+    default:
+      return static_cast<const double*>(data)[i];
+  }
+}
+
+void store_sample(GstAudioFormat format, gpointer data, gsize i, double x)
+{
+  switch(format)
+  {
+    case GST_AUDIO_FORMAT_S16:
+      static_cast<gint16*>(data)[i] =
+        static_cast<gint16>(std::min(std::llrint(clamp(x, -1.0, 1.0) * s16_scale), 32767LL));
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      static_cast<gint32*>(data)[i] = s32_from_double(x);
+      break;
+    case GST_AUDIO_FORMAT_F32:
+      static_cast<float*>(data)[i] = static_cast<float>(x);
+      break;
+    default:
+      static_cast<double*>(data)[i] = x;
+      break;
+  }
+}
+
+template<typename T>
+void deinterleave_scalar(gconstpointer src, const gpointer* planes, int channels, gsize frames)
+{
+  const T* in = static_cast<const T*>(src);
+
+  for(int c = 0; c < channels; ++c)
+  {
+    T* const out = static_cast<T*>(planes[c]);
+    for(gsize i = 0; i < frames; ++i)
+      out[i] = in[i * channels + c];
+  }
+}
+
+template<typename T>
+void interleave_scalar(const gconstpointer* planes, gpointer dest, int channels, gsize frames)
+{
+  T* const out = static_cast<T*>(dest);
+
+  for(int c = 0; c < channels; ++c)
+  {
+    const T* const in = static_cast<const T*>(planes[c]);
+    for(gsize i = 0; i < frames; ++i)
+      out[i * channels + c] = in[i];
+  }
+}
+
+#ifdef GSTREAMERMM_AUDIO_KERNELS_SSE2
+
+/* SSE2 kernels */
+
+inline __m128i sse2_s16_to_s32_lo(__m128i v)
+{
+  return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+}
+
+inline __m128i sse2_s16_to_s32_hi(__m128i v)
+{
+  return _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+}
+
+void gain_f32_sse2(gpointer data, gsize samples, double gain)
+{
+  float* const p = static_cast<float*>(data);
+  const float g = static_cast<float>(gain);
+  const __m128 vg = _mm_set1_ps(g);
+  gsize i = 0;
+
+  for(; i + 4 <= samples; i += 4)
+    _mm_storeu_ps(p + i, _mm_mul_ps(_mm_loadu_ps(p + i), vg));
+
+  gain_float_scalar<float>(p + i, samples - i, gain);
+}
+
+void gain_s16_sse2(gpointer data, gsize samples, double gain)
+{
+  gint16* const p = static_cast<gint16*>(data);
+  const __m128 vg = _mm_set1_ps(static_cast<float>(gain));
+  const __m128 lo = _mm_set1_ps(-32768.0f);
+  const __m128 hi = _mm_set1_ps(32767.0f);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    __m128 f0 = _mm_mul_ps(_mm_cvtepi32_ps(sse2_s16_to_s32_lo(v)), vg);
+    __m128 f1 = _mm_mul_ps(_mm_cvtepi32_ps(sse2_s16_to_s32_hi(v)), vg);
+    f0 = _mm_min_ps(_mm_max_ps(f0, lo), hi);
+    f1 = _mm_min_ps(_mm_max_ps(f1, lo), hi);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i),
+      _mm_packs_epi32(_mm_cvtps_epi32(f0), _mm_cvtps_epi32(f1)));
+  }
+
+  gain_s16_scalar(p + i, samples - i, gain);
+}
+
+void mix_f32_sse2(gpointer dest, const gconstpointer* sources, guint n_sources, gsize samples)
+{
+  float* const out = static_cast<float*>(dest);
+  const __m128 lo = _mm_set1_ps(-1.0f);
+  const __m128 hi = _mm_set1_ps(1.0f);
+  gsize i = 0;
+
+  for(; i + 4 <= samples; i += 4)
+  {
+    __m128 acc = _mm_loadu_ps(static_cast<const float*>(sources[0]) + i);
+    for(guint s = 1; s < n_sources; ++s)
+      acc = _mm_add_ps(acc, _mm_loadu_ps(static_cast<const float*>(sources[s]) + i));
+
+    _mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(acc, lo), hi));
+  }
+
+  mix_float_range<float>(out, sources, n_sources, i, samples);
+}
+
+void mix_s16_sse2(gpointer dest, const gconstpointer* sources, guint n_sources, gsize samples)
+{
+  gint16* const out = static_cast<gint16*>(dest);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    for(guint s = 0; s < n_sources; ++s)
+    {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(static_cast<const gint16*>(sources[s]) + i));
+      acc0 = _mm_add_epi32(acc0, sse2_s16_to_s32_lo(v));
+      acc1 = _mm_add_epi32(acc1, sse2_s16_to_s32_hi(v));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(acc0, acc1));
+  }
+
+  mix_int_range<gint16, int>(out, sources, n_sources, i, samples);
+}
+
+void measure_f32_sse2(gconstpointer data, gsize samples, double& peak, double& sum_squares)
+{
+  const float* const p = static_cast<const float*>(data);
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  __m128 max = _mm_setzero_ps();
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  gsize i = 0;
+
+  for(; i + 4 <= samples; i += 4)
+  {
+    const __m128 v = _mm_loadu_ps(p + i);
+    max = _mm_max_ps(max, _mm_and_ps(v, abs_mask));
+
+    const __m128d d0 = _mm_cvtps_pd(v);
+    const __m128d d1 = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+    sum0 = _mm_add_pd(sum0, _mm_mul_pd(d0, d0));
+    sum1 = _mm_add_pd(sum1, _mm_mul_pd(d1, d1));
+  }
+
+  float maxs[4];
+  double sums[2];
+  _mm_storeu_ps(maxs, max);
+  _mm_storeu_pd(sums, _mm_add_pd(sum0, sum1));
+
+  measure_scalar<float>(p + i, samples - i, peak, sum_squares);
+  peak = std::max(peak, static_cast<double>(std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]))));
+  sum_squares += sums[0] + sums[1];
+}
+
+void measure_s16_sse2(gconstpointer data, gsize samples, double& peak, double& sum_squares)
+{
+  const gint16* const p = static_cast<const gint16*>(data);
+  const __m128i zero = _mm_setzero_si128();
+  __m128i max = zero;
+  __m128i min = zero;
+  __m128i sum = zero;
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    max = _mm_max_epi16(max, v);
+    min = _mm_min_epi16(min, v);
+
+    // The sums of two squares fit in 32 unsigned bits, accumulate them in
+    // 64 bits.
+    const __m128i squares = _mm_madd_epi16(v, v);
+    sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(squares, zero));
+    sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(squares, zero));
+  }
+
+  gint16 maxs[8], mins[8];
+  guint64 sums[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(maxs), max);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(mins), min);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(sums), sum);
+
+  measure_s16_scalar(p + i, samples - i, peak, sum_squares);
+  for(int k = 0; k < 8; ++k)
+    peak = std::max(peak, static_cast<double>(std::max<int>(maxs[k], -mins[k])));
+  sum_squares += static_cast<double>(sums[0] + sums[1]);
+}
+
+void convert_s16_f32_sse2(gconstpointer src, gpointer dest, gsize samples)
+{
+  const gint16* const in = static_cast<const gint16*>(src);
+  float* const out = static_cast<float*>(dest);
+  const __m128 scale = _mm_set1_ps(1.0f / s16_scale);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(sse2_s16_to_s32_lo(v)), scale));
+    _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(sse2_s16_to_s32_hi(v)), scale));
+  }
+
+  convert_s16_f32_scalar(in + i, out + i, samples - i);
+}
+
+void convert_f32_s16_sse2(gconstpointer src, gpointer dest, gsize samples)
+{
+  const float* const in = static_cast<const float*>(src);
+  gint16* const out = static_cast<gint16*>(dest);
+  const __m128 lo = _mm_set1_ps(-1.0f);
+  const __m128 hi = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(s16_scale);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    const __m128 f0 = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), lo), hi), scale);
+    const __m128 f1 = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), lo), hi), scale);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+      _mm_packs_epi32(_mm_cvtps_epi32(f0), _mm_cvtps_epi32(f1)));
+  }
+
+  convert_f32_s16_scalar(in + i, out + i, samples - i);
+}
+
+#endif /* GSTREAMERMM_AUDIO_KERNELS_SSE2 */
+
+#ifdef GSTREAMERMM_AUDIO_KERNELS_AVX2
+
+/* AVX2 kernels */
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET inline __m128i avx2_pack_s32(__m256i v)
+{
+  return _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+AVX2_TARGET void gain_f32_avx2(gpointer data, gsize samples, double gain)
+{
+  float* const p = static_cast<float*>(data);
+  const __m256 vg = _mm256_set1_ps(static_cast<float>(gain));
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+    _mm256_storeu_ps(p + i, _mm256_mul_ps(_mm256_loadu_ps(p + i), vg));
+
+  gain_float_scalar<float>(p + i, samples - i, gain);
+}
+
+AVX2_TARGET void gain_s16_avx2(gpointer data, gsize samples, double gain)
+{
+  gint16* const p = static_cast<gint16*>(data);
+  const __m256 vg = _mm256_set1_ps(static_cast<float>(gain));
+  const __m256 lo = _mm256_set1_ps(-32768.0f);
+  const __m256 hi = _mm256_set1_ps(32767.0f);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    const __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+    __m256 f = _mm256_mul_ps(_mm256_cvtepi32_ps(v), vg);
+    f = _mm256_min_ps(_mm256_max_ps(f, lo), hi);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), avx2_pack_s32(_mm256_cvtps_epi32(f)));
+  }
+
+  gain_s16_scalar(p + i, samples - i, gain);
+}
+
+AVX2_TARGET void mix_f32_avx2(gpointer dest, const gconstpointer* sources, guint n_sources, gsize samples)
+{
+  float* const out = static_cast<float*>(dest);
+  const __m256 lo = _mm256_set1_ps(-1.0f);
+  const __m256 hi = _mm256_set1_ps(1.0f);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    __m256 acc = _mm256_loadu_ps(static_cast<const float*>(sources[0]) + i);
+    for(guint s = 1; s < n_sources; ++s)
+      acc = _mm256_add_ps(acc, _mm256_loadu_ps(static_cast<const float*>(sources[s]) + i));
+
+    _mm256_storeu_ps(out + i, _mm256_min_ps(_mm256_max_ps(acc, lo), hi));
+  }
+
+  mix_float_range<float>(out, sources, n_sources, i, samples);
+}
+
+AVX2_TARGET void mix_s16_avx2(gpointer dest, const gconstpointer* sources, guint n_sources, gsize samples)
+{
+  gint16* const out = static_cast<gint16*>(dest);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    __m256i acc = _mm256_setzero_si256();
+    for(guint s = 0; s < n_sources; ++s)
+    {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(static_cast<const gint16*>(sources[s]) + i));
+      acc = _mm256_add_epi32(acc, _mm256_cvtepi16_epi32(v));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), avx2_pack_s32(acc));
+  }
+
+  mix_int_range<gint16, int>(out, sources, n_sources, i, samples);
+}
+
+AVX2_TARGET void measure_f32_avx2(gconstpointer data, gsize samples, double& peak, double& sum_squares)
+{
+  const float* const p = static_cast<const float*>(data);
+  const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  __m256 max = _mm256_setzero_ps();
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    const __m256 v = _mm256_loadu_ps(p + i);
+    max = _mm256_max_ps(max, _mm256_and_ps(v, abs_mask));
+
+    const __m256d d0 = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+    const __m256d d1 = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+    sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(d0, d0));
+    sum1 = _mm256_add_pd(sum1, _mm256_mul_pd(d1, d1));
+  }
+
+  float maxs[8];
+  double sums[4];
+  _mm256_storeu_ps(maxs, max);
+  _mm256_storeu_pd(sums, _mm256_add_pd(sum0, sum1));
+
+  measure_scalar<float>(p + i, samples - i, peak, sum_squares);
+  for(int k = 0; k < 8; ++k)
+    peak = std::max(peak, static_cast<double>(maxs[k]));
+  sum_squares += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+AVX2_TARGET void measure_s16_avx2(gconstpointer data, gsize samples, double& peak, double& sum_squares)
+{
+  const gint16* const p = static_cast<const gint16*>(data);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i max = zero;
+  __m256i min = zero;
+  __m256i sum = zero;
+  gsize i = 0;
+
+  for(; i + 16 <= samples; i += 16)
+  {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    max = _mm256_max_epi16(max, v);
+    min = _mm256_min_epi16(min, v);
+
+    const __m256i squares = _mm256_madd_epi16(v, v);
+    sum = _mm256_add_epi64(sum, _mm256_unpacklo_epi32(squares, zero));
+    sum = _mm256_add_epi64(sum, _mm256_unpackhi_epi32(squares, zero));
+  }
+
+  gint16 maxs[16], mins[16];
+  guint64 sums[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(maxs), max);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(mins), min);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), sum);
+
+  measure_s16_scalar(p + i, samples - i, peak, sum_squares);
+  for(int k = 0; k < 16; ++k)
+    peak = std::max(peak, static_cast<double>(std::max<int>(maxs[k], -mins[k])));
+  sum_squares += static_cast<double>(sums[0] + sums[1] + sums[2] + sums[3]);
+}
+
+AVX2_TARGET void convert_s16_f32_avx2(gconstpointer src, gpointer dest, gsize samples)
+{
+  const gint16* const in = static_cast<const gint16*>(src);
+  float* const out = static_cast<float*>(dest);
+  const __m256 scale = _mm256_set1_ps(1.0f / s16_scale);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    const __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+  }
+
+  convert_s16_f32_scalar(in + i, out + i, samples - i);
+}
+
+AVX2_TARGET void convert_f32_s16_avx2(gconstpointer src, gpointer dest, gsize samples)
+{
+  const float* const in = static_cast<const float*>(src);
+  gint16* const out = static_cast<gint16*>(dest);
+  const __m256 lo = _mm256_set1_ps(-1.0f);
+  const __m256 hi = _mm256_set1_ps(1.0f);
+  const __m256 scale = _mm256_set1_ps(s16_scale);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    const __m256 f = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i), lo), hi), scale);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), avx2_pack_s32(_mm256_cvtps_epi32(f)));
+  }
+
+  convert_f32_s16_scalar(in + i, out + i, samples - i);
+}
+
+#undef AVX2_TARGET
+
+#endif /* GSTREAMERMM_AUDIO_KERNELS_AVX2 */
+
+#ifdef GSTREAMERMM_AUDIO_KERNELS_NEON
+
+/* NEON kernels */
+
+// vmaxnmq_f32() and vminnmq_f32() return the number if one operand is NaN,
+// which gives the same clamping as the scalar kernels.
+inline float32x4_t neon_clamp(float32x4_t x, float32x4_t lo, float32x4_t hi)
+{
+  return vminnmq_f32(vmaxnmq_f32(x, lo), hi);
+}
+
+void gain_f32_neon(gpointer data, gsize samples, double gain)
+{
+  float* const p = static_cast<float*>(data);
+  const float g = static_cast<float>(gain);
+  gsize i = 0;
+
+  for(; i + 4 <= samples; i += 4)
+    vst1q_f32(p + i, vmulq_n_f32(vld1q_f32(p + i), g));
+
+  gain_float_scalar<float>(p + i, samples - i, gain);
+}
+
+void gain_s16_neon(gpointer data, gsize samples, double gain)
+{
+  gint16* const p = static_cast<gint16*>(data);
+  const float g = static_cast<float>(gain);
+  const float32x4_t lo = vdupq_n_f32(-32768.0f);
+  const float32x4_t hi = vdupq_n_f32(32767.0f);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    const int16x8_t v = vld1q_s16(p + i);
+    const float32x4_t f0 = neon_clamp(vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), g), lo, hi);
+    const float32x4_t f1 = neon_clamp(vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), g), lo, hi);
+    vst1q_s16(p + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(f0)), vqmovn_s32(vcvtnq_s32_f32(f1))));
+  }
+
+  gain_s16_scalar(p + i, samples - i, gain);
+}
+
+void mix_f32_neon(gpointer dest, const gconstpointer* sources, guint n_sources, gsize samples)
+{
+  float* const out = static_cast<float*>(dest);
+  const float32x4_t lo = vdupq_n_f32(-1.0f);
+  const float32x4_t hi = vdupq_n_f32(1.0f);
+  gsize i = 0;
+
+  for(; i + 4 <= samples; i += 4)
+  {
+    float32x4_t acc = vld1q_f32(static_cast<const float*>(sources[0]) + i);
+    for(guint s = 1; s < n_sources; ++s)
+      acc = vaddq_f32(acc, vld1q_f32(static_cast<const float*>(sources[s]) + i));
+
+    vst1q_f32(out + i, neon_clamp(acc, lo, hi));
+  }
+
+  mix_float_range<float>(out, sources, n_sources, i, samples);
+}
+
+void mix_s16_neon(gpointer dest, const gconstpointer* sources, guint n_sources, gsize samples)
+{
+  gint16* const out = static_cast<gint16*>(dest);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    int32x4_t acc0 = vdupq_n_s32(0);
+    int32x4_t acc1 = vdupq_n_s32(0);
+    for(guint s = 0; s < n_sources; ++s)
+    {
+      const int16x8_t v = vld1q_s16(static_cast<const gint16*>(sources[s]) + i);
+      acc0 = vaddw_s16(acc0, vget_low_s16(v));
+      acc1 = vaddw_s16(acc1, vget_high_s16(v));
+    }
+
+    vst1q_s16(out + i, vcombine_s16(vqmovn_s32(acc0), vqmovn_s32(acc1)));
+  }
+
+  mix_int_range<gint16, int>(out, sources, n_sources, i, samples);
+}
+
+void measure_f32_neon(gconstpointer data, gsize samples, double& peak, double& sum_squares)
+{
+  const float* const p = static_cast<const float*>(data);
+  float32x4_t max = vdupq_n_f32(0.0f);
+  float64x2_t sum0 = vdupq_n_f64(0.0);
+  float64x2_t sum1 = vdupq_n_f64(0.0);
+  gsize i = 0;
+
+  for(; i + 4 <= samples; i += 4)
+  {
+    const float32x4_t v = vld1q_f32(p + i);
+    max = vmaxq_f32(max, vabsq_f32(v));
+
+    const float64x2_t d0 = vcvt_f64_f32(vget_low_f32(v));
+    const float64x2_t d1 = vcvt_high_f64_f32(v);
+    sum0 = vaddq_f64(sum0, vmulq_f64(d0, d0));
+    sum1 = vaddq_f64(sum1, vmulq_f64(d1, d1));
+  }
+
+  measure_scalar<float>(p + i, samples - i, peak, sum_squares);
+  peak = std::max(peak, static_cast<double>(vmaxvq_f32(max)));
+  sum_squares += vaddvq_f64(vaddq_f64(sum0, sum1));
+}
+
+void measure_s16_neon(gconstpointer data, gsize samples, double& peak, double& sum_squares)
+{
+  const gint16* const p = static_cast<const gint16*>(data);
+  int16x8_t max = vdupq_n_s16(0);
+  int16x8_t min = vdupq_n_s16(0);
+  uint64x2_t sum = vdupq_n_u64(0);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    const int16x8_t v = vld1q_s16(p + i);
+    max = vmaxq_s16(max, v);
+    min = vminq_s16(min, v);
+
+    // A square fits in 31 bits, accumulate pairs of them in 64 bits.
+    sum = vpadalq_u32(sum, vreinterpretq_u32_s32(vmull_s16(vget_low_s16(v), vget_low_s16(v))));
+    sum = vpadalq_u32(sum, vreinterpretq_u32_s32(vmull_high_s16(v, v)));
+  }
+
+  measure_s16_scalar(p + i, samples - i, peak, sum_squares);
+  peak = std::max(peak, static_cast<double>(std::max<int>(vmaxvq_s16(max), -vminvq_s16(min))));
+  sum_squares += static_cast<double>(vaddvq_u64(sum));
+}
+
+void convert_s16_f32_neon(gconstpointer src, gpointer dest, gsize samples)
+{
+  const gint16* const in = static_cast<const gint16*>(src);
+  float* const out = static_cast<float*>(dest);
+  const float scale = 1.0f / s16_scale;
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    const int16x8_t v = vld1q_s16(in + i);
+    vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+    vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_high_s16(v)), scale));
+  }
+
+  convert_s16_f32_scalar(in + i, out + i, samples - i);
+}
+
+void convert_f32_s16_neon(gconstpointer src, gpointer dest, gsize samples)
+{
+  const float* const in = static_cast<const float*>(src);
+  gint16* const out = static_cast<gint16*>(dest);
+  const float32x4_t lo = vdupq_n_f32(-1.0f);
+  const float32x4_t hi = vdupq_n_f32(1.0f);
+  gsize i = 0;
+
+  for(; i + 8 <= samples; i += 8)
+  {
+    const float32x4_t f0 = vmulq_n_f32(neon_clamp(vld1q_f32(in + i), lo, hi), s16_scale);
+    const float32x4_t f1 = vmulq_n_f32(neon_clamp(vld1q_f32(in + i + 4), lo, hi), s16_scale);
+    vst1q_s16(out + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(f0)), vqmovn_s32(vcvtnq_s32_f32(f1))));
+  }
+
+  convert_f32_s16_scalar(in + i, out + i, samples - i);
+}
+
+#endif /* GSTREAMERMM_AUDIO_KERNELS_NEON */
+
+int format_width(GstAudioFormat format)
+{
+  switch(format)
+  {
+    case GST_AUDIO_FORMAT_S16:
+      return 2;
+    case GST_AUDIO_FORMAT_S32:
+    case GST_AUDIO_FORMAT_F32:
+      return 4;
+    default:
+      return 8;
+  }
+}
+
+double format_scale(GstAudioFormat format)
+{
+  switch(format)
+  {
+    case GST_AUDIO_FORMAT_S16:
+      return s16_scale;
+    case GST_AUDIO_FORMAT_S32:
+      return s32_scale;
+    default:
+      return 1.0;
+  }
+}
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+AudioKernels::AudioKernels(const Gst::AudioInfo& info, AudioKernelsIsa isa)
+{
+  select(GST_AUDIO_INFO_FORMAT(info.gobj()), info.get_channels(), isa,
+    GST_AUDIO_INFO_LAYOUT(info.gobj()));
+}
+
+AudioKernels::AudioKernels(Gst::AudioFormat format, int channels, AudioKernelsIsa isa,
+  Gst::AudioLayout layout)
+{
+  select(static_cast<GstAudioFormat>(format), channels, isa, static_cast<GstAudioLayout>(layout));
+}
+
+void AudioKernels::select(GstAudioFormat format, int channels, AudioKernelsIsa isa, GstAudioLayout layout)
+{
+  if(!is_format_supported(static_cast<Gst::AudioFormat>(format)))
+    gstreamermm_handle_error(Glib::ustring("Gst::AudioKernels does not support the format ") +
+      gst_audio_format_to_string(format));
+
+  if(channels <= 0)
+    gstreamermm_handle_error("Gst::AudioKernels needs at least one channel");
+
+  if(!is_isa_supported(isa))
+    isa = get_best_isa();
+
+  format_ = format;
+  channels_ = channels;
+  width_ = format_width(format);
+  layout_ = layout;
+  isa_ = isa;
+  fast_convert_ = nullptr;
+  fast_convert_format_ = GST_AUDIO_FORMAT_UNKNOWN;
+
+  switch(format)
+  {
+    case GST_AUDIO_FORMAT_S16:
+      gain_ = &gain_s16_scalar;
+      mix_ = &mix_int_scalar<gint16, int>;
+      measure_ = &measure_s16_scalar;
+      fast_convert_ = &convert_s16_f32_scalar;
+      fast_convert_format_ = GST_AUDIO_FORMAT_F32;
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      gain_ = &gain_s32_scalar;
+      mix_ = &mix_int_scalar<gint32, gint64>;
+      measure_ = &measure_scalar<gint32>;
+      break;
+    case GST_AUDIO_FORMAT_F32:
+      gain_ = &gain_float_scalar<float>;
+      mix_ = &mix_float_scalar<float>;
+      measure_ = &measure_scalar<float>;
+      fast_convert_ = &convert_f32_s16_scalar;
+      fast_convert_format_ = GST_AUDIO_FORMAT_S16;
+      break;
+    default:
+      gain_ = &gain_float_scalar<double>;
+      mix_ = &mix_float_scalar<double>;
+      measure_ = &measure_scalar<double>;
+      break;
+  }
+
+  switch(isa)
+  {
+#ifdef GSTREAMERMM_AUDIO_KERNELS_SSE2
+    case AUDIO_KERNELS_ISA_SSE2:
+      if(format == GST_AUDIO_FORMAT_S16)
+      {
+        gain_ = &gain_s16_sse2;
+        mix_ = &mix_s16_sse2;
+        measure_ = &measure_s16_sse2;
+        fast_convert_ = &convert_s16_f32_sse2;
+      }
+      else if(format == GST_AUDIO_FORMAT_F32)
+      {
+        gain_ = &gain_f32_sse2;
+        mix_ = &mix_f32_sse2;
+        measure_ = &measure_f32_sse2;
+        fast_convert_ = &convert_f32_s16_sse2;
+      }
+      break;
+#endif
+#ifdef GSTREAMERMM_AUDIO_KERNELS_AVX2
+    case AUDIO_KERNELS_ISA_AVX2:
+      if(format == GST_AUDIO_FORMAT_S16)
+      {
+        gain_ = &gain_s16_avx2;
+        mix_ = &mix_s16_avx2;
+        measure_ = &measure_s16_avx2;
+        fast_convert_ = &convert_s16_f32_avx2;
+      }
+      else if(format == GST_AUDIO_FORMAT_F32)
+      {
+        gain_ = &gain_f32_avx2;
+        mix_ = &mix_f32_avx2;
+        measure_ = &measure_f32_avx2;
+        fast_convert_ = &convert_f32_s16_avx2;
+      }
+      break;
+#endif
+#ifdef GSTREAMERMM_AUDIO_KERNELS_NEON
+    case AUDIO_KERNELS_ISA_NEON:
+      if(format == GST_AUDIO_FORMAT_S16)
+      {
+        gain_ = &gain_s16_neon;
+        mix_ = &mix_s16_neon;
+        measure_ = &measure_s16_neon;
+        fast_convert_ = &convert_s16_f32_neon;
+      }
+      else if(format == GST_AUDIO_FORMAT_F32)
+      {
+        gain_ = &gain_f32_neon;
+        mix_ = &mix_f32_neon;
+        measure_ = &measure_f32_neon;
+        fast_convert_ = &convert_f32_s16_neon;
+      }
+      break;
+#endif
+    default:
+      break;
+  }
+}
+
+AudioKernelsIsa AudioKernels::get_best_isa()
+{
+  if(is_isa_supported(AUDIO_KERNELS_ISA_AVX2))
+    return AUDIO_KERNELS_ISA_AVX2;
+  if(is_isa_supported(AUDIO_KERNELS_ISA_SSE2))
+    return AUDIO_KERNELS_ISA_SSE2;
+  if(is_isa_supported(AUDIO_KERNELS_ISA_NEON))
+    return AUDIO_KERNELS_ISA_NEON;
+
+  return AUDIO_KERNELS_ISA_SCALAR;
+}
+
+bool AudioKernels::is_isa_supported(AudioKernelsIsa isa)
+{
+  switch(isa)
+  {
+    case AUDIO_KERNELS_ISA_SCALAR:
+      return true;
+#ifdef GSTREAMERMM_AUDIO_KERNELS_SSE2
+    case AUDIO_KERNELS_ISA_SSE2:
+      return true;
+#endif
+#ifdef GSTREAMERMM_AUDIO_KERNELS_AVX2
+    case AUDIO_KERNELS_ISA_AVX2:
+    {
+      static const bool supported = __builtin_cpu_supports("avx2");
+      return supported;
+    }
+#endif
+#ifdef GSTREAMERMM_AUDIO_KERNELS_NEON
+    case AUDIO_KERNELS_ISA_NEON:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+const char* AudioKernels::get_isa_name(AudioKernelsIsa isa)
+{
+  switch(isa)
+  {
+    case AUDIO_KERNELS_ISA_SSE2:
+      return "sse2";
+    case AUDIO_KERNELS_ISA_AVX2:
+      return "avx2";
+    case AUDIO_KERNELS_ISA_NEON:
+      return "neon";
+    default:
+      return "scalar";
+  }
+}
+
+bool AudioKernels::is_format_supported(Gst::AudioFormat format)
+{
+  switch(static_cast<GstAudioFormat>(format))
+  {
+    case GST_AUDIO_FORMAT_S16:
+    case GST_AUDIO_FORMAT_S32:
+    case GST_AUDIO_FORMAT_F32:
+    case GST_AUDIO_FORMAT_F64:
+      return true;
+    default:
+      return false;
+  }
+}
+
+AudioKernelsIsa AudioKernels::get_isa() const
+{
+  return isa_;
+}
+
+Gst::AudioFormat AudioKernels::get_format() const
+{
+  return static_cast<Gst::AudioFormat>(format_);
+}
+
+int AudioKernels::get_channels() const
+{
+  return channels_;
+}
+
+Gst::AudioLayout AudioKernels::get_layout() const
+{
+  return static_cast<Gst::AudioLayout>(layout_);
+}
+
+void AudioKernels::apply_gain(gpointer data, gsize frames, double gain) const
+{
+  gain_(data, frames * channels_, gain);
+}
+
+void AudioKernels::mix(gpointer dest, const gconstpointer* sources, guint n_sources, gsize frames) const
+{
+  if(!n_sources)
+  {
+    std::memset(dest, 0, frames * channels_ * width_);
+    return;
+  }
+
+  mix_(dest, sources, n_sources, frames * channels_);
+}
+
+void AudioKernels::convert(gconstpointer src, Gst::AudioFormat dest_format, gpointer dest, gsize frames) const
+{
+  const GstAudioFormat c_dest_format = static_cast<GstAudioFormat>(dest_format);
+  const gsize samples = frames * channels_;
+
+  if(!is_format_supported(dest_format))
+    gstreamermm_handle_error(Glib::ustring("Gst::AudioKernels does not support the format ") +
+      gst_audio_format_to_string(c_dest_format));
+
+  if(c_dest_format == format_)
+    std::memmove(dest, src, samples * width_);
+  else if(c_dest_format == fast_convert_format_)
+    fast_convert_(src, dest, samples);
+  else
+  {
+    for(gsize i = 0; i < samples; ++i)
+      store_sample(c_dest_format, dest, i, load_sample(format_, src, i));
+  }
+}
+
+void AudioKernels::deinterleave(gconstpointer src, const gpointer* planes, gsize frames) const
+{
+  switch(width_)
+  {
+    case 2:
+      deinterleave_scalar<gint16>(src, planes, channels_, frames);
+      break;
+    case 4:
+      deinterleave_scalar<gint32>(src, planes, channels_, frames);
+      break;
+    default:
+      deinterleave_scalar<gint64>(src, planes, channels_, frames);
+      break;
+  }
+}
+
+void AudioKernels::interleave(const gconstpointer* planes, gpointer dest, gsize frames) const
+{
+  switch(width_)
+  {
+    case 2:
+      interleave_scalar<gint16>(planes, dest, channels_, frames);
+      break;
+    case 4:
+      interleave_scalar<gint32>(planes, dest, channels_, frames);
+      break;
+    default:
+      interleave_scalar<gint64>(planes, dest, channels_, frames);
+      break;
+  }
+}
+
+void AudioKernels::measure(gconstpointer data, gsize frames, double& peak, double& rms) const
+{
+  const gsize samples = frames * channels_;
+  const double scale = format_scale(format_);
+  double sum_squares = 0.0;
+
+  peak = 0.0;
+  rms = 0.0;
+  if(!samples)
+    return;
+
+  measure_(data, samples, peak, sum_squares);
+  peak /= scale;
+  rms = std::sqrt(sum_squares / samples) / scale;
+}
+
+void AudioKernels::measure_channels(gconstpointer data, gsize frames, double* peaks, double* rms) const
+{
+  const bool planar = layout_ == GST_AUDIO_LAYOUT_NON_INTERLEAVED;
+  const gsize stride = planar ? 1 : channels_;
+
+  for(int c = 0; c < channels_; ++c)
+  {
+    const gsize first = planar ? c * frames : c;
+    double max = 0.0;
+    double sum = 0.0;
+
+    for(gsize i = 0; i < frames; ++i)
+    {
+      const double s = load_sample(format_, data, first + i * stride);
+      max = std::max(max, std::fabs(s));
+      sum += s * s;
+    }
+
+    peaks[c] = max;
+    rms[c] = frames ? std::sqrt(sum / frames) : 0.0;
+  }
+}
+
+} // namespace Gst
@@ -0,0 +1,199 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_AUDIOKERNELS_H
+#define _GSTREAMERMM_AUDIOKERNELS_H
+
+#include <gstreamermm/audioinfo.h>
+
+namespace Gst
+{
+
+/** The instruction sets Gst::AudioKernels can use.
+ */
+enum AudioKernelsIsa
+{
+  /** Portable C++, used on all hosts. */
+  AUDIO_KERNELS_ISA_SCALAR,
+  /** SSE2, available on all x86-64 hosts. */
+  AUDIO_KERNELS_ISA_SSE2,
+  /** AVX2, selected at run time when the CPU supports it. */
+  AUDIO_KERNELS_ISA_AVX2,
+  /** NEON, available on all AArch64 hosts. */
+  AUDIO_KERNELS_ISA_NEON
+};
+
+/**
+ * Gst::AudioKernels provides optimized sample loops for the common raw
+ * audio operations: gain, mixing with clipping, conversion between formats,
+ * interleaving and level measurement.
+ *
+ * The kernels for a format are selected once, when the object is created,
+ * typically in Gst::AudioFilter::setup_vfunc() from the negotiated
+ * Gst::AudioInfo. The calls on the streaming thread then go straight to the
+ * selected loop:
+ * @code
+ * bool MyFilter::setup_vfunc(const Gst::AudioInfo& info)
+ * {
+ *   kernels.reset(new Gst::AudioKernels(info));
+ *   return true;
+ * }
+ *
+ * Gst::FlowReturn MyFilter::transform_ip_vfunc(const Glib::RefPtr<Gst::Buffer>& buffer)
+ * {
+ *   Gst::MapInfo map;
+ *   buffer->map(map, Gst::MAP_READWRITE);
+ *   kernels->apply_gain(map.get_data(), map.get_size() / bpf, gain);
+ *   buffer->unmap(map);
+ *   return Gst::FLOW_OK;
+ * }
+ * @endcode
+ *
+ * The S16, S32, F32 and F64 formats in host byte order are supported, in
+ * both layouts. Gain, mixing, conversion and measurement treat a buffer as
+ * one array of samples, which is the same for both layouts; the planes of a
+ * non-interleaved buffer follow each other, as mapped by
+ * Gst::MappedAudioBuffer. The F32 and S16 kernels have SSE2, AVX2 and NEON
+ * variants; the best instruction set supported by the CPU is chosen at run
+ * time, with a portable fallback. All variants give the same results,
+ * except for rounding differences in the accumulated levels.
+ *
+ * Integer samples saturate instead of wrapping around, floating point
+ * samples are clipped to [-1.0, 1.0] when mixing.
+ */
+class AudioKernels
+{
+public:
+  /** Selects the kernels for the format and channels of @a info.
+   *
+   * @param info The negotiated audio format.
+   * @param isa The instruction set to use; it is lowered to the best one
+   * supported by the CPU.
+   *
+   * @throw std::runtime_error if the format is not supported.
+   */
+  explicit AudioKernels(const Gst::AudioInfo& info, AudioKernelsIsa isa = get_best_isa());
+
+  /** Selects the kernels for samples of @a format.
+   *
+   * @param format The sample format.
+   * @param channels The number of channels.
+   * @param isa The instruction set to use; it is lowered to the best one
+   * supported by the CPU.
+   * @param layout The layout of the samples.
+   *
+   * @throw std::runtime_error if the format is not supported.
+   */
+  AudioKernels(Gst::AudioFormat format, int channels, AudioKernelsIsa isa = get_best_isa(),
+    Gst::AudioLayout layout = Gst::AUDIO_LAYOUT_INTERLEAVED);
+
+  /** Returns the best instruction set supported by the CPU.
+   */
+  static AudioKernelsIsa get_best_isa();
+
+  /** Checks whether the CPU supports @a isa.
+   */
+  static bool is_isa_supported(AudioKernelsIsa isa);
+
+  /** Returns a short name of @a isa, such as "avx2".
+   */
+  static const char* get_isa_name(AudioKernelsIsa isa);
+
+  /** Checks whether Gst::AudioKernels supports @a format.
+   */
+  static bool is_format_supported(Gst::AudioFormat format);
+
+  /** Returns the instruction set used by the kernels.
+   */
+  AudioKernelsIsa get_isa() const;
+
+  /** Returns the sample format.
+   */
+  Gst::AudioFormat get_format() const;
+
+  /** Returns the number of channels.
+   */
+  int get_channels() const;
+
+  /** Returns the layout of the samples.
+   */
+  Gst::AudioLayout get_layout() const;
+
+  /** Multiplies @a frames frames at @a data with @a gain in place.
+   */
+  void apply_gain(gpointer data, gsize frames, double gain) const;
+
+  /** Adds @a n_sources buffers of @a frames frames each into @a dest,
+   * clipping the sums. @a dest may be one of the sources.
+   */
+  void mix(gpointer dest, const gconstpointer* sources, guint n_sources, gsize frames) const;
+
+  /** Converts @a frames frames at @a src to @a dest_format in @a dest.
+   *
+   * @throw std::runtime_error if @a dest_format is not supported.
+   */
+  void convert(gconstpointer src, Gst::AudioFormat dest_format, gpointer dest, gsize frames) const;
+
+  /** Splits @a frames interleaved frames at @a src into one plane per
+   * channel.
+   */
+  void deinterleave(gconstpointer src, const gpointer* planes, gsize frames) const;
+
+  /** Merges one plane per channel into @a frames interleaved frames at
+   * @a dest.
+   */
+  void interleave(const gconstpointer* planes, gpointer dest, gsize frames) const;
+
+  /** Measures the peak and RMS level over all channels, in the range
+   * [0.0, 1.0] for integer samples.
+   */
+  void measure(gconstpointer data, gsize frames, double& peak, double& rms) const;
+
+  /** Measures the peak and RMS level of each channel, in either layout.
+   * @a peaks and @a rms must have room for get_channels() values.
+   */
+  void measure_channels(gconstpointer data, gsize frames, double* peaks, double* rms) const;
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  typedef void (*GainFunc)(gpointer data, gsize samples, double gain);
+  typedef void (*MixFunc)(gpointer dest, const gconstpointer* sources, guint n_sources, gsize samples);
+  typedef void (*MeasureFunc)(gconstpointer data, gsize samples, double& peak, double& sum_squares);
+  typedef void (*ConvertFunc)(gconstpointer src, gpointer dest, gsize samples);
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+private:
+  void select(GstAudioFormat format, int channels, AudioKernelsIsa isa, GstAudioLayout layout);
+
+  GstAudioFormat format_;
+  int channels_;
+  int width_;
+  GstAudioLayout layout_;
+  AudioKernelsIsa isa_;
+  GainFunc gain_;
+  MixFunc mix_;
+  MeasureFunc measure_;
+  // The optimized conversion between S16 and F32, if the format is one of
+  // them.
+  ConvertFunc fast_convert_;
+  GstAudioFormat fast_convert_format_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_AUDIOKERNELS_H */
@@ -0,0 +1,373 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/audiolatencytuner.h>
+#include <algorithm>
+
+namespace
+{
+
+Gst::ClockTime get_monotonic_time()
+{
+  return g_get_monotonic_time() * GST_USECOND;
+}
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+AudioLatencyTuner::AudioLatencyTuner(ClockTime target_latency)
+: direction_(AUDIO_RING_BUFFER_PLAYBACK),
+  clock_slot_(sigc::ptr_fun(&get_monotonic_time)),
+  target_latency_(target_latency),
+  min_segment_time_(GST_MSECOND),
+  measure_periods_(100),
+  calibrated_(false),
+  jitter_(0),
+  device_latency_(0),
+  min_headroom_(0),
+  quantum_frames_(1),
+  xruns_seen_(0),
+  rate_(0),
+  bpf_(0),
+  segment_frames_(0),
+  segments_(0),
+  restart_(true),
+  window_calls_(0),
+  window_frames_(0),
+  window_start_(0),
+  window_min_lag_(0),
+  window_jitter_(0),
+  window_delay_(0)
+{}
+
+void AudioLatencyTuner::set_target_latency(ClockTime target_latency)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  target_latency_ = target_latency;
+}
+
+ClockTime AudioLatencyTuner::get_target_latency() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return target_latency_;
+}
+
+void AudioLatencyTuner::set_min_segment_time(ClockTime min_segment_time)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  min_segment_time_ = min_segment_time;
+}
+
+ClockTime AudioLatencyTuner::get_min_segment_time() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return min_segment_time_;
+}
+
+void AudioLatencyTuner::set_measure_periods(guint periods)
+{
+  measure_periods_.store(std::max(periods, 2u), std::memory_order_relaxed);
+}
+
+guint AudioLatencyTuner::get_measure_periods() const
+{
+  return measure_periods_.load(std::memory_order_relaxed);
+}
+
+void AudioLatencyTuner::set_clock_slot(const SlotClock& slot)
+{
+  clock_slot_ = slot;
+}
+
+void AudioLatencyTuner::attach(const Glib::RefPtr<CallbackAudioRingBuffer>& ring_buffer,
+  const CallbackAudioRingBuffer::SlotIO& io, const CallbackAudioRingBuffer::SlotPrepare& prepare,
+  const CallbackAudioRingBuffer::SlotDevice& unprepare, const CallbackAudioRingBuffer::SlotDelay& delay,
+  const CallbackAudioRingBuffer::SlotReset& reset)
+{
+  ring_buffer_ = ring_buffer;
+  direction_ = ring_buffer->get_direction();
+  io_slot_ = io;
+  prepare_slot_ = prepare;
+  unprepare_slot_ = unprepare;
+  delay_slot_ = delay;
+  reset_slot_ = reset;
+
+  ring_buffer->set_io_slot(sigc::mem_fun(*this, &AudioLatencyTuner::on_io));
+  ring_buffer->set_prepare_slots(sigc::mem_fun(*this, &AudioLatencyTuner::on_prepare),
+    sigc::mem_fun(*this, &AudioLatencyTuner::on_unprepare));
+  ring_buffer->set_delay_slot(delay);
+  ring_buffer->set_reset_slot(sigc::mem_fun(*this, &AudioLatencyTuner::on_reset));
+}
+
+bool AudioLatencyTuner::is_calibrated() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return calibrated_;
+}
+
+ClockTime AudioLatencyTuner::get_jitter() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return jitter_;
+}
+
+ClockTime AudioLatencyTuner::get_device_latency() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return device_latency_;
+}
+
+ClockTime AudioLatencyTuner::get_segment_time() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return segments_ ? frames_to_time(segment_frames_) : 0;
+}
+
+int AudioLatencyTuner::get_segments() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return segments_;
+}
+
+ClockTime AudioLatencyTuner::get_latency() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(!segments_)
+    return 0;
+
+  // Captured samples can be read as soon as their segment is complete.
+  const guint queued = direction_ == AUDIO_RING_BUFFER_PLAYBACK ? segments_ : 1;
+  return frames_to_time(static_cast<guint64>(queued) * segment_frames_) + device_latency_;
+}
+
+ClockTime AudioLatencyTuner::get_max_latency() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(!segments_)
+    return 0;
+
+  return frames_to_time(static_cast<guint64>(segments_) * segment_frames_) + device_latency_;
+}
+
+bool AudioLatencyTuner::is_target_met() const
+{
+  const ClockTime latency = get_latency();
+  return latency && latency <= get_target_latency();
+}
+
+bool AudioLatencyTuner::needs_retune() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(!segments_)
+    return false;
+
+  guint segment_frames = 0, segments = 0;
+  compute_layout(segment_frames, segments);
+  return segment_frames != segment_frames_ || segments != segments_;
+}
+
+void AudioLatencyTuner::add_to_query(const Glib::RefPtr<QueryLatency>& query) const
+{
+  bool live = false;
+  ClockTime min_latency = 0, max_latency = 0;
+  query->parse(live, min_latency, max_latency);
+
+  min_latency += get_latency();
+  if(max_latency != CLOCK_TIME_NONE)
+    max_latency += get_max_latency();
+
+  query->set(true, min_latency, max_latency);
+}
+
+void AudioLatencyTuner::reset()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  calibrated_ = false;
+  jitter_ = 0;
+  device_latency_ = 0;
+  min_headroom_ = 0;
+  quantum_frames_ = 1;
+  restart_.store(true, std::memory_order_relaxed);
+}
+
+int AudioLatencyTuner::on_io(guint8* data, guint length)
+{
+  const int done = io_slot_(data, length);
+  const ClockTime now = clock_slot_();
+  const guint delay = delay_slot_ ? delay_slot_() : 0;
+  const guint64 frames = done > 0 ? done / bpf_ : 0;
+
+  if(restart_.exchange(false, std::memory_order_relaxed))
+    window_calls_ = 0;
+
+  // The first call of a window is the reference the others are compared
+  // with: a backend keeping up completes its calls at the pace of the
+  // frames it processes.
+  if(!window_calls_)
+  {
+    window_start_ = now;
+    window_frames_ = 0;
+    window_min_lag_ = 0;
+    window_jitter_ = 0;
+    window_delay_ = delay;
+  }
+  else
+  {
+    window_frames_ += frames;
+    const gint64 lag = static_cast<gint64>(now - window_start_) -
+      static_cast<gint64>(frames_to_time(window_frames_));
+    window_min_lag_ = std::min(window_min_lag_, lag);
+    window_jitter_ = std::max<ClockTime>(window_jitter_, lag - window_min_lag_);
+    window_delay_ = std::max(window_delay_, delay);
+  }
+
+  if(++window_calls_ >= measure_periods_.load(std::memory_order_relaxed))
+    end_window();
+
+  return done;
+}
+
+bool AudioLatencyTuner::on_prepare(AudioRingBufferSpec& spec)
+{
+  const GstAudioInfo* const info = &spec.gobj()->info;
+  const int rate = GST_AUDIO_INFO_RATE(info);
+  const int bpf = GST_AUDIO_INFO_BPF(info);
+  if(rate <= 0 || bpf <= 0)
+    return false;
+
+  const guint delay = delay_slot_ ? delay_slot_() : 0;
+
+  guint segment_frames = 0, segments = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // The period of the backend is only known at the rate it was measured
+    // at.
+    if(rate != rate_)
+      quantum_frames_ = 1;
+
+    rate_ = rate;
+    bpf_ = bpf;
+    device_latency_ = std::max(device_latency_, frames_to_time(delay));
+    compute_layout(segment_frames, segments);
+  }
+
+  const guint64 segment_time = gst_util_uint64_scale(segment_frames, G_USEC_PER_SEC, rate);
+  spec.set_segsize(segment_frames * bpf);
+  spec.set_segtotal(segments);
+  spec.set_seglatency(segments);
+  spec.set_latency_time(segment_time);
+  spec.set_buffer_time(segment_time * segments);
+
+  if(prepare_slot_ && !prepare_slot_(spec))
+    return false;
+
+  const int segsize = spec.get_segsize();
+  if(segsize <= 0 || segsize % bpf || spec.get_segtotal() <= 0)
+    return false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  segment_frames_ = segsize / bpf;
+  segments_ = spec.get_segtotal();
+
+  // The backend rounded the segments to its own period.
+  if(segment_frames_ != segment_frames)
+    quantum_frames_ = segment_frames_;
+
+  // Only the xruns of this layout make the next one grow.
+  xruns_seen_ = ring_buffer_->get_underruns() + ring_buffer_->get_device_xruns();
+  restart_.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+bool AudioLatencyTuner::on_unprepare()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    segments_ = 0;
+  }
+
+  return unprepare_slot_ ? unprepare_slot_() : true;
+}
+
+void AudioLatencyTuner::on_reset()
+{
+  restart_.store(true, std::memory_order_relaxed);
+
+  if(reset_slot_)
+    reset_slot_();
+}
+
+void AudioLatencyTuner::end_window()
+{
+  const guint64 xruns = ring_buffer_->get_underruns() + ring_buffer_->get_device_xruns();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  calibrated_ = true;
+  jitter_ = std::max(jitter_, window_jitter_);
+  device_latency_ = std::max(device_latency_, frames_to_time(window_delay_));
+
+  // The queued time did not absorb the backend: queue one more segment.
+  if(xruns > xruns_seen_)
+    min_headroom_ = std::max(min_headroom_, frames_to_time(static_cast<guint64>(segments_) * segment_frames_));
+
+  // The counters may have been reset in the meantime.
+  xruns_seen_ = xruns;
+  window_calls_ = 0;
+}
+
+void AudioLatencyTuner::compute_layout(guint& segment_frames, guint& segments) const
+{
+  const ClockTime budget = target_latency_ > device_latency_ ? target_latency_ - device_latency_ : 0;
+  const ClockTime headroom = get_headroom();
+
+  // Capture only waits for one segment, the others absorb the jitter of the
+  // reader. Playback waits for all the segments: use as few as possible
+  // for the headroom to fit in the budget, and the largest ones which fit.
+  ClockTime segment_time = budget / 2;
+  if(direction_ == AUDIO_RING_BUFFER_CAPTURE)
+    segment_time = budget;
+  else if(headroom < budget)
+  {
+    const ClockTime spare = budget - headroom;
+    segment_time = budget / std::max<ClockTime>(2, (budget + spare - 1) / spare);
+  }
+
+  guint64 frames = gst_util_uint64_scale(segment_time, rate_, GST_SECOND);
+  frames = std::max(frames, gst_util_uint64_scale_ceil(min_segment_time_, rate_, GST_SECOND));
+  frames = std::max<guint64>(frames / quantum_frames_, 1) * quantum_frames_;
+  segment_frames = frames;
+
+  const ClockTime actual_time = frames_to_time(frames);
+  segments = std::max<guint64>(2, (headroom + actual_time - 1) / actual_time + 1);
+}
+
+ClockTime AudioLatencyTuner::get_headroom() const
+{
+  return std::max(jitter_ * 3 / 2, min_headroom_);
+}
+
+ClockTime AudioLatencyTuner::frames_to_time(guint64 frames) const
+{
+  return rate_ > 0 ? gst_util_uint64_scale(frames, GST_SECOND, rate_) : 0;
+}
+
+} // namespace Gst
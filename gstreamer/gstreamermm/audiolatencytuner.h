@@ -0,0 +1,253 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_AUDIOLATENCYTUNER_H
+#define _GSTREAMERMM_AUDIOLATENCYTUNER_H
+
+#include <gstreamermm/callbackaudioringbuffer.h>
+#include <gstreamermm/clockutils.h>
+#include <gstreamermm/query.h>
+#include <sigc++/trackable.h>
+#include <atomic>
+#include <mutex>
+
+namespace Gst
+{
+
+/**
+ * Gst::AudioLatencyTuner chooses the segment layout of a
+ * Gst::CallbackAudioRingBuffer for a target latency, from the timing of the
+ * device measured while it runs.
+ *
+ * The tuner is attached to the ring buffer in place of the device slots,
+ * which it calls itself. When the ring buffer is acquired, it writes the
+ * segment size and count into the Gst::AudioRingBufferSpec, before the
+ * prepare slot of the backend is called; the backend may still round the
+ * segment size to its own period, which is then used for later layouts.
+ *
+ * While the device runs, the tuner measures:
+ * - the jitter of the backend: how late the I/O calls complete compared to
+ *   the frames they processed, over windows of get_measure_periods() calls;
+ * - the device latency: the largest delay reported by the delay slot;
+ * - the xruns counted by the ring buffer.
+ *
+ * The playback layout keeps one and a half times the jitter queued in the
+ * segments which are not being processed, within the target latency minus
+ * the device latency; the capture layout uses segments of the target
+ * latency minus the device latency. Each time xruns are seen, the queued
+ * time of the next layout grows by one segment, even if the target latency
+ * cannot be met any more.
+ *
+ * The segments of an acquired ring buffer cannot change size, so a new
+ * layout takes effect when the ring buffer is acquired again, as
+ * Gst::AudioBaseSink and Gst::AudioBaseSrc do on caps changes and when going
+ * from READY to PAUSED. needs_retune() tells whether the layout in use
+ * differs from the one the tuner would choose now.
+ *
+ * @code
+ * Glib::RefPtr<Gst::AudioRingBuffer> MySink::create_ring_buffer_vfunc()
+ * {
+ *   Glib::RefPtr<Gst::CallbackAudioRingBuffer> ring_buffer =
+ *     Gst::CallbackAudioRingBuffer::create(Gst::AUDIO_RING_BUFFER_PLAYBACK);
+ *   tuner.attach(ring_buffer, sigc::mem_fun(*this, &MySink::write_to_device));
+ *   return ring_buffer;
+ * }
+ * @endcode
+ *
+ * The measurements are taken on the device side of the ring buffer; only a
+ * mutex guarding the results is locked, once per measurement window.
+ */
+class AudioLatencyTuner : public sigc::trackable
+{
+public:
+  /** For example,
+   * Gst::ClockTime on_clock();.
+   * The slot returns a monotonic time in nanoseconds.
+   */
+  typedef sigc::slot<Gst::ClockTime> SlotClock;
+
+  /** Creates a tuner for @a target_latency.
+   */
+  explicit AudioLatencyTuner(Gst::ClockTime target_latency = 20 * Gst::MILLI_SECOND);
+
+  /** Sets the latency the layouts aim at, including the device latency.
+   */
+  void set_target_latency(Gst::ClockTime target_latency);
+
+  /** Returns the latency the layouts aim at.
+   */
+  Gst::ClockTime get_target_latency() const;
+
+  /** Sets the shortest segment a layout may use. The default is 1 ms.
+   */
+  void set_min_segment_time(Gst::ClockTime min_segment_time);
+
+  /** Returns the shortest segment a layout may use.
+   */
+  Gst::ClockTime get_min_segment_time() const;
+
+  /** Sets the number of I/O calls of a measurement window. The default is
+   * 100.
+   */
+  void set_measure_periods(guint periods);
+
+  /** Returns the number of I/O calls of a measurement window.
+   */
+  guint get_measure_periods() const;
+
+  /** Sets the slot returning the time the I/O calls are measured with. The
+   * default is the monotonic time of GLib.
+   */
+  void set_clock_slot(const SlotClock& slot);
+
+  /** Attaches the tuner to @a ring_buffer, setting all its device slots
+   * except the open and close ones. The tuner calls the given slots, which
+   * may be empty except for @a io, in place of the ring buffer.
+   *
+   * The delay slot is also called to measure the device latency, when the
+   * ring buffer is acquired and after each I/O call.
+   *
+   * The ring buffer must not be acquired yet.
+   */
+  void attach(const Glib::RefPtr<Gst::CallbackAudioRingBuffer>& ring_buffer,
+    const Gst::CallbackAudioRingBuffer::SlotIO& io,
+    const Gst::CallbackAudioRingBuffer::SlotPrepare& prepare = Gst::CallbackAudioRingBuffer::SlotPrepare(),
+    const Gst::CallbackAudioRingBuffer::SlotDevice& unprepare = Gst::CallbackAudioRingBuffer::SlotDevice(),
+    const Gst::CallbackAudioRingBuffer::SlotDelay& delay = Gst::CallbackAudioRingBuffer::SlotDelay(),
+    const Gst::CallbackAudioRingBuffer::SlotReset& reset = Gst::CallbackAudioRingBuffer::SlotReset());
+
+  /** Returns whether a measurement window completed since the tuner was
+   * created or reset.
+   */
+  bool is_calibrated() const;
+
+  /** Returns the largest jitter of the backend measured so far.
+   */
+  Gst::ClockTime get_jitter() const;
+
+  /** Returns the largest device latency measured so far.
+   */
+  Gst::ClockTime get_device_latency() const;
+
+  /** Returns the duration of a segment of the ring buffer, or 0 if it is not
+   * acquired.
+   */
+  Gst::ClockTime get_segment_time() const;
+
+  /** Returns the number of segments of the ring buffer, or 0 if it is not
+   * acquired.
+   */
+  int get_segments() const;
+
+  /** Returns the minimum latency achieved by the acquired layout, including
+   * the device latency: all the segments for playback, one segment for
+   * capture.
+   */
+  Gst::ClockTime get_latency() const;
+
+  /** Returns the maximum latency of the acquired layout: all the segments
+   * and the device latency.
+   */
+  Gst::ClockTime get_max_latency() const;
+
+  /** Returns whether the latency of the acquired layout is within the
+   * target latency.
+   */
+  bool is_target_met() const;
+
+  /** Returns whether the tuner would choose a different layout if the ring
+   * buffer was acquired again.
+   */
+  bool needs_retune() const;
+
+  /** Adds the latency of the acquired layout to the latency already in
+   * @a query, and marks it as live.
+   *
+   * A source answers the query with its own latency:
+   * @code
+   * query->set(true, 0, 0);
+   * tuner.add_to_query(query);
+   * @endcode
+   * and a sink adds its latency to the answer of the upstream elements:
+   * @code
+   * if(get_static_pad("sink")->peer_query(query))
+   *   tuner.add_to_query(query);
+   * @endcode
+   */
+  void add_to_query(const Glib::RefPtr<Gst::QueryLatency>& query) const;
+
+  /** Forgets the measurements and the growth caused by xruns.
+   */
+  void reset();
+
+private:
+  int on_io(guint8* data, guint length);
+  bool on_prepare(Gst::AudioRingBufferSpec& spec);
+  bool on_unprepare();
+  void on_reset();
+
+  void end_window();
+  void compute_layout(guint& segment_frames, guint& segments) const;
+  Gst::ClockTime get_headroom() const;
+  Gst::ClockTime frames_to_time(guint64 frames) const;
+
+  Glib::RefPtr<Gst::CallbackAudioRingBuffer> ring_buffer_;
+  Gst::AudioRingBufferDirection direction_;
+  Gst::CallbackAudioRingBuffer::SlotIO io_slot_;
+  Gst::CallbackAudioRingBuffer::SlotPrepare prepare_slot_;
+  Gst::CallbackAudioRingBuffer::SlotDevice unprepare_slot_;
+  Gst::CallbackAudioRingBuffer::SlotDelay delay_slot_;
+  Gst::CallbackAudioRingBuffer::SlotReset reset_slot_;
+  SlotClock clock_slot_;
+
+  mutable std::mutex mutex_;
+  Gst::ClockTime target_latency_;
+  Gst::ClockTime min_segment_time_;
+  std::atomic<guint> measure_periods_;
+  bool calibrated_;
+  Gst::ClockTime jitter_;
+  Gst::ClockTime device_latency_;
+  // The queued time required after xruns.
+  Gst::ClockTime min_headroom_;
+  // The period of the backend, which segments are a multiple of.
+  guint quantum_frames_;
+  guint64 xruns_seen_;
+
+  // The acquired layout, only changed while the device side is stopped.
+  int rate_;
+  guint bpf_;
+  guint segment_frames_;
+  guint segments_;
+
+  // Set when the device stops, so that the pause is not measured.
+  std::atomic<bool> restart_;
+
+  // The current measurement window, only used by the device side.
+  guint window_calls_;
+  guint64 window_frames_;
+  Gst::ClockTime window_start_;
+  // How late the I/O calls completed, compared to the frames processed.
+  gint64 window_min_lag_;
+  Gst::ClockTime window_jitter_;
+  guint window_delay_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_AUDIOLATENCYTUNER_H */
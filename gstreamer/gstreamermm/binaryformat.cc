@@ -0,0 +1,797 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/binaryformat.h>
+#include <gstreamermm/handle_error.h>
+#include <cstring>
+
+/*
+ * Layout of an encoded object:
+ *
+ *   'G' 'B' <version> <kind> <body>
+ *
+ * where kind is 'S' (structure), 'C' (caps) or 'T' (tag list). Unsigned
+ * integers are LEB128 varints, signed integers are zigzag encoded varints,
+ * floating point numbers are stored as little endian IEEE 754. Strings are
+ * stored as varint (length + 1) followed by the bytes and a terminating
+ * zero, so that they can be used in place; a NULL string is stored as 0.
+ *
+ *   structure: <name> <n_fields> (<field name> <value>)*
+ *   caps:      <is_any> [<n_structures> (<structure> <features>)*]
+ *   tag list:  <scope> <n_tags> (<tag name> <n_values> <value>*)*
+ *   value:     <type tag> <payload>
+ */
+
+namespace
+{
+
+enum
+{
+  KIND_STRUCTURE = 'S',
+  KIND_CAPS = 'C',
+  KIND_TAGLIST = 'T'
+};
+
+enum
+{
+  VALUE_BOOLEAN,
+  VALUE_INT,
+  VALUE_UINT,
+  VALUE_INT64,
+  VALUE_UINT64,
+  VALUE_FLOAT,
+  VALUE_DOUBLE,
+  VALUE_STRING,
+  VALUE_FRACTION,
+  VALUE_INT_RANGE,
+  VALUE_INT64_RANGE,
+  VALUE_DOUBLE_RANGE,
+  VALUE_FRACTION_RANGE,
+  VALUE_ARRAY,
+  VALUE_LIST,
+  VALUE_STRUCTURE,
+  VALUE_CAPS,
+  VALUE_SERIALIZED,
+  VALUE_BUFFER
+};
+
+// Nesting limit, so that malformed data cannot exhaust the stack.
+const guint max_depth = 64;
+
+// Frees a value on scope exit unless its contents have been taken.
+class ValueHolder
+{
+public:
+  ValueHolder()
+  {
+    std::memset(&value, 0, sizeof(value));
+  }
+
+  ~ValueHolder()
+  {
+    if(G_IS_VALUE(&value))
+      g_value_unset(&value);
+  }
+
+  GValue value;
+};
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+/***************************** Gst::BinaryEncoder *****************************/
+
+BinaryEncoder::BinaryEncoder()
+: data_(nullptr), size_(0), position_(0)
+{}
+
+BinaryEncoder::BinaryEncoder(guint8* data, gsize size)
+: data_(data), size_(size), position_(0)
+{}
+
+void BinaryEncoder::encode(const StructureView& structure)
+{
+  put_header(KIND_STRUCTURE);
+  put_structure(structure.gobj());
+}
+
+void BinaryEncoder::encode(const Glib::RefPtr<const Gst::Caps>& caps)
+{
+  put_header(KIND_CAPS);
+  put_caps(caps->gobj());
+}
+
+void BinaryEncoder::encode(const Gst::TagList& tag_list)
+{
+  const GstTagList* list = tag_list.gobj();
+
+  put_header(KIND_TAGLIST);
+  put_byte(gst_tag_list_get_scope(list));
+
+  const gint n_tags = gst_tag_list_n_tags(list);
+  put_uint(n_tags);
+
+  for(gint i = 0; i < n_tags; ++i)
+  {
+    const gchar* tag = gst_tag_list_nth_tag_name(list, i);
+    const guint n_values = gst_tag_list_get_tag_size(list, tag);
+
+    put_string(tag);
+    put_uint(n_values);
+
+    for(guint j = 0; j < n_values; ++j)
+      put_value(gst_tag_list_get_value_index(const_cast<GstTagList*>(list), tag, j));
+  }
+}
+
+gsize BinaryEncoder::get_size() const
+{
+  return position_;
+}
+
+bool BinaryEncoder::is_complete() const
+{
+  return position_ <= size_;
+}
+
+void BinaryEncoder::reset()
+{
+  position_ = 0;
+}
+
+std::vector<guint8> BinaryEncoder::encode_to_vector(const StructureView& structure)
+{
+  BinaryEncoder sizer;
+  sizer.encode(structure);
+
+  std::vector<guint8> result(sizer.get_size());
+  BinaryEncoder encoder(result.data(), result.size());
+  encoder.encode(structure);
+  return result;
+}
+
+std::vector<guint8> BinaryEncoder::encode_to_vector(const Glib::RefPtr<const Gst::Caps>& caps)
+{
+  BinaryEncoder sizer;
+  sizer.encode(caps);
+
+  std::vector<guint8> result(sizer.get_size());
+  BinaryEncoder encoder(result.data(), result.size());
+  encoder.encode(caps);
+  return result;
+}
+
+std::vector<guint8> BinaryEncoder::encode_to_vector(const Gst::TagList& tag_list)
+{
+  BinaryEncoder sizer;
+  sizer.encode(tag_list);
+
+  std::vector<guint8> result(sizer.get_size());
+  BinaryEncoder encoder(result.data(), result.size());
+  encoder.encode(tag_list);
+  return result;
+}
+
+void BinaryEncoder::put_header(guint8 kind)
+{
+  put_byte('G');
+  put_byte('B');
+  put_byte(FORMAT_VERSION);
+  put_byte(kind);
+}
+
+void BinaryEncoder::put_byte(guint8 byte)
+{
+  if(position_ < size_)
+    data_[position_] = byte;
+  ++position_;
+}
+
+void BinaryEncoder::put_bytes(const void* bytes, gsize size)
+{
+  // Once something did not fit, position_ stays beyond size_, so nothing
+  // written later is stored either.
+  if(position_ + size <= size_)
+    std::memcpy(data_ + position_, bytes, size);
+  position_ += size;
+}
+
+void BinaryEncoder::put_uint(guint64 value)
+{
+  while(value >= 0x80)
+  {
+    put_byte(static_cast<guint8>(value) | 0x80);
+    value >>= 7;
+  }
+  put_byte(static_cast<guint8>(value));
+}
+
+void BinaryEncoder::put_int(gint64 value)
+{
+  put_uint((static_cast<guint64>(value) << 1) ^ static_cast<guint64>(value >> 63));
+}
+
+void BinaryEncoder::put_string(const gchar* str)
+{
+  if(!str)
+  {
+    put_uint(0);
+    return;
+  }
+
+  const gsize length = std::strlen(str);
+  put_uint(length + 1);
+  put_bytes(str, length + 1);
+}
+
+void BinaryEncoder::put_value(const GValue* value)
+{
+  const GType type = G_VALUE_TYPE(value);
+
+  switch(type)
+  {
+    case G_TYPE_BOOLEAN:
+      put_byte(VALUE_BOOLEAN);
+      put_byte(g_value_get_boolean(value) ? 1 : 0);
+      return;
+    case G_TYPE_INT:
+      put_byte(VALUE_INT);
+      put_int(g_value_get_int(value));
+      return;
+    case G_TYPE_UINT:
+      put_byte(VALUE_UINT);
+      put_uint(g_value_get_uint(value));
+      return;
+    case G_TYPE_INT64:
+      put_byte(VALUE_INT64);
+      put_int(g_value_get_int64(value));
+      return;
+    case G_TYPE_UINT64:
+      put_byte(VALUE_UINT64);
+      put_uint(g_value_get_uint64(value));
+      return;
+    case G_TYPE_FLOAT:
+    {
+      const gfloat f = g_value_get_float(value);
+      guint32 bits;
+      std::memcpy(&bits, &f, sizeof(bits));
+      bits = GUINT32_TO_LE(bits);
+      put_byte(VALUE_FLOAT);
+      put_bytes(&bits, sizeof(bits));
+      return;
+    }
+    case G_TYPE_DOUBLE:
+    {
+      const gdouble d = g_value_get_double(value);
+      guint64 bits;
+      std::memcpy(&bits, &d, sizeof(bits));
+      bits = GUINT64_TO_LE(bits);
+      put_byte(VALUE_DOUBLE);
+      put_bytes(&bits, sizeof(bits));
+      return;
+    }
+    case G_TYPE_STRING:
+      put_byte(VALUE_STRING);
+      put_string(g_value_get_string(value));
+      return;
+    default:
+      break;
+  }
+
+  if(type == GST_TYPE_FRACTION)
+  {
+    put_byte(VALUE_FRACTION);
+    put_int(gst_value_get_fraction_numerator(value));
+    put_int(gst_value_get_fraction_denominator(value));
+  }
+  else if(type == GST_TYPE_INT_RANGE)
+  {
+    put_byte(VALUE_INT_RANGE);
+    put_int(gst_value_get_int_range_min(value));
+    put_int(gst_value_get_int_range_max(value));
+    put_int(gst_value_get_int_range_step(value));
+  }
+  else if(type == GST_TYPE_INT64_RANGE)
+  {
+    put_byte(VALUE_INT64_RANGE);
+    put_int(gst_value_get_int64_range_min(value));
+    put_int(gst_value_get_int64_range_max(value));
+    put_int(gst_value_get_int64_range_step(value));
+  }
+  else if(type == GST_TYPE_DOUBLE_RANGE)
+  {
+    // Stored as two plain double values.
+    GValue d = G_VALUE_INIT;
+    g_value_init(&d, G_TYPE_DOUBLE);
+    put_byte(VALUE_DOUBLE_RANGE);
+    g_value_set_double(&d, gst_value_get_double_range_min(value));
+    put_value(&d);
+    g_value_set_double(&d, gst_value_get_double_range_max(value));
+    put_value(&d);
+  }
+  else if(type == GST_TYPE_FRACTION_RANGE)
+  {
+    put_byte(VALUE_FRACTION_RANGE);
+    put_value(gst_value_get_fraction_range_min(value));
+    put_value(gst_value_get_fraction_range_max(value));
+  }
+  else if(type == GST_TYPE_ARRAY)
+  {
+    const guint size = gst_value_array_get_size(value);
+    put_byte(VALUE_ARRAY);
+    put_uint(size);
+    for(guint i = 0; i < size; ++i)
+      put_value(gst_value_array_get_value(value, i));
+  }
+  else if(type == GST_TYPE_LIST)
+  {
+    const guint size = gst_value_list_get_size(value);
+    put_byte(VALUE_LIST);
+    put_uint(size);
+    for(guint i = 0; i < size; ++i)
+      put_value(gst_value_list_get_value(value, i));
+  }
+  else if(type == GST_TYPE_STRUCTURE && gst_value_get_structure(value))
+  {
+    put_byte(VALUE_STRUCTURE);
+    put_structure(gst_value_get_structure(value));
+  }
+  else if(type == GST_TYPE_CAPS && gst_value_get_caps(value))
+  {
+    put_byte(VALUE_CAPS);
+    put_caps(gst_value_get_caps(value));
+  }
+  else if(type == GST_TYPE_BUFFER && gst_value_get_buffer(value))
+  {
+    // Binary blobs, see Gst::Structure::set_blob().
+    GstBuffer* buffer = gst_value_get_buffer(value);
+    GstMapInfo info;
+    if(!gst_buffer_map(buffer, &info, GST_MAP_READ))
+    {
+      gstreamermm_handle_error("cannot map buffer for serialization");
+      return;
+    }
+
+    put_byte(VALUE_BUFFER);
+    put_uint(info.size);
+    put_bytes(info.data, info.size);
+    gst_buffer_unmap(buffer, &info);
+  }
+  else
+  {
+    gchar* serialized = gst_value_serialize(value);
+    if(!serialized)
+    {
+      gstreamermm_handle_error(Glib::ustring("cannot serialize value of type ") + g_type_name(type));
+      return;
+    }
+
+    put_byte(VALUE_SERIALIZED);
+    put_string(g_type_name(type));
+    put_string(serialized);
+    g_free(serialized);
+  }
+}
+
+void BinaryEncoder::put_structure(const GstStructure* structure)
+{
+  const gint n_fields = gst_structure_n_fields(structure);
+
+  put_string(gst_structure_get_name(structure));
+  put_uint(n_fields);
+
+  for(gint i = 0; i < n_fields; ++i)
+  {
+    const gchar* name = gst_structure_nth_field_name(structure, i);
+    put_string(name);
+    put_value(gst_structure_get_value(structure, name));
+  }
+}
+
+void BinaryEncoder::put_caps(const GstCaps* caps)
+{
+  if(gst_caps_is_any(caps))
+  {
+    put_byte(1);
+    return;
+  }
+
+  const guint size = gst_caps_get_size(caps);
+  put_byte(0);
+  put_uint(size);
+
+  for(guint i = 0; i < size; ++i)
+  {
+    put_structure(gst_caps_get_structure(caps, i));
+
+    GstCapsFeatures* features = gst_caps_get_features(caps, i);
+    if(!features || gst_caps_features_is_equal(features, GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY))
+      put_string(nullptr);
+    else
+    {
+      gchar* str = gst_caps_features_to_string(features);
+      put_string(str);
+      g_free(str);
+    }
+  }
+}
+
+/***************************** Gst::BinaryDecoder *****************************/
+
+BinaryDecoder::BinaryDecoder(const guint8* data, gsize size, BinaryDecodeFlags flags)
+: data_(data), size_(size), position_(0), flags_(flags)
+{}
+
+Gst::Structure BinaryDecoder::decode_structure()
+{
+  get_header(KIND_STRUCTURE);
+  return Gst::Structure(get_structure(0), false);
+}
+
+Glib::RefPtr<Gst::Caps> BinaryDecoder::decode_caps()
+{
+  get_header(KIND_CAPS);
+  return Glib::wrap(get_caps(0), false);
+}
+
+Gst::TagList BinaryDecoder::decode_taglist()
+{
+  get_header(KIND_TAGLIST);
+
+  Gst::TagList tag_list(gst_tag_list_new_empty(), false);
+  gst_tag_list_set_scope(tag_list.gobj(), static_cast<GstTagScope>(get_byte()));
+
+  const guint64 n_tags = get_uint();
+  for(guint64 i = 0; i < n_tags; ++i)
+  {
+    const gchar* tag = get_string();
+    if(!tag || !gst_tag_exists(tag))
+      gstreamermm_handle_error("unknown tag in binary tag list");
+
+    const guint64 n_values = get_uint();
+    for(guint64 j = 0; j < n_values; ++j)
+    {
+      ValueHolder holder;
+      get_value(&holder.value, 1);
+      gst_tag_list_add_value(tag_list.gobj(), GST_TAG_MERGE_APPEND, tag, &holder.value);
+    }
+  }
+
+  return tag_list;
+}
+
+gsize BinaryDecoder::get_position() const
+{
+  return position_;
+}
+
+bool BinaryDecoder::at_end() const
+{
+  return position_ >= size_;
+}
+
+void BinaryDecoder::get_header(guint8 kind)
+{
+  const guint8* header = get_bytes(4);
+
+  if(header[0] != 'G' || header[1] != 'B')
+    gstreamermm_handle_error("not a binary encoded object");
+  if(header[2] != BinaryEncoder::FORMAT_VERSION)
+    gstreamermm_handle_error("unsupported binary format version");
+  if(header[3] != kind)
+    gstreamermm_handle_error("unexpected kind of binary encoded object");
+}
+
+guint8 BinaryDecoder::get_byte()
+{
+  return *get_bytes(1);
+}
+
+const guint8* BinaryDecoder::get_bytes(gsize size)
+{
+  if(size > size_ - position_)
+    gstreamermm_handle_error("truncated binary data");
+
+  const guint8* bytes = data_ + position_;
+  position_ += size;
+  return bytes;
+}
+
+guint64 BinaryDecoder::get_uint()
+{
+  guint64 value = 0;
+
+  for(guint shift = 0; shift < 64; shift += 7)
+  {
+    const guint8 byte = get_byte();
+    value |= static_cast<guint64>(byte & 0x7f) << shift;
+    if(!(byte & 0x80))
+      return value;
+  }
+
+  gstreamermm_handle_error("malformed integer in binary data");
+  return 0;
+}
+
+gint64 BinaryDecoder::get_int()
+{
+  const guint64 value = get_uint();
+  return static_cast<gint64>(value >> 1) ^ -static_cast<gint64>(value & 1);
+}
+
+const gchar* BinaryDecoder::get_string()
+{
+  const guint64 size = get_uint();
+  if(!size)
+    return nullptr;
+
+  if(size > size_ - position_)
+    gstreamermm_handle_error("truncated binary data");
+
+  const gchar* str = reinterpret_cast<const gchar*>(get_bytes(size));
+  if(str[size - 1] != '\0')
+    gstreamermm_handle_error("malformed string in binary data");
+
+  return str;
+}
+
+void BinaryDecoder::get_value(GValue* value, guint depth)
+{
+  if(depth > max_depth)
+    gstreamermm_handle_error("binary data nested too deeply");
+
+  switch(get_byte())
+  {
+    case VALUE_BOOLEAN:
+      g_value_init(value, G_TYPE_BOOLEAN);
+      g_value_set_boolean(value, get_byte() != 0);
+      break;
+    case VALUE_INT:
+      g_value_init(value, G_TYPE_INT);
+      g_value_set_int(value, static_cast<gint>(get_int()));
+      break;
+    case VALUE_UINT:
+      g_value_init(value, G_TYPE_UINT);
+      g_value_set_uint(value, static_cast<guint>(get_uint()));
+      break;
+    case VALUE_INT64:
+      g_value_init(value, G_TYPE_INT64);
+      g_value_set_int64(value, get_int());
+      break;
+    case VALUE_UINT64:
+      g_value_init(value, G_TYPE_UINT64);
+      g_value_set_uint64(value, get_uint());
+      break;
+    case VALUE_FLOAT:
+    {
+      guint32 bits;
+      std::memcpy(&bits, get_bytes(sizeof(bits)), sizeof(bits));
+      bits = GUINT32_FROM_LE(bits);
+      gfloat f;
+      std::memcpy(&f, &bits, sizeof(f));
+      g_value_init(value, G_TYPE_FLOAT);
+      g_value_set_float(value, f);
+      break;
+    }
+    case VALUE_DOUBLE:
+    {
+      guint64 bits;
+      std::memcpy(&bits, get_bytes(sizeof(bits)), sizeof(bits));
+      bits = GUINT64_FROM_LE(bits);
+      gdouble d;
+      std::memcpy(&d, &bits, sizeof(d));
+      g_value_init(value, G_TYPE_DOUBLE);
+      g_value_set_double(value, d);
+      break;
+    }
+    case VALUE_STRING:
+    {
+      const gchar* str = get_string();
+      g_value_init(value, G_TYPE_STRING);
+      if(flags_ & BINARY_DECODE_BORROW_STRINGS)
+        g_value_set_static_string(value, str);
+      else
+        g_value_set_string(value, str);
+      break;
+    }
+    case VALUE_FRACTION:
+    {
+      const gint64 numerator = get_int();
+      const gint64 denominator = get_int();
+      if(!denominator)
+        gstreamermm_handle_error("malformed fraction in binary data");
+      g_value_init(value, GST_TYPE_FRACTION);
+      gst_value_set_fraction(value, static_cast<gint>(numerator), static_cast<gint>(denominator));
+      break;
+    }
+    case VALUE_INT_RANGE:
+    {
+      const gint64 min = get_int();
+      const gint64 max = get_int();
+      const gint64 step = get_int();
+      if(step <= 0 || min >= max)
+        gstreamermm_handle_error("malformed range in binary data");
+      g_value_init(value, GST_TYPE_INT_RANGE);
+      gst_value_set_int_range_step(value, static_cast<gint>(min), static_cast<gint>(max), static_cast<gint>(step));
+      break;
+    }
+    case VALUE_INT64_RANGE:
+    {
+      const gint64 min = get_int();
+      const gint64 max = get_int();
+      const gint64 step = get_int();
+      if(step <= 0 || min >= max)
+        gstreamermm_handle_error("malformed range in binary data");
+      g_value_init(value, GST_TYPE_INT64_RANGE);
+      gst_value_set_int64_range_step(value, min, max, step);
+      break;
+    }
+    case VALUE_DOUBLE_RANGE:
+    {
+      ValueHolder min, max;
+      get_value(&min.value, depth + 1);
+      get_value(&max.value, depth + 1);
+      if(!G_VALUE_HOLDS_DOUBLE(&min.value) || !G_VALUE_HOLDS_DOUBLE(&max.value))
+        gstreamermm_handle_error("malformed range in binary data");
+      g_value_init(value, GST_TYPE_DOUBLE_RANGE);
+      gst_value_set_double_range(value, g_value_get_double(&min.value), g_value_get_double(&max.value));
+      break;
+    }
+    case VALUE_FRACTION_RANGE:
+    {
+      ValueHolder min, max;
+      get_value(&min.value, depth + 1);
+      get_value(&max.value, depth + 1);
+      if(!GST_VALUE_HOLDS_FRACTION(&min.value) || !GST_VALUE_HOLDS_FRACTION(&max.value))
+        gstreamermm_handle_error("malformed range in binary data");
+      g_value_init(value, GST_TYPE_FRACTION_RANGE);
+      gst_value_set_fraction_range(value, &min.value, &max.value);
+      break;
+    }
+    case VALUE_ARRAY:
+    {
+      const guint64 size = get_uint();
+      g_value_init(value, GST_TYPE_ARRAY);
+      for(guint64 i = 0; i < size; ++i)
+      {
+        ValueHolder element;
+        get_value(&element.value, depth + 1);
+        gst_value_array_append_and_take_value(value, &element.value);
+      }
+      break;
+    }
+    case VALUE_LIST:
+    {
+      const guint64 size = get_uint();
+      g_value_init(value, GST_TYPE_LIST);
+      for(guint64 i = 0; i < size; ++i)
+      {
+        ValueHolder element;
+        get_value(&element.value, depth + 1);
+        gst_value_list_append_and_take_value(value, &element.value);
+      }
+      break;
+    }
+    case VALUE_STRUCTURE:
+      g_value_init(value, GST_TYPE_STRUCTURE);
+      g_value_take_boxed(value, get_structure(depth + 1));
+      break;
+    case VALUE_CAPS:
+      g_value_init(value, GST_TYPE_CAPS);
+      g_value_take_boxed(value, get_caps(depth + 1));
+      break;
+    case VALUE_SERIALIZED:
+    {
+      const gchar* type_name = get_string();
+      const gchar* serialized = get_string();
+      const GType type = type_name ? g_type_from_name(type_name) : G_TYPE_INVALID;
+      if(!type || !serialized)
+        gstreamermm_handle_error("unknown value type in binary data");
+
+      g_value_init(value, type);
+      if(!gst_value_deserialize(value, serialized))
+        gstreamermm_handle_error(Glib::ustring("cannot deserialize value of type ") + type_name);
+      break;
+    }
+    case VALUE_BUFFER:
+    {
+      const guint64 size = get_uint();
+      if(size > size_ - position_)
+        gstreamermm_handle_error("truncated binary data");
+
+      const guint8* bytes = get_bytes(size);
+      GstBuffer* buffer;
+      if(!size)
+        buffer = gst_buffer_new();
+      else if(flags_ & BINARY_DECODE_BORROW_STRINGS)
+        buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,
+          const_cast<guint8*>(bytes), size, 0, size, nullptr, nullptr);
+      else
+      {
+        buffer = gst_buffer_new_allocate(nullptr, size, nullptr);
+        gst_buffer_fill(buffer, 0, bytes, size);
+      }
+
+      g_value_init(value, GST_TYPE_BUFFER);
+      g_value_take_boxed(value, buffer);
+      break;
+    }
+    default:
+      gstreamermm_handle_error("unknown value tag in binary data");
+  }
+}
+
+GstStructure* BinaryDecoder::get_structure(guint depth)
+{
+  const gchar* name = get_string();
+  if(!name || !gst_structure_validate_name(name))
+    gstreamermm_handle_error("malformed structure name in binary data");
+
+  // Owns the structure until it is complete.
+  Gst::Structure structure(gst_structure_new_empty(name), false);
+
+  const guint64 n_fields = get_uint();
+  for(guint64 i = 0; i < n_fields; ++i)
+  {
+    const gchar* field = get_string();
+    if(!field)
+      gstreamermm_handle_error("malformed field name in binary data");
+
+    ValueHolder holder;
+    get_value(&holder.value, depth + 1);
+    gst_structure_id_take_value(structure.gobj(), g_quark_from_string(field), &holder.value);
+  }
+
+  return structure.release();
+}
+
+GstCaps* BinaryDecoder::get_caps(guint depth)
+{
+  if(get_byte())
+    return gst_caps_new_any();
+
+  // Owns the caps until they are complete.
+  Glib::RefPtr<Gst::Caps> caps = Glib::wrap(gst_caps_new_empty(), false);
+
+  const guint64 size = get_uint();
+  for(guint64 i = 0; i < size; ++i)
+  {
+    GstStructure* structure = get_structure(depth + 1);
+    const gchar* features = nullptr;
+
+    try
+    {
+      features = get_string();
+    }
+    catch(...)
+    {
+      gst_structure_free(structure);
+      throw;
+    }
+
+    gst_caps_append_structure_full(caps->gobj(), structure,
+      features ? gst_caps_features_from_string(features) : nullptr);
+  }
+
+  return caps.release()->gobj();
+}
+
+} // namespace Gst
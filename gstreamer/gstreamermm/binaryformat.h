@@ -0,0 +1,209 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_BINARYFORMAT_H
+#define _GSTREAMERMM_BINARYFORMAT_H
+
+#include <gstreamermm/structure.h>
+#include <gstreamermm/caps.h>
+#include <gstreamermm/taglist.h>
+#include <vector>
+
+namespace Gst
+{
+
+/** Flags for Gst::BinaryDecoder.
+ */
+enum BinaryDecodeFlags
+{
+  /** Copy string fields out of the encoded data. */
+  BINARY_DECODE_COPY_STRINGS = 0,
+  /** Let decoded string and binary blob fields point into the encoded data
+   * instead of copying them. The data must outlive the decoded objects
+   * (copies of the decoded objects are independent of the data).
+   */
+  BINARY_DECODE_BORROW_STRINGS = 1 << 0
+};
+
+/**
+ * Gst::BinaryEncoder writes Gst::Structure, Gst::Caps and Gst::TagList
+ * objects in a compact, versioned binary format.
+ *
+ * It is a faster alternative to the text format of
+ * Gst::Structure::to_string() and Gst::Caps::to_string() when objects have
+ * to be passed between processes. Integers, floating point numbers,
+ * strings, fractions, ranges, arrays, lists, nested structures, caps and
+ * binary blobs (see Gst::Structure::set_blob()) are encoded directly;
+ * values of other types fall back to their gst_value_serialize()
+ * representation.
+ *
+ * The encoder writes into a caller provided buffer. If the buffer is too
+ * small, encoding continues to count the required size without writing, so
+ * that the caller can retry with a larger buffer:
+ * @code
+ * guint8 buffer[256];
+ * Gst::BinaryEncoder encoder(buffer, sizeof(buffer));
+ * encoder.encode(structure);
+ * if(!encoder.is_complete())
+ * {
+ *   std::vector<guint8> data(encoder.get_size());
+ *   ...
+ * }
+ * @endcode
+ *
+ * The format is independent of the host byte order.
+ */
+class BinaryEncoder
+{
+public:
+  /** The version of the format written by the encoder.
+   */
+  static const guint8 FORMAT_VERSION = 1;
+
+  /** Creates an encoder which does not write any data, but only computes
+   * the size of the encoded objects.
+   */
+  BinaryEncoder();
+
+  /** Creates an encoder writing to @a data.
+   *
+   * @param data The buffer to write to.
+   * @param size The size of @a data in bytes.
+   */
+  BinaryEncoder(guint8* data, gsize size);
+
+  BinaryEncoder(const BinaryEncoder&) = delete;
+  BinaryEncoder& operator=(const BinaryEncoder&) = delete;
+
+  /** Appends @a structure to the encoded data.
+   */
+  void encode(const StructureView& structure);
+
+  /** Appends @a caps to the encoded data.
+   */
+  void encode(const Glib::RefPtr<const Gst::Caps>& caps);
+
+  /** Appends @a tag_list to the encoded data.
+   */
+  void encode(const Gst::TagList& tag_list);
+
+  /** Returns the number of bytes needed for everything encoded so far.
+   */
+  gsize get_size() const;
+
+  /** Checks whether everything encoded so far fitted into the buffer.
+   */
+  bool is_complete() const;
+
+  /** Starts writing at the beginning of the buffer again.
+   */
+  void reset();
+
+  /** Encodes @a structure into a newly allocated vector.
+   */
+  static std::vector<guint8> encode_to_vector(const StructureView& structure);
+
+  /** Encodes @a caps into a newly allocated vector.
+   */
+  static std::vector<guint8> encode_to_vector(const Glib::RefPtr<const Gst::Caps>& caps);
+
+  /** Encodes @a tag_list into a newly allocated vector.
+   */
+  static std::vector<guint8> encode_to_vector(const Gst::TagList& tag_list);
+
+private:
+  void put_header(guint8 kind);
+  void put_byte(guint8 byte);
+  void put_bytes(const void* bytes, gsize size);
+  void put_uint(guint64 value);
+  void put_int(gint64 value);
+  void put_string(const gchar* str);
+  void put_value(const GValue* value);
+  void put_structure(const GstStructure* structure);
+  void put_caps(const GstCaps* caps);
+
+  guint8* data_;
+  gsize size_;
+  gsize position_;
+};
+
+/**
+ * Gst::BinaryDecoder reads objects written by Gst::BinaryEncoder.
+ *
+ * Several objects can be decoded one after the other from the same data.
+ * Malformed data, data of an unsupported format version and objects of an
+ * unexpected kind cause a std::runtime_error to be thrown.
+ *
+ * With BINARY_DECODE_BORROW_STRINGS the string and binary blob fields of
+ * decoded structures point into the encoded data instead of being copied.
+ */
+class BinaryDecoder
+{
+public:
+  /** Creates a decoder reading from @a data.
+   *
+   * @param data The encoded data.
+   * @param size The size of @a data in bytes.
+   * @param flags Flags controlling the decoding.
+   */
+  BinaryDecoder(const guint8* data, gsize size, BinaryDecodeFlags flags = BINARY_DECODE_COPY_STRINGS);
+
+  BinaryDecoder(const BinaryDecoder&) = delete;
+  BinaryDecoder& operator=(const BinaryDecoder&) = delete;
+
+  /** Decodes the next object, which must be a Gst::Structure.
+   */
+  Gst::Structure decode_structure();
+
+  /** Decodes the next object, which must be a Gst::Caps.
+   */
+  Glib::RefPtr<Gst::Caps> decode_caps();
+
+  /** Decodes the next object, which must be a Gst::TagList.
+   */
+  Gst::TagList decode_taglist();
+
+  /** Returns the number of bytes consumed so far.
+   */
+  gsize get_position() const;
+
+  /** Checks whether all data has been consumed.
+   */
+  bool at_end() const;
+
+private:
+  void get_header(guint8 kind);
+  guint8 get_byte();
+  const guint8* get_bytes(gsize size);
+  guint64 get_uint();
+  gint64 get_int();
+  const gchar* get_string();
+  void get_value(GValue* value, guint depth);
+  GstStructure* get_structure(guint depth);
+  GstCaps* get_caps(guint depth);
+
+  const guint8* data_;
+  gsize size_;
+  gsize position_;
+  BinaryDecodeFlags flags_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_BINARYFORMAT_H */
@@ -0,0 +1,154 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_BORROWEDREF_H
+#define _GSTREAMERMM_BORROWEDREF_H
+
+#include <glibmm/refptr.h>
+
+namespace Gst
+{
+
+/**
+ * Gst::BorrowedRef is a non-owning view of a reference counted gstreamermm
+ * object.
+ *
+ * It is handed to callbacks which only need the object for the duration of
+ * the call. Unlike Glib::RefPtr, neither creating, copying nor destroying a
+ * Gst::BorrowedRef touches the reference count of the underlying object, so
+ * no atomic operations are performed. The caller of the callback guarantees
+ * that the object stays alive until the callback returns.
+ *
+ * A Gst::BorrowedRef must not be stored beyond the callback. If the object
+ * has to be kept, take a real reference with acquire():
+ * @code
+ * bool on_bus_message(Gst::BorrowedRef<Gst::Bus> bus,
+ *   Gst::BorrowedRef<Gst::Message> message)
+ * {
+ *   if(message->get_message_type() == Gst::MESSAGE_ERROR)
+ *     last_error = message.acquire();
+ *   return true;
+ * }
+ * @endcode
+ */
+template <class T>
+class BorrowedRef
+{
+public:
+  /** Default constructor. Creates an empty view.
+   */
+  BorrowedRef() noexcept
+  : pobject_(nullptr)
+  {}
+
+  /** Creates a view of @a pobject without taking a reference.
+   */
+  explicit BorrowedRef(T* pobject) noexcept
+  : pobject_(pobject)
+  {}
+
+  /** Creates a view of the object held by @a src without taking a reference.
+   * @a src must outlive the view.
+   */
+  BorrowedRef(const Glib::RefPtr<T>& src) noexcept
+  : pobject_(src.operator->())
+  {}
+
+  /** Converts a view of a derived type (e.g. Gst::Pad) into a view of one of
+   * its base types (e.g. Gst::Object).
+   */
+  template <class T_CastFrom>
+  BorrowedRef(const BorrowedRef<T_CastFrom>& src) noexcept
+  : pobject_(src.get())
+  {}
+
+  /** Dereferencing.
+   */
+  T* operator->() const noexcept
+  {
+    return pobject_;
+  }
+
+  /** Dereferencing.
+   */
+  T& operator*() const noexcept
+  {
+    return *pobject_;
+  }
+
+  /** Returns the stored pointer.
+   */
+  T* get() const noexcept
+  {
+    return pobject_;
+  }
+
+  /** Test whether the view points to an object.
+   */
+  explicit operator bool() const noexcept
+  {
+    return pobject_ != nullptr;
+  }
+
+  /** Takes a new reference to the object and returns it in a Glib::RefPtr,
+   * so that it can be kept after the callback returns.
+   */
+  Glib::RefPtr<T> acquire() const
+  {
+    if(pobject_)
+      pobject_->reference();
+
+    return Glib::RefPtr<T>(pobject_);
+  }
+
+  /** Tests whether both views point to the same object.
+   */
+  template <class T_CastFrom>
+  bool operator==(const BorrowedRef<T_CastFrom>& src) const noexcept
+  {
+    return pobject_ == src.get();
+  }
+
+  /** Tests whether the views point to different objects.
+   */
+  template <class T_CastFrom>
+  bool operator!=(const BorrowedRef<T_CastFrom>& src) const noexcept
+  {
+    return pobject_ != src.get();
+  }
+
+private:
+  T* pobject_;
+};
+
+/** Turns a Glib::RefPtr which does not own its reference (for example the
+ * result of <tt>Glib::wrap(c_object, false)</tt> on an object owned by the
+ * caller) into a Gst::BorrowedRef. The reference count is not modified.
+ *
+ * @relates Gst::BorrowedRef
+ */
+template <class T>
+inline BorrowedRef<T> borrow(Glib::RefPtr<T>&& unowned) noexcept
+{
+  return BorrowedRef<T>(unowned.release());
+}
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_BORROWEDREF_H */
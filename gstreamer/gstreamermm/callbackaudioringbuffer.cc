@@ -0,0 +1,401 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/callbackaudioringbuffer.h>
+#include <algorithm>
+#include <chrono>
+
+namespace Gst
+{
+
+Glib::RefPtr<CallbackAudioRingBuffer> CallbackAudioRingBuffer::create(
+  AudioRingBufferDirection direction, bool threaded)
+{
+  const GType type = Gst::register_mm_type<CallbackAudioRingBuffer>("gstreamermm__CallbackAudioRingBuffer");
+
+  // The instance init function of the type creates the C++ wrapper, which
+  // also sinks the floating reference.
+  GstAudioRingBuffer* const castitem = GST_AUDIO_RING_BUFFER(g_object_new(type, nullptr));
+  Glib::RefPtr<CallbackAudioRingBuffer> ring_buffer =
+    Glib::RefPtr<CallbackAudioRingBuffer>::cast_static(Glib::wrap(castitem, false));
+
+  ring_buffer->direction_ = direction;
+  ring_buffer->threaded_ = threaded;
+  return ring_buffer;
+}
+
+CallbackAudioRingBuffer::CallbackAudioRingBuffer(GstAudioRingBuffer* castitem)
+: Glib::ObjectBase(typeid (CallbackAudioRingBuffer)),
+  Gst::AudioRingBuffer(castitem),
+  direction_(AUDIO_RING_BUFFER_PLAYBACK),
+  threaded_(true),
+  max_periods_(1),
+  partial_(0),
+  written_(0),
+  in_flight_(0),
+  underruns_(0),
+  device_xruns_(0),
+  running_(false),
+  wakeup_(false)
+{}
+
+CallbackAudioRingBuffer::~CallbackAudioRingBuffer()
+{
+  stop_thread();
+}
+
+void CallbackAudioRingBuffer::set_io_slot(const SlotIO& slot)
+{
+  io_slot_ = slot;
+}
+
+void CallbackAudioRingBuffer::set_delay_slot(const SlotDelay& slot)
+{
+  delay_slot_ = slot;
+}
+
+void CallbackAudioRingBuffer::set_open_close_slots(const SlotDevice& open, const SlotDevice& close)
+{
+  open_slot_ = open;
+  close_slot_ = close;
+}
+
+void CallbackAudioRingBuffer::set_prepare_slots(const SlotPrepare& prepare, const SlotDevice& unprepare)
+{
+  prepare_slot_ = prepare;
+  unprepare_slot_ = unprepare;
+}
+
+void CallbackAudioRingBuffer::set_reset_slot(const SlotReset& slot)
+{
+  reset_slot_ = slot;
+}
+
+void CallbackAudioRingBuffer::set_max_periods(guint max_periods)
+{
+  max_periods_ = std::max(max_periods, 1u);
+}
+
+guint CallbackAudioRingBuffer::get_max_periods() const
+{
+  return max_periods_;
+}
+
+AudioRingBufferDirection CallbackAudioRingBuffer::get_direction() const
+{
+  return direction_;
+}
+
+guint64 CallbackAudioRingBuffer::get_underruns() const
+{
+  return underruns_.load(std::memory_order_relaxed);
+}
+
+guint64 CallbackAudioRingBuffer::get_device_xruns() const
+{
+  return device_xruns_.load(std::memory_order_relaxed);
+}
+
+void CallbackAudioRingBuffer::reset_xruns()
+{
+  underruns_.store(0, std::memory_order_relaxed);
+  device_xruns_.store(0, std::memory_order_relaxed);
+}
+
+bool CallbackAudioRingBuffer::process()
+{
+  GstAudioRingBuffer* const rb = gobj();
+  gint segment = 0;
+  guint8* data = nullptr;
+  gint len = 0;
+
+  if(!gst_audio_ring_buffer_prepare_read(rb, &segment, &data, &len))
+  {
+    // A stopped ring buffer restarts at a segment boundary.
+    if(g_atomic_int_get(&rb->state) == GST_AUDIO_RING_BUFFER_STATE_STOPPED)
+      partial_ = 0;
+
+    return false;
+  }
+
+  const bool playback = direction_ == AUDIO_RING_BUFFER_PLAYBACK;
+  const guint64 segment_start = static_cast<guint64>(g_atomic_int_get(&rb->segdone) - rb->segbase) *
+    rb->samples_per_seg;
+  const guint64 written = written_.load(std::memory_order_acquire);
+
+  // Batch the following segments as long as they are contiguous in memory
+  // and, for playback, completely committed.
+  guint periods = std::min<guint>(max_periods_, rb->spec.segtotal - segment);
+  if(playback && periods > 1)
+  {
+    const guint64 ready = written > segment_start ? (written - segment_start) / rb->samples_per_seg : 0;
+    periods = std::max<guint>(1, std::min<guint64>(periods, ready));
+  }
+
+  // The samples of a partially processed segment were checked before.
+  if(playback && !partial_ && written < segment_start + rb->samples_per_seg)
+    underruns_.fetch_add(1, std::memory_order_relaxed);
+
+  guint8* const start = data + partial_;
+  const guint length = periods * len - partial_;
+
+  in_flight_.store(length / GST_AUDIO_INFO_BPF(&rb->spec.info), std::memory_order_relaxed);
+  int done = io_slot_ ? io_slot_(start, length) : static_cast<int>(length);
+  in_flight_.store(0, std::memory_order_relaxed);
+
+  guint completed = 0;
+  if(done < 0 || static_cast<guint>(done) > length)
+  {
+    // Give up on the segments, and do not hand stale samples to the
+    // reader.
+    device_xruns_.fetch_add(1, std::memory_order_relaxed);
+
+    if(!playback)
+      gst_audio_format_fill_silence(rb->spec.info.finfo, start, length);
+
+    completed = periods;
+    partial_ = 0;
+  }
+  else
+  {
+    const guint processed = partial_ + done;
+    completed = processed / len;
+    partial_ = processed % len;
+  }
+
+  // Played segments are cleared to silence, so that they are not played
+  // again if the writer does not keep up.
+  if(playback)
+  {
+    for(guint i = 0; i < completed; ++i)
+      gst_audio_ring_buffer_clear(rb, segment + i);
+  }
+
+  if(completed)
+    gst_audio_ring_buffer_advance(rb, completed);
+
+  return true;
+}
+
+bool CallbackAudioRingBuffer::open_device_vfunc()
+{
+  return open_slot_ ? open_slot_() : true;
+}
+
+bool CallbackAudioRingBuffer::acquire_vfunc(Gst::AudioRingBufferSpec& spec)
+{
+  if(prepare_slot_ && !prepare_slot_(spec))
+    return false;
+
+  GstAudioRingBuffer* const rb = gobj();
+  const GstAudioRingBufferSpec* const c_spec = spec.gobj();
+
+  if(c_spec->segsize <= 0 || c_spec->segtotal <= 0)
+    return false;
+
+  rb->size = c_spec->segtotal * c_spec->segsize;
+  rb->memory = static_cast<guint8*>(g_malloc(rb->size));
+  gst_audio_format_fill_silence(c_spec->info.finfo, rb->memory, rb->size);
+
+  written_.store(0, std::memory_order_relaxed);
+  partial_ = 0;
+  return true;
+}
+
+bool CallbackAudioRingBuffer::release_vfunc()
+{
+  // The device thread must not touch the memory any more.
+  stop_thread();
+
+  GstAudioRingBuffer* const rb = gobj();
+  g_free(rb->memory);
+  rb->memory = nullptr;
+  rb->size = 0;
+
+  return unprepare_slot_ ? unprepare_slot_() : true;
+}
+
+bool CallbackAudioRingBuffer::close_device_vfunc()
+{
+  return close_slot_ ? close_slot_() : true;
+}
+
+bool CallbackAudioRingBuffer::start_vfunc()
+{
+  wake_thread();
+  return true;
+}
+
+bool CallbackAudioRingBuffer::pause_vfunc()
+{
+  // The device thread goes to sleep after the current I/O, when
+  // prepare_read() reports that the ring buffer is not started.
+  if(reset_slot_)
+    reset_slot_();
+
+  return true;
+}
+
+bool CallbackAudioRingBuffer::resume_vfunc()
+{
+  wake_thread();
+  return true;
+}
+
+bool CallbackAudioRingBuffer::stop_vfunc()
+{
+  if(reset_slot_)
+    reset_slot_();
+
+  return true;
+}
+
+guint CallbackAudioRingBuffer::delay_vfunc()
+{
+  // The I/O slot does not report its progress, so all the frames passed to
+  // the current call are counted until it returns. A partially processed
+  // segment only counts the frames not processed yet.
+  guint delay = in_flight_.load(std::memory_order_relaxed);
+
+  if(delay_slot_)
+    delay += delay_slot_();
+
+  return delay;
+}
+
+bool CallbackAudioRingBuffer::activate_vfunc(bool active)
+{
+  if(active)
+    start_thread();
+  else
+    stop_thread();
+
+  return true;
+}
+
+guint CallbackAudioRingBuffer::commit_raw_vfunc(guint64& sample, const guint8* data,
+  int in_samples, int out_samples, int& accum)
+{
+  // Use the implementation of GstAudioRingBuffer directly, the samples do
+  // not have to be copied.
+  GstAudioRingBufferClass* const base =
+    static_cast<GstAudioRingBufferClass*>(g_type_class_peek(GST_TYPE_AUDIO_RING_BUFFER));
+
+  const guint64 start = sample;
+  const guint result = base->commit(gobj(), &sample, const_cast<guint8*>(data),
+    in_samples, out_samples, &accum);
+  const guint64 end = std::max<guint64>(sample, start + result);
+
+  // Only the streaming thread commits, the device thread reads.
+  if(end > written_.load(std::memory_order_relaxed))
+    written_.store(end, std::memory_order_release);
+
+  return result;
+}
+
+void CallbackAudioRingBuffer::clear_all_vfunc()
+{
+  Gst::AudioRingBuffer::clear_all_vfunc();
+
+  // Called by set_sample(), which restarts the sample positions.
+  GstAudioRingBuffer* const rb = gobj();
+  written_.store(static_cast<guint64>(g_atomic_int_get(&rb->segdone) - rb->segbase) * rb->samples_per_seg,
+    std::memory_order_release);
+}
+
+void CallbackAudioRingBuffer::start_thread()
+{
+  if(!threaded_ || thread_.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_.store(true, std::memory_order_relaxed);
+    wakeup_ = false;
+  }
+
+  thread_ = std::thread(&CallbackAudioRingBuffer::thread_loop, this);
+}
+
+void CallbackAudioRingBuffer::stop_thread()
+{
+  if(!thread_.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_.store(false, std::memory_order_release);
+  }
+  cond_.notify_one();
+
+  thread_.join();
+}
+
+void CallbackAudioRingBuffer::wake_thread()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wakeup_ = true;
+  }
+  cond_.notify_one();
+}
+
+void CallbackAudioRingBuffer::thread_loop()
+{
+  GstAudioRingBuffer* const rb = gobj();
+  std::chrono::steady_clock::time_point deadline;
+  bool paced = false;
+
+  while(running_.load(std::memory_order_acquire))
+  {
+    const gint segdone = g_atomic_int_get(&rb->segdone);
+
+    if(process())
+    {
+      // Without an I/O slot nothing blocks like a device does, so the
+      // segments are consumed in real time instead.
+      if(!io_slot_ && rb->spec.info.rate > 0)
+      {
+        const gint segments = std::max(0, g_atomic_int_get(&rb->segdone) - segdone);
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        if(!paced || deadline < now)
+          deadline = now;
+        paced = true;
+
+        deadline += std::chrono::microseconds(gst_util_uint64_scale_int(
+          static_cast<guint64>(segments) * rb->samples_per_seg, G_USEC_PER_SEC, rb->spec.info.rate));
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait_until(lock, deadline, [this] { return !running_.load(std::memory_order_relaxed); });
+      }
+
+      continue;
+    }
+
+    paced = false;
+
+    // Not started: sleep until start(), resume() or deactivation.
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return !running_.load(std::memory_order_relaxed) || wakeup_; });
+    wakeup_ = false;
+  }
+}
+
+} // namespace Gst
@@ -0,0 +1,262 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_CALLBACKAUDIORINGBUFFER_H
+#define _GSTREAMERMM_CALLBACKAUDIORINGBUFFER_H
+
+#include <gstreamermm/audioringbuffer.h>
+#include <gstreamermm/register.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Gst
+{
+
+/** The direction of the samples in a Gst::CallbackAudioRingBuffer.
+ */
+enum AudioRingBufferDirection
+{
+  /** Samples are committed by a sink and written to the device. */
+  AUDIO_RING_BUFFER_PLAYBACK,
+  /** Samples are read from the device and read by a source. */
+  AUDIO_RING_BUFFER_CAPTURE
+};
+
+/**
+ * Gst::CallbackAudioRingBuffer is a ready to use Gst::AudioRingBuffer which
+ * moves segments between the ring buffer and a device through callbacks.
+ *
+ * The ring buffer memory is shared between one producer and one consumer:
+ * the streaming thread of the element commits or reads samples, and the
+ * device side processes one segment after the other. Both sides only
+ * synchronize through the atomic segment counters of Gst::AudioRingBuffer,
+ * so no lock is taken while samples flow; a mutex is only used to put the
+ * device thread to sleep while the ring buffer is not started.
+ *
+ * The device side is driven either by a thread owned by the ring buffer,
+ * which calls the I/O slot for each segment and is expected to block like a
+ * device does, or by the backend itself calling process(), for instance from
+ * the callback of a native audio API or from its own clock.
+ *
+ * An element derived from Gst::AudioBaseSink or Gst::AudioBaseSrc returns
+ * the ring buffer from its create_ring_buffer_vfunc():
+ * @code
+ * Glib::RefPtr<Gst::AudioRingBuffer> MySink::create_ring_buffer_vfunc()
+ * {
+ *   Glib::RefPtr<Gst::CallbackAudioRingBuffer> ring_buffer =
+ *     Gst::CallbackAudioRingBuffer::create(Gst::AUDIO_RING_BUFFER_PLAYBACK);
+ *   ring_buffer->set_io_slot(sigc::mem_fun(*this, &MySink::write_to_device));
+ *   return ring_buffer;
+ * }
+ * @endcode
+ *
+ * The xrun counters make glitches observable: get_underruns() counts
+ * segments which were handed to the device before they were completely
+ * committed (silence or partial data was played), get_device_xruns() counts
+ * failures of the I/O slot.
+ */
+class CallbackAudioRingBuffer : public Gst::AudioRingBuffer
+{
+public:
+  /** For example,
+   * int on_io(guint8* data, guint length);.
+   * The slot is called with one or more contiguous segments and returns the
+   * number of bytes written to or read from the device, or a negative value
+   * on error. Fewer bytes than @a length may be processed; the rest is
+   * passed to the next call.
+   */
+  typedef sigc::slot<int, guint8*, guint> SlotIO;
+
+  /** For example,
+   * guint on_delay();.
+   * The slot returns the number of frames queued in the device.
+   */
+  typedef sigc::slot<guint> SlotDelay;
+
+  /** For example,
+   * bool on_open();.
+   * Used for opening, unpreparing and closing the device.
+   */
+  typedef sigc::slot<bool> SlotDevice;
+
+  /** For example,
+   * bool on_prepare(Gst::AudioRingBufferSpec& spec);.
+   * The slot configures the device for @a spec before the segments are
+   * allocated, and may adjust the segment size and count.
+   */
+  typedef sigc::slot<bool, Gst::AudioRingBufferSpec&> SlotPrepare;
+
+  /** For example,
+   * void on_reset();.
+   * The slot unblocks a pending device I/O when the ring buffer is paused or
+   * stopped.
+   */
+  typedef sigc::slot<void> SlotReset;
+
+  /** Creates a new ring buffer.
+   *
+   * @param direction Whether the ring buffer is used for playback or
+   * capture.
+   * @param threaded Whether the ring buffer runs its own device thread. If
+   * false, the backend has to call process() for every segment.
+   */
+  static Glib::RefPtr<CallbackAudioRingBuffer> create(AudioRingBufferDirection direction,
+    bool threaded = true);
+
+  /** Sets the slot moving segments between the ring buffer and the device.
+   * Without a slot, segments are consumed, or captured as silence, in real
+   * time by the device thread, or immediately by process().
+   *
+   * The slot must be set before the ring buffer is activated.
+   */
+  void set_io_slot(const SlotIO& slot);
+
+  /** Sets the slot reporting the number of frames queued in the device,
+   * which is added to the frames of the segment being processed.
+   *
+   * While the I/O slot runs, all the frames passed to it are counted as
+   * pending, so the delay is an upper bound until the slot returns.
+   *
+   * The slot must be set before the ring buffer is activated.
+   */
+  void set_delay_slot(const SlotDelay& slot);
+
+  /** Sets the slots called when the device is opened and closed. Without
+   * slots, opening and closing succeed.
+   */
+  void set_open_close_slots(const SlotDevice& open, const SlotDevice& close);
+
+  /** Sets the slots called when the ring buffer is acquired and released.
+   * Without slots, preparing and unpreparing succeed.
+   */
+  void set_prepare_slots(const SlotPrepare& prepare, const SlotDevice& unprepare);
+
+  /** Sets the slot called when the ring buffer is paused or stopped.
+   */
+  void set_reset_slot(const SlotReset& slot);
+
+  /** Sets the maximum number of contiguous segments passed to the I/O slot
+   * at once. The default is 1.
+   *
+   * Batching reduces the number of calls and wakeups for backends which
+   * can process more than one period at a time. For playback, only
+   * segments which are completely committed are batched, so the latency
+   * does not grow. For capture, batching makes the device fill several
+   * segments before the source can read the first one.
+   */
+  void set_max_periods(guint max_periods);
+
+  /** Returns the maximum number of contiguous segments passed to the I/O
+   * slot at once.
+   */
+  guint get_max_periods() const;
+
+  /** Processes the next segments, when the ring buffer is started.
+   *
+   * This is called by the device thread of a threaded ring buffer, and has
+   * to be called by the backend otherwise. It must always be called from
+   * the same thread.
+   *
+   * @return true if the I/O slot was called, false if the ring buffer is
+   * not started.
+   */
+  bool process();
+
+  /** Returns the direction of the ring buffer.
+   */
+  AudioRingBufferDirection get_direction() const;
+
+  /** Returns the number of segments handed to the device before they were
+   * completely committed. Always 0 for capture.
+   */
+  guint64 get_underruns() const;
+
+  /** Returns the number of times the I/O slot failed.
+   */
+  guint64 get_device_xruns() const;
+
+  /** Resets the xrun counters.
+   */
+  void reset_xruns();
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  // Required by Gst::register_mm_type(); ring buffers have no element class
+  // data to set up.
+  static void class_init(Gst::ElementClass<CallbackAudioRingBuffer>*) {}
+
+  explicit CallbackAudioRingBuffer(GstAudioRingBuffer* castitem);
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+  ~CallbackAudioRingBuffer() override;
+
+protected:
+  bool open_device_vfunc() override;
+  bool acquire_vfunc(Gst::AudioRingBufferSpec& spec) override;
+  bool release_vfunc() override;
+  bool close_device_vfunc() override;
+  bool start_vfunc() override;
+  bool pause_vfunc() override;
+  bool resume_vfunc() override;
+  bool stop_vfunc() override;
+  guint delay_vfunc() override;
+  bool activate_vfunc(bool active) override;
+  guint commit_raw_vfunc(guint64& sample, const guint8* data,
+    int in_samples, int out_samples, int& accum) override;
+  void clear_all_vfunc() override;
+
+private:
+  void start_thread();
+  void stop_thread();
+  void wake_thread();
+  void thread_loop();
+
+  AudioRingBufferDirection direction_;
+  bool threaded_;
+  SlotIO io_slot_;
+  SlotDelay delay_slot_;
+  SlotDevice open_slot_;
+  SlotDevice close_slot_;
+  SlotPrepare prepare_slot_;
+  SlotDevice unprepare_slot_;
+  SlotReset reset_slot_;
+  guint max_periods_;
+
+  // The bytes of the current segment already processed by the device.
+  // Only used by the device side.
+  guint partial_;
+
+  // The end of the committed samples, in the sample positions of commit().
+  std::atomic<guint64> written_;
+  // The frames passed to the current call of the I/O slot.
+  std::atomic<guint> in_flight_;
+  std::atomic<guint64> underruns_;
+  std::atomic<guint64> device_xruns_;
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::atomic<bool> running_;
+  bool wakeup_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_CALLBACKAUDIORINGBUFFER_H */
@@ -0,0 +1,329 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/capscache.h>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+
+// Intersections use the Gst::CapsIntersectMode as operation.
+enum
+{
+  OPERATION_IS_SUBSET = 16,
+  OPERATION_CAN_INTERSECT,
+  OPERATION_LOOKUP
+};
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+struct CapsCache::Impl
+{
+  struct Entry
+  {
+    Entry(int operation, const Glib::RefPtr<const Gst::Caps>& caps1,
+      const Glib::RefPtr<const Gst::Caps>& caps2, guint hash1, guint hash2)
+    : operation(operation), caps1(caps1), caps2(caps2), hash1(hash1), hash2(hash2),
+      result(false)
+    {}
+
+    int operation;
+    Glib::RefPtr<const Gst::Caps> caps1;
+    Glib::RefPtr<const Gst::Caps> caps2;
+    guint hash1;
+    guint hash2;
+    Glib::RefPtr<Gst::Caps> intersection;
+    bool result;
+  };
+
+  typedef std::list<Entry> EntryList;
+
+  // The cache holds a reference to the caps, so their addresses cannot be
+  // reused and they cannot be modified while they are cached.
+  struct IdentityKey
+  {
+    int operation;
+    const GstCaps* caps1;
+    const GstCaps* caps2;
+
+    bool operator==(const IdentityKey& other) const
+    {
+      return operation == other.operation && caps1 == other.caps1 && caps2 == other.caps2;
+    }
+  };
+
+  struct HashKey
+  {
+    int operation;
+    guint hash1;
+    guint hash2;
+
+    bool operator==(const HashKey& other) const
+    {
+      return operation == other.operation && hash1 == other.hash1 && hash2 == other.hash2;
+    }
+  };
+
+  struct KeyHasher
+  {
+    std::size_t operator()(const IdentityKey& key) const
+    {
+      return std::hash<const void*>()(key.caps1) * 31 + std::hash<const void*>()(key.caps2) + key.operation;
+    }
+
+    std::size_t operator()(const HashKey& key) const
+    {
+      return (static_cast<std::size_t>(key.hash1) * 31 + key.hash2) * 31 + key.operation;
+    }
+  };
+
+  explicit Impl(gsize capacity)
+  : capacity(capacity), hits(0), misses(0)
+  {}
+
+  static IdentityKey identity_key(const Entry& entry)
+  {
+    IdentityKey key = { entry.operation, entry.caps1 ? entry.caps1->gobj() : nullptr,
+      entry.caps2 ? entry.caps2->gobj() : nullptr };
+    return key;
+  }
+
+  static HashKey hash_key(const Entry& entry)
+  {
+    HashKey key = { entry.operation, entry.hash1, entry.hash2 };
+    return key;
+  }
+
+  static bool caps_equal(const Glib::RefPtr<const Gst::Caps>& caps1, const Glib::RefPtr<const Gst::Caps>& caps2)
+  {
+    if(!caps1 || !caps2)
+      return !caps1 && !caps2;
+    return gst_caps_is_strictly_equal(caps1->gobj(), caps2->gobj());
+  }
+
+  // Must be called with the mutex locked. On a miss, returns nullptr and
+  // the hashes of the caps for the following insert().
+  const Entry* find(int operation, const Glib::RefPtr<const Gst::Caps>& caps1,
+    const Glib::RefPtr<const Gst::Caps>& caps2, guint& hash1, guint& hash2);
+
+  // Must be called with the mutex locked.
+  void insert(const Entry& entry);
+
+  // Must be called with the mutex locked.
+  void erase(EntryList::iterator it);
+
+  gsize capacity;
+  EntryList entries;
+  std::unordered_map<IdentityKey, EntryList::iterator, KeyHasher> by_identity;
+  std::unordered_multimap<HashKey, EntryList::iterator, KeyHasher> by_hash;
+  std::mutex mutex;
+  guint64 hits;
+  guint64 misses;
+};
+
+const CapsCache::Impl::Entry* CapsCache::Impl::find(int operation,
+  const Glib::RefPtr<const Gst::Caps>& caps1, const Glib::RefPtr<const Gst::Caps>& caps2,
+  guint& hash1, guint& hash2)
+{
+  const IdentityKey key = { operation, caps1 ? caps1->gobj() : nullptr, caps2 ? caps2->gobj() : nullptr };
+  auto identity_it = by_identity.find(key);
+  if(identity_it != by_identity.end())
+  {
+    entries.splice(entries.begin(), entries, identity_it->second);
+    ++hits;
+    return &entries.front();
+  }
+
+  hash1 = caps1 ? caps1->hash() : 0;
+  hash2 = caps2 ? caps2->hash() : 0;
+
+  const HashKey hkey = { operation, hash1, hash2 };
+  auto range = by_hash.equal_range(hkey);
+  for(auto it = range.first; it != range.second; ++it)
+  {
+    const Entry& entry = *it->second;
+    if(caps_equal(entry.caps1, caps1) && caps_equal(entry.caps2, caps2))
+    {
+      entries.splice(entries.begin(), entries, it->second);
+      ++hits;
+      return &entries.front();
+    }
+  }
+
+  ++misses;
+  return nullptr;
+}
+
+void CapsCache::Impl::insert(const Entry& entry)
+{
+  // Another thread may have stored the same result in the meantime.
+  if(!capacity || by_identity.count(identity_key(entry)))
+    return;
+
+  entries.push_front(entry);
+  by_identity.insert(std::make_pair(identity_key(entry), entries.begin()));
+  by_hash.insert(std::make_pair(hash_key(entry), entries.begin()));
+
+  while(entries.size() > capacity)
+    erase(std::prev(entries.end()));
+}
+
+void CapsCache::Impl::erase(EntryList::iterator it)
+{
+  by_identity.erase(identity_key(*it));
+
+  auto range = by_hash.equal_range(hash_key(*it));
+  for(auto hash_it = range.first; hash_it != range.second; ++hash_it)
+  {
+    if(hash_it->second == it)
+    {
+      by_hash.erase(hash_it);
+      break;
+    }
+  }
+
+  entries.erase(it);
+}
+
+CapsCache::CapsCache(gsize capacity)
+: impl_(new Impl(capacity))
+{}
+
+CapsCache::~CapsCache()
+{}
+
+Glib::RefPtr<Gst::Caps> CapsCache::intersect(const Glib::RefPtr<const Gst::Caps>& caps1,
+  const Glib::RefPtr<const Gst::Caps>& caps2, CapsIntersectMode mode)
+{
+  guint hash1 = 0, hash2 = 0;
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if(const Impl::Entry* entry = impl_->find(mode, caps1, caps2, hash1, hash2))
+      return entry->intersection;
+  }
+
+  Impl::Entry entry(mode, caps1, caps2, hash1, hash2);
+  entry.intersection = caps1->get_intersect(caps2, mode);
+
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  impl_->insert(entry);
+  return entry.intersection;
+}
+
+bool CapsCache::is_subset(const Glib::RefPtr<const Gst::Caps>& subset,
+  const Glib::RefPtr<const Gst::Caps>& superset)
+{
+  guint hash1 = 0, hash2 = 0;
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if(const Impl::Entry* entry = impl_->find(OPERATION_IS_SUBSET, subset, superset, hash1, hash2))
+      return entry->result;
+  }
+
+  Impl::Entry entry(OPERATION_IS_SUBSET, subset, superset, hash1, hash2);
+  entry.result = subset->is_subset(superset);
+
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  impl_->insert(entry);
+  return entry.result;
+}
+
+bool CapsCache::can_intersect(const Glib::RefPtr<const Gst::Caps>& caps1,
+  const Glib::RefPtr<const Gst::Caps>& caps2)
+{
+  guint hash1 = 0, hash2 = 0;
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if(const Impl::Entry* entry = impl_->find(OPERATION_CAN_INTERSECT, caps1, caps2, hash1, hash2))
+      return entry->result;
+  }
+
+  Impl::Entry entry(OPERATION_CAN_INTERSECT, caps1, caps2, hash1, hash2);
+  entry.result = caps1->can_intersect(caps2);
+
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  impl_->insert(entry);
+  return entry.result;
+}
+
+bool CapsCache::lookup(const Glib::RefPtr<const Gst::Caps>& caps, bool& result)
+{
+  guint hash1 = 0, hash2 = 0;
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+
+  const Impl::Entry* entry = impl_->find(OPERATION_LOOKUP, caps, Glib::RefPtr<const Gst::Caps>(), hash1, hash2);
+  if(!entry)
+    return false;
+
+  result = entry->result;
+  return true;
+}
+
+void CapsCache::insert(const Glib::RefPtr<const Gst::Caps>& caps, bool result)
+{
+  Impl::Entry entry(OPERATION_LOOKUP, caps, Glib::RefPtr<const Gst::Caps>(), caps->hash(), 0);
+  entry.result = result;
+
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  impl_->insert(entry);
+}
+
+void CapsCache::clear()
+{
+  // Drop the references outside of the lock.
+  Impl::EntryList entries;
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->by_identity.clear();
+    impl_->by_hash.clear();
+    entries.swap(impl_->entries);
+  }
+}
+
+gsize CapsCache::get_capacity() const
+{
+  return impl_->capacity;
+}
+
+gsize CapsCache::get_size() const
+{
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  return impl_->entries.size();
+}
+
+guint64 CapsCache::get_hits() const
+{
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  return impl_->hits;
+}
+
+guint64 CapsCache::get_misses() const
+{
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  return impl_->misses;
+}
+
+} // namespace Gst
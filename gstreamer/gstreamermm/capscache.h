@@ -0,0 +1,117 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_CAPSCACHE_H
+#define _GSTREAMERMM_CAPSCACHE_H
+
+#include <gstreamermm/caps.h>
+#include <memory>
+
+namespace Gst
+{
+
+/**
+ * Gst::CapsCache is a bounded, thread-safe cache of caps negotiation
+ * results.
+ *
+ * Negotiation repeatedly intersects and compares identical caps, and every
+ * comparison walks the structures field by field. Gst::CapsCache remembers
+ * the results of intersect(), is_subset() and can_intersect(), and evicts
+ * the least recently used result once its capacity is reached.
+ *
+ * Results are looked up by the identity of the caps first, and then by
+ * their structural hash (see Gst::Caps::hash()), verified with
+ * Gst::Caps::is_strictly_equal(). The cache keeps a reference to all caps it
+ * stores, which makes them non-writable for as long as they are cached;
+ * caps returned by intersect() are shared with the cache and have to be
+ * made writable before they are modified.
+ *
+ * lookup() and insert() memoize any other yes/no answer about a single
+ * caps, such as the result of an accept-caps query (see
+ * Gst::Pad::enable_accept_caps_cache()).
+ */
+class CapsCache
+{
+public:
+  /** Creates a cache holding at most @a capacity results.
+   */
+  explicit CapsCache(gsize capacity = 64);
+  ~CapsCache();
+
+  CapsCache(const CapsCache&) = delete;
+  CapsCache& operator=(const CapsCache&) = delete;
+
+  /** Returns the intersection of @a caps1 and @a caps2, like
+   * Gst::Caps::get_intersect().
+   */
+  Glib::RefPtr<Gst::Caps> intersect(const Glib::RefPtr<const Gst::Caps>& caps1,
+    const Glib::RefPtr<const Gst::Caps>& caps2, CapsIntersectMode mode = CAPS_INTERSECT_ZIG_ZAG);
+
+  /** Checks whether @a subset is a subset of @a superset, like
+   * Gst::Caps::is_subset().
+   */
+  bool is_subset(const Glib::RefPtr<const Gst::Caps>& subset,
+    const Glib::RefPtr<const Gst::Caps>& superset);
+
+  /** Checks whether @a caps1 and @a caps2 intersect, like
+   * Gst::Caps::can_intersect().
+   */
+  bool can_intersect(const Glib::RefPtr<const Gst::Caps>& caps1,
+    const Glib::RefPtr<const Gst::Caps>& caps2);
+
+  /** Looks up a result stored with insert().
+   *
+   * @param caps The caps the result belongs to.
+   * @param result Location for the stored result.
+   * @return true if a result was found.
+   */
+  bool lookup(const Glib::RefPtr<const Gst::Caps>& caps, bool& result);
+
+  /** Stores a yes/no @a result for @a caps.
+   */
+  void insert(const Glib::RefPtr<const Gst::Caps>& caps, bool result);
+
+  /** Removes all results. The hit and miss counters are not reset.
+   */
+  void clear();
+
+  /** Returns the maximum number of results held by the cache.
+   */
+  gsize get_capacity() const;
+
+  /** Returns the number of results currently held by the cache.
+   */
+  gsize get_size() const;
+
+  /** Returns the number of lookups answered from the cache.
+   */
+  guint64 get_hits() const;
+
+  /** Returns the number of lookups which were not found in the cache.
+   */
+  guint64 get_misses() const;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_CAPSCACHE_H */
@@ -0,0 +1,120 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/capsdescription.h>
+
+namespace Gst
+{
+
+void CapsField::append_to(GstStructure* structure) const
+{
+  GValue value = G_VALUE_INIT;
+
+  switch(kind_)
+  {
+    case KIND_BOOLEAN:
+      g_value_init(&value, G_TYPE_BOOLEAN);
+      g_value_set_boolean(&value, v0_);
+      break;
+    case KIND_INT:
+      g_value_init(&value, G_TYPE_INT);
+      g_value_set_int(&value, v0_);
+      break;
+    case KIND_INT_RANGE:
+      g_value_init(&value, GST_TYPE_INT_RANGE);
+      gst_value_set_int_range(&value, v0_, v1_);
+      break;
+    case KIND_INT_LIST:
+      g_value_init(&value, GST_TYPE_LIST);
+      for(std::size_t i = 0; i < count_; ++i)
+      {
+        GValue element = G_VALUE_INIT;
+        g_value_init(&element, G_TYPE_INT);
+        g_value_set_int(&element, ints_[i]);
+        gst_value_list_append_and_take_value(&value, &element);
+      }
+      break;
+    case KIND_FRACTION:
+      g_value_init(&value, GST_TYPE_FRACTION);
+      gst_value_set_fraction(&value, v0_, v1_);
+      break;
+    case KIND_FRACTION_RANGE:
+      g_value_init(&value, GST_TYPE_FRACTION_RANGE);
+      gst_value_set_fraction_range_full(&value, v0_, v1_, v2_, v3_);
+      break;
+    case KIND_STRING:
+      g_value_init(&value, G_TYPE_STRING);
+      g_value_set_static_string(&value, string_);
+      break;
+    case KIND_STRING_LIST:
+      g_value_init(&value, GST_TYPE_LIST);
+      for(std::size_t i = 0; i < count_; ++i)
+      {
+        GValue element = G_VALUE_INIT;
+        g_value_init(&element, G_TYPE_STRING);
+        g_value_set_static_string(&element, strings_[i]);
+        gst_value_list_append_and_take_value(&value, &element);
+      }
+      break;
+  }
+
+  gst_structure_take_value(structure, name_, &value);
+}
+
+void CapsStructureDescription::append_to(GstCaps* caps) const
+{
+  GstStructure* structure = gst_structure_new_empty(media_type_);
+
+  for(std::size_t i = 0; i < n_fields_; ++i)
+    fields_[i].append_to(structure);
+
+  gst_caps_append_structure_full(caps, structure,
+    features_ ? gst_caps_features_from_string(features_) : nullptr);
+}
+
+Glib::RefPtr<Gst::Caps> StaticCapsDescription::get() const
+{
+  GstCaps* caps = caps_.load(std::memory_order_acquire);
+
+  if(G_UNLIKELY(!caps))
+  {
+    GstCaps* built = gst_caps_new_empty();
+
+    if(structures_)
+    {
+      for(std::size_t i = 0; i < n_structures_; ++i)
+        structures_[i].append_to(built);
+    }
+    else
+      structure_.append_to(built);
+
+    // Like GstStaticCaps, the caps live until the end of the process.
+    GST_MINI_OBJECT_FLAG_SET(built, GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED);
+
+    // If another thread was faster, use its caps.
+    if(caps_.compare_exchange_strong(caps, built, std::memory_order_acq_rel, std::memory_order_acquire))
+      caps = built;
+    else
+      gst_caps_unref(built);
+  }
+
+  return Glib::wrap(caps, true);
+}
+
+} // namespace Gst
@@ -0,0 +1,286 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_CAPSDESCRIPTION_H
+#define _GSTREAMERMM_CAPSDESCRIPTION_H
+
+#include <gstreamermm/caps.h>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+
+namespace Gst
+{
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace Private
+{
+
+// Structure and field names start with a letter and continue with letters,
+// digits and any of "/-_.:+", see gst_structure_validate_name().
+constexpr bool caps_name_char_is_valid(char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+    c == '/' || c == '-' || c == '_' || c == '.' || c == ':' || c == '+';
+}
+
+constexpr bool caps_name_tail_is_valid(const char* name)
+{
+  return !*name || (caps_name_char_is_valid(*name) && caps_name_tail_is_valid(name + 1));
+}
+
+constexpr bool caps_name_is_valid(const char* name)
+{
+  return name && ((*name >= 'a' && *name <= 'z') || (*name >= 'A' && *name <= 'Z')) &&
+    caps_name_tail_is_valid(name + 1);
+}
+
+constexpr const char* checked_caps_name(const char* name)
+{
+  return caps_name_is_valid(name) ? name : throw std::invalid_argument("invalid caps name");
+}
+
+} // namespace Private
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+/**
+ * Gst::CapsField describes one field of a Gst::CapsStructureDescription.
+ *
+ * Fields are created with the constexpr factory functions, which validate
+ * the field name, ranges and fractions. When the fields are declared
+ * constexpr, invalid descriptions fail to compile:
+ * @code
+ * static const char* const formats[] = { "S16LE", "F32LE" };
+ * static constexpr Gst::CapsField audio_fields[] = {
+ *   Gst::CapsField::string_list("format", formats),
+ *   Gst::CapsField::string("layout", "interleaved"),
+ *   Gst::CapsField::int_range("rate", 1, G_MAXINT),
+ *   Gst::CapsField::int_range("channels", 1, 8)
+ * };
+ * @endcode
+ *
+ * Strings and lists are referenced, not copied, so they must have static
+ * storage duration.
+ */
+class CapsField
+{
+public:
+  enum Kind
+  {
+    KIND_BOOLEAN,
+    KIND_INT,
+    KIND_INT_RANGE,
+    KIND_INT_LIST,
+    KIND_FRACTION,
+    KIND_FRACTION_RANGE,
+    KIND_STRING,
+    KIND_STRING_LIST
+  };
+
+  /** A boolean field.
+   */
+  static constexpr CapsField boolean(const char* name, bool value)
+  {
+    return CapsField(name, KIND_BOOLEAN, value, 0, 0, 0);
+  }
+
+  /** An integer field.
+   */
+  static constexpr CapsField integer(const char* name, int value)
+  {
+    return CapsField(name, KIND_INT, value, 0, 0, 0);
+  }
+
+  /** An integer range field; @a min must be smaller than @a max.
+   */
+  static constexpr CapsField int_range(const char* name, int min, int max)
+  {
+    return min < max ? CapsField(name, KIND_INT_RANGE, min, max, 0, 0) :
+      throw std::invalid_argument("empty integer range");
+  }
+
+  /** A list of alternative integers; the list must not be empty.
+   */
+  template<std::size_t N>
+  static constexpr CapsField int_list(const char* name, const int (&values)[N])
+  {
+    return CapsField(name, KIND_INT_LIST, values, N);
+  }
+
+  /** A fraction field; @a denom must not be zero.
+   */
+  static constexpr CapsField fraction(const char* name, int num, int denom)
+  {
+    return denom ? CapsField(name, KIND_FRACTION, num, denom, 0, 0) :
+      throw std::invalid_argument("fraction with zero denominator");
+  }
+
+  /** A fraction range field from @a min_num/@a min_denom to
+   * @a max_num/@a max_denom; denominators must be positive.
+   */
+  static constexpr CapsField fraction_range(const char* name, int min_num, int min_denom, int max_num, int max_denom)
+  {
+    return min_denom > 0 && max_denom > 0 &&
+      static_cast<long long>(min_num) * max_denom < static_cast<long long>(max_num) * min_denom ?
+      CapsField(name, KIND_FRACTION_RANGE, min_num, min_denom, max_num, max_denom) :
+      throw std::invalid_argument("invalid fraction range");
+  }
+
+  /** A string field.
+   */
+  static constexpr CapsField string(const char* name, const char* value)
+  {
+    return value ? CapsField(name, KIND_STRING, value) :
+      throw std::invalid_argument("null string value");
+  }
+
+  /** A list of alternative strings; the list must not be empty.
+   */
+  template<std::size_t N>
+  static constexpr CapsField string_list(const char* name, const char* const (&values)[N])
+  {
+    return CapsField(name, KIND_STRING_LIST, values, N);
+  }
+
+  constexpr const char* get_name() const { return name_; }
+  constexpr Kind get_kind() const { return kind_; }
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  // Used by Gst::StaticCapsDescription to build the caps.
+  void append_to(GstStructure* structure) const;
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+private:
+  constexpr CapsField(const char* name, Kind kind, int v0, int v1, int v2, int v3)
+  : name_(Private::checked_caps_name(name)), kind_(kind), v0_(v0), v1_(v1), v2_(v2), v3_(v3),
+    string_(nullptr), strings_(nullptr), ints_(nullptr), count_(0)
+  {}
+
+  constexpr CapsField(const char* name, Kind kind, const char* value)
+  : name_(Private::checked_caps_name(name)), kind_(kind), v0_(0), v1_(0), v2_(0), v3_(0),
+    string_(value), strings_(nullptr), ints_(nullptr), count_(0)
+  {}
+
+  constexpr CapsField(const char* name, Kind kind, const char* const* values, std::size_t count)
+  : name_(Private::checked_caps_name(name)), kind_(kind), v0_(0), v1_(0), v2_(0), v3_(0),
+    string_(nullptr), strings_(values), ints_(nullptr), count_(count)
+  {}
+
+  constexpr CapsField(const char* name, Kind kind, const int* values, std::size_t count)
+  : name_(Private::checked_caps_name(name)), kind_(kind), v0_(0), v1_(0), v2_(0), v3_(0),
+    string_(nullptr), strings_(nullptr), ints_(values), count_(count)
+  {}
+
+  const char* name_;
+  Kind kind_;
+  int v0_, v1_, v2_, v3_;
+  const char* string_;
+  const char* const* strings_;
+  const int* ints_;
+  std::size_t count_;
+};
+
+/**
+ * Gst::CapsStructureDescription describes one structure of a
+ * Gst::StaticCapsDescription: a media type, its fields and optionally caps
+ * features such as "memory:GLMemory".
+ */
+class CapsStructureDescription
+{
+public:
+  /** Describes a structure without fields.
+   */
+  constexpr explicit CapsStructureDescription(const char* media_type, const char* features = nullptr)
+  : media_type_(Private::checked_caps_name(media_type)), fields_(nullptr), n_fields_(0),
+    features_(features)
+  {}
+
+  /** Describes a structure with the given @a fields.
+   */
+  template<std::size_t N>
+  constexpr CapsStructureDescription(const char* media_type, const CapsField (&fields)[N],
+    const char* features = nullptr)
+  : media_type_(Private::checked_caps_name(media_type)), fields_(fields), n_fields_(N),
+    features_(features)
+  {}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  // Used by Gst::StaticCapsDescription to build the caps.
+  void append_to(GstCaps* caps) const;
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+private:
+  const char* media_type_;
+  const CapsField* fields_;
+  std::size_t n_fields_;
+  const char* features_;
+};
+
+/**
+ * Gst::StaticCapsDescription is a caps description which is materialized
+ * into a Gst::Caps the first time it is needed and shared afterwards.
+ *
+ * It replaces building the same caps from a string or with
+ * Gst::Caps::set_simple() each time an element class or instance is
+ * initialized. The constructor is constexpr, so a description with static
+ * storage duration is initialized before any code runs:
+ * @code
+ * static const Gst::StaticCapsDescription sink_caps(
+ *   Gst::CapsStructureDescription("audio/x-raw", audio_fields));
+ * ...
+ * add_pad_template(Gst::PadTemplate::create("sink", Gst::PAD_SINK,
+ *   Gst::PAD_ALWAYS, sink_caps.get()));
+ * @endcode
+ *
+ * The caps returned by get() are shared and must not be modified.
+ */
+class StaticCapsDescription
+{
+public:
+  /** Describes caps with a single structure.
+   */
+  constexpr explicit StaticCapsDescription(const CapsStructureDescription& structure)
+  : structure_(structure), structures_(nullptr), n_structures_(0), caps_(nullptr)
+  {}
+
+  /** Describes caps with several alternative structures.
+   */
+  template<std::size_t N>
+  constexpr explicit StaticCapsDescription(const CapsStructureDescription (&structures)[N])
+  : structure_("application/x-unused"), structures_(structures), n_structures_(N), caps_(nullptr)
+  {}
+
+  StaticCapsDescription(const StaticCapsDescription&) = delete;
+  StaticCapsDescription& operator=(const StaticCapsDescription&) = delete;
+
+  /** Returns the described caps. They are built on the first call and the
+   * same caps are returned by all later calls.
+   */
+  Glib::RefPtr<Gst::Caps> get() const;
+
+private:
+  CapsStructureDescription structure_;
+  const CapsStructureDescription* structures_;
+  std::size_t n_structures_;
+  mutable std::atomic<GstCaps*> caps_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_CAPSDESCRIPTION_H */
@@ -0,0 +1,105 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_FIELDKEY_H
+#define _GSTREAMERMM_FIELDKEY_H
+
+#include <glib.h>
+#include <atomic>
+
+namespace Gst
+{
+
+/**
+ * Gst::FieldKey is a pre-interned name of a Gst::Structure field or a
+ * Gst::TagList tag.
+ *
+ * Methods taking a Glib::ustring field name have to build the string and
+ * look the name up in the GQuark table on every call. A Gst::FieldKey is
+ * created once, usually as a static constant, and looks the name up only
+ * the first time its quark is needed:
+ * @code
+ * static const Gst::FieldKey width_key("width");
+ * ...
+ * int width;
+ * if(structure.get_field(width_key, width))
+ *   ...
+ * @endcode
+ *
+ * The constructor taking a name is constexpr, so static keys are constant
+ * initialized and do not depend on static initialization order. The name
+ * must have static storage duration (e.g. a string literal).
+ */
+class FieldKey
+{
+public:
+  /** Creates a key for the field @a name. The name is interned lazily.
+   * @param name A string with static storage duration.
+   */
+  constexpr explicit FieldKey(const char* name) noexcept
+  : name_(name), quark_(0)
+  {}
+
+  /** Creates a key from an already interned quark.
+   */
+  explicit FieldKey(GQuark quark) noexcept
+  : name_(g_quark_to_string(quark)), quark_(quark)
+  {}
+
+  FieldKey(const FieldKey& other) noexcept
+  : name_(other.name_), quark_(other.quark_.load(std::memory_order_relaxed))
+  {}
+
+  FieldKey& operator=(const FieldKey& other) noexcept
+  {
+    name_ = other.name_;
+    quark_.store(other.quark_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+  }
+
+  /** Returns the field name.
+   */
+  const char* get_name() const noexcept
+  {
+    return name_;
+  }
+
+  /** Returns the quark of the field name, interning it on first use.
+   */
+  GQuark get_quark() const noexcept
+  {
+    GQuark quark = quark_.load(std::memory_order_relaxed);
+    if(G_UNLIKELY(!quark))
+    {
+      // Interning the same string twice yields the same quark, so racing
+      // threads store the same value.
+      quark = g_quark_from_static_string(name_);
+      quark_.store(quark, std::memory_order_relaxed);
+    }
+    return quark;
+  }
+
+private:
+  const char* name_;
+  mutable std::atomic<GQuark> quark_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_FIELDKEY_H */
@@ -0,0 +1,522 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/loudnessmeter.h>
+#include <gstreamermm/handle_error.h>
+#include <gstreamermm/mapinfo.h>
+#include <gstreamermm/message.h>
+#include <gstreamermm/structure.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+// The blocks of the momentary and short-term loudness, in blocks of 100 ms.
+const gsize momentary_blocks = 4;
+const gsize short_term_blocks = 30;
+
+// The histogram of the gating blocks covers -70 LUFS to +30 LUFS.
+const double absolute_gate = -70.0;
+const int histogram_bins = 1000;
+const double bins_per_lu = 10.0;
+
+// The quality of the oversampling filter of the true peak.
+const int true_peak_quality = 2;
+
+double to_lufs(double mean_square)
+{
+  return mean_square > 0.0 ? -0.691 + 10.0 * std::log10(mean_square) :
+    -std::numeric_limits<double>::infinity();
+}
+
+double to_db(double peak)
+{
+  return peak > 0.0 ? 20.0 * std::log10(peak) : -std::numeric_limits<double>::infinity();
+}
+
+gboolean loudness_meta_init(GstMeta* meta, gpointer, GstBuffer*)
+{
+  Gst::LoudnessMeta* const loudness = reinterpret_cast<Gst::LoudnessMeta*>(meta);
+  loudness->momentary = loudness->short_term = loudness->integrated = loudness->true_peak =
+    -std::numeric_limits<double>::infinity();
+  return TRUE;
+}
+
+gboolean loudness_meta_transform(GstBuffer* dest, GstMeta* meta, GstBuffer*, GQuark type, gpointer)
+{
+  // Copies keep the measurement; the other transformations change the
+  // samples, which drops the metadata thanks to its audio tag.
+  if(GST_META_TRANSFORM_IS_COPY(type))
+  {
+    const Gst::LoudnessMeta* const source = reinterpret_cast<Gst::LoudnessMeta*>(meta);
+    Gst::LoudnessMeta* const copy = reinterpret_cast<Gst::LoudnessMeta*>(
+      gst_buffer_add_meta(dest, Gst::LoudnessMeta::get_info(), nullptr));
+    copy->momentary = source->momentary;
+    copy->short_term = source->short_term;
+    copy->integrated = source->integrated;
+    copy->true_peak = source->true_peak;
+  }
+  return TRUE;
+}
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+LoudnessMeter::LoudnessMeter(const Gst::AudioInfo& info)
+{
+  init(info.get_rate(), info.get_channels());
+
+  if(info.get_flags() & Gst::AUDIO_FLAG_UNPOSITIONED)
+    return;
+
+  for(int c = 0; c < channels_; ++c)
+  {
+    switch(info.gobj()->position[c])
+    {
+      case GST_AUDIO_CHANNEL_POSITION_LFE1:
+      case GST_AUDIO_CHANNEL_POSITION_LFE2:
+        weights_[c] = 0.0;
+        break;
+      case GST_AUDIO_CHANNEL_POSITION_REAR_LEFT:
+      case GST_AUDIO_CHANNEL_POSITION_REAR_RIGHT:
+      case GST_AUDIO_CHANNEL_POSITION_SIDE_LEFT:
+      case GST_AUDIO_CHANNEL_POSITION_SIDE_RIGHT:
+        weights_[c] = 1.41;
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+LoudnessMeter::LoudnessMeter(int rate, int channels)
+{
+  init(rate, channels);
+}
+
+void LoudnessMeter::init(int rate, int channels)
+{
+  if(rate <= 0 || channels <= 0)
+    gstreamermm_handle_error("invalid loudness meter configuration");
+
+  rate_ = rate;
+  channels_ = channels;
+  weights_.assign(channels, 1.0);
+
+  // The K-weighting filter: a high shelf modelling the head, then a high
+  // pass, designed for any rate from the analog prototypes of BS.1770.
+  double f0 = 1681.974450955533;
+  double q = 0.7071752369554196;
+  double k = std::tan(G_PI * f0 / rate);
+  const double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+  const double vb = std::pow(vh, 0.4996667741545416);
+  double a0 = 1.0 + k / q + k * k;
+  shelf_.b0 = (vh + vb * k / q + k * k) / a0;
+  shelf_.b1 = 2.0 * (k * k - vh) / a0;
+  shelf_.b2 = (vh - vb * k / q + k * k) / a0;
+  shelf_.a1 = 2.0 * (k * k - 1.0) / a0;
+  shelf_.a2 = (1.0 - k / q + k * k) / a0;
+
+  f0 = 38.13547087602444;
+  q = 0.5003270373238773;
+  k = std::tan(G_PI * f0 / rate);
+  a0 = 1.0 + k / q + k * k;
+  high_pass_.b0 = 1.0;
+  high_pass_.b1 = -2.0;
+  high_pass_.b2 = 1.0;
+  high_pass_.a1 = 2.0 * (k * k - 1.0) / a0;
+  high_pass_.a2 = (1.0 - k / q + k * k) / a0;
+
+  block_length_ = std::max(1, (rate + 5) / 10);
+
+  const int oversampling = rate < 96000 ? 4 : rate < 192000 ? 2 : 1;
+  if(oversampling > 1)
+  {
+    oversampler_.reset(new PolyphaseResampler(
+      PolyphaseFilterBank::get(rate, rate * oversampling, true_peak_quality), channels));
+  }
+  kernels_.reset(new AudioKernels(Gst::AUDIO_FORMAT_F32, channels));
+
+  reset();
+}
+
+int LoudnessMeter::get_rate() const
+{
+  return rate_;
+}
+
+int LoudnessMeter::get_channels() const
+{
+  return channels_;
+}
+
+void LoudnessMeter::set_channel_weight(int channel, double weight)
+{
+  g_return_if_fail(channel >= 0 && channel < channels_);
+  weights_[channel] = weight;
+}
+
+double LoudnessMeter::get_channel_weight(int channel) const
+{
+  g_return_val_if_fail(channel >= 0 && channel < channels_, 0.0);
+  return weights_[channel];
+}
+
+void LoudnessMeter::reset()
+{
+  state_.assign(4 * channels_, 0.0);
+  block_sums_.assign(channels_, 0.0);
+  block_frames_ = 0;
+  blocks_.assign(short_term_blocks, 0.0);
+  next_block_ = 0;
+  n_blocks_ = 0;
+  histogram_counts_.assign(histogram_bins, 0);
+  histogram_sums_.assign(histogram_bins, 0.0);
+  if(oversampler_)
+    oversampler_->reset();
+  true_peak_ = 0.0;
+  max_true_peak_ = 0.0;
+  last_true_peak_ = 0.0;
+}
+
+void LoudnessMeter::process(const float* data, gsize frames)
+{
+  const Biquad shelf = shelf_;
+  const Biquad high_pass = high_pass_;
+
+  for(gsize i = 0; i < frames; ++i)
+  {
+    for(int c = 0; c < channels_; ++c)
+    {
+      // Transposed direct form II, in double precision: the 38 Hz high
+      // pass is too close to DC for single precision.
+      double* const z = &state_[4 * c];
+      const double x = data[i * channels_ + c];
+      const double s = shelf.b0 * x + z[0];
+      z[0] = shelf.b1 * x - shelf.a1 * s + z[1];
+      z[1] = shelf.b2 * x - shelf.a2 * s;
+      const double y = high_pass.b0 * s + z[2];
+      z[2] = high_pass.b1 * s - high_pass.a1 * y + z[3];
+      z[3] = high_pass.b2 * s - high_pass.a2 * y;
+      block_sums_[c] += y * y;
+    }
+
+    if(++block_frames_ == block_length_)
+      end_block();
+  }
+
+  // The sample peak, and the peak between the samples.
+  double peak = 0.0, rms = 0.0;
+  kernels_->measure(data, frames, peak, rms);
+  if(oversampler_)
+  {
+    oversampled_.resize(oversampler_->get_out_frames(frames) * channels_);
+    const gsize oversampled_frames = oversampler_->process(data, frames, oversampled_.data());
+    double oversampled_peak = 0.0;
+    kernels_->measure(oversampled_.data(), oversampled_frames, oversampled_peak, rms);
+    peak = std::max(peak, oversampled_peak);
+  }
+
+  last_true_peak_ = peak;
+  true_peak_ = std::max(true_peak_, peak);
+  max_true_peak_ = std::max(max_true_peak_, peak);
+}
+
+void LoudnessMeter::end_block()
+{
+  double mean_square = 0.0;
+  for(int c = 0; c < channels_; ++c)
+  {
+    mean_square += weights_[c] * block_sums_[c] / block_length_;
+    block_sums_[c] = 0.0;
+  }
+  block_frames_ = 0;
+
+  blocks_[next_block_] = mean_square;
+  next_block_ = (next_block_ + 1) % short_term_blocks;
+  ++n_blocks_;
+
+  // The gating blocks of 400 ms overlap by 75%.
+  if(n_blocks_ < momentary_blocks)
+    return;
+
+  double gating_block = 0.0;
+  for(gsize i = 1; i <= momentary_blocks; ++i)
+    gating_block += blocks_[(next_block_ + short_term_blocks - i) % short_term_blocks];
+  gating_block /= momentary_blocks;
+
+  const double loudness = to_lufs(gating_block);
+  if(loudness < absolute_gate)
+    return;
+
+  const int bin = std::min(histogram_bins - 1,
+    static_cast<int>((loudness - absolute_gate) * bins_per_lu));
+  ++histogram_counts_[bin];
+  histogram_sums_[bin] += gating_block;
+}
+
+double LoudnessMeter::get_momentary() const
+{
+  double sum = 0.0;
+  for(gsize i = 1; i <= momentary_blocks; ++i)
+    sum += blocks_[(next_block_ + short_term_blocks - i) % short_term_blocks];
+  return to_lufs(sum / momentary_blocks);
+}
+
+double LoudnessMeter::get_short_term() const
+{
+  double sum = 0.0;
+  for(double block : blocks_)
+    sum += block;
+  return to_lufs(sum / short_term_blocks);
+}
+
+double LoudnessMeter::get_integrated() const
+{
+  guint64 count = 0;
+  double sum = 0.0;
+  for(int bin = 0; bin < histogram_bins; ++bin)
+  {
+    count += histogram_counts_[bin];
+    sum += histogram_sums_[bin];
+  }
+  if(!count)
+    return -std::numeric_limits<double>::infinity();
+
+  // The bins whose center is above the relative gate.
+  const double relative_gate = to_lufs(sum / count) - 10.0;
+  count = 0;
+  sum = 0.0;
+  for(int bin = 0; bin < histogram_bins; ++bin)
+  {
+    if(absolute_gate + (bin + 0.5) / bins_per_lu >= relative_gate)
+    {
+      count += histogram_counts_[bin];
+      sum += histogram_sums_[bin];
+    }
+  }
+
+  return count ? to_lufs(sum / count) : -std::numeric_limits<double>::infinity();
+}
+
+double LoudnessMeter::get_true_peak() const
+{
+  return to_db(true_peak_);
+}
+
+double LoudnessMeter::get_max_true_peak() const
+{
+  return to_db(max_true_peak_);
+}
+
+double LoudnessMeter::get_last_true_peak() const
+{
+  return to_db(last_true_peak_);
+}
+
+void LoudnessMeter::reset_true_peak()
+{
+  true_peak_ = 0.0;
+}
+
+GType LoudnessMeta::get_api_type()
+{
+  static const gchar* tags[] = { GST_META_TAG_AUDIO_STR, nullptr };
+  static const GType type = gst_meta_api_type_register("GstMMLoudnessMetaAPI", tags);
+  return type;
+}
+
+const GstMetaInfo* LoudnessMeta::get_info()
+{
+  static const GstMetaInfo* const info = gst_meta_register(get_api_type(), "GstMMLoudnessMeta",
+    sizeof(LoudnessMeta), &loudness_meta_init, nullptr, &loudness_meta_transform);
+  return info;
+}
+
+LoudnessMeta* LoudnessMeta::add(const Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  return reinterpret_cast<LoudnessMeta*>(gst_buffer_add_meta(buffer->gobj(), get_info(), nullptr));
+}
+
+LoudnessMeta* LoudnessMeta::get(const Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  return reinterpret_cast<LoudnessMeta*>(gst_buffer_get_meta(buffer->gobj(), get_api_type()));
+}
+
+bool LoudnessLevel::register_element(Glib::RefPtr<Gst::Plugin> plugin)
+{
+  return Gst::ElementFactory::register_element(plugin, "mmloudnesslevel", Gst::RANK_NONE,
+    Gst::register_mm_type<LoudnessLevel>("gstreamermm__LoudnessLevel"));
+}
+
+void LoudnessLevel::class_init(Gst::ElementClass<LoudnessLevel>* klass)
+{
+  klass->set_metadata("Loudness level", "Filter/Analyzer/Audio",
+    "Measures the EBU R 128 loudness and true peak of audio",
+    "The gstreamermm Development Team");
+
+  Gst::AudioFilter::add_pad_templates(klass,
+    Gst::AudioFilter::create_caps({ Gst::AUDIO_FORMAT_S16, Gst::AUDIO_FORMAT_F32 }));
+}
+
+LoudnessLevel::LoudnessLevel(GstAudioFilter* gobj)
+: Glib::ObjectBase(typeid (LoudnessLevel)),
+  Gst::AudioFilter(gobj),
+  interval_(*this, "interval", GST_SECOND),
+  post_messages_(*this, "post-messages", true),
+  attach_meta_(*this, "attach-meta", true),
+  rate_(0),
+  interval_frames_(0)
+{
+  set_in_place(true);
+  property_attach_meta().signal_changed().connect(
+    sigc::mem_fun(*this, &LoudnessLevel::on_attach_meta_changed));
+}
+
+Glib::PropertyProxy<guint64> LoudnessLevel::property_interval()
+{
+  return interval_.get_proxy();
+}
+
+Glib::PropertyProxy<bool> LoudnessLevel::property_post_messages()
+{
+  return post_messages_.get_proxy();
+}
+
+Glib::PropertyProxy<bool> LoudnessLevel::property_attach_meta()
+{
+  return attach_meta_.get_proxy();
+}
+
+bool LoudnessLevel::setup_vfunc(const Gst::AudioInfo& info)
+{
+  meter_.reset(new LoudnessMeter(info));
+  kernels_.reset(GST_AUDIO_INFO_FORMAT(info.gobj()) == GST_AUDIO_FORMAT_S16 ?
+    new AudioKernels(info) : nullptr);
+  rate_ = info.get_rate();
+  interval_frames_ = 0;
+
+  on_attach_meta_changed();
+  return true;
+}
+
+Gst::FlowReturn LoudnessLevel::transform_ip_vfunc(const Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  if(!meter_)
+    return Gst::FLOW_NOT_NEGOTIATED;
+
+  Gst::MapInfo map;
+  if(!buffer->map(map, Gst::MAP_READ))
+    return Gst::FLOW_ERROR;
+
+  const int channels = meter_->get_channels();
+  const gsize frames = map.get_size() / ((kernels_ ? sizeof(gint16) : sizeof(float)) * channels);
+  const float* samples = reinterpret_cast<const float*>(map.get_data());
+  if(kernels_)
+  {
+    converted_.resize(frames * channels);
+    kernels_->convert(map.get_data(), Gst::AUDIO_FORMAT_F32, converted_.data(), frames);
+    samples = converted_.data();
+  }
+  meter_->process(samples, frames);
+  buffer->unmap(map);
+
+  if(attach_meta_.get_value() && gst_buffer_is_writable(buffer->gobj()))
+  {
+    LoudnessMeta* const meta = LoudnessMeta::add(buffer);
+    meta->momentary = meter_->get_momentary();
+    meta->short_term = meter_->get_short_term();
+    meta->integrated = meter_->get_integrated();
+    meta->true_peak = meter_->get_last_true_peak();
+  }
+
+  interval_frames_ += frames;
+  const guint64 interval = std::max<guint64>(1,
+    gst_util_uint64_scale_int(interval_.get_value(), rate_, GST_SECOND));
+  if(interval_frames_ >= interval)
+  {
+    Gst::ClockTime end = buffer->get_pts();
+    if(end != Gst::CLOCK_TIME_NONE)
+      end += gst_util_uint64_scale_int(frames, GST_SECOND, rate_);
+    post_loudness(end);
+  }
+
+  return Gst::FLOW_OK;
+}
+
+void LoudnessLevel::on_attach_meta_changed()
+{
+  // Without metadata, the buffers need not be writable.
+  set_passthrough(!attach_meta_.get_value());
+}
+
+void LoudnessLevel::post_loudness(Gst::ClockTime end)
+{
+  if(post_messages_.get_value())
+  {
+    Gst::Structure structure("loudness");
+    structure.set_field("timestamp", static_cast<guint64>(end));
+    structure.set_field("duration",
+      static_cast<guint64>(gst_util_uint64_scale_int(interval_frames_, GST_SECOND, rate_)));
+    structure.set_field("momentary", meter_->get_momentary());
+    structure.set_field("short-term", meter_->get_short_term());
+    structure.set_field("integrated", meter_->get_integrated());
+    structure.set_field("true-peak", meter_->get_true_peak());
+    structure.set_field("max-true-peak", meter_->get_max_true_peak());
+
+    post_message(Gst::MessageElement::create(
+      Glib::wrap(GST_OBJECT(gobj()), true), std::move(structure)));
+  }
+
+  interval_frames_ = 0;
+  meter_->reset_true_peak();
+}
+
+bool LoudnessLevel::sink_event_vfunc(const Glib::RefPtr<Gst::Event>& event)
+{
+  switch(event->get_event_type())
+  {
+    case Gst::EVENT_EOS:
+      // Report the last, partial interval.
+      if(meter_ && interval_frames_)
+        post_loudness(Gst::CLOCK_TIME_NONE);
+      break;
+    case Gst::EVENT_FLUSH_STOP:
+      if(meter_)
+        meter_->reset();
+      interval_frames_ = 0;
+      break;
+    default:
+      break;
+  }
+
+  return Gst::AudioFilter::sink_event_vfunc(event);
+}
+
+bool LoudnessLevel::stop_vfunc()
+{
+  meter_.reset();
+  return Gst::AudioFilter::stop_vfunc();
+}
+
+} // namespace Gst
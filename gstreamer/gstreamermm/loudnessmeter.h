@@ -0,0 +1,261 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_LOUDNESSMETER_H
+#define _GSTREAMERMM_LOUDNESSMETER_H
+
+#include <gstreamermm/audiofilter.h>
+#include <gstreamermm/audioinfo.h>
+#include <gstreamermm/audiokernels.h>
+#include <gstreamermm/buffer.h>
+#include <gstreamermm/elementfactory.h>
+#include <gstreamermm/plugin.h>
+#include <gstreamermm/polyphaseresampler.h>
+#include <gstreamermm/register.h>
+#include <glibmm/property.h>
+#include <memory>
+#include <vector>
+
+namespace Gst
+{
+
+/**
+ * Gst::LoudnessMeter measures the loudness of interleaved F32 audio as
+ * specified by ITU-R BS.1770 and EBU R 128.
+ *
+ * The samples are K-weighted and accumulated in blocks of 100 ms. The
+ * momentary loudness covers the last 400 ms, the short-term loudness the
+ * last 3 s, and the integrated loudness the whole stream, with the absolute
+ * gate at -70 LUFS and the relative gate 10 LU below the ungated level. The
+ * true peak is measured on the signal oversampled 4 times below 96 kHz and
+ * twice below 192 kHz, with a Gst::PolyphaseResampler.
+ *
+ * Loudness values are in LUFS and peaks in dBTP; both are
+ * -std::numeric_limits<double>::infinity() for silence.
+ */
+class LoudnessMeter
+{
+public:
+  /** Creates a meter for the rate, channels and channel positions of
+   * @a info. The surround channels are weighted by 1.41 and the LFE channel
+   * is ignored.
+   */
+  explicit LoudnessMeter(const Gst::AudioInfo& info);
+
+  /** Creates a meter for @a channels channels of equal weights.
+   *
+   * @throw std::runtime_error if the rate or the number of channels is not
+   * positive.
+   */
+  LoudnessMeter(int rate, int channels);
+
+  /** Returns the sample rate.
+   */
+  int get_rate() const;
+
+  /** Returns the number of channels.
+   */
+  int get_channels() const;
+
+  /** Sets the weight of @a channel, 0.0 to ignore it.
+   */
+  void set_channel_weight(int channel, double weight);
+
+  /** Returns the weight of @a channel.
+   */
+  double get_channel_weight(int channel) const;
+
+  /** Measures @a frames frames at @a data.
+   */
+  void process(const float* data, gsize frames);
+
+  /** Returns the loudness of the last 400 ms.
+   */
+  double get_momentary() const;
+
+  /** Returns the loudness of the last 3 s.
+   */
+  double get_short_term() const;
+
+  /** Returns the gated loudness of the whole stream.
+   */
+  double get_integrated() const;
+
+  /** Returns the true peak since the last call to reset_true_peak().
+   */
+  double get_true_peak() const;
+
+  /** Returns the true peak of the whole stream.
+   */
+  double get_max_true_peak() const;
+
+  /** Returns the true peak of the frames of the last call to process().
+   */
+  double get_last_true_peak() const;
+
+  /** Starts a new interval for get_true_peak().
+   */
+  void reset_true_peak();
+
+  /** Forgets the measured stream.
+   */
+  void reset();
+
+private:
+  void init(int rate, int channels);
+  void end_block();
+
+  struct Biquad
+  {
+    double b0, b1, b2, a1, a2;
+  };
+
+  int rate_;
+  int channels_;
+  std::vector<double> weights_;
+  Biquad shelf_;
+  Biquad high_pass_;
+  // Two transposed direct form II states per channel and filter.
+  std::vector<double> state_;
+  // The sum of the squares of each channel in the current block.
+  std::vector<double> block_sums_;
+  gsize block_frames_;
+  gsize block_length_;
+  // The weighted mean squares of the last 30 blocks of 100 ms.
+  std::vector<double> blocks_;
+  gsize next_block_;
+  gsize n_blocks_;
+  // The gating blocks of 400 ms, in bins of 0.1 LU from -70 LUFS.
+  std::vector<guint64> histogram_counts_;
+  std::vector<double> histogram_sums_;
+
+  std::unique_ptr<PolyphaseResampler> oversampler_;
+  std::unique_ptr<AudioKernels> kernels_;
+  std::vector<float> oversampled_;
+  double true_peak_;
+  double max_true_peak_;
+  double last_true_peak_;
+};
+
+/**
+ * Gst::LoudnessMeta holds the loudness measured by Gst::LoudnessLevel at the
+ * end of a buffer.
+ *
+ * @code
+ * Gst::LoudnessMeta* meta = Gst::LoudnessMeta::get(buffer);
+ * if(meta)
+ *   std::cout << meta->momentary << " LUFS" << std::endl;
+ * @endcode
+ */
+struct LoudnessMeta
+{
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  GstMeta meta;
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+  /** The momentary loudness, in LUFS. */
+  double momentary;
+  /** The short-term loudness, in LUFS. */
+  double short_term;
+  /** The integrated loudness, in LUFS. */
+  double integrated;
+  /** The true peak of the buffer, in dBTP. */
+  double true_peak;
+
+  /** Returns the API type of the metadata.
+   */
+  static GType get_api_type();
+
+  /** Returns the registered implementation of the metadata.
+   */
+  static const GstMetaInfo* get_info();
+
+  /** Adds a Gst::LoudnessMeta to @a buffer, which must be writable.
+   */
+  static LoudnessMeta* add(const Glib::RefPtr<Gst::Buffer>& buffer);
+
+  /** Returns the Gst::LoudnessMeta of @a buffer, or nullptr.
+   */
+  static LoudnessMeta* get(const Glib::RefPtr<Gst::Buffer>& buffer);
+};
+
+/**
+ * Gst::LoudnessLevel is an in-place element measuring the loudness of S16
+ * or F32 audio with a Gst::LoudnessMeter.
+ *
+ * It is registered as "mmloudnesslevel" by register_element(). Every
+ * "interval" nanoseconds of audio, it posts a Gst::MessageElement with a
+ * "loudness" structure holding the "timestamp", "duration", "momentary",
+ * "short-term", "integrated", "true-peak" and "max-true-peak" fields, as
+ * doubles except for the first two. When "attach-meta" is true, each buffer
+ * also gets a Gst::LoudnessMeta; the buffers are otherwise passed through
+ * unchanged, without being copied.
+ */
+class LoudnessLevel : public Gst::AudioFilter
+{
+public:
+  /** Registers the element as "mmloudnesslevel" in @a plugin.
+   */
+  static bool register_element(Glib::RefPtr<Gst::Plugin> plugin);
+
+  /** The interval between the messages, in nanoseconds.
+   */
+  Glib::PropertyProxy<guint64> property_interval();
+
+  /** Whether to post the messages.
+   */
+  Glib::PropertyProxy<bool> property_post_messages();
+
+  /** Whether to attach a Gst::LoudnessMeta to each buffer. Can be changed
+   * while playing.
+   */
+  Glib::PropertyProxy<bool> property_attach_meta();
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  static void class_init(Gst::ElementClass<LoudnessLevel>* klass);
+
+  explicit LoudnessLevel(GstAudioFilter* gobj);
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+protected:
+  bool setup_vfunc(const Gst::AudioInfo& info) override;
+  Gst::FlowReturn transform_ip_vfunc(const Glib::RefPtr<Gst::Buffer>& buffer) override;
+  bool sink_event_vfunc(const Glib::RefPtr<Gst::Event>& event) override;
+  bool stop_vfunc() override;
+
+private:
+  void on_attach_meta_changed();
+  void post_loudness(Gst::ClockTime end);
+
+  Glib::Property<guint64> interval_;
+  Glib::Property<bool> post_messages_;
+  Glib::Property<bool> attach_meta_;
+
+  std::unique_ptr<LoudnessMeter> meter_;
+  // Converts S16 samples to F32 for the meter.
+  std::unique_ptr<AudioKernels> kernels_;
+  std::vector<float> converted_;
+  int rate_;
+  // The frames measured since the last message.
+  guint64 interval_frames_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_LOUDNESSMETER_H */
@@ -0,0 +1,102 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/mappedaudiobuffer.h>
+#include <gstreamermm/handle_error.h>
+
+namespace Gst
+{
+
+MappedAudioBuffer::MappedAudioBuffer(const Gst::AudioInfo& info,
+  const Glib::RefPtr<Gst::Buffer>& buffer, Gst::MapFlags flags)
+: buffer_(buffer),
+  frames_(0),
+  channels_(info.get_channels()),
+  sample_size_(GST_AUDIO_INFO_WIDTH(info.gobj()) / 8),
+  planar_(!info.is_interleaved())
+{
+  const int bpf = info.get_bpf();
+
+  if(!buffer || bpf <= 0)
+    gstreamermm_handle_error("Gst::MappedAudioBuffer: invalid buffer or audio info");
+
+  if(!buffer->map(map_, flags))
+    gstreamermm_handle_error("Gst::MappedAudioBuffer: failed to map the buffer");
+
+  if(map_.get_size() % bpf)
+  {
+    buffer->unmap(map_);
+    gstreamermm_handle_error("Gst::MappedAudioBuffer: the buffer does not hold whole frames");
+  }
+
+  frames_ = map_.get_size() / bpf;
+
+  // Without a GstAudioMeta, the planes are tightly packed one after the
+  // other.
+  guint8* const data = map_.get_data();
+  const int n_planes = info.get_n_planes();
+  const gsize plane_size = frames_ * sample_size_ * (planar_ ? 1 : channels_);
+
+  planes_.reserve(n_planes);
+  for(int i = 0; i < n_planes; ++i)
+    planes_.push_back(data + i * plane_size);
+}
+
+MappedAudioBuffer::~MappedAudioBuffer()
+{
+  buffer_->unmap(map_);
+}
+
+gsize MappedAudioBuffer::get_n_frames() const
+{
+  return frames_;
+}
+
+int MappedAudioBuffer::get_n_channels() const
+{
+  return channels_;
+}
+
+int MappedAudioBuffer::get_n_planes() const
+{
+  return planes_.size();
+}
+
+bool MappedAudioBuffer::is_planar() const
+{
+  return planar_;
+}
+
+gpointer MappedAudioBuffer::get_plane(int plane) const
+{
+  g_return_val_if_fail(plane >= 0 && plane < get_n_planes(), nullptr);
+  return planes_[plane];
+}
+
+const std::vector<gpointer>& MappedAudioBuffer::get_planes() const
+{
+  return planes_;
+}
+
+Glib::RefPtr<Gst::Buffer> MappedAudioBuffer::get_buffer() const
+{
+  return buffer_;
+}
+
+} // namespace Gst
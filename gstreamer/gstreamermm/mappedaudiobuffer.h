@@ -0,0 +1,183 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_MAPPEDAUDIOBUFFER_H
+#define _GSTREAMERMM_MAPPEDAUDIOBUFFER_H
+
+#include <gstreamermm/audioinfo.h>
+#include <gstreamermm/buffer.h>
+#include <gstreamermm/mapinfo.h>
+#include <vector>
+
+namespace Gst
+{
+
+/**
+ * Gst::AudioChannelView gives access to the samples of one channel of a
+ * Gst::MappedAudioBuffer, without copying them.
+ *
+ * The samples of a channel are contiguous in a non-interleaved buffer, and
+ * get_stride() samples apart in an interleaved one. Loops which are meant to
+ * be vectorized check is_contiguous() and use data() directly.
+ */
+template<typename T>
+class AudioChannelView
+{
+public:
+  AudioChannelView(T* data, gsize frames, gsize stride)
+  : data_(data), frames_(frames), stride_(stride)
+  {}
+
+  /** Returns a pointer to the first sample.
+   */
+  T* data() const { return data_; }
+
+  /** Returns the number of samples.
+   */
+  gsize size() const { return frames_; }
+
+  /** Returns the distance between two samples, in samples.
+   */
+  gsize get_stride() const { return stride_; }
+
+  /** Checks whether the samples follow each other in memory.
+   */
+  bool is_contiguous() const { return stride_ == 1; }
+
+  /** Returns the sample of frame @a i.
+   */
+  T& operator[](gsize i) const { return data_[i * stride_]; }
+
+private:
+  T* data_;
+  gsize frames_;
+  gsize stride_;
+};
+
+/**
+ * Gst::MappedAudioBuffer maps a Gst::Buffer of raw audio and exposes its
+ * planes and channels in the format described by a Gst::AudioInfo.
+ *
+ * With the non-interleaved layout, the buffer holds one plane per channel,
+ * one after the other, and each channel is a contiguous array of samples.
+ * Per-channel processing then works in place, instead of deinterleaving and
+ * interleaving every buffer:
+ * @code
+ * Gst::FlowReturn MyFilter::transform_ip_vfunc(const Glib::RefPtr<Gst::Buffer>& buffer)
+ * {
+ *   Gst::MappedAudioBuffer audio(info, buffer, Gst::MAP_READWRITE);
+ *   for(int c = 0; c < audio.get_n_channels(); ++c)
+ *   {
+ *     Gst::AudioChannelView<float> channel = audio.get_channel<float>(c);
+ *     process(channel.data(), channel.size());
+ *   }
+ *   return Gst::FLOW_OK;
+ * }
+ * @endcode
+ *
+ * The buffer stays mapped until the Gst::MappedAudioBuffer is destroyed.
+ * The buffer must be writable when it is mapped with Gst::MAP_WRITE.
+ */
+class MappedAudioBuffer
+{
+public:
+  /** Maps @a buffer, which holds samples in the format of @a info.
+   *
+   * @param info The format of the samples.
+   * @param buffer The buffer to map.
+   * @param flags The flags used to map the buffer.
+   *
+   * @throw std::runtime_error if the buffer could not be mapped or does not
+   * hold whole frames.
+   */
+  MappedAudioBuffer(const Gst::AudioInfo& info, const Glib::RefPtr<Gst::Buffer>& buffer,
+    Gst::MapFlags flags);
+
+  MappedAudioBuffer(const MappedAudioBuffer&) = delete;
+  MappedAudioBuffer& operator=(const MappedAudioBuffer&) = delete;
+
+  ~MappedAudioBuffer();
+
+  /** Returns the number of frames in the buffer.
+   */
+  gsize get_n_frames() const;
+
+  /** Returns the number of channels.
+   */
+  int get_n_channels() const;
+
+  /** Returns the number of planes: 1 for interleaved samples, one per
+   * channel otherwise.
+   */
+  int get_n_planes() const;
+
+  /** Checks whether the samples are stored in one plane per channel.
+   */
+  bool is_planar() const;
+
+  /** Returns the samples of plane @a plane.
+   */
+  gpointer get_plane(int plane) const;
+
+  /** Returns the pointers to all planes, for instance for
+   * Gst::AudioKernels::interleave().
+   */
+  const std::vector<gpointer>& get_planes() const;
+
+  /** Returns a view on the samples of @a channel. The sample type @a T must
+   * match the width of the sample format.
+   */
+  template<typename T>
+  AudioChannelView<T> get_channel(int channel) const;
+
+  /** Returns the mapped buffer.
+   */
+  Glib::RefPtr<Gst::Buffer> get_buffer() const;
+
+private:
+  Glib::RefPtr<Gst::Buffer> buffer_;
+  Gst::MapInfo map_;
+  gsize frames_;
+  int channels_;
+  int sample_size_;
+  bool planar_;
+  std::vector<gpointer> planes_;
+};
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+template<typename T>
+AudioChannelView<T> MappedAudioBuffer::get_channel(int channel) const
+{
+  g_return_val_if_fail(sizeof(T) == static_cast<gsize>(sample_size_),
+    AudioChannelView<T>(nullptr, 0, 1));
+  g_return_val_if_fail(channel >= 0 && channel < channels_,
+    AudioChannelView<T>(nullptr, 0, 1));
+
+  if(is_planar())
+    return AudioChannelView<T>(static_cast<T*>(planes_[channel]), frames_, 1);
+
+  return AudioChannelView<T>(static_cast<T*>(planes_[0]) + channel, frames_, channels_);
+}
+
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_MAPPEDAUDIOBUFFER_H */
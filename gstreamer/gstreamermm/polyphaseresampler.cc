@@ -0,0 +1,598 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/polyphaseresampler.h>
+#include <gstreamermm/handle_error.h>
+#include <gstreamermm/mapinfo.h>
+#include <gstreamermm/message.h>
+#include <gstreamermm/query.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define GSTREAMERMM_POLYPHASE_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define GSTREAMERMM_POLYPHASE_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__)
+#define GSTREAMERMM_POLYPHASE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+
+/* Dot products of @a n floats, @a n being a multiple of 8. */
+
+float dot_scalar(const float* a, const float* b, guint n)
+{
+  float sum = 0.0f;
+  for(guint i = 0; i < n; ++i)
+    sum += a[i] * b[i];
+  return sum;
+}
+
+#ifdef GSTREAMERMM_POLYPHASE_SSE2
+float dot_sse2(const float* a, const float* b, guint n)
+{
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  for(guint i = 0; i < n; i += 8)
+  {
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  acc0 = _mm_add_ps(acc0, acc1);
+  acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+  acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+  return _mm_cvtss_f32(acc0);
+}
+#endif /* GSTREAMERMM_POLYPHASE_SSE2 */
+
+#ifdef GSTREAMERMM_POLYPHASE_AVX2
+__attribute__((target("avx2")))
+float dot_avx2(const float* a, const float* b, guint n)
+{
+  __m256 acc = _mm256_setzero_ps();
+  for(guint i = 0; i < n; i += 8)
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+#endif /* GSTREAMERMM_POLYPHASE_AVX2 */
+
+#ifdef GSTREAMERMM_POLYPHASE_NEON
+float dot_neon(const float* a, const float* b, guint n)
+{
+  float32x4_t acc0 = vdupq_n_f32(0.0f);
+  float32x4_t acc1 = vdupq_n_f32(0.0f);
+  for(guint i = 0; i < n; i += 8)
+  {
+    acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+  }
+  return vaddvq_f32(vaddq_f32(acc0, acc1));
+}
+#endif /* GSTREAMERMM_POLYPHASE_NEON */
+
+// The zeroth order modified Bessel function of the first kind, for the
+// Kaiser window.
+double bessel_i0(double x)
+{
+  double sum = 1.0, term = 1.0;
+  for(int k = 1; k < 50 && term > sum * 1e-12; ++k)
+  {
+    const double t = x / (2.0 * k);
+    term *= t * t;
+    sum += term;
+  }
+  return sum;
+}
+
+int clamp_quality(int quality)
+{
+  return std::max(Gst::PolyphaseFilterBank::QUALITY_MIN,
+    std::min(quality, Gst::PolyphaseFilterBank::QUALITY_MAX));
+}
+
+// The number of output frames computable from @a available input frames in
+// the history, given the position of the next output frame.
+gsize count_out_frames(const Gst::PolyphaseFilterBank& bank, gsize available, gsize index, guint phase)
+{
+  // Output frame j needs the input samples from its index to
+  // index + n_taps - 1.
+  const gint64 n_phases = bank.get_n_phases();
+  const gint64 remaining = (static_cast<gint64>(available) - bank.get_n_taps() + 1) * n_phases -
+    static_cast<gint64>(index) * n_phases - phase;
+  if(remaining <= 0)
+    return 0;
+  return static_cast<gsize>((remaining + bank.get_step() - 1) / bank.get_step());
+}
+
+typedef std::tuple<guint, guint, int> FilterBankKey;
+
+// The filter banks in use. A bank is freed with its last resampler, and
+// created again when needed; its entry is removed when the next bank is
+// created.
+std::mutex filter_banks_mutex;
+std::map<FilterBankKey, std::weak_ptr<const Gst::PolyphaseFilterBank>> filter_banks;
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+const int PolyphaseFilterBank::QUALITY_MIN;
+const int PolyphaseFilterBank::QUALITY_DEFAULT;
+const int PolyphaseFilterBank::QUALITY_MAX;
+const guint PolyphaseFilterBank::MAX_PHASES;
+
+std::shared_ptr<const PolyphaseFilterBank> PolyphaseFilterBank::get(int in_rate, int out_rate,
+  int quality)
+{
+  if(in_rate <= 0 || out_rate <= 0)
+    gstreamermm_handle_error("invalid sample rate");
+
+  const guint gcd = gst_util_greatest_common_divisor(in_rate, out_rate);
+  const guint n_phases = out_rate / gcd;
+  const guint step = in_rate / gcd;
+  if(n_phases > MAX_PHASES)
+    gstreamermm_handle_error("the ratio of the sample rates needs too many filter phases");
+
+  quality = clamp_quality(quality);
+  const FilterBankKey key(n_phases, step, quality);
+
+  std::lock_guard<std::mutex> lock(filter_banks_mutex);
+  auto it = filter_banks.find(key);
+  std::shared_ptr<const PolyphaseFilterBank> bank;
+  if(it != filter_banks.end())
+    bank = it->second.lock();
+  if(bank)
+    return bank;
+
+  for(it = filter_banks.begin(); it != filter_banks.end();)
+  {
+    if(it->second.expired())
+      it = filter_banks.erase(it);
+    else
+      ++it;
+  }
+
+  bank = std::make_shared<const PolyphaseFilterBank>(n_phases, step, quality);
+  filter_banks[key] = bank;
+  return bank;
+}
+
+PolyphaseFilterBank::PolyphaseFilterBank(guint n_phases, guint step, int quality)
+: n_phases_(n_phases),
+  step_(step),
+  quality_(quality)
+{
+  // The cutoff is relative to the input Nyquist frequency. When
+  // downsampling, it moves to the output Nyquist frequency, which makes the
+  // impulse response longer by the same ratio.
+  const double ratio = std::min(1.0, static_cast<double>(n_phases) / step);
+  const double cutoff = (0.85 + 0.01 * quality) * ratio;
+  const double beta = 4.0 + 0.6 * quality;
+  const guint base_taps = 16 + 8 * quality;
+  n_taps_ = (static_cast<guint>(std::ceil(base_taps / ratio)) + 7) / 8 * 8;
+
+  coefficients_.resize(static_cast<gsize>(n_phases_) * n_taps_);
+  const double half = n_taps_ / 2.0;
+  const double i0_beta = bessel_i0(beta);
+
+  for(guint phase = 0; phase < n_phases_; ++phase)
+  {
+    // Tap k of the phase applies to the input sample at distance d from the
+    // output position; the output position is phase / n_phases after the
+    // input sample of tap n_taps / 2 - 1.
+    float* const coefficients = &coefficients_[phase * n_taps_];
+    double sum = 0.0;
+    for(guint k = 0; k < n_taps_; ++k)
+    {
+      const double d = (static_cast<double>(k) - (half - 1.0)) -
+        static_cast<double>(phase) / n_phases_;
+      const double x = G_PI * cutoff * d;
+      const double sinc = d == 0.0 ? 1.0 : std::sin(x) / x;
+      const double r = d / half;
+      const double window = r * r < 1.0 ? bessel_i0(beta * std::sqrt(1.0 - r * r)) / i0_beta : 0.0;
+      coefficients[k] = static_cast<float>(sinc * window);
+      sum += coefficients[k];
+    }
+
+    // Unity gain at DC for every phase.
+    for(guint k = 0; k < n_taps_; ++k)
+      coefficients[k] = static_cast<float>(coefficients[k] / sum);
+  }
+}
+
+PolyphaseResampler::PolyphaseResampler(const std::shared_ptr<const PolyphaseFilterBank>& bank,
+  int channels, AudioKernelsIsa isa)
+: bank_(bank),
+  channels_(channels),
+  history_(channels),
+  index_(0),
+  phase_(0)
+{
+  if(!bank_ || channels_ <= 0)
+    gstreamermm_handle_error("invalid resampler configuration");
+
+  if(!AudioKernels::is_isa_supported(isa))
+    isa = AudioKernels::get_best_isa();
+
+  isa_ = AUDIO_KERNELS_ISA_SCALAR;
+  dot_ = &dot_scalar;
+  switch(isa)
+  {
+#ifdef GSTREAMERMM_POLYPHASE_SSE2
+    case AUDIO_KERNELS_ISA_SSE2:
+      isa_ = isa;
+      dot_ = &dot_sse2;
+      break;
+#endif
+#ifdef GSTREAMERMM_POLYPHASE_AVX2
+    case AUDIO_KERNELS_ISA_AVX2:
+      isa_ = isa;
+      dot_ = &dot_avx2;
+      break;
+#endif
+#ifdef GSTREAMERMM_POLYPHASE_NEON
+    case AUDIO_KERNELS_ISA_NEON:
+      isa_ = isa;
+      dot_ = &dot_neon;
+      break;
+#endif
+    default:
+      break;
+  }
+
+  reset();
+}
+
+std::shared_ptr<const PolyphaseFilterBank> PolyphaseResampler::get_filter_bank() const
+{
+  return bank_;
+}
+
+int PolyphaseResampler::get_channels() const
+{
+  return channels_;
+}
+
+AudioKernelsIsa PolyphaseResampler::get_isa() const
+{
+  return isa_;
+}
+
+void PolyphaseResampler::reset()
+{
+  // Start with the silence before the first sample that the first output
+  // frame depends on.
+  for(std::vector<float>& history : history_)
+    history.assign(bank_->get_n_taps() / 2 - 1, 0.0f);
+  index_ = 0;
+  phase_ = 0;
+}
+
+gsize PolyphaseResampler::get_out_frames(gsize in_frames) const
+{
+  return count_out_frames(*bank_, history_[0].size() + in_frames, index_, phase_);
+}
+
+gsize PolyphaseResampler::get_drain_frames() const
+{
+  return get_out_frames(bank_->get_n_taps() / 2);
+}
+
+gsize PolyphaseResampler::process(const float* in, gsize in_frames, float* out)
+{
+  const gsize out_frames = get_out_frames(in_frames);
+
+  for(int c = 0; c < channels_; ++c)
+  {
+    std::vector<float>& history = history_[c];
+    const gsize begin = history.size();
+    history.resize(begin + in_frames);
+    for(gsize i = 0; i < in_frames; ++i)
+      history[begin + i] = in[i * channels_ + c];
+  }
+
+  const guint n_taps = bank_->get_n_taps();
+  const guint n_phases = bank_->get_n_phases();
+  const guint step = bank_->get_step();
+
+  for(gsize i = 0; i < out_frames; ++i)
+  {
+    const float* const coefficients = bank_->get_phase(phase_);
+    for(int c = 0; c < channels_; ++c)
+      out[i * channels_ + c] = dot_(&history_[c][index_], coefficients, n_taps);
+
+    phase_ += step;
+    index_ += phase_ / n_phases;
+    phase_ %= n_phases;
+  }
+
+  // Drop the samples no further output frame depends on. When
+  // downsampling, the next frame may start after the last sample.
+  const gsize consumed = std::min(index_, history_[0].size());
+  for(std::vector<float>& history : history_)
+    history.erase(history.begin(), history.begin() + consumed);
+  index_ -= consumed;
+
+  return out_frames;
+}
+
+gsize PolyphaseResampler::drain(float* out)
+{
+  const std::vector<float> silence(static_cast<gsize>(bank_->get_n_taps() / 2) * channels_, 0.0f);
+  const gsize frames = process(silence.data(), bank_->get_n_taps() / 2, out);
+  reset();
+  return frames;
+}
+
+bool PolyphaseResample::register_element(Glib::RefPtr<Gst::Plugin> plugin)
+{
+  return Gst::ElementFactory::register_element(plugin, "mmpolyphaseresample", Gst::RANK_NONE,
+    Gst::register_mm_type<PolyphaseResample>("gstreamermm__PolyphaseResample"));
+}
+
+void PolyphaseResample::class_init(Gst::ElementClass<PolyphaseResample>* klass)
+{
+  klass->set_metadata("Polyphase audio resampler", "Filter/Converter/Audio",
+    "Resamples F32 audio with a shared polyphase filter bank",
+    "The gstreamermm Development Team");
+
+  Gst::AudioFilter::add_pad_templates(klass,
+    Gst::AudioFilter::create_caps({ Gst::AUDIO_FORMAT_F32 }));
+}
+
+PolyphaseResample::PolyphaseResample(GstAudioFilter* gobj)
+: Glib::ObjectBase(typeid (PolyphaseResample)),
+  Gst::AudioFilter(gobj),
+  quality_(*this, "quality", PolyphaseFilterBank::QUALITY_DEFAULT),
+  started_(false),
+  start_time_(0),
+  out_offset_(0),
+  latency_(0)
+{}
+
+Glib::PropertyProxy<int> PolyphaseResample::property_quality()
+{
+  return quality_.get_proxy();
+}
+
+Glib::RefPtr<Gst::Caps> PolyphaseResample::transform_caps_vfunc(Gst::PadDirection,
+  const Glib::RefPtr<Gst::Caps>& caps, const Glib::RefPtr<Gst::Caps>& filter)
+{
+  // Any rate on the other pad, all the other fields unchanged.
+  GstCaps* result = gst_caps_copy(caps->gobj());
+  for(guint i = 0; i < gst_caps_get_size(result); ++i)
+  {
+    gst_structure_set(gst_caps_get_structure(result, i),
+      "rate", GST_TYPE_INT_RANGE, 1, G_MAXINT, nullptr);
+  }
+
+  if(filter)
+  {
+    GstCaps* const intersection = gst_caps_intersect_full(filter->gobj(), result,
+      GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref(result);
+    result = intersection;
+  }
+
+  return Glib::wrap(result, false);
+}
+
+Glib::RefPtr<Gst::Caps> PolyphaseResample::fixate_caps_vfunc(Gst::PadDirection,
+  const Glib::RefPtr<Gst::Caps>& caps, const Glib::RefPtr<Gst::Caps>& othercaps)
+{
+  GstCaps* result = gst_caps_copy(othercaps->gobj());
+  if(gst_caps_is_empty(result))
+    return Glib::wrap(result, false);
+
+  // Prefer keeping the rate, or the closest one.
+  result = gst_caps_truncate(result);
+  int rate = 0;
+  if(!gst_caps_is_empty(caps->gobj()) &&
+    gst_structure_get_int(gst_caps_get_structure(caps->gobj(), 0), "rate", &rate))
+  {
+    gst_structure_fixate_field_nearest_int(gst_caps_get_structure(result, 0), "rate", rate);
+  }
+
+  return Glib::wrap(gst_caps_fixate(result), false);
+}
+
+bool PolyphaseResample::set_caps_vfunc(const Glib::RefPtr<Gst::Caps>& incaps,
+  const Glib::RefPtr<Gst::Caps>& outcaps)
+{
+  // The parent parses the input format into the info of the filter.
+  if(!Gst::AudioFilter::set_caps_vfunc(incaps, outcaps))
+    return false;
+
+  Gst::AudioInfo in_info;
+  if(!in_info.from_caps(incaps) || !out_info_.from_caps(outcaps) ||
+    in_info.get_channels() != out_info_.get_channels())
+  {
+    return false;
+  }
+
+  std::shared_ptr<const PolyphaseFilterBank> bank;
+  try
+  {
+    bank = PolyphaseFilterBank::get(in_info.get_rate(), out_info_.get_rate(), quality_.get_value());
+  }
+  catch(const std::runtime_error& error)
+  {
+    GST_ELEMENT_ERROR(gobj(), CORE, NEGOTIATION, (nullptr), ("%s", error.what()));
+    return false;
+  }
+
+  if(!resampler_ || resampler_->get_filter_bank() != bank ||
+    resampler_->get_channels() != in_info.get_channels())
+  {
+    resampler_.reset(new PolyphaseResampler(bank, in_info.get_channels()));
+    started_ = false;
+  }
+
+  // An output frame is computed once the input reaches the end of its
+  // filter, half of the taps after it.
+  const guint64 latency = gst_util_uint64_scale_int(bank->get_n_taps() / 2, GST_SECOND, in_info.get_rate());
+  if(latency_.exchange(latency) != latency)
+    post_message(Gst::MessageLatency::create(Glib::wrap(GST_OBJECT(gobj()), true)));
+
+  return true;
+}
+
+Glib::RefPtr<Gst::Buffer> PolyphaseResample::create_output(gsize frames)
+{
+  Glib::RefPtr<Gst::Buffer> buffer = Gst::Buffer::create(frames * out_info_.get_bpf());
+
+  const int rate = out_info_.get_rate();
+  const Gst::ClockTime begin = start_time_ + gst_util_uint64_scale_int(out_offset_, GST_SECOND, rate);
+  const Gst::ClockTime end = start_time_ + gst_util_uint64_scale_int(out_offset_ + frames, GST_SECOND, rate);
+  buffer->set_pts(begin);
+  buffer->set_duration(end - begin);
+  GST_BUFFER_OFFSET(buffer->gobj()) = out_offset_;
+  GST_BUFFER_OFFSET_END(buffer->gobj()) = out_offset_ + frames;
+  out_offset_ += frames;
+
+  return buffer;
+}
+
+Gst::FlowReturn PolyphaseResample::generate_output_vfunc(Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  GstBuffer* const queued = gobj()->queued_buf;
+  if(!queued)
+    return Gst::FLOW_OK;
+  gobj()->queued_buf = nullptr;
+  Glib::RefPtr<Gst::Buffer> input = Glib::wrap(queued, false);
+
+  if(!resampler_)
+    return Gst::FLOW_NOT_NEGOTIATED;
+
+  if(GST_BUFFER_FLAG_IS_SET(queued, GST_BUFFER_FLAG_DISCONT) || !started_)
+  {
+    // Without a timestamp, the timeline goes on from the end of the last
+    // output, or starts at the start of the segment.
+    Gst::ClockTime start = input->get_pts();
+    if(start == Gst::CLOCK_TIME_NONE && started_)
+      start = start_time_ + gst_util_uint64_scale_int(out_offset_, GST_SECOND, out_info_.get_rate());
+    else if(start == Gst::CLOCK_TIME_NONE)
+    {
+      const GstSegment& segment = GST_BASE_TRANSFORM(gobj())->segment;
+      start = segment.format == GST_FORMAT_TIME ? segment.start : 0;
+    }
+
+    resampler_->reset();
+    started_ = true;
+    start_time_ = start;
+    out_offset_ = 0;
+  }
+
+  Gst::MapInfo in_map;
+  if(!input->map(in_map, Gst::MAP_READ))
+    return Gst::FLOW_ERROR;
+
+  const gsize in_frames = in_map.get_size() / out_info_.get_bpf();
+  const gsize out_frames = resampler_->get_out_frames(in_frames);
+  Glib::RefPtr<Gst::Buffer> output = out_frames ? create_output(out_frames) :
+    Glib::RefPtr<Gst::Buffer>();
+
+  if(output)
+  {
+    Gst::MapInfo out_map;
+    output->map(out_map, Gst::MAP_WRITE);
+    resampler_->process(reinterpret_cast<const float*>(in_map.get_data()), in_frames,
+      reinterpret_cast<float*>(out_map.get_data()));
+    output->unmap(out_map);
+  }
+  else
+  {
+    // The samples are kept until they complete an output frame.
+    resampler_->process(reinterpret_cast<const float*>(in_map.get_data()), in_frames, nullptr);
+  }
+  input->unmap(in_map);
+
+  buffer = output;
+  return Gst::FLOW_OK;
+}
+
+bool PolyphaseResample::sink_event_vfunc(const Glib::RefPtr<Gst::Event>& event)
+{
+  switch(event->get_event_type())
+  {
+    case Gst::EVENT_EOS:
+      // Push the frames still held back by the filter.
+      if(resampler_ && resampler_->get_drain_frames())
+      {
+        Glib::RefPtr<Gst::Buffer> output = create_output(resampler_->get_drain_frames());
+        Gst::MapInfo map;
+        output->map(map, Gst::MAP_WRITE);
+        resampler_->drain(reinterpret_cast<float*>(map.get_data()));
+        output->unmap(map);
+        get_src_pad()->push(std::move(output));
+      }
+      break;
+    case Gst::EVENT_FLUSH_STOP:
+    case Gst::EVENT_SEGMENT:
+      if(resampler_)
+        resampler_->reset();
+      started_ = false;
+      break;
+    default:
+      break;
+  }
+
+  return Gst::AudioFilter::sink_event_vfunc(event);
+}
+
+bool PolyphaseResample::base_transform_query_vfunc(Gst::PadDirection direction,
+  const Glib::RefPtr<Gst::Query>& query)
+{
+  if(!Gst::AudioFilter::base_transform_query_vfunc(direction, query))
+    return false;
+
+  const guint64 latency = latency_.load();
+  if(direction == Gst::PAD_SRC && GST_QUERY_TYPE(query->gobj()) == GST_QUERY_LATENCY && latency)
+  {
+    gboolean live = FALSE;
+    GstClockTime min_latency = 0, max_latency = 0;
+    gst_query_parse_latency(query->gobj(), &live, &min_latency, &max_latency);
+    gst_query_set_latency(query->gobj(), live, min_latency + latency,
+      max_latency != GST_CLOCK_TIME_NONE ? max_latency + latency : GST_CLOCK_TIME_NONE);
+  }
+
+  return true;
+}
+
+bool PolyphaseResample::stop_vfunc()
+{
+  resampler_.reset();
+  return Gst::AudioFilter::stop_vfunc();
+}
+
+} // namespace Gst
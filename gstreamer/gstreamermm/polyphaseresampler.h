@@ -0,0 +1,258 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_POLYPHASERESAMPLER_H
+#define _GSTREAMERMM_POLYPHASERESAMPLER_H
+
+#include <gstreamermm/audiofilter.h>
+#include <gstreamermm/audioinfo.h>
+#include <gstreamermm/audiokernels.h>
+#include <gstreamermm/elementfactory.h>
+#include <gstreamermm/plugin.h>
+#include <gstreamermm/register.h>
+#include <glibmm/property.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace Gst
+{
+
+/**
+ * Gst::PolyphaseFilterBank holds the coefficients of a windowed sinc low-pass
+ * filter, split into one phase per output position between two input
+ * samples.
+ *
+ * Converting from @a in_rate to @a out_rate uses out_rate / gcd phases. The
+ * coefficients only depend on the rates and the quality, so filter banks are
+ * created once with get() and shared by all the resamplers converting
+ * between the same rates, in all threads.
+ */
+class PolyphaseFilterBank
+{
+public:
+  /** The lowest quality.
+   */
+  static const int QUALITY_MIN = 0;
+
+  /** The default quality, a good compromise for 44.1 kHz to 48 kHz.
+   */
+  static const int QUALITY_DEFAULT = 4;
+
+  /** The highest quality.
+   */
+  static const int QUALITY_MAX = 10;
+
+  /** The highest number of phases, which limits the memory used by unusual
+   * rate ratios.
+   */
+  static const guint MAX_PHASES = 4096;
+
+  /** Returns the filter bank converting from @a in_rate to @a out_rate with
+   * @a quality, creating it if no resampler is using it yet.
+   *
+   * @param in_rate The input sample rate.
+   * @param out_rate The output sample rate.
+   * @param quality The quality, from QUALITY_MIN to QUALITY_MAX; higher
+   * qualities use longer filters with a steeper cutoff.
+   *
+   * @throw std::runtime_error if a rate is not positive or the ratio needs
+   * more than MAX_PHASES phases.
+   */
+  static std::shared_ptr<const PolyphaseFilterBank> get(int in_rate, int out_rate,
+    int quality = QUALITY_DEFAULT);
+
+  /** Returns the number of phases, out_rate / gcd(in_rate, out_rate).
+   */
+  guint get_n_phases() const { return n_phases_; }
+
+  /** Returns the number of input samples consumed by get_n_phases() output
+   * samples, in_rate / gcd(in_rate, out_rate).
+   */
+  guint get_step() const { return step_; }
+
+  /** Returns the number of taps of each phase, a multiple of 8.
+   */
+  guint get_n_taps() const { return n_taps_; }
+
+  /** Returns the get_n_taps() coefficients of @a phase.
+   */
+  const float* get_phase(guint phase) const { return &coefficients_[phase * n_taps_]; }
+
+  /** Returns the quality.
+   */
+  int get_quality() const { return quality_; }
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  PolyphaseFilterBank(guint n_phases, guint step, int quality);
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+  PolyphaseFilterBank(const PolyphaseFilterBank&) = delete;
+  PolyphaseFilterBank& operator=(const PolyphaseFilterBank&) = delete;
+
+private:
+  guint n_phases_;
+  guint step_;
+  guint n_taps_;
+  int quality_;
+  std::vector<float> coefficients_;
+};
+
+/**
+ * Gst::PolyphaseResampler converts interleaved F32 samples from one rate to
+ * another with a Gst::PolyphaseFilterBank.
+ *
+ * The resampler keeps the last input samples of each channel between calls,
+ * so a stream can be processed in buffers of any size. The output is delayed
+ * by get_n_taps() / 2 input samples, which drain() flushes at the end of the
+ * stream. The dot products of the filter use the instruction set selected
+ * like for Gst::AudioKernels.
+ */
+class PolyphaseResampler
+{
+public:
+  /** Creates a resampler for @a channels channels.
+   *
+   * @param bank The filter bank, from Gst::PolyphaseFilterBank::get().
+   * @param channels The number of channels.
+   * @param isa The instruction set to use; it is lowered to the best one
+   * supported by the CPU.
+   */
+  PolyphaseResampler(const std::shared_ptr<const PolyphaseFilterBank>& bank, int channels,
+    AudioKernelsIsa isa = AudioKernels::get_best_isa());
+
+  /** Returns the filter bank.
+   */
+  std::shared_ptr<const PolyphaseFilterBank> get_filter_bank() const;
+
+  /** Returns the number of channels.
+   */
+  int get_channels() const;
+
+  /** Returns the instruction set used by the filter.
+   */
+  AudioKernelsIsa get_isa() const;
+
+  /** Returns the number of frames process() produces from @a in_frames
+   * more input frames.
+   */
+  gsize get_out_frames(gsize in_frames) const;
+
+  /** Resamples @a in_frames frames at @a in and writes
+   * get_out_frames(@a in_frames) frames to @a out.
+   *
+   * @return The number of frames written.
+   */
+  gsize process(const float* in, gsize in_frames, float* out);
+
+  /** Returns the number of frames drain() produces.
+   */
+  gsize get_drain_frames() const;
+
+  /** Writes the get_drain_frames() frames still held back by the filter to
+   * @a out, as if the stream was followed by silence, and resets the
+   * resampler.
+   *
+   * @return The number of frames written.
+   */
+  gsize drain(float* out);
+
+  /** Forgets the input samples, for instance after a seek.
+   */
+  void reset();
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  typedef float (*DotFunc)(const float* a, const float* b, guint n);
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+private:
+  std::shared_ptr<const PolyphaseFilterBank> bank_;
+  int channels_;
+  AudioKernelsIsa isa_;
+  DotFunc dot_;
+  // The pending input samples of each channel, starting with the oldest
+  // sample the next output frame depends on.
+  std::vector<std::vector<float>> history_;
+  // The position of the next output frame: an index into history_ and a
+  // phase.
+  gsize index_;
+  guint phase_;
+};
+
+/**
+ * Gst::PolyphaseResample is an element converting the sample rate of
+ * interleaved F32 audio with a Gst::PolyphaseResampler.
+ *
+ * It is registered as "mmpolyphaseresample" by register_element(), and
+ * accepts any rate on either pad, like the stock "audioresample" element.
+ * The "quality" property, from Gst::PolyphaseFilterBank::QUALITY_MIN to
+ * Gst::PolyphaseFilterBank::QUALITY_MAX, is read when the caps are set.
+ *
+ * All the instances converting between the same rates with the same quality
+ * share one filter bank, which makes starting many streams cheap. The delay
+ * of the filter, half of its taps, is added to the latency.
+ */
+class PolyphaseResample : public Gst::AudioFilter
+{
+public:
+  /** Registers the element as "mmpolyphaseresample" in @a plugin.
+   */
+  static bool register_element(Glib::RefPtr<Gst::Plugin> plugin);
+
+  /** The quality used for the next caps.
+   */
+  Glib::PropertyProxy<int> property_quality();
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  static void class_init(Gst::ElementClass<PolyphaseResample>* klass);
+
+  explicit PolyphaseResample(GstAudioFilter* gobj);
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+protected:
+  Glib::RefPtr<Gst::Caps> transform_caps_vfunc(Gst::PadDirection direction,
+    const Glib::RefPtr<Gst::Caps>& caps, const Glib::RefPtr<Gst::Caps>& filter) override;
+  Glib::RefPtr<Gst::Caps> fixate_caps_vfunc(Gst::PadDirection direction,
+    const Glib::RefPtr<Gst::Caps>& caps, const Glib::RefPtr<Gst::Caps>& othercaps) override;
+  bool set_caps_vfunc(const Glib::RefPtr<Gst::Caps>& incaps,
+    const Glib::RefPtr<Gst::Caps>& outcaps) override;
+  Gst::FlowReturn generate_output_vfunc(Glib::RefPtr<Gst::Buffer>& buffer) override;
+  bool sink_event_vfunc(const Glib::RefPtr<Gst::Event>& event) override;
+  bool base_transform_query_vfunc(Gst::PadDirection direction, const Glib::RefPtr<Gst::Query>& query) override;
+  bool stop_vfunc() override;
+
+private:
+  Glib::RefPtr<Gst::Buffer> create_output(gsize frames);
+
+  Glib::Property<int> quality_;
+  Gst::AudioInfo out_info_;
+  std::unique_ptr<PolyphaseResampler> resampler_;
+  // Whether a timeline was started since the last discontinuity, flush or
+  // segment; the time of its first output frame, and the number of frames
+  // produced since.
+  bool started_;
+  Gst::ClockTime start_time_;
+  guint64 out_offset_;
+  // The delay of the filter, added to the latency.
+  std::atomic<guint64> latency_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_POLYPHASERESAMPLER_H */
@@ -0,0 +1,211 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/videocodecworkers.h>
+#include <gstreamermm/handle_error.h>
+#include <glibmm/exceptionhandler.h>
+
+namespace Gst
+{
+
+VideoCodecWorkers::VideoCodecWorkers(guint threads, const SlotProcess& process, const SlotFinish& finish,
+  const SlotLock& lock, const SlotLock& unlock)
+: process_(process),
+  finish_(finish),
+  lock_(lock),
+  unlock_(unlock),
+  error_(Gst::FLOW_OK),
+  finishing_(false),
+  quit_(false)
+{
+  if(!threads)
+    gstreamermm_handle_error("Gst::VideoCodecWorkers needs at least one thread");
+
+  for(guint i = 0; i < threads; ++i)
+    threads_.emplace_back(&VideoCodecWorkers::thread_loop, this);
+}
+
+VideoCodecWorkers::~VideoCodecWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+    pending_.clear();
+  }
+  queued_.notify_all();
+
+  for(std::thread& thread : threads_)
+    thread.join();
+}
+
+guint VideoCodecWorkers::get_threads() const
+{
+  return threads_.size();
+}
+
+guint VideoCodecWorkers::get_max_frames() const
+{
+  return threads_.size() * 2;
+}
+
+Gst::FlowReturn VideoCodecWorkers::submit(const Glib::RefPtr<Gst::VideoCodecFrame>& frame)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  wait_unlocked(lock, [this] { return jobs_.size() < get_max_frames(); });
+
+  // After an error, the frame is finished with it without being processed.
+  if(error_ != Gst::FLOW_OK)
+  {
+    const Gst::FlowReturn error = error_;
+    lock.unlock();
+    finish_(frame, error);
+    return error;
+  }
+
+  std::shared_ptr<Job> job = std::make_shared<Job>();
+  job->frame = frame;
+  job->result = Gst::FLOW_OK;
+  job->done = false;
+  jobs_.push_back(job);
+  pending_.push_back(job);
+  lock.unlock();
+
+  queued_.notify_one();
+  return Gst::FLOW_OK;
+}
+
+Gst::FlowReturn VideoCodecWorkers::drain()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  wait_unlocked(lock, [this] { return jobs_.empty() && !finishing_; });
+  return error_;
+}
+
+void VideoCodecWorkers::flush()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  // The jobs which were not started are done; the running ones are waited
+  // for. The caller holds the stream lock, so no frame is being finished.
+  for(const std::shared_ptr<Job>& job : pending_)
+    job->done = true;
+  pending_.clear();
+
+  completed_.wait(lock, [this]
+  {
+    for(const std::shared_ptr<Job>& job : jobs_)
+    {
+      if(!job->done)
+        return false;
+    }
+    return true;
+  });
+
+  jobs_.clear();
+  error_ = Gst::FLOW_OK;
+}
+
+void VideoCodecWorkers::thread_loop()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while(true)
+  {
+    queued_.wait(lock, [this] { return quit_ || !pending_.empty(); });
+    if(quit_)
+      return;
+
+    std::shared_ptr<Job> job = pending_.front();
+    pending_.pop_front();
+
+    lock.unlock();
+    Gst::FlowReturn result = Gst::FLOW_ERROR;
+    try
+    {
+      result = process_(job->frame);
+    }
+    catch(...)
+    {
+      Glib::exception_handlers_invoke();
+    }
+    lock.lock();
+
+    job->result = result;
+    job->done = true;
+    completed_.notify_all();
+    finish_completed(lock);
+  }
+}
+
+void VideoCodecWorkers::finish_completed(std::unique_lock<std::mutex>& lock)
+{
+  // One worker at a time finishes the frames, so that they stay in order.
+  if(finishing_ || jobs_.empty() || !jobs_.front()->done)
+    return;
+
+  // The stream lock is taken before the mutex, like in the streaming
+  // thread.
+  finishing_ = true;
+  lock.unlock();
+  lock_();
+  lock.lock();
+
+  // The finish slot pushes downstream: it is called without the mutex,
+  // while the workers go on with the next frames. Once a frame failed, the
+  // next ones are finished with its error, so that none is output.
+  while(!quit_ && !jobs_.empty() && jobs_.front()->done)
+  {
+    std::shared_ptr<Job> job = jobs_.front();
+    jobs_.pop_front();
+    const Gst::FlowReturn result = error_ != Gst::FLOW_OK ? error_ : job->result;
+
+    lock.unlock();
+    const Gst::FlowReturn finished = finish_(job->frame, result);
+    lock.lock();
+
+    if(error_ == Gst::FLOW_OK)
+      error_ = finished;
+  }
+
+  finishing_ = false;
+  completed_.notify_all();
+  lock.unlock();
+  unlock_();
+  lock.lock();
+}
+
+void VideoCodecWorkers::wait_unlocked(std::unique_lock<std::mutex>& lock,
+  const std::function<bool()>& ready)
+{
+  if(ready())
+    return;
+
+  // The workers need the stream lock to finish the frames.
+  lock.unlock();
+  unlock_();
+  lock.lock();
+  completed_.wait(lock, ready);
+
+  lock.unlock();
+  lock_();
+  lock.lock();
+}
+
+} // namespace Gst
@@ -0,0 +1,163 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_VIDEOCODECWORKERS_H
+#define _GSTREAMERMM_VIDEOCODECWORKERS_H
+
+#include <gstreamermm/videocodecframe.h>
+#include <gstreamermm/enums.h>
+#include <sigc++/sigc++.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Gst
+{
+
+/**
+ * Gst::VideoCodecWorkers processes the frames of a Gst::VideoDecoder or a
+ * Gst::VideoEncoder on a pool of threads, and finishes them in the order
+ * they were submitted.
+ *
+ * The streaming thread of the codec submits each frame with submit(); a
+ * worker thread calls the process slot, which decodes or encodes the frame
+ * and returns its result. The frames are processed concurrently and may
+ * complete out of order: the finish slot is called for each of them, in
+ * submission order, as soon as it and the frames before it completed. It
+ * is called from a worker thread, with the stream lock of the codec held.
+ * At most get_max_frames() frames are in flight; submit() blocks when they
+ * are all taken.
+ *
+ * submit() and drain() are called with the stream lock held, and release
+ * it while they wait, so that the frames can be finished meanwhile.
+ *
+ * The process slot runs without the stream lock, so it must not call
+ * methods of the codec which take it, such as finish_frame() or
+ * set_output_state().
+ *
+ * Gst::VideoDecoder and Gst::VideoEncoder create the workers when frame
+ * threading is enabled with their set_frame_threads().
+ */
+class VideoCodecWorkers
+{
+public:
+  /** For example,
+   * Gst::FlowReturn on_process(const Glib::RefPtr<Gst::VideoCodecFrame>& frame);.
+   */
+  typedef sigc::slot<Gst::FlowReturn, const Glib::RefPtr<Gst::VideoCodecFrame>&> SlotProcess;
+
+  /** For example,
+   * Gst::FlowReturn on_finish(const Glib::RefPtr<Gst::VideoCodecFrame>& frame, Gst::FlowReturn result);.
+   */
+  typedef sigc::slot<Gst::FlowReturn, const Glib::RefPtr<Gst::VideoCodecFrame>&, Gst::FlowReturn> SlotFinish;
+
+  /** For example,
+   * void on_lock();.
+   */
+  typedef sigc::slot<void> SlotLock;
+
+  /** Starts @a threads worker threads.
+   *
+   * @param threads The number of threads, at least 1.
+   * @param process Processes a frame, on a worker thread.
+   * @param finish Finishes a processed frame with the result of
+   * @a process, on a worker thread with the stream lock held.
+   * @param lock Takes the stream lock of the codec.
+   * @param unlock Releases the stream lock of the codec.
+   */
+  VideoCodecWorkers(guint threads, const SlotProcess& process, const SlotFinish& finish,
+    const SlotLock& lock, const SlotLock& unlock);
+
+  /** Drops the frames which were not processed yet, and joins the threads.
+   */
+  ~VideoCodecWorkers();
+
+  VideoCodecWorkers(const VideoCodecWorkers&) = delete;
+  VideoCodecWorkers& operator=(const VideoCodecWorkers&) = delete;
+
+  /** Returns the number of worker threads.
+   */
+  guint get_threads() const;
+
+  /** Returns the maximum number of frames in flight, twice the number of
+   * threads.
+   */
+  guint get_max_frames() const;
+
+  /** Queues @a frame for processing. Blocks while get_max_frames() frames
+   * are in flight.
+   *
+   * @return The first error returned by the finish slot since the last
+   * flush(), or Gst::FLOW_OK.
+   */
+  Gst::FlowReturn submit(const Glib::RefPtr<Gst::VideoCodecFrame>& frame);
+
+  /** Waits for all frames to be processed and finished.
+   *
+   * @return The first error returned by the finish slot since the last
+   * flush(), or Gst::FLOW_OK.
+   */
+  Gst::FlowReturn drain();
+
+  /** Drops the frames which were not processed yet, and waits for the
+   * others, which are dropped without being finished. Clears the error.
+   */
+  void flush();
+
+private:
+  struct Job
+  {
+    Glib::RefPtr<Gst::VideoCodecFrame> frame;
+    Gst::FlowReturn result;
+    bool done;
+  };
+
+  void thread_loop();
+  void finish_completed(std::unique_lock<std::mutex>& lock);
+  void wait_unlocked(std::unique_lock<std::mutex>& lock, const std::function<bool()>& ready);
+
+  SlotProcess process_;
+  SlotFinish finish_;
+  SlotLock lock_;
+  SlotLock unlock_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  // Signaled when a job is queued, and on destruction.
+  std::condition_variable queued_;
+  // Signaled when a job completes, and when the frames are finished.
+  std::condition_variable completed_;
+  // The jobs in flight, in submission order, and the ones not started yet.
+  std::deque<std::shared_ptr<Job>> jobs_;
+  std::deque<std::shared_ptr<Job>> pending_;
+  // The first error of the finish slot, with which the next frames are
+  // finished until flush().
+  Gst::FlowReturn error_;
+  // Whether a worker finishes the completed frames.
+  bool finishing_;
+  bool quit_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_VIDEOCODECWORKERS_H */
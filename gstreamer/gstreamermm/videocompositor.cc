@@ -0,0 +1,737 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/videocompositor.h>
+#include <gstreamermm/videolayout.h>
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+
+namespace
+{
+
+// The L2 cache the tiles are sized for, when "tile-size" is 0.
+const double l2_cache_size = 256 * 1024;
+
+enum
+{
+  COVERAGE_UNKNOWN,
+  COVERAGE_TRANSPARENT,
+  COVERAGE_VISIBLE
+};
+
+// The conversion from RGB to YUV uses integer coefficients with 13
+// fractional bits, like Gst::VideoKernels.
+const int coefficient_bits = 13;
+const int coefficient_round = 1 << (coefficient_bits - 1);
+
+enum
+{
+  COEFFICIENT_Y_OFFSET,
+  COEFFICIENT_YR,
+  COEFFICIENT_YG,
+  COEFFICIENT_YB,
+  COEFFICIENT_UR,
+  COEFFICIENT_UG,
+  COEFFICIENT_UB,
+  COEFFICIENT_VR,
+  COEFFICIENT_VG,
+  COEFFICIENT_VB,
+  N_COEFFICIENTS
+};
+
+// Computes the coefficients converting RGB to the color matrix and range
+// of @a info.
+void get_coefficients(const GstVideoInfo* info, int* coefficients)
+{
+  gdouble kr = 0.299, kb = 0.114;
+  gst_video_color_matrix_get_Kr_Kb(info->colorimetry.matrix, &kr, &kb);
+
+  const bool full_range = info->colorimetry.range == GST_VIDEO_COLOR_RANGE_0_255;
+  const double y_scale = (full_range ? 255.0 : 219.0) / 255.0;
+  const double c_scale = (full_range ? 255.0 : 224.0) / 255.0;
+  const double kg = 1.0 - kr - kb;
+  const double one = 1 << coefficient_bits;
+  const double u_scale = c_scale / (2 * (1 - kb));
+  const double v_scale = c_scale / (2 * (1 - kr));
+
+  coefficients[COEFFICIENT_Y_OFFSET] = full_range ? 0 : 16;
+  coefficients[COEFFICIENT_YR] = std::lround(kr * y_scale * one);
+  coefficients[COEFFICIENT_YG] = std::lround(kg * y_scale * one);
+  coefficients[COEFFICIENT_YB] = std::lround(kb * y_scale * one);
+  coefficients[COEFFICIENT_UR] = std::lround(-kr * u_scale * one);
+  coefficients[COEFFICIENT_UG] = std::lround(-kg * u_scale * one);
+  coefficients[COEFFICIENT_UB] = std::lround((1 - kb) * u_scale * one);
+  coefficients[COEFFICIENT_VR] = std::lround((1 - kr) * v_scale * one);
+  coefficients[COEFFICIENT_VG] = std::lround(-kg * v_scale * one);
+  coefficients[COEFFICIENT_VB] = std::lround(-kb * v_scale * one);
+}
+
+inline int clamp_u8(int x)
+{
+  return x < 0 ? 0 : (x > 255 ? 255 : x);
+}
+
+// Divides by 255, rounding to nearest, for x in [0, 65025].
+inline int div255(int x)
+{
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+/* A pool of threads sharing out the tiles of a frame with the streaming
+ * thread. run() returns once all tiles are blended.
+ */
+class VideoCompositor::TileWorkers
+{
+public:
+  explicit TileWorkers(guint threads)
+  : task_(nullptr),
+    count_(0),
+    next_(0),
+    running_(0),
+    generation_(0),
+    quit_(false)
+  {
+    // The streaming thread is one of the threads.
+    for(guint i = 1; i < threads; ++i)
+      threads_.emplace_back(&TileWorkers::thread_loop, this);
+  }
+
+  ~TileWorkers()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      quit_ = true;
+    }
+    started_.notify_all();
+
+    for(std::thread& thread : threads_)
+      thread.join();
+  }
+
+  void run(guint count, const std::function<void(guint)>& task)
+  {
+    if(threads_.empty() || count < 2)
+    {
+      for(guint i = 0; i < count; ++i)
+        task(i);
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &task;
+      count_ = count;
+      next_ = 0;
+      running_ = threads_.size();
+      ++generation_;
+    }
+    started_.notify_all();
+
+    run_tasks();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [this] { return !running_; });
+    task_ = nullptr;
+  }
+
+private:
+  void run_tasks()
+  {
+    for(guint i = next_++; i < count_; i = next_++)
+      (*task_)(i);
+  }
+
+  void thread_loop()
+  {
+    guint64 generation = 0;
+    while(true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        started_.wait(lock, [&] { return quit_ || generation_ != generation; });
+        if(quit_)
+          return;
+        generation = generation_;
+      }
+
+      run_tasks();
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if(!--running_)
+        finished_.notify_one();
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable started_;
+  std::condition_variable finished_;
+  const std::function<void(guint)>* task_;
+  guint count_;
+  std::atomic<guint> next_;
+  // The threads still running tasks of the current frame.
+  guint running_;
+  guint64 generation_;
+  bool quit_;
+};
+
+/* A layer blended onto the current frame.
+ */
+struct VideoCompositor::Layer
+{
+  Gst::ConstVideoPlane pixels;
+  int x;
+  int y;
+  int alpha;
+  bool rgb;
+  guint zorder;
+  std::vector<guint8>* coverage;
+};
+
+Glib::RefPtr<VideoCompositorPad> VideoCompositorPad::create(const Glib::RefPtr<const Gst::PadTemplate>& templ,
+  const Glib::ustring& name)
+{
+  return Glib::RefPtr<VideoCompositorPad>(new VideoCompositorPad(templ, name));
+}
+
+VideoCompositorPad::VideoCompositorPad(const Glib::RefPtr<const Gst::PadTemplate>& templ, const Glib::ustring& name)
+: Glib::ObjectBase(typeid (VideoCompositorPad)),
+  Gst::AggregatorPad(templ, name),
+  xpos_(*this, "xpos", 0),
+  ypos_(*this, "ypos", 0),
+  alpha_(*this, "alpha", 1.0),
+  zorder_(*this, "zorder", 0),
+  has_info_(false),
+  background_(false),
+  current_end_(Gst::CLOCK_TIME_NONE),
+  coverage_valid_(false),
+  coverage_x_(0),
+  coverage_y_(0),
+  coverage_tile_size_(0),
+  coverage_columns_(0)
+{}
+
+Glib::PropertyProxy<int> VideoCompositorPad::property_xpos()
+{
+  return xpos_.get_proxy();
+}
+
+Glib::PropertyProxy<int> VideoCompositorPad::property_ypos()
+{
+  return ypos_.get_proxy();
+}
+
+Glib::PropertyProxy<double> VideoCompositorPad::property_alpha()
+{
+  return alpha_.get_proxy();
+}
+
+Glib::PropertyProxy<guint> VideoCompositorPad::property_zorder()
+{
+  return zorder_.get_proxy();
+}
+
+bool VideoCompositorPad::is_background() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return background_;
+}
+
+void VideoCompositorPad::flush_vfunc()
+{
+  current_.reset();
+  coverage_.clear();
+  coverage_valid_ = false;
+}
+
+bool VideoCompositor::register_element(Glib::RefPtr<Gst::Plugin> plugin)
+{
+  return Gst::ElementFactory::register_element(plugin, "mmvideocompositor", Gst::RANK_NONE,
+    Gst::register_mm_type<VideoCompositor>("gstreamermm__VideoCompositor"));
+}
+
+void VideoCompositor::class_init(Gst::ElementClass<VideoCompositor>* klass)
+{
+  klass->set_metadata("Video compositor", "Filter/Editor/Video/Compositor",
+    "Blends RGBA and AYUV layers onto I420 or NV12 video in place",
+    "The gstreamermm Development Team");
+
+  klass->add_pad_template(Gst::PadTemplate::create("src", Gst::PAD_SRC, Gst::PAD_ALWAYS,
+    Gst::Caps::create_from_string(GST_VIDEO_CAPS_MAKE("{ I420, NV12 }"))));
+  klass->add_pad_template(Gst::PadTemplate::create("sink_%u", Gst::PAD_SINK, Gst::PAD_REQUEST,
+    Gst::Caps::create_from_string(GST_VIDEO_CAPS_MAKE("{ I420, NV12, RGBA, AYUV }"))));
+}
+
+VideoCompositor::VideoCompositor(GstElement* gobj)
+: Glib::ObjectBase(typeid (VideoCompositor)),
+  Gst::Aggregator(gobj),
+  threads_(*this, "threads", 0),
+  tile_size_(*this, "tile-size", 0),
+  blended_tiles_(0),
+  skipped_tiles_(0)
+{}
+
+VideoCompositor::~VideoCompositor()
+{}
+
+Glib::PropertyProxy<guint> VideoCompositor::property_threads()
+{
+  return threads_.get_proxy();
+}
+
+Glib::PropertyProxy<guint> VideoCompositor::property_tile_size()
+{
+  return tile_size_.get_proxy();
+}
+
+guint64 VideoCompositor::get_blended_tiles() const
+{
+  return blended_tiles_;
+}
+
+guint64 VideoCompositor::get_skipped_tiles() const
+{
+  return skipped_tiles_;
+}
+
+bool VideoCompositor::start_vfunc()
+{
+  guint threads = threads_.get_value();
+  if(!threads)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  workers_.reset(new TileWorkers(threads));
+  blended_tiles_ = 0;
+  skipped_tiles_ = 0;
+  return true;
+}
+
+bool VideoCompositor::stop_vfunc()
+{
+  workers_.reset();
+
+  for(const Glib::RefPtr<Gst::AggregatorPad>& pad : get_sink_pads())
+    Glib::RefPtr<VideoCompositorPad>::cast_static(pad)->flush_vfunc();
+
+  return true;
+}
+
+Glib::RefPtr<Gst::AggregatorPad> VideoCompositor::create_new_pad_vfunc(const Glib::RefPtr<Gst::PadTemplate>& templ,
+  const Glib::ustring& name, const Glib::RefPtr<const Gst::Caps>&)
+{
+  return VideoCompositorPad::create(templ, name);
+}
+
+bool VideoCompositor::sink_event_vfunc(const Glib::RefPtr<Gst::AggregatorPad>& pad,
+  const Glib::RefPtr<Gst::Event>& event)
+{
+  if(GST_EVENT_TYPE(event->gobj()) != GST_EVENT_CAPS)
+    return Gst::Aggregator::sink_event_vfunc(pad, event);
+
+  GstCaps* caps = nullptr;
+  gst_event_parse_caps(event->gobj(), &caps);
+  return set_pad_caps(Glib::RefPtr<VideoCompositorPad>::cast_static(pad), Glib::wrap(caps, true));
+}
+
+bool VideoCompositor::set_pad_caps(const Glib::RefPtr<VideoCompositorPad>& pad, const Glib::RefPtr<Gst::Caps>& caps)
+{
+  Gst::VideoInfo info;
+  if(!Gst::VideoLayout::from_caps(caps, info))
+    return false;
+
+  const GstVideoFormat format = GST_VIDEO_INFO_FORMAT(info.gobj());
+  const bool background = format == GST_VIDEO_FORMAT_I420 || format == GST_VIDEO_FORMAT_NV12;
+
+  if(background)
+  {
+    for(const Glib::RefPtr<Gst::AggregatorPad>& other : get_sink_pads())
+    {
+      if(other != pad && Glib::RefPtr<VideoCompositorPad>::cast_static(other)->is_background())
+      {
+        GST_ELEMENT_ERROR(gobj(), CORE, NEGOTIATION, (nullptr),
+          ("%s has a second I420 or NV12 input", get_name().c_str()));
+        return false;
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(pad->mutex_);
+    pad->info_ = info;
+    pad->has_info_ = true;
+    pad->background_ = background;
+  }
+
+  if(background)
+    set_src_caps(caps);
+
+  return true;
+}
+
+void VideoCompositor::update_layer(const Glib::RefPtr<VideoCompositorPad>& pad, Gst::ClockTime start,
+  Gst::ClockTime end)
+{
+  // Takes the next frame of the layer once it starts before the end of
+  // the background frame.
+  const Gst::ClockTime time = pad->get_running_time();
+  const bool due = time == Gst::CLOCK_TIME_NONE || start == Gst::CLOCK_TIME_NONE ||
+    (end != Gst::CLOCK_TIME_NONE ? time < end : time <= start);
+
+  if(pad->has_buffer() && due)
+  {
+    pad->current_ = pad->pop_buffer();
+    pad->coverage_valid_ = false;
+
+    // A gap leaves the layer without a frame until the next one.
+    if(pad->current_ && GST_BUFFER_FLAG_IS_SET(pad->current_->gobj(), GST_BUFFER_FLAG_GAP))
+      pad->current_.reset();
+
+    if(pad->current_)
+    {
+      const Gst::ClockTime duration = pad->current_->get_duration();
+      pad->current_end_ = time != Gst::CLOCK_TIME_NONE && duration != Gst::CLOCK_TIME_NONE ?
+        time + duration : Gst::CLOCK_TIME_NONE;
+
+      std::lock_guard<std::mutex> lock(pad->mutex_);
+      pad->current_info_ = pad->info_;
+    }
+  }
+
+  if(pad->current_ && pad->current_end_ != Gst::CLOCK_TIME_NONE && start != Gst::CLOCK_TIME_NONE &&
+    pad->current_end_ <= start)
+  {
+    pad->current_.reset();
+  }
+}
+
+int VideoCompositor::get_tile_size(gsize n_layers) const
+{
+  const guint size = tile_size_.get_value();
+  if(size)
+    return (std::min(size, 4096u) + 15) & ~15u;
+
+  // The background takes 1.5 bytes per pixel, and each layer 4 more.
+  const double pixel_size = 1.5 + 4.0 * n_layers;
+  int tile_size = 512;
+  while(tile_size > 32 && tile_size * tile_size * pixel_size > l2_cache_size)
+    tile_size /= 2;
+
+  return tile_size;
+}
+
+Gst::FlowReturn VideoCompositor::aggregate_vfunc(bool timeout)
+{
+  Glib::RefPtr<VideoCompositorPad> background;
+  std::vector<Glib::RefPtr<VideoCompositorPad>> pads;
+  bool ended = false;
+
+  for(const Glib::RefPtr<Gst::AggregatorPad>& pad : get_sink_pads())
+  {
+    Glib::RefPtr<VideoCompositorPad> compositor_pad = Glib::RefPtr<VideoCompositorPad>::cast_static(pad);
+    if(compositor_pad->is_background())
+      background = compositor_pad;
+    else
+    {
+      pads.push_back(compositor_pad);
+
+      bool has_info = false;
+      {
+        std::lock_guard<std::mutex> lock(compositor_pad->mutex_);
+        has_info = compositor_pad->has_info_;
+      }
+      ended = ended || (!has_info && pad->is_eos());
+    }
+  }
+
+  if(!background)
+  {
+    // Waits for the background after a live timeout; ends if an input
+    // ended before sending its caps.
+    if(timeout)
+      return Gst::FLOW_OK;
+    if(ended)
+      return Gst::FLOW_EOS;
+
+    GST_ELEMENT_ERROR(gobj(), CORE, NEGOTIATION, (nullptr),
+      ("%s has no I420 or NV12 input", get_name().c_str()));
+    return Gst::FLOW_NOT_NEGOTIATED;
+  }
+
+  const Gst::ClockTime start = background->get_running_time();
+  Glib::RefPtr<Gst::Buffer> buffer = background->pop_buffer();
+  if(!buffer)
+    return background->is_eos() ? Gst::FLOW_EOS : Gst::FLOW_OK;
+
+  // There is nothing to blend onto during a gap of the background.
+  if(GST_BUFFER_FLAG_IS_SET(buffer->gobj(), GST_BUFFER_FLAG_GAP))
+    return Gst::FLOW_OK;
+
+  Gst::VideoInfo info;
+  {
+    std::lock_guard<std::mutex> lock(background->mutex_);
+    info = background->info_;
+  }
+
+  const Gst::ClockTime duration = buffer->get_duration();
+  const Gst::ClockTime end = start != Gst::CLOCK_TIME_NONE && duration != Gst::CLOCK_TIME_NONE ?
+    start + duration : Gst::CLOCK_TIME_NONE;
+
+  // Only copies the background if it is shared. The output is timestamped
+  // in running time, the time of the segment of the aggregator.
+  buffer = buffer->create_writable();
+  if(start != Gst::CLOCK_TIME_NONE)
+    buffer->set_pts(start);
+
+  const int width = GST_VIDEO_INFO_WIDTH(info.gobj());
+  const int height = GST_VIDEO_INFO_HEIGHT(info.gobj());
+
+  std::vector<Glib::RefPtr<VideoCompositorPad>> visible;
+  for(const Glib::RefPtr<VideoCompositorPad>& pad : pads)
+  {
+    update_layer(pad, start, end);
+
+    const GstVideoInfo* layer_info = pad->current_info_.gobj();
+    const int x = pad->xpos_.get_value();
+    const int y = pad->ypos_.get_value();
+    if(pad->current_ && pad->alpha_.get_value() > 0.0 &&
+      x < width && x + GST_VIDEO_INFO_WIDTH(layer_info) > 0 &&
+      y < height && y + GST_VIDEO_INFO_HEIGHT(layer_info) > 0)
+    {
+      visible.push_back(pad);
+    }
+  }
+
+  if(visible.empty())
+    return finish_buffer(buffer);
+
+  Gst::VideoFrame frame;
+  if(!frame.map(info, buffer, Gst::MAP_READWRITE))
+  {
+    GST_ELEMENT_ERROR(gobj(), RESOURCE, WRITE, (nullptr), ("Could not map the background frame"));
+    return Gst::FLOW_ERROR;
+  }
+
+  const int tile_size = get_tile_size(visible.size());
+  const int columns = (width + tile_size - 1) / tile_size;
+  const int rows = (height + tile_size - 1) / tile_size;
+
+  // The frames stay mapped until the tiles are blended.
+  std::vector<Gst::VideoFrame> frames;
+  frames.reserve(visible.size());
+  std::vector<Layer> layers;
+
+  for(const Glib::RefPtr<VideoCompositorPad>& pad : visible)
+  {
+    frames.push_back(Gst::VideoFrame());
+    Gst::VideoFrame& layer_frame = frames.back();
+    if(!layer_frame.map(pad->current_info_, pad->current_, Gst::MAP_READ))
+    {
+      frames.pop_back();
+      continue;
+    }
+
+    Layer layer;
+    layer.pixels = layer_frame.get_plane(0);
+    layer.x = pad->xpos_.get_value();
+    layer.y = pad->ypos_.get_value();
+    layer.alpha = std::min(255, static_cast<int>(std::lround(pad->alpha_.get_value() * 255)));
+    layer.rgb = GST_VIDEO_INFO_FORMAT(pad->current_info_.gobj()) == GST_VIDEO_FORMAT_RGBA;
+    layer.zorder = pad->zorder_.get_value();
+    layer.coverage = &pad->coverage_;
+
+    // Which tiles the layer covers is known while it shows the same frame
+    // at the same place.
+    if(!pad->coverage_valid_ || pad->coverage_x_ != layer.x ||
+      pad->coverage_y_ != layer.y || pad->coverage_tile_size_ != tile_size ||
+      pad->coverage_columns_ != columns || pad->coverage_.size() != static_cast<gsize>(columns * rows))
+    {
+      pad->coverage_.assign(columns * rows, COVERAGE_UNKNOWN);
+      pad->coverage_valid_ = true;
+      pad->coverage_x_ = layer.x;
+      pad->coverage_y_ = layer.y;
+      pad->coverage_tile_size_ = tile_size;
+      pad->coverage_columns_ = columns;
+    }
+
+    layers.push_back(layer);
+  }
+
+  std::stable_sort(layers.begin(), layers.end(),
+    [](const Layer& a, const Layer& b) { return a.zorder < b.zorder; });
+
+  int coefficients[N_COEFFICIENTS];
+  get_coefficients(info.gobj(), coefficients);
+
+  workers_->run(columns * rows, [&](guint tile)
+  {
+    blend_tile(frame, layers, coefficients, tile_size, tile);
+  });
+
+  for(Gst::VideoFrame& layer_frame : frames)
+    layer_frame.unmap();
+  frame.unmap();
+
+  return finish_buffer(buffer);
+}
+
+void VideoCompositor::blend_tile(Gst::VideoFrame& frame, const std::vector<Layer>& layers,
+  const int* coefficients, int tile_size, guint tile)
+{
+  const int width = frame.get_width();
+  const int height = frame.get_height();
+  const int columns = (width + tile_size - 1) / tile_size;
+  const int tile_left = (tile % columns) * tile_size;
+  const int tile_top = (tile / columns) * tile_size;
+  const int tile_right = std::min(width, tile_left + tile_size);
+  const int tile_bottom = std::min(height, tile_top + tile_size);
+
+  const Gst::VideoPlane luma = frame.get_component(GST_VIDEO_COMP_Y);
+  const Gst::VideoPlane u_plane = frame.get_component(GST_VIDEO_COMP_U);
+  const Gst::VideoPlane v_plane = frame.get_component(GST_VIDEO_COMP_V);
+
+  // The Y, U, V and alpha of the layer pixels of two rows, which share
+  // their chroma samples.
+  std::vector<int> samples(tile_size * 2 * 4);
+  guint64 blended = 0, skipped = 0;
+
+  for(const Layer& layer : layers)
+  {
+    const int left = std::max(tile_left, layer.x);
+    const int right = std::min(tile_right, layer.x + layer.pixels.get_width());
+    const int top = std::max(tile_top, layer.y);
+    const int bottom = std::min(tile_bottom, layer.y + layer.pixels.get_height());
+    if(left >= right || top >= bottom)
+      continue;
+
+    // Tiles are never shared between threads, nor their coverage.
+    guint8& coverage = (*layer.coverage)[tile];
+    if(coverage == COVERAGE_UNKNOWN)
+    {
+      const int alpha_offset = layer.rgb ? 3 : 0;
+      coverage = COVERAGE_TRANSPARENT;
+      for(int y = top; y < bottom && coverage == COVERAGE_TRANSPARENT; ++y)
+      {
+        const guint8* const p = layer.pixels.get_pixel(left - layer.x, y - layer.y) + alpha_offset;
+        for(int x = 0; x < right - left; ++x)
+        {
+          if(p[x * 4])
+          {
+            coverage = COVERAGE_VISIBLE;
+            break;
+          }
+        }
+      }
+    }
+
+    if(coverage == COVERAGE_TRANSPARENT)
+    {
+      ++skipped;
+      continue;
+    }
+
+    ++blended;
+
+    // Chroma blocks start on even pixels.
+    const int block_left = left & ~1;
+    const int block_right = (right + 1) & ~1;
+
+    for(int block_top = top & ~1; block_top < bottom; block_top += 2)
+    {
+      for(int r = 0; r < 2; ++r)
+      {
+        int* const s = samples.data() + r * tile_size * 4;
+        for(int x = block_left; x < block_right; ++x)
+          s[(x - block_left) * 4 + 3] = 0;
+
+        const int y = block_top + r;
+        if(y < top || y >= bottom)
+          continue;
+
+        const guint8* const p = layer.pixels.get_pixel(left - layer.x, y - layer.y);
+        guint8* const d = luma.get_row(y);
+
+        for(int x = left; x < right; ++x)
+        {
+          const guint8* const pixel = p + (x - left) * 4;
+          int* const sample = s + (x - block_left) * 4;
+
+          if(layer.rgb)
+          {
+            const int red = pixel[0], green = pixel[1], blue = pixel[2];
+            sample[0] = clamp_u8(coefficients[COEFFICIENT_Y_OFFSET] + ((coefficients[COEFFICIENT_YR] * red +
+              coefficients[COEFFICIENT_YG] * green + coefficients[COEFFICIENT_YB] * blue +
+              coefficient_round) >> coefficient_bits));
+            sample[1] = clamp_u8(128 + ((coefficients[COEFFICIENT_UR] * red + coefficients[COEFFICIENT_UG] * green +
+              coefficients[COEFFICIENT_UB] * blue + coefficient_round) >> coefficient_bits));
+            sample[2] = clamp_u8(128 + ((coefficients[COEFFICIENT_VR] * red + coefficients[COEFFICIENT_VG] * green +
+              coefficients[COEFFICIENT_VB] * blue + coefficient_round) >> coefficient_bits));
+            sample[3] = div255(pixel[3] * layer.alpha);
+          }
+          else
+          {
+            sample[0] = pixel[1];
+            sample[1] = pixel[2];
+            sample[2] = pixel[3];
+            sample[3] = div255(pixel[0] * layer.alpha);
+          }
+
+          const int a = sample[3];
+          if(a)
+            d[x] = static_cast<guint8>(div255(sample[0] * a + d[x] * (255 - a)));
+        }
+      }
+
+      // Blends each chroma sample with the mean of the four layer pixels,
+      // weighted by their alpha.
+      const int* const s0 = samples.data();
+      const int* const s1 = samples.data() + tile_size * 4;
+      const int chroma_y = block_top / 2;
+
+      for(int x = block_left; x < block_right; x += 2)
+      {
+        const int i = (x - block_left) * 4;
+        const int a0 = s0[i + 3], a1 = s0[i + 7], a2 = s1[i + 3], a3 = s1[i + 7];
+        const int alpha_sum = a0 + a1 + a2 + a3;
+        if(!alpha_sum)
+          continue;
+
+        const int u = s0[i + 1] * a0 + s0[i + 5] * a1 + s1[i + 1] * a2 + s1[i + 5] * a3;
+        const int v = s0[i + 2] * a0 + s0[i + 6] * a1 + s1[i + 2] * a2 + s1[i + 6] * a3;
+        guint8* const du = u_plane.get_pixel(x / 2, chroma_y);
+        guint8* const dv = v_plane.get_pixel(x / 2, chroma_y);
+        *du = static_cast<guint8>((u + *du * (4 * 255 - alpha_sum) + 2 * 255) / (4 * 255));
+        *dv = static_cast<guint8>((v + *dv * (4 * 255 - alpha_sum) + 2 * 255) / (4 * 255));
+      }
+    }
+  }
+
+  blended_tiles_ += blended;
+  skipped_tiles_ += skipped;
+}
+
+} // namespace Gst
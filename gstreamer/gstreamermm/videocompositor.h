@@ -0,0 +1,208 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_VIDEOCOMPOSITOR_H
+#define _GSTREAMERMM_VIDEOCOMPOSITOR_H
+
+#include <gstreamermm/aggregator.h>
+#include <gstreamermm/elementfactory.h>
+#include <gstreamermm/plugin.h>
+#include <gstreamermm/register.h>
+#include <gstreamermm/videoframe.h>
+#include <gstreamermm/videoinfo.h>
+#include <glibmm/property.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Gst
+{
+
+class VideoCompositor;
+
+/**
+ * Gst::VideoCompositorPad is a sink pad of a Gst::VideoCompositor. Its
+ * properties place the frames of a layer input on the background.
+ */
+class VideoCompositorPad : public Gst::AggregatorPad
+{
+public:
+  /** Creates a pad from @a templ, which has to be a sink pad template.
+   */
+  static Glib::RefPtr<VideoCompositorPad> create(const Glib::RefPtr<const Gst::PadTemplate>& templ,
+    const Glib::ustring& name);
+
+  /** The horizontal position of the left edge of the layer on the
+   * background, in pixels. It may be negative.
+   */
+  Glib::PropertyProxy<int> property_xpos();
+
+  /** The vertical position of the top edge of the layer on the background,
+   * in pixels. It may be negative.
+   */
+  Glib::PropertyProxy<int> property_ypos();
+
+  /** The opacity of the layer, from 0.0 to 1.0, which multiplies the alpha
+   * of its pixels.
+   */
+  Glib::PropertyProxy<double> property_alpha();
+
+  /** The stacking order of the layer; higher layers are blended last. Layers
+   * of equal order are stacked in the order their pads were requested.
+   */
+  Glib::PropertyProxy<guint> property_zorder();
+
+  /** Checks whether the input is the background, the I420 or NV12 input
+   * the layers are blended onto.
+   */
+  bool is_background() const;
+
+protected:
+  VideoCompositorPad(const Glib::RefPtr<const Gst::PadTemplate>& templ, const Glib::ustring& name);
+
+  void flush_vfunc() override;
+
+private:
+  friend class VideoCompositor;
+
+  Glib::Property<int> xpos_;
+  Glib::Property<int> ypos_;
+  Glib::Property<double> alpha_;
+  Glib::Property<guint> zorder_;
+
+  // Protects the caps of the input, which change from its streaming thread.
+  mutable std::mutex mutex_;
+  Gst::VideoInfo info_;
+  bool has_info_;
+  bool background_;
+
+  // The state below is only used by the streaming thread of the compositor.
+
+  // The layer frame being shown, and the running time it ends at.
+  Glib::RefPtr<Gst::Buffer> current_;
+  Gst::VideoInfo current_info_;
+  Gst::ClockTime current_end_;
+
+  // Whether each tile is covered by visible pixels of the current frame,
+  // for the position and tiling it was computed with. Invalidated whenever
+  // a new frame is taken, since pooled buffers are reused.
+  std::vector<guint8> coverage_;
+  bool coverage_valid_;
+  int coverage_x_;
+  int coverage_y_;
+  int coverage_tile_size_;
+  int coverage_columns_;
+};
+
+/**
+ * Gst::VideoCompositor blends RGBA and AYUV layers onto I420 or NV12 video,
+ * such as logos and captions rendered by the application.
+ *
+ * It is registered as "mmvideocompositor" by register_element(). One of its
+ * "sink_%u" inputs carries the I420 or NV12 background, whose caps are
+ * those of the output; the other inputs carry the layers, placed with the
+ * properties of their Gst::VideoCompositorPad:
+ * @code
+ * videotestsrc ! video/x-raw,format=NV12 ! mmvideocompositor name=comp sink_1::xpos=16 ! ...
+ * appsrc name=logo caps=video/x-raw,format=RGBA,... ! comp.
+ * @endcode
+ *
+ * An output frame is produced for each background frame, which is blended
+ * in place: the background buffer is only copied if it is shared. Each
+ * layer shows its latest frame which started before the background frame,
+ * until that frame ends; a layer whose frames have no duration keeps its
+ * last frame shown.
+ *
+ * The frame is blended in square tiles sized so that the background and
+ * layer pixels of a tile fit in a 256 KiB L2 cache, and the tiles are
+ * shared out to "threads" threads, the streaming thread included. The tiles
+ * where a layer has no visible pixel are skipped; which tiles they are is
+ * remembered for as long as the layer shows the same frame at the same
+ * position, so that static overlays only cost the tiles they cover.
+ *
+ * RGBA layers are converted with the color matrix and range of the
+ * background, BT.601 if it has none. The chroma of a 2x2 block of pixels is
+ * blended with the mean of the alpha of the layer pixels, each weighted by
+ * its alpha, so that the colors of transparent pixels do not bleed.
+ */
+class VideoCompositor : public Gst::Aggregator
+{
+public:
+  /** Registers the element as "mmvideocompositor" in @a plugin.
+   */
+  static bool register_element(Glib::RefPtr<Gst::Plugin> plugin);
+
+  /** The number of threads blending the tiles, the streaming thread
+   * included, or 0 for one per CPU. Read when the element starts.
+   */
+  Glib::PropertyProxy<guint> property_threads();
+
+  /** The width and height of the tiles, in pixels, or 0 to size them for
+   * the L2 cache. Rounded up to a multiple of 16, at most 4096.
+   */
+  Glib::PropertyProxy<guint> property_tile_size();
+
+  /** Returns the number of tiles blended with a layer since the element
+   * started, counting each layer of a tile.
+   */
+  guint64 get_blended_tiles() const;
+
+  /** Returns the number of tiles skipped since the element started because
+   * a layer had no visible pixel on them, counting each layer of a tile.
+   */
+  guint64 get_skipped_tiles() const;
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  static void class_init(Gst::ElementClass<VideoCompositor>* klass);
+
+  explicit VideoCompositor(GstElement* gobj);
+  virtual ~VideoCompositor();
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+protected:
+  Gst::FlowReturn aggregate_vfunc(bool timeout) override;
+  bool sink_event_vfunc(const Glib::RefPtr<Gst::AggregatorPad>& pad,
+    const Glib::RefPtr<Gst::Event>& event) override;
+  Glib::RefPtr<Gst::AggregatorPad> create_new_pad_vfunc(const Glib::RefPtr<Gst::PadTemplate>& templ,
+    const Glib::ustring& name, const Glib::RefPtr<const Gst::Caps>& caps) override;
+  bool start_vfunc() override;
+  bool stop_vfunc() override;
+
+private:
+  class TileWorkers;
+  struct Layer;
+
+  bool set_pad_caps(const Glib::RefPtr<VideoCompositorPad>& pad, const Glib::RefPtr<Gst::Caps>& caps);
+  void update_layer(const Glib::RefPtr<VideoCompositorPad>& pad, Gst::ClockTime start, Gst::ClockTime end);
+  int get_tile_size(gsize n_layers) const;
+  void blend_tile(Gst::VideoFrame& frame, const std::vector<Layer>& layers, const int* coefficients,
+    int tile_size, guint tile);
+
+  Glib::Property<guint> threads_;
+  Glib::Property<guint> tile_size_;
+
+  std::unique_ptr<TileWorkers> workers_;
+  std::atomic<guint64> blended_tiles_;
+  std::atomic<guint64> skipped_tiles_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_VIDEOCOMPOSITOR_H */
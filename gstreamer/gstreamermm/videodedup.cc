@@ -0,0 +1,291 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/videodedup.h>
+#include <gstreamermm/elementfactory.h>
+#include <gstreamermm/message.h>
+#include <gstreamermm/pad.h>
+#include <gstreamermm/padtemplate.h>
+#include <gstreamermm/videoframe.h>
+#include <gstreamermm/videolayout.h>
+#include <algorithm>
+
+namespace
+{
+
+// The end of a frame, or Gst::CLOCK_TIME_NONE if it is not known.
+Gst::ClockTime get_end(const Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  const Gst::ClockTime pts = buffer->get_pts();
+  const Gst::ClockTime duration = buffer->get_duration();
+  return pts != Gst::CLOCK_TIME_NONE && duration != Gst::CLOCK_TIME_NONE ?
+    pts + duration : Gst::CLOCK_TIME_NONE;
+}
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+bool VideoDedup::register_element(Glib::RefPtr<Gst::Plugin> plugin)
+{
+  return Gst::ElementFactory::register_element(plugin, "mmvideodedup", Gst::RANK_NONE,
+    Gst::register_mm_type<VideoDedup>("gstreamermm__VideoDedup"));
+}
+
+void VideoDedup::class_init(Gst::ElementClass<VideoDedup>* klass)
+{
+  klass->set_metadata("Video deduplicator", "Filter/Video",
+    "Drops or flags the repeated frames of video, extending the duration of the frames they repeat",
+    "The gstreamermm Development Team");
+
+  // The formats whose planes have a pixel stride, which can be hashed.
+  const Glib::RefPtr<Gst::Caps> caps = Gst::Caps::create_from_string(GST_VIDEO_CAPS_MAKE(
+    "{ I420, YV12, NV12, NV21, Y42B, Y444, YUY2, UYVY, AYUV, GRAY8, "
+    "RGBA, BGRA, ARGB, ABGR, RGBx, BGRx, xRGB, xBGR, RGB, BGR }"));
+  klass->add_pad_template(Gst::PadTemplate::create("sink", Gst::PAD_SINK, Gst::PAD_ALWAYS, caps));
+  klass->add_pad_template(Gst::PadTemplate::create("src", Gst::PAD_SRC, Gst::PAD_ALWAYS, caps));
+}
+
+VideoDedup::VideoDedup(GstBaseTransform* gobj)
+: Glib::ObjectBase(typeid (VideoDedup)),
+  Gst::BaseTransform(gobj),
+  drop_(*this, "drop", true),
+  grid_(*this, "grid", 1),
+  max_repeats_(*this, "max-repeats", 0),
+  negotiated_(false),
+  dropping_(true),
+  grid_step_(1),
+  max_repeats_value_(0),
+  frame_duration_(0),
+  has_hash_(false),
+  hash_(0),
+  repeats_(0),
+  held_end_(Gst::CLOCK_TIME_NONE),
+  held_result_(Gst::FLOW_OK),
+  frames_(0),
+  total_repeats_(0)
+{
+  // The frames are only dropped or flagged: the allocation queries go
+  // upstream.
+  set_passthrough(true);
+}
+
+Glib::PropertyProxy<bool> VideoDedup::property_drop()
+{
+  return drop_.get_proxy();
+}
+
+Glib::PropertyProxy<guint> VideoDedup::property_grid()
+{
+  return grid_.get_proxy();
+}
+
+Glib::PropertyProxy<guint> VideoDedup::property_max_repeats()
+{
+  return max_repeats_.get_proxy();
+}
+
+guint64 VideoDedup::get_frames() const
+{
+  return frames_.load();
+}
+
+guint64 VideoDedup::get_repeats() const
+{
+  return total_repeats_.load();
+}
+
+bool VideoDedup::set_caps_vfunc(const Glib::RefPtr<Gst::Caps>& incaps, const Glib::RefPtr<Gst::Caps>&)
+{
+  negotiated_ = Gst::VideoLayout::from_caps(incaps, info_);
+  if(!negotiated_)
+    return false;
+
+  dropping_ = drop_.get_value();
+  grid_step_ = static_cast<int>(std::min<guint>(std::max<guint>(1, grid_.get_value()), G_MAXINT));
+  max_repeats_value_ = max_repeats_.get_value();
+  // The frames of another format are never repeats.
+  has_hash_ = false;
+  repeats_ = 0;
+
+  const int fps_n = GST_VIDEO_INFO_FPS_N(info_.gobj());
+  const int fps_d = GST_VIDEO_INFO_FPS_D(info_.gobj());
+  const guint64 duration = dropping_ && fps_n > 0 ?
+    gst_util_uint64_scale_int(GST_SECOND, fps_d, fps_n) : 0;
+  if(frame_duration_.exchange(duration) != duration)
+    post_message(Gst::MessageLatency::create(Glib::wrap(GST_OBJECT(gobj()), true)));
+
+  return true;
+}
+
+Glib::RefPtr<Gst::Buffer> VideoDedup::release_held(Gst::ClockTime next)
+{
+  Glib::RefPtr<Gst::Buffer> held = held_;
+  held_.reset();
+  if(!held || !repeats_)
+    return held;
+
+  // The frame lasts until the next different frame, or the end of its last
+  // repeat.
+  const Gst::ClockTime end = next != Gst::CLOCK_TIME_NONE ? next : held_end_;
+  const Gst::ClockTime pts = held->get_pts();
+  if(pts != Gst::CLOCK_TIME_NONE && end != Gst::CLOCK_TIME_NONE && end > pts)
+  {
+    // Only the metadata is copied if the frame is shared.
+    held = held->create_writable();
+    held->set_duration(end - pts);
+  }
+
+  return held;
+}
+
+Gst::FlowReturn VideoDedup::generate_output_vfunc(Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  GstBuffer* const queued = gobj()->queued_buf;
+  if(!queued)
+    return Gst::FLOW_OK;
+  gobj()->queued_buf = nullptr;
+  Glib::RefPtr<Gst::Buffer> input = Glib::wrap(queued, false);
+
+  // A held frame pushed before an event failed to be pushed.
+  if(held_result_ != Gst::FLOW_OK)
+  {
+    const Gst::FlowReturn result = held_result_;
+    held_result_ = Gst::FLOW_OK;
+    return result;
+  }
+
+  if(!negotiated_)
+    return Gst::FLOW_NOT_NEGOTIATED;
+
+  Gst::VideoFrame frame;
+  if(!frame.map(info_, input, Gst::MAP_READ))
+  {
+    GST_ELEMENT_ERROR(gobj(), RESOURCE, READ, (nullptr), ("Could not map the frame"));
+    return Gst::FLOW_ERROR;
+  }
+  const guint64 hash = kernels_.hash(frame, grid_step_);
+  frame.unmap();
+
+  ++frames_;
+  const bool repeat = has_hash_ && hash == hash_ &&
+    (!max_repeats_value_ || repeats_ < max_repeats_value_);
+  has_hash_ = true;
+  hash_ = hash;
+
+  if(repeat)
+  {
+    ++repeats_;
+    ++total_repeats_;
+
+    if(dropping_)
+    {
+      held_end_ = get_end(input);
+      return Gst::FLOW_OK;
+    }
+
+    input = input->create_writable();
+    GST_BUFFER_FLAG_SET(input->gobj(), GST_BUFFER_FLAG_DROPPABLE);
+    buffer = input;
+    return Gst::FLOW_OK;
+  }
+
+  if(dropping_)
+  {
+    // The previous frame is pushed now that its duration is known.
+    buffer = release_held(input->get_pts());
+    held_ = input;
+    held_end_ = get_end(input);
+  }
+  else
+    buffer = input;
+
+  repeats_ = 0;
+  return Gst::FLOW_OK;
+}
+
+void VideoDedup::reset()
+{
+  held_.reset();
+  held_end_ = Gst::CLOCK_TIME_NONE;
+  has_hash_ = false;
+  repeats_ = 0;
+}
+
+bool VideoDedup::sink_event_vfunc(const Glib::RefPtr<Gst::Event>& event)
+{
+  switch(event->get_event_type())
+  {
+  case Gst::EVENT_FLUSH_STOP:
+    reset();
+    held_result_ = Gst::FLOW_OK;
+    break;
+  case Gst::EVENT_EOS:
+  case Gst::EVENT_CAPS:
+  case Gst::EVENT_SEGMENT:
+  case Gst::EVENT_GAP:
+    // The held frame ends before these events, and the next frame starts a
+    // new run, since there is no held frame left to extend. The other
+    // events, such as tags, leave the run going.
+    if(held_)
+    {
+      const Gst::FlowReturn result = get_src_pad()->push(release_held(Gst::CLOCK_TIME_NONE));
+      if(result != Gst::FLOW_OK)
+        held_result_ = result;
+
+      has_hash_ = false;
+      repeats_ = 0;
+    }
+    break;
+  default:
+    break;
+  }
+
+  return Gst::BaseTransform::sink_event_vfunc(event);
+}
+
+bool VideoDedup::base_transform_query_vfunc(Gst::PadDirection direction, const Glib::RefPtr<Gst::Query>& query)
+{
+  if(!Gst::BaseTransform::base_transform_query_vfunc(direction, query))
+    return false;
+
+  // Dropping holds each frame until the next one arrives.
+  const guint64 duration = frame_duration_.load();
+  if(direction == Gst::PAD_SRC && GST_QUERY_TYPE(query->gobj()) == GST_QUERY_LATENCY && duration)
+  {
+    gboolean live = FALSE;
+    GstClockTime min_latency = 0, max_latency = 0;
+    gst_query_parse_latency(query->gobj(), &live, &min_latency, &max_latency);
+    gst_query_set_latency(query->gobj(), live, min_latency + duration,
+      max_latency != GST_CLOCK_TIME_NONE ? max_latency + duration : GST_CLOCK_TIME_NONE);
+  }
+
+  return true;
+}
+
+bool VideoDedup::stop_vfunc()
+{
+  reset();
+  held_result_ = Gst::FLOW_OK;
+  negotiated_ = false;
+  return Gst::BaseTransform::stop_vfunc();
+}
+
+} // namespace Gst
@@ -0,0 +1,132 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_VIDEODEDUP_H
+#define _GSTREAMERMM_VIDEODEDUP_H
+
+#include <gstreamermm/basetransform.h>
+#include <gstreamermm/register.h>
+#include <gstreamermm/videoinfo.h>
+#include <gstreamermm/videokernels.h>
+#include <glibmm/property.h>
+#include <atomic>
+
+namespace Gst
+{
+
+/**
+ * Gst::VideoDedup is an element removing the repeated frames of a video
+ * stream, such as the frames of a screen capture or of slides which do not
+ * change, so that they are not encoded again.
+ *
+ * It is registered as "mmvideodedup" by register_element(). Each frame is
+ * hashed with Gst::VideoKernels::hash(), and is a repeat when its hash is
+ * the one of the previous frame. The "grid" property hashes a fraction of
+ * the pixels, which is faster for large frames but misses the changes
+ * between the sampled pixels.
+ *
+ * When "drop" is true, the repeats are dropped and the duration of the
+ * frame they repeat is extended until the next different frame, so the
+ * stream stays continuous. Each frame is held until the next one arrives
+ * to know its duration: the element adds the duration of one frame to the
+ * latency. When "drop" is false, the repeats are pushed with the
+ * Gst::BUFFER_FLAG_DROPPABLE flag set.
+ *
+ * The pixels are never modified or copied, and the properties are read when
+ * the caps are set.
+ */
+class VideoDedup : public Gst::BaseTransform
+{
+public:
+  /** Registers the element as "mmvideodedup" in @a plugin.
+   */
+  static bool register_element(Glib::RefPtr<Gst::Plugin> plugin);
+
+  /** Whether to drop the repeated frames, or only flag them.
+   */
+  Glib::PropertyProxy<bool> property_drop();
+
+  /** The step between the rows, and the blocks of 32 bytes of a row, which
+   * are hashed; 1 hashes all the pixels.
+   */
+  Glib::PropertyProxy<guint> property_grid();
+
+  /** The highest number of consecutive repeats dropped or flagged, 0 for no
+   * limit: the next repeat is pushed as a new frame, so that a stream keeps
+   * refreshing.
+   */
+  Glib::PropertyProxy<guint> property_max_repeats();
+
+  /** Returns the number of frames received.
+   */
+  guint64 get_frames() const;
+
+  /** Returns the number of repeated frames dropped or flagged.
+   */
+  guint64 get_repeats() const;
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  static void class_init(Gst::ElementClass<VideoDedup>* klass);
+
+  explicit VideoDedup(GstBaseTransform* gobj);
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+protected:
+  bool set_caps_vfunc(const Glib::RefPtr<Gst::Caps>& incaps, const Glib::RefPtr<Gst::Caps>& outcaps) override;
+  Gst::FlowReturn generate_output_vfunc(Glib::RefPtr<Gst::Buffer>& buffer) override;
+  bool sink_event_vfunc(const Glib::RefPtr<Gst::Event>& event) override;
+  bool base_transform_query_vfunc(Gst::PadDirection direction, const Glib::RefPtr<Gst::Query>& query) override;
+  bool stop_vfunc() override;
+
+private:
+  Glib::RefPtr<Gst::Buffer> release_held(Gst::ClockTime next);
+  void reset();
+
+  Glib::Property<bool> drop_;
+  Glib::Property<guint> grid_;
+  Glib::Property<guint> max_repeats_;
+
+  VideoKernels kernels_;
+  Gst::VideoInfo info_;
+  bool negotiated_;
+  bool dropping_;
+  int grid_step_;
+  guint max_repeats_value_;
+  // The duration of a frame, added to the latency when dropping.
+  std::atomic<guint64> frame_duration_;
+
+  // The hash of the previous frame, and the number of its repeats.
+  bool has_hash_;
+  guint64 hash_;
+  guint repeats_;
+  // When dropping, the frame waiting for its duration, and the end of its
+  // last repeat.
+  Glib::RefPtr<Gst::Buffer> held_;
+  Gst::ClockTime held_end_;
+  // The result of pushing the held frame before an event, returned for the
+  // next frame.
+  Gst::FlowReturn held_result_;
+
+  std::atomic<guint64> frames_;
+  std::atomic<guint64> total_repeats_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_VIDEODEDUP_H */
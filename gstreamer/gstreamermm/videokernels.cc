@@ -0,0 +1,1405 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/videokernels.h>
+#include <gstreamermm/audiokernels.h>
+#include <gstreamermm/handle_error.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define GSTREAMERMM_VIDEO_KERNELS_SSE2 1
+#include <emmintrin.h>
+// AVX2 code is compiled with a target attribute and selected at run time,
+// which needs GCC or Clang.
+#if defined(__GNUC__)
+#define GSTREAMERMM_VIDEO_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__)
+#define GSTREAMERMM_VIDEO_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+
+// The conversions between YUV and RGB use integer coefficients with 13
+// fractional bits: the products of 8 bit samples fit in 16 bits, and their
+// sums in 32 bits, which all instruction sets compute exactly.
+const int coefficient_bits = 13;
+const int coefficient_round = 1 << (coefficient_bits - 1);
+
+enum
+{
+  // YUV to RGB
+  COEFFICIENT_Y_OFFSET,
+  COEFFICIENT_Y,
+  COEFFICIENT_RV,
+  COEFFICIENT_GU,
+  COEFFICIENT_GV,
+  COEFFICIENT_BU,
+  // RGB to YUV
+  COEFFICIENT_YR,
+  COEFFICIENT_YG,
+  COEFFICIENT_YB,
+  COEFFICIENT_UR,
+  COEFFICIENT_UG,
+  COEFFICIENT_UB,
+  COEFFICIENT_VR,
+  COEFFICIENT_VG,
+  COEFFICIENT_VB,
+  N_COEFFICIENTS
+};
+
+// Computes the coefficients for the color matrix and range of @a info.
+void get_coefficients(const GstVideoInfo* info, int* coefficients)
+{
+  gdouble kr = 0.299, kb = 0.114;
+  gst_video_color_matrix_get_Kr_Kb(info->colorimetry.matrix, &kr, &kb);
+
+  const bool full_range = info->colorimetry.range == GST_VIDEO_COLOR_RANGE_0_255;
+  const double y_scale = full_range ? 255.0 : 219.0;
+  const double c_scale = full_range ? 255.0 : 224.0;
+  const double kg = 1.0 - kr - kb;
+  const double one = 1 << coefficient_bits;
+
+  coefficients[COEFFICIENT_Y_OFFSET] = full_range ? 0 : 16;
+  coefficients[COEFFICIENT_Y] = std::lround(255.0 / y_scale * one);
+  coefficients[COEFFICIENT_RV] = std::lround(255.0 / c_scale * 2 * (1 - kr) * one);
+  coefficients[COEFFICIENT_GU] = std::lround(-255.0 / c_scale * 2 * (1 - kb) * kb / kg * one);
+  coefficients[COEFFICIENT_GV] = std::lround(-255.0 / c_scale * 2 * (1 - kr) * kr / kg * one);
+  coefficients[COEFFICIENT_BU] = std::lround(255.0 / c_scale * 2 * (1 - kb) * one);
+
+  const double u_scale = c_scale / 255.0 / (2 * (1 - kb));
+  const double v_scale = c_scale / 255.0 / (2 * (1 - kr));
+  coefficients[COEFFICIENT_YR] = std::lround(kr * y_scale / 255.0 * one);
+  coefficients[COEFFICIENT_YG] = std::lround(kg * y_scale / 255.0 * one);
+  coefficients[COEFFICIENT_YB] = std::lround(kb * y_scale / 255.0 * one);
+  coefficients[COEFFICIENT_UR] = std::lround(-kr * u_scale * one);
+  coefficients[COEFFICIENT_UG] = std::lround(-kg * u_scale * one);
+  coefficients[COEFFICIENT_UB] = std::lround((1 - kb) * u_scale * one);
+  coefficients[COEFFICIENT_VR] = std::lround((1 - kr) * v_scale * one);
+  coefficients[COEFFICIENT_VG] = std::lround(-kg * v_scale * one);
+  coefficients[COEFFICIENT_VB] = std::lround(-kb * v_scale * one);
+}
+
+inline guint8 clamp_u8(int x)
+{
+  return static_cast<guint8>(x < 0 ? 0 : (x > 255 ? 255 : x));
+}
+
+// Divides by 255, rounding to nearest, for x in [0, 65025].
+inline int div255(int x)
+{
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+bool is_rgb(GstVideoFormat format)
+{
+  return format == GST_VIDEO_FORMAT_RGBA || format == GST_VIDEO_FORMAT_BGRx;
+}
+
+// Returns row @a row of @a component, gathered in @a temp if its samples
+// are not contiguous.
+const guint8* read_row(const Gst::ConstVideoPlane& component, int row, guint8* temp)
+{
+  const guint8* const p = component.get_row(row);
+  const int pixel_stride = component.get_pixel_stride();
+  if(pixel_stride == 1)
+    return p;
+
+  for(int x = 0; x < component.get_width(); ++x)
+    temp[x] = p[x * pixel_stride];
+
+  return temp;
+}
+
+// Returns where row @a row of @a component can be computed: the row itself
+// if its samples are contiguous, @a temp otherwise.
+guint8* get_row_target(const Gst::VideoPlane& component, int row, guint8* temp)
+{
+  return component.get_pixel_stride() == 1 ? component.get_row(row) : temp;
+}
+
+// Stores the samples of @a data into row @a row of @a component, if they
+// were not computed in place.
+void write_row(const Gst::VideoPlane& component, int row, const guint8* data)
+{
+  guint8* const p = component.get_row(row);
+  const int pixel_stride = component.get_pixel_stride();
+  if(p == data)
+    return;
+
+  if(pixel_stride == 1)
+    std::memcpy(p, data, component.get_width());
+  else
+  {
+    for(int x = 0; x < component.get_width(); ++x)
+      p[x * pixel_stride] = data[x];
+  }
+}
+
+// The index of the left (or top) source pixel of each destination pixel,
+// and the weight of the next one in [0, 255], for bilinear interpolation
+// between pixel centers.
+void compute_positions(int src_size, int dest_size, std::vector<int>& indexes, std::vector<int>& weights)
+{
+  indexes.resize(dest_size);
+  weights.resize(dest_size);
+
+  for(int i = 0; i < dest_size; ++i)
+  {
+    // The center of the destination pixel in source pixels, in 16.16
+    // fixed point.
+    gint64 position = (((2 * static_cast<gint64>(i) + 1) * src_size) << 16) / (2 * dest_size) - (1 << 15);
+    position = std::max<gint64>(position, 0);
+
+    int index = static_cast<int>(position >> 16);
+    int weight = static_cast<int>((position >> 8) & 0xff);
+    if(index >= src_size - 1)
+    {
+      index = src_size - 1;
+      weight = 0;
+    }
+
+    indexes[i] = index;
+    weights[i] = weight;
+  }
+}
+
+/* Scalar kernels */
+
+void yuv_to_rgb_scalar(const guint8* y, const guint8* u, const guint8* v, guint8* rgb,
+  int width, const int* coefficients, bool bgr)
+{
+  const int y_offset = coefficients[COEFFICIENT_Y_OFFSET];
+  const int cy = coefficients[COEFFICIENT_Y];
+  const int rv = coefficients[COEFFICIENT_RV];
+  const int gu = coefficients[COEFFICIENT_GU];
+  const int gv = coefficients[COEFFICIENT_GV];
+  const int bu = coefficients[COEFFICIENT_BU];
+  const int r = bgr ? 2 : 0;
+  const int b = bgr ? 0 : 2;
+
+  for(int x = 0; x < width; ++x)
+  {
+    const int luma = (y[x] - y_offset) * cy + coefficient_round;
+    const int cb = u[x >> 1] - 128;
+    const int cr = v[x >> 1] - 128;
+    guint8* const p = rgb + x * 4;
+
+    p[r] = clamp_u8((luma + cr * rv) >> coefficient_bits);
+    p[1] = clamp_u8((luma + cb * gu + cr * gv) >> coefficient_bits);
+    p[b] = clamp_u8((luma + cb * bu) >> coefficient_bits);
+    p[3] = 255;
+  }
+}
+
+void rgb_to_y_scalar(const guint8* rgb, guint8* y, int width, const int* coefficients, bool bgr)
+{
+  const int y_offset = coefficients[COEFFICIENT_Y_OFFSET];
+  const int yr = coefficients[COEFFICIENT_YR];
+  const int yg = coefficients[COEFFICIENT_YG];
+  const int yb = coefficients[COEFFICIENT_YB];
+  const int r = bgr ? 2 : 0;
+  const int b = bgr ? 0 : 2;
+
+  for(int x = 0; x < width; ++x)
+  {
+    const guint8* const p = rgb + x * 4;
+    y[x] = clamp_u8(y_offset + ((p[r] * yr + p[1] * yg + p[b] * yb + coefficient_round) >> coefficient_bits));
+  }
+}
+
+void lerp_scalar(const guint8* a, const guint8* b, guint8* dest, gsize size, int weight)
+{
+  const int weight_a = 256 - weight;
+
+  for(gsize i = 0; i < size; ++i)
+    dest[i] = static_cast<guint8>((a[i] * weight_a + b[i] * weight + 128) >> 8);
+}
+
+// Blends pixels with their alpha in the fourth byte; the alpha of the
+// result is the alpha of the "over" operator.
+void blend_scalar(const guint8* src, guint8* dest, int width, int alpha)
+{
+  for(int x = 0; x < width; ++x)
+  {
+    const guint8* const s = src + x * 4;
+    guint8* const d = dest + x * 4;
+    const int a = div255(s[3] * alpha);
+
+    for(int k = 0; k < 3; ++k)
+      d[k] = static_cast<guint8>(div255(s[k] * a + d[k] * (255 - a)));
+    d[3] = static_cast<guint8>(div255(255 * a + d[3] * (255 - a)));
+  }
+}
+
+// The hash reads the rows in stripes of 32 bytes, as four 64 bit lanes:
+// each lane adds its data, and the product of the two 32 bit halves of the
+// data mixed with a key and the position of the stripe, to its accumulator.
+// SSE2, AVX2 and NEON all multiply 32 bit halves into 64 bits.
+const guint64 hash_keys[4] = {
+  G_GUINT64_CONSTANT(0x9e3779b185ebca87), G_GUINT64_CONSTANT(0xc2b2ae3d27d4eb4f),
+  G_GUINT64_CONSTANT(0x165667b19e3779f9), G_GUINT64_CONSTANT(0x27d4eb2f165667c5)
+};
+const guint64 hash_positions[4] = {
+  G_GUINT64_CONSTANT(0x61c8864680b583eb), G_GUINT64_CONSTANT(0x8ebc6af09c88c6e3),
+  G_GUINT64_CONSTANT(0x589965cc75374cc3), G_GUINT64_CONSTANT(0x1d8e4e27c47d124f)
+};
+const gsize hash_stripe_size = 32;
+
+void hash_stripe(const guint8* stripe, guint64 index, guint64* acc)
+{
+  for(int j = 0; j < 4; ++j)
+  {
+    guint64 data;
+    std::memcpy(&data, stripe + j * 8, 8);
+    const guint64 mixed = (data ^ hash_keys[j]) + index * hash_positions[j];
+    acc[j] += data + (mixed & 0xffffffff) * (mixed >> 32);
+  }
+}
+
+// Hashes the last, partial stripe, padded with zeros, if @a index is not
+// past it.
+void hash_tail(const guint8* data, gsize size, gsize index, guint64* acc)
+{
+  if(index * hash_stripe_size < size)
+  {
+    guint8 stripe[hash_stripe_size] = {};
+    std::memcpy(stripe, data + index * hash_stripe_size, size - index * hash_stripe_size);
+    hash_stripe(stripe, index, acc);
+  }
+}
+
+// Hashes the stripes of a row whose index is a multiple of @a step.
+void hash_scalar(const guint8* data, gsize size, gsize step, guint64* acc)
+{
+  gsize i = 0;
+  for(; (i + 1) * hash_stripe_size <= size; i += step)
+    hash_stripe(data + i * hash_stripe_size, i, acc);
+
+  hash_tail(data, size, i, acc);
+}
+
+// Mixes the accumulators after each row, so that the order of the rows
+// matters.
+void hash_scramble(guint64* acc)
+{
+  for(int j = 0; j < 4; ++j)
+    acc[j] = (acc[j] ^ (acc[j] >> 47) ^ hash_keys[j]) * G_GUINT64_CONSTANT(0x9e3779b1);
+}
+
+guint64 hash_avalanche(guint64 x)
+{
+  x ^= x >> 33;
+  x *= G_GUINT64_CONSTANT(0xff51afd7ed558ccd);
+  x ^= x >> 33;
+  x *= G_GUINT64_CONSTANT(0xc4ceb9fe1a85ec53);
+  return x ^ (x >> 33);
+}
+
+guint64 hash_finish(const guint64* acc)
+{
+  guint64 hash = 0;
+  for(int j = 0; j < 4; ++j)
+    hash = hash_avalanche(hash ^ hash_avalanche(acc[j] + hash_keys[j]));
+  return hash;
+}
+
+// Sums the absolute differences of two rows, and copies the first one into
+// @a copy if it is not nullptr, which may be the second one.
+guint64 sad_scalar(const guint8* a, const guint8* b, guint8* copy, gsize size)
+{
+  guint64 sum = 0;
+  for(gsize i = 0; i < size; ++i)
+    sum += std::abs(a[i] - b[i]);
+
+  if(copy)
+    std::memmove(copy, a, size);
+  return sum;
+}
+
+#ifdef GSTREAMERMM_VIDEO_KERNELS_SSE2
+
+/* SSE2 kernels */
+
+// Two 16 bit coefficients, multiplied with a pair of samples by
+// _mm_madd_epi16().
+inline __m128i sse2_pair(int lo, int hi)
+{
+  return _mm_set1_epi32(static_cast<int>((static_cast<guint32>(hi) << 16) | static_cast<guint16>(lo)));
+}
+
+inline __m128i sse2_div255(__m128i x)
+{
+  x = _mm_add_epi16(x, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Loads the 4 chroma samples of 8 pixels, each repeated for two pixels,
+// as 16 bit values centered on 0.
+inline __m128i sse2_load_chroma(const guint8* c)
+{
+  gint32 samples;
+  std::memcpy(&samples, c, sizeof(samples));
+  const __m128i v = _mm_cvtsi32_si128(samples);
+  return _mm_sub_epi16(_mm_unpacklo_epi8(_mm_unpacklo_epi8(v, v), _mm_setzero_si128()),
+    _mm_set1_epi16(128));
+}
+
+void yuv_to_rgb_sse2(const guint8* y, const guint8* u, const guint8* v, guint8* rgb,
+  int width, const int* coefficients, bool bgr)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+  const __m128i y_offset = _mm_set1_epi16(coefficients[COEFFICIENT_Y_OFFSET]);
+  // (Y, 1) * (cy, round), (U, V) * (0, rv), (gu, gv) and (bu, 0)
+  const __m128i ky = sse2_pair(coefficients[COEFFICIENT_Y], coefficient_round);
+  const __m128i kr = sse2_pair(0, coefficients[COEFFICIENT_RV]);
+  const __m128i kg = sse2_pair(coefficients[COEFFICIENT_GU], coefficients[COEFFICIENT_GV]);
+  const __m128i kb = sse2_pair(coefficients[COEFFICIENT_BU], 0);
+  const __m128i alpha = _mm_set1_epi8(-1);
+  int x = 0;
+
+  for(; x + 8 <= width; x += 8)
+  {
+    const __m128i luma = _mm_sub_epi16(
+      _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + x)), zero), y_offset);
+    const __m128i cb = sse2_load_chroma(u + x / 2);
+    const __m128i cr = sse2_load_chroma(v + x / 2);
+
+    const __m128i luma_lo = _mm_madd_epi16(_mm_unpacklo_epi16(luma, ones), ky);
+    const __m128i luma_hi = _mm_madd_epi16(_mm_unpackhi_epi16(luma, ones), ky);
+    const __m128i chroma_lo = _mm_unpacklo_epi16(cb, cr);
+    const __m128i chroma_hi = _mm_unpackhi_epi16(cb, cr);
+
+    const __m128i r = _mm_packs_epi32(
+      _mm_srai_epi32(_mm_add_epi32(luma_lo, _mm_madd_epi16(chroma_lo, kr)), coefficient_bits),
+      _mm_srai_epi32(_mm_add_epi32(luma_hi, _mm_madd_epi16(chroma_hi, kr)), coefficient_bits));
+    const __m128i g = _mm_packs_epi32(
+      _mm_srai_epi32(_mm_add_epi32(luma_lo, _mm_madd_epi16(chroma_lo, kg)), coefficient_bits),
+      _mm_srai_epi32(_mm_add_epi32(luma_hi, _mm_madd_epi16(chroma_hi, kg)), coefficient_bits));
+    const __m128i b = _mm_packs_epi32(
+      _mm_srai_epi32(_mm_add_epi32(luma_lo, _mm_madd_epi16(chroma_lo, kb)), coefficient_bits),
+      _mm_srai_epi32(_mm_add_epi32(luma_hi, _mm_madd_epi16(chroma_hi, kb)), coefficient_bits));
+
+    const __m128i r8 = _mm_packus_epi16(r, r);
+    const __m128i g8 = _mm_packus_epi16(g, g);
+    const __m128i b8 = _mm_packus_epi16(b, b);
+    const __m128i first = _mm_unpacklo_epi8(bgr ? b8 : r8, g8);
+    const __m128i second = _mm_unpacklo_epi8(bgr ? r8 : b8, alpha);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb + x * 4), _mm_unpacklo_epi16(first, second));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb + x * 4 + 16), _mm_unpackhi_epi16(first, second));
+  }
+
+  yuv_to_rgb_scalar(y + x, u + x / 2, v + x / 2, rgb + x * 4, width - x, coefficients, bgr);
+}
+
+void lerp_sse2(const guint8* a, const guint8* b, guint8* dest, gsize size, int weight)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i weight_a = _mm_set1_epi16(256 - weight);
+  const __m128i weight_b = _mm_set1_epi16(weight);
+  const __m128i round = _mm_set1_epi16(128);
+  gsize i = 0;
+
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+
+    const __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+      _mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), weight_a),
+      _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), weight_b)), round), 8);
+    const __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+      _mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), weight_a),
+      _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), weight_b)), round), 8);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(lo, hi));
+  }
+
+  lerp_scalar(a + i, b + i, dest + i, size - i, weight);
+}
+
+// Blends two pixels unpacked to 16 bits.
+inline __m128i sse2_blend_pixels(__m128i s, __m128i d, __m128i alpha)
+{
+  // Broadcast the alpha of each pixel to its four components, and use an
+  // opaque source for the alpha component of the result.
+  __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xff), 0xff);
+  a = sse2_div255(_mm_mullo_epi16(a, alpha));
+  s = _mm_or_si128(s, _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0));
+
+  return sse2_div255(_mm_add_epi16(_mm_mullo_epi16(s, a),
+    _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a))));
+}
+
+void blend_sse2(const guint8* src, guint8* dest, int width, int alpha)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i global_alpha = _mm_set1_epi16(alpha);
+  int x = 0;
+
+  for(; x + 4 <= width; x += 4)
+  {
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+    const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + x * 4));
+
+    const __m128i lo = sse2_blend_pixels(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), global_alpha);
+    const __m128i hi = sse2_blend_pixels(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), global_alpha);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), _mm_packus_epi16(lo, hi));
+  }
+
+  blend_scalar(src + x * 4, dest + x * 4, width - x, alpha);
+}
+
+inline __m128i sse2_hash_lanes(__m128i acc, __m128i data, __m128i key, __m128i position)
+{
+  const __m128i mixed = _mm_add_epi64(_mm_xor_si128(data, key), position);
+  return _mm_add_epi64(_mm_add_epi64(acc, data), _mm_mul_epu32(mixed, _mm_srli_epi64(mixed, 32)));
+}
+
+void hash_sse2(const guint8* data, gsize size, gsize step, guint64* acc)
+{
+  const __m128i key_lo = _mm_set_epi64x(hash_keys[1], hash_keys[0]);
+  const __m128i key_hi = _mm_set_epi64x(hash_keys[3], hash_keys[2]);
+  const __m128i advance_lo = _mm_set_epi64x(hash_positions[1] * step, hash_positions[0] * step);
+  const __m128i advance_hi = _mm_set_epi64x(hash_positions[3] * step, hash_positions[2] * step);
+  __m128i position_lo = _mm_setzero_si128();
+  __m128i position_hi = _mm_setzero_si128();
+  __m128i acc_lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc));
+  __m128i acc_hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + 2));
+  gsize i = 0;
+
+  for(; (i + 1) * hash_stripe_size <= size; i += step)
+  {
+    const guint8* const stripe = data + i * hash_stripe_size;
+    acc_lo = sse2_hash_lanes(acc_lo, _mm_loadu_si128(reinterpret_cast<const __m128i*>(stripe)),
+      key_lo, position_lo);
+    acc_hi = sse2_hash_lanes(acc_hi, _mm_loadu_si128(reinterpret_cast<const __m128i*>(stripe + 16)),
+      key_hi, position_hi);
+    position_lo = _mm_add_epi64(position_lo, advance_lo);
+    position_hi = _mm_add_epi64(position_hi, advance_hi);
+  }
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(acc), acc_lo);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 2), acc_hi);
+  hash_tail(data, size, i, acc);
+}
+
+guint64 sad_sse2(const guint8* a, const guint8* b, guint8* copy, gsize size)
+{
+  __m128i sum = _mm_setzero_si128();
+  gsize i = 0;
+
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    sum = _mm_add_epi64(sum, _mm_sad_epu8(va, vb));
+    if(copy)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(copy + i), va);
+  }
+
+  guint64 lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sum);
+  return lanes[0] + lanes[1] + sad_scalar(a + i, b + i, copy ? copy + i : nullptr, size - i);
+}
+
+#endif /* GSTREAMERMM_VIDEO_KERNELS_SSE2 */
+
+#ifdef GSTREAMERMM_VIDEO_KERNELS_AVX2
+
+/* AVX2 kernels */
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET inline __m256i avx2_pair(int lo, int hi)
+{
+  return _mm256_set1_epi32(static_cast<int>((static_cast<guint32>(hi) << 16) | static_cast<guint16>(lo)));
+}
+
+AVX2_TARGET inline __m256i avx2_div255(__m256i x)
+{
+  x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+// Computes one component of 16 pixels from the products with the luma and
+// the chroma pairs, in pixel order.
+AVX2_TARGET inline __m256i avx2_component(__m256i luma_lo, __m256i luma_hi, __m256i chroma_lo,
+  __m256i chroma_hi, __m256i k)
+{
+  // The unpacked halves hold pixels 0-3 and 8-11, 4-7 and 12-15: packing
+  // them in each lane restores the order.
+  return _mm256_packs_epi32(
+    _mm256_srai_epi32(_mm256_add_epi32(luma_lo, _mm256_madd_epi16(chroma_lo, k)), coefficient_bits),
+    _mm256_srai_epi32(_mm256_add_epi32(luma_hi, _mm256_madd_epi16(chroma_hi, k)), coefficient_bits));
+}
+
+AVX2_TARGET void yuv_to_rgb_avx2(const guint8* y, const guint8* u, const guint8* v, guint8* rgb,
+  int width, const int* coefficients, bool bgr)
+{
+  const __m256i ones = _mm256_set1_epi16(1);
+  const __m256i c128 = _mm256_set1_epi16(128);
+  const __m256i y_offset = _mm256_set1_epi16(coefficients[COEFFICIENT_Y_OFFSET]);
+  const __m256i ky = avx2_pair(coefficients[COEFFICIENT_Y], coefficient_round);
+  const __m256i kr = avx2_pair(0, coefficients[COEFFICIENT_RV]);
+  const __m256i kg = avx2_pair(coefficients[COEFFICIENT_GU], coefficients[COEFFICIENT_GV]);
+  const __m256i kb = avx2_pair(coefficients[COEFFICIENT_BU], 0);
+  const __m256i alpha = _mm256_set1_epi16(255);
+  int x = 0;
+
+  for(; x + 16 <= width; x += 16)
+  {
+    const __m256i luma = _mm256_sub_epi16(
+      _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x))), y_offset);
+    const __m128i u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2));
+    const __m128i v8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2));
+    const __m256i cb = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(u8, u8)), c128);
+    const __m256i cr = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(v8, v8)), c128);
+
+    const __m256i luma_lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(luma, ones), ky);
+    const __m256i luma_hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(luma, ones), ky);
+    const __m256i chroma_lo = _mm256_unpacklo_epi16(cb, cr);
+    const __m256i chroma_hi = _mm256_unpackhi_epi16(cb, cr);
+
+    const __m256i r = avx2_component(luma_lo, luma_hi, chroma_lo, chroma_hi, kr);
+    const __m256i g = avx2_component(luma_lo, luma_hi, chroma_lo, chroma_hi, kg);
+    const __m256i b = avx2_component(luma_lo, luma_hi, chroma_lo, chroma_hi, kb);
+
+    // Pack to bytes, then move the 16 bytes of each component together.
+    const __m256i rg = _mm256_permute4x64_epi64(_mm256_packus_epi16(r, g), 0xd8);
+    const __m256i ba = _mm256_permute4x64_epi64(_mm256_packus_epi16(b, alpha), 0xd8);
+    const __m128i r8 = _mm256_castsi256_si128(rg);
+    const __m128i g8 = _mm256_extracti128_si256(rg, 1);
+    const __m128i b8 = _mm256_castsi256_si128(ba);
+    const __m128i a8 = _mm256_extracti128_si256(ba, 1);
+
+    const __m128i first_lo = _mm_unpacklo_epi8(bgr ? b8 : r8, g8);
+    const __m128i first_hi = _mm_unpackhi_epi8(bgr ? b8 : r8, g8);
+    const __m128i second_lo = _mm_unpacklo_epi8(bgr ? r8 : b8, a8);
+    const __m128i second_hi = _mm_unpackhi_epi8(bgr ? r8 : b8, a8);
+
+    __m128i* const out = reinterpret_cast<__m128i*>(rgb + x * 4);
+    _mm_storeu_si128(out, _mm_unpacklo_epi16(first_lo, second_lo));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(first_lo, second_lo));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(first_hi, second_hi));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(first_hi, second_hi));
+  }
+
+  yuv_to_rgb_scalar(y + x, u + x / 2, v + x / 2, rgb + x * 4, width - x, coefficients, bgr);
+}
+
+AVX2_TARGET void lerp_avx2(const guint8* a, const guint8* b, guint8* dest, gsize size, int weight)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i weight_a = _mm256_set1_epi16(256 - weight);
+  const __m256i weight_b = _mm256_set1_epi16(weight);
+  const __m256i round = _mm256_set1_epi16(128);
+  gsize i = 0;
+
+  for(; i + 32 <= size; i += 32)
+  {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+
+    const __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(
+      _mm256_mullo_epi16(_mm256_unpacklo_epi8(va, zero), weight_a),
+      _mm256_mullo_epi16(_mm256_unpacklo_epi8(vb, zero), weight_b)), round), 8);
+    const __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(
+      _mm256_mullo_epi16(_mm256_unpackhi_epi8(va, zero), weight_a),
+      _mm256_mullo_epi16(_mm256_unpackhi_epi8(vb, zero), weight_b)), round), 8);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), _mm256_packus_epi16(lo, hi));
+  }
+
+  lerp_scalar(a + i, b + i, dest + i, size - i, weight);
+}
+
+AVX2_TARGET inline __m256i avx2_blend_pixels(__m256i s, __m256i d, __m256i alpha)
+{
+  __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xff), 0xff);
+  a = avx2_div255(_mm256_mullo_epi16(a, alpha));
+  s = _mm256_or_si256(s, _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0));
+
+  return avx2_div255(_mm256_add_epi16(_mm256_mullo_epi16(s, a),
+    _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), a))));
+}
+
+AVX2_TARGET void blend_avx2(const guint8* src, guint8* dest, int width, int alpha)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i global_alpha = _mm256_set1_epi16(alpha);
+  int x = 0;
+
+  for(; x + 8 <= width; x += 8)
+  {
+    const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+    const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dest + x * 4));
+
+    const __m256i lo = avx2_blend_pixels(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero),
+      global_alpha);
+    const __m256i hi = avx2_blend_pixels(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero),
+      global_alpha);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + x * 4), _mm256_packus_epi16(lo, hi));
+  }
+
+  blend_scalar(src + x * 4, dest + x * 4, width - x, alpha);
+}
+
+AVX2_TARGET void hash_avx2(const guint8* data, gsize size, gsize step, guint64* acc)
+{
+  const __m256i key = _mm256_set_epi64x(hash_keys[3], hash_keys[2], hash_keys[1], hash_keys[0]);
+  const __m256i advance = _mm256_set_epi64x(hash_positions[3] * step, hash_positions[2] * step,
+    hash_positions[1] * step, hash_positions[0] * step);
+  __m256i position = _mm256_setzero_si256();
+  __m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc));
+  gsize i = 0;
+
+  for(; (i + 1) * hash_stripe_size <= size; i += step)
+  {
+    const __m256i stripe = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i * hash_stripe_size));
+    const __m256i mixed = _mm256_add_epi64(_mm256_xor_si256(stripe, key), position);
+    sum = _mm256_add_epi64(_mm256_add_epi64(sum, stripe), _mm256_mul_epu32(mixed, _mm256_srli_epi64(mixed, 32)));
+    position = _mm256_add_epi64(position, advance);
+  }
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc), sum);
+  hash_tail(data, size, i, acc);
+}
+
+AVX2_TARGET guint64 sad_avx2(const guint8* a, const guint8* b, guint8* copy, gsize size)
+{
+  __m256i sum = _mm256_setzero_si256();
+  gsize i = 0;
+
+  for(; i + 32 <= size; i += 32)
+  {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    sum = _mm256_add_epi64(sum, _mm256_sad_epu8(va, vb));
+    if(copy)
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(copy + i), va);
+  }
+
+  guint64 lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sum);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+    sad_scalar(a + i, b + i, copy ? copy + i : nullptr, size - i);
+}
+
+#undef AVX2_TARGET
+
+#endif /* GSTREAMERMM_VIDEO_KERNELS_AVX2 */
+
+#ifdef GSTREAMERMM_VIDEO_KERNELS_NEON
+
+/* NEON kernels */
+
+inline uint16x8_t neon_div255(uint16x8_t x)
+{
+  x = vaddq_u16(x, vdupq_n_u16(128));
+  return vshrq_n_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), 8);
+}
+
+inline int16x8_t neon_load_chroma(const guint8* c)
+{
+  guint32 samples;
+  std::memcpy(&samples, c, sizeof(samples));
+  const uint8x8_t v = vreinterpret_u8_u32(vdup_n_u32(samples));
+  return vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vzip1_u8(v, v))), vdupq_n_s16(128));
+}
+
+inline uint8x8_t neon_component(int32x4_t luma_lo, int32x4_t luma_hi, int16x8_t cb, int16x8_t cr,
+  int kb, int kr)
+{
+  int32x4_t lo = vmlal_n_s16(vmlal_n_s16(luma_lo, vget_low_s16(cb), kb), vget_low_s16(cr), kr);
+  int32x4_t hi = vmlal_n_s16(vmlal_n_s16(luma_hi, vget_high_s16(cb), kb), vget_high_s16(cr), kr);
+  return vqmovun_s16(vcombine_s16(vqmovn_s32(vshrq_n_s32(lo, coefficient_bits)),
+    vqmovn_s32(vshrq_n_s32(hi, coefficient_bits))));
+}
+
+void yuv_to_rgb_neon(const guint8* y, const guint8* u, const guint8* v, guint8* rgb,
+  int width, const int* coefficients, bool bgr)
+{
+  const int16x8_t y_offset = vdupq_n_s16(coefficients[COEFFICIENT_Y_OFFSET]);
+  const int32x4_t round = vdupq_n_s32(coefficient_round);
+  const int16_t cy = coefficients[COEFFICIENT_Y];
+  int x = 0;
+
+  for(; x + 8 <= width; x += 8)
+  {
+    const int16x8_t luma = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + x))), y_offset);
+    const int16x8_t cb = neon_load_chroma(u + x / 2);
+    const int16x8_t cr = neon_load_chroma(v + x / 2);
+    const int32x4_t luma_lo = vmlal_n_s16(round, vget_low_s16(luma), cy);
+    const int32x4_t luma_hi = vmlal_n_s16(round, vget_high_s16(luma), cy);
+
+    const uint8x8_t r = neon_component(luma_lo, luma_hi, cb, cr, 0, coefficients[COEFFICIENT_RV]);
+    const uint8x8_t g = neon_component(luma_lo, luma_hi, cb, cr,
+      coefficients[COEFFICIENT_GU], coefficients[COEFFICIENT_GV]);
+    const uint8x8_t b = neon_component(luma_lo, luma_hi, cb, cr, coefficients[COEFFICIENT_BU], 0);
+
+    uint8x8x4_t pixels;
+    pixels.val[0] = bgr ? b : r;
+    pixels.val[1] = g;
+    pixels.val[2] = bgr ? r : b;
+    pixels.val[3] = vdup_n_u8(255);
+    vst4_u8(rgb + x * 4, pixels);
+  }
+
+  yuv_to_rgb_scalar(y + x, u + x / 2, v + x / 2, rgb + x * 4, width - x, coefficients, bgr);
+}
+
+void lerp_neon(const guint8* a, const guint8* b, guint8* dest, gsize size, int weight)
+{
+  const uint16_t weight_a = 256 - weight;
+  const uint16_t weight_b = weight;
+  gsize i = 0;
+
+  for(; i + 16 <= size; i += 16)
+  {
+    const uint8x16_t va = vld1q_u8(a + i);
+    const uint8x16_t vb = vld1q_u8(b + i);
+
+    const uint16x8_t lo = vmlaq_n_u16(vmulq_n_u16(vmovl_u8(vget_low_u8(va)), weight_a),
+      vmovl_u8(vget_low_u8(vb)), weight_b);
+    const uint16x8_t hi = vmlaq_n_u16(vmulq_n_u16(vmovl_u8(vget_high_u8(va)), weight_a),
+      vmovl_u8(vget_high_u8(vb)), weight_b);
+
+    vst1q_u8(dest + i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+  }
+
+  lerp_scalar(a + i, b + i, dest + i, size - i, weight);
+}
+
+void blend_neon(const guint8* src, guint8* dest, int width, int alpha)
+{
+  const uint8x8_t global_alpha = vdup_n_u8(alpha);
+  const uint8x8_t opaque = vdup_n_u8(255);
+  int x = 0;
+
+  for(; x + 8 <= width; x += 8)
+  {
+    const uint8x8x4_t s = vld4_u8(src + x * 4);
+    uint8x8x4_t d = vld4_u8(dest + x * 4);
+
+    const uint8x8_t a = vmovn_u16(neon_div255(vmull_u8(s.val[3], global_alpha)));
+    const uint8x8_t inverse = vsub_u8(opaque, a);
+
+    for(int k = 0; k < 3; ++k)
+      d.val[k] = vmovn_u16(neon_div255(vmlal_u8(vmull_u8(s.val[k], a), d.val[k], inverse)));
+    d.val[3] = vmovn_u16(neon_div255(vmlal_u8(vmull_u8(opaque, a), d.val[3], inverse)));
+
+    vst4_u8(dest + x * 4, d);
+  }
+
+  blend_scalar(src + x * 4, dest + x * 4, width - x, alpha);
+}
+
+inline uint64x2_t neon_hash_lanes(uint64x2_t acc, uint64x2_t data, uint64x2_t key, uint64x2_t position)
+{
+  const uint64x2_t mixed = vaddq_u64(veorq_u64(data, key), position);
+  return vmlal_u32(vaddq_u64(acc, data), vmovn_u64(mixed), vshrn_n_u64(mixed, 32));
+}
+
+void hash_neon(const guint8* data, gsize size, gsize step, guint64* acc)
+{
+  const uint64x2_t key_lo = vcombine_u64(vcreate_u64(hash_keys[0]), vcreate_u64(hash_keys[1]));
+  const uint64x2_t key_hi = vcombine_u64(vcreate_u64(hash_keys[2]), vcreate_u64(hash_keys[3]));
+  const uint64x2_t advance_lo = vcombine_u64(vcreate_u64(hash_positions[0] * step),
+    vcreate_u64(hash_positions[1] * step));
+  const uint64x2_t advance_hi = vcombine_u64(vcreate_u64(hash_positions[2] * step),
+    vcreate_u64(hash_positions[3] * step));
+  uint64x2_t position_lo = vdupq_n_u64(0);
+  uint64x2_t position_hi = vdupq_n_u64(0);
+  uint64x2_t acc_lo = vcombine_u64(vcreate_u64(acc[0]), vcreate_u64(acc[1]));
+  uint64x2_t acc_hi = vcombine_u64(vcreate_u64(acc[2]), vcreate_u64(acc[3]));
+  gsize i = 0;
+
+  for(; (i + 1) * hash_stripe_size <= size; i += step)
+  {
+    const guint8* const stripe = data + i * hash_stripe_size;
+    acc_lo = neon_hash_lanes(acc_lo, vreinterpretq_u64_u8(vld1q_u8(stripe)), key_lo, position_lo);
+    acc_hi = neon_hash_lanes(acc_hi, vreinterpretq_u64_u8(vld1q_u8(stripe + 16)), key_hi, position_hi);
+    position_lo = vaddq_u64(position_lo, advance_lo);
+    position_hi = vaddq_u64(position_hi, advance_hi);
+  }
+
+  acc[0] = vgetq_lane_u64(acc_lo, 0);
+  acc[1] = vgetq_lane_u64(acc_lo, 1);
+  acc[2] = vgetq_lane_u64(acc_hi, 0);
+  acc[3] = vgetq_lane_u64(acc_hi, 1);
+  hash_tail(data, size, i, acc);
+}
+
+guint64 sad_neon(const guint8* a, const guint8* b, guint8* copy, gsize size)
+{
+  uint64x2_t sum = vdupq_n_u64(0);
+  gsize i = 0;
+
+  for(; i + 16 <= size; i += 16)
+  {
+    const uint8x16_t va = vld1q_u8(a + i);
+    const uint8x16_t vb = vld1q_u8(b + i);
+    sum = vpadalq_u32(sum, vpaddlq_u16(vpaddlq_u8(vabdq_u8(va, vb))));
+    if(copy)
+      vst1q_u8(copy + i, va);
+  }
+
+  return vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1) +
+    sad_scalar(a + i, b + i, copy ? copy + i : nullptr, size - i);
+}
+
+#endif /* GSTREAMERMM_VIDEO_KERNELS_NEON */
+
+void check_format(GstVideoFormat format)
+{
+  if(!Gst::VideoKernels::is_format_supported(static_cast<Gst::VideoFormat>(format)))
+    gstreamermm_handle_error(Glib::ustring("Gst::VideoKernels does not support the format ") +
+      gst_video_format_to_string(format));
+}
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+VideoKernels::VideoKernels(VideoKernelsIsa isa)
+{
+  if(!is_isa_supported(isa))
+    isa = get_best_isa();
+
+  isa_ = isa;
+  yuv_to_rgb_ = &yuv_to_rgb_scalar;
+  lerp_ = &lerp_scalar;
+  blend_ = &blend_scalar;
+  hash_ = &hash_scalar;
+  sad_ = &sad_scalar;
+
+  switch(isa)
+  {
+#ifdef GSTREAMERMM_VIDEO_KERNELS_SSE2
+    case VIDEO_KERNELS_ISA_SSE2:
+      yuv_to_rgb_ = &yuv_to_rgb_sse2;
+      lerp_ = &lerp_sse2;
+      blend_ = &blend_sse2;
+      hash_ = &hash_sse2;
+      sad_ = &sad_sse2;
+      break;
+#endif
+#ifdef GSTREAMERMM_VIDEO_KERNELS_AVX2
+    case VIDEO_KERNELS_ISA_AVX2:
+      yuv_to_rgb_ = &yuv_to_rgb_avx2;
+      lerp_ = &lerp_avx2;
+      blend_ = &blend_avx2;
+      hash_ = &hash_avx2;
+      sad_ = &sad_avx2;
+      break;
+#endif
+#ifdef GSTREAMERMM_VIDEO_KERNELS_NEON
+    case VIDEO_KERNELS_ISA_NEON:
+      yuv_to_rgb_ = &yuv_to_rgb_neon;
+      lerp_ = &lerp_neon;
+      blend_ = &blend_neon;
+      hash_ = &hash_neon;
+      sad_ = &sad_neon;
+      break;
+#endif
+    default:
+      break;
+  }
+}
+
+VideoKernelsIsa VideoKernels::get_best_isa()
+{
+  if(is_isa_supported(VIDEO_KERNELS_ISA_AVX2))
+    return VIDEO_KERNELS_ISA_AVX2;
+  if(is_isa_supported(VIDEO_KERNELS_ISA_SSE2))
+    return VIDEO_KERNELS_ISA_SSE2;
+  if(is_isa_supported(VIDEO_KERNELS_ISA_NEON))
+    return VIDEO_KERNELS_ISA_NEON;
+
+  return VIDEO_KERNELS_ISA_SCALAR;
+}
+
+bool VideoKernels::is_isa_supported(VideoKernelsIsa isa)
+{
+  switch(isa)
+  {
+    case VIDEO_KERNELS_ISA_SCALAR:
+      return true;
+#ifdef GSTREAMERMM_VIDEO_KERNELS_SSE2
+    case VIDEO_KERNELS_ISA_SSE2:
+      return true;
+#endif
+#ifdef GSTREAMERMM_VIDEO_KERNELS_AVX2
+    case VIDEO_KERNELS_ISA_AVX2:
+      // The audio kernels already detect the CPU features.
+      return AudioKernels::is_isa_supported(AUDIO_KERNELS_ISA_AVX2);
+#endif
+#ifdef GSTREAMERMM_VIDEO_KERNELS_NEON
+    case VIDEO_KERNELS_ISA_NEON:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+const char* VideoKernels::get_isa_name(VideoKernelsIsa isa)
+{
+  switch(isa)
+  {
+    case VIDEO_KERNELS_ISA_SSE2:
+      return "sse2";
+    case VIDEO_KERNELS_ISA_AVX2:
+      return "avx2";
+    case VIDEO_KERNELS_ISA_NEON:
+      return "neon";
+    default:
+      return "scalar";
+  }
+}
+
+bool VideoKernels::is_format_supported(Gst::VideoFormat format)
+{
+  switch(static_cast<GstVideoFormat>(format))
+  {
+    case GST_VIDEO_FORMAT_I420:
+    case GST_VIDEO_FORMAT_NV12:
+    case GST_VIDEO_FORMAT_YUY2:
+    case GST_VIDEO_FORMAT_RGBA:
+    case GST_VIDEO_FORMAT_BGRx:
+      return true;
+    default:
+      return false;
+  }
+}
+
+VideoKernelsIsa VideoKernels::get_isa() const
+{
+  return isa_;
+}
+
+void VideoKernels::convert(const Gst::VideoFrame& src, Gst::VideoFrame& dest) const
+{
+  const GstVideoFormat src_format = static_cast<GstVideoFormat>(src.get_format());
+  const GstVideoFormat dest_format = static_cast<GstVideoFormat>(dest.get_format());
+  check_format(src_format);
+  check_format(dest_format);
+
+  if(src.get_width() != dest.get_width() || src.get_height() != dest.get_height())
+    gstreamermm_handle_error("Gst::VideoKernels::convert(): the frames have different sizes");
+
+  if(src_format == dest_format)
+    Gst::VideoFrame::copy(dest, src);
+  else if(is_rgb(src_format) && is_rgb(dest_format))
+    convert_rgb_to_rgb(src, dest);
+  else if(is_rgb(src_format))
+    convert_rgb_to_yuv(src, dest);
+  else if(is_rgb(dest_format))
+    convert_yuv_to_rgb(src, dest);
+  else
+    convert_yuv_to_yuv(src, dest);
+}
+
+void VideoKernels::convert_yuv_to_rgb(const Gst::VideoFrame& src, Gst::VideoFrame& dest) const
+{
+  int coefficients[N_COEFFICIENTS];
+  get_coefficients(&src.gobj()->info, coefficients);
+
+  const Gst::ConstVideoPlane y_component = src.get_component(0);
+  const Gst::ConstVideoPlane u_component = src.get_component(1);
+  const Gst::ConstVideoPlane v_component = src.get_component(2);
+  const int chroma_shift = GST_VIDEO_FORMAT_INFO_H_SUB(src.gobj()->info.finfo, 1);
+  const Gst::VideoPlane out = dest.get_plane(0);
+  const bool bgr = dest.get_format() == Gst::VIDEO_FORMAT_BGRx;
+
+  std::vector<guint8> temp(y_component.get_width() + 2 * u_component.get_width());
+  guint8* const y_temp = temp.data();
+  guint8* const u_temp = y_temp + y_component.get_width();
+  guint8* const v_temp = u_temp + u_component.get_width();
+
+  for(int row = 0; row < out.get_height(); ++row)
+  {
+    const int chroma_row = row >> chroma_shift;
+    yuv_to_rgb_(read_row(y_component, row, y_temp), read_row(u_component, chroma_row, u_temp),
+      read_row(v_component, chroma_row, v_temp), out.get_row(row), out.get_width(), coefficients, bgr);
+  }
+}
+
+void VideoKernels::convert_rgb_to_yuv(const Gst::VideoFrame& src, Gst::VideoFrame& dest) const
+{
+  int coefficients[N_COEFFICIENTS];
+  get_coefficients(&dest.gobj()->info, coefficients);
+
+  const Gst::ConstVideoPlane in = src.get_plane(0);
+  const bool bgr = src.get_format() == Gst::VIDEO_FORMAT_BGRx;
+  const int r = bgr ? 2 : 0;
+  const int b = bgr ? 0 : 2;
+  const Gst::VideoPlane y_component = dest.get_component(0);
+  const Gst::VideoPlane u_component = dest.get_component(1);
+  const Gst::VideoPlane v_component = dest.get_component(2);
+  const int chroma_shift = GST_VIDEO_FORMAT_INFO_H_SUB(dest.gobj()->info.finfo, 1);
+  const int width = in.get_width();
+  const int height = in.get_height();
+
+  std::vector<guint8> temp(width + 2 * u_component.get_width());
+  guint8* const y_temp = temp.data();
+  guint8* const u_temp = y_temp + width;
+  guint8* const v_temp = u_temp + u_component.get_width();
+
+  const int u_r = coefficients[COEFFICIENT_UR], u_g = coefficients[COEFFICIENT_UG], u_b = coefficients[COEFFICIENT_UB];
+  const int v_r = coefficients[COEFFICIENT_VR], v_g = coefficients[COEFFICIENT_VG], v_b = coefficients[COEFFICIENT_VB];
+  // The chroma is the mean of 2x2 pixels; a 4:2:2 row is counted twice.
+  const int chroma_bits = coefficient_bits + 2;
+  const int chroma_round = 1 << (chroma_bits - 1);
+
+  for(int chroma_row = 0; chroma_row < u_component.get_height(); ++chroma_row)
+  {
+    const int first = chroma_row << chroma_shift;
+    const int last = std::min(first + (1 << chroma_shift) - 1, height - 1);
+
+    for(int row = first; row <= last; ++row)
+    {
+      guint8* const out = get_row_target(y_component, row, y_temp);
+      rgb_to_y_scalar(in.get_row(row), out, width, coefficients, bgr);
+      write_row(y_component, row, out);
+    }
+
+    const guint8* const top = in.get_row(first);
+    const guint8* const bottom = in.get_row(last);
+    guint8* const u_out = get_row_target(u_component, chroma_row, u_temp);
+    guint8* const v_out = get_row_target(v_component, chroma_row, v_temp);
+
+    for(int x = 0; x < u_component.get_width(); ++x)
+    {
+      const int left = 8 * x;
+      const int right = 4 * std::min(2 * x + 1, width - 1);
+      const int sum_r = top[left + r] + top[right + r] + bottom[left + r] + bottom[right + r];
+      const int sum_g = top[left + 1] + top[right + 1] + bottom[left + 1] + bottom[right + 1];
+      const int sum_b = top[left + b] + top[right + b] + bottom[left + b] + bottom[right + b];
+
+      u_out[x] = clamp_u8(128 + ((sum_r * u_r + sum_g * u_g + sum_b * u_b + chroma_round) >> chroma_bits));
+      v_out[x] = clamp_u8(128 + ((sum_r * v_r + sum_g * v_g + sum_b * v_b + chroma_round) >> chroma_bits));
+    }
+
+    write_row(u_component, chroma_row, u_out);
+    write_row(v_component, chroma_row, v_out);
+  }
+}
+
+void VideoKernels::convert_yuv_to_yuv(const Gst::VideoFrame& src, Gst::VideoFrame& dest) const
+{
+  const int in_shift = GST_VIDEO_FORMAT_INFO_H_SUB(src.gobj()->info.finfo, 1);
+  const int out_shift = GST_VIDEO_FORMAT_INFO_H_SUB(dest.gobj()->info.finfo, 1);
+
+  const Gst::ConstVideoPlane in_luma = src.get_component(0);
+  const Gst::VideoPlane out_luma = dest.get_component(0);
+  std::vector<guint8> temp(2 * in_luma.get_width());
+
+  for(int row = 0; row < out_luma.get_height(); ++row)
+    write_row(out_luma, row, read_row(in_luma, row, temp.data()));
+
+  for(guint component = 1; component < 3; ++component)
+  {
+    const Gst::ConstVideoPlane in = src.get_component(component);
+    const Gst::VideoPlane out = dest.get_component(component);
+    guint8* const in_temp = temp.data();
+    guint8* const out_temp = in_temp + in.get_width();
+
+    for(int row = 0; row < out.get_height(); ++row)
+    {
+      if(in_shift >= out_shift)
+      {
+        // Repeat the source rows if there are fewer of them.
+        write_row(out, row, read_row(in, row >> (in_shift - out_shift), in_temp));
+        continue;
+      }
+
+      // Average two source rows.
+      const int first = row << 1;
+      const int second = std::min(first + 1, in.get_height() - 1);
+      const guint8* const top = in.get_row(first);
+      const guint8* const bottom = in.get_row(second);
+      const int pixel_stride = in.get_pixel_stride();
+      guint8* const target = get_row_target(out, row, out_temp);
+
+      for(int x = 0; x < out.get_width(); ++x)
+        target[x] = static_cast<guint8>((top[x * pixel_stride] + bottom[x * pixel_stride] + 1) >> 1);
+
+      write_row(out, row, target);
+    }
+  }
+}
+
+void VideoKernels::convert_rgb_to_rgb(const Gst::VideoFrame& src, Gst::VideoFrame& dest) const
+{
+  // RGBA and BGRx: swap red and blue, the alpha of RGBA is dropped or
+  // opaque.
+  const Gst::ConstVideoPlane in = src.get_plane(0);
+  const Gst::VideoPlane out = dest.get_plane(0);
+
+  for(int row = 0; row < out.get_height(); ++row)
+  {
+    const guint8* const s = in.get_row(row);
+    guint8* const d = out.get_row(row);
+
+    for(int x = 0; x < out.get_width(); ++x)
+    {
+      d[x * 4] = s[x * 4 + 2];
+      d[x * 4 + 1] = s[x * 4 + 1];
+      d[x * 4 + 2] = s[x * 4];
+      d[x * 4 + 3] = 255;
+    }
+  }
+}
+
+void VideoKernels::scale(const Gst::VideoFrame& src, Gst::VideoFrame& dest) const
+{
+  const GstVideoFormat format = static_cast<GstVideoFormat>(src.get_format());
+  check_format(format);
+
+  if(dest.get_format() != src.get_format())
+    gstreamermm_handle_error("Gst::VideoKernels::scale(): the frames have different formats");
+
+  for(guint plane = 0; plane < src.get_n_planes(); ++plane)
+  {
+    // Planes with components of different sizes, such as the one of YUY2,
+    // are scaled one component after the other.
+    bool uniform = true;
+    for(guint component = 0; component < src.get_n_components(); ++component)
+    {
+      if(src.get_component_plane(component) == plane &&
+        src.get_component(component).get_width() != src.get_plane(plane).get_width())
+        uniform = false;
+    }
+
+    if(uniform)
+    {
+      const Gst::ConstVideoPlane in = src.get_plane(plane);
+      scale_channels(in, dest.get_plane(plane), in.get_pixel_stride());
+      continue;
+    }
+
+    for(guint component = 0; component < src.get_n_components(); ++component)
+    {
+      if(src.get_component_plane(component) == plane)
+        scale_channels(src.get_component(component), dest.get_component(component), 1);
+    }
+  }
+}
+
+void VideoKernels::scale_plane(const Gst::ConstVideoPlane& src, const Gst::VideoPlane& dest) const
+{
+  if(src.get_pixel_stride() != dest.get_pixel_stride())
+    gstreamermm_handle_error("Gst::VideoKernels::scale_plane(): the planes have different pixel strides");
+
+  scale_channels(src, dest, src.get_pixel_stride());
+}
+
+void VideoKernels::scale_channels(const Gst::ConstVideoPlane& src, const Gst::VideoPlane& dest, int channels) const
+{
+  const int src_width = src.get_width();
+  const int src_height = src.get_height();
+  const int dest_width = dest.get_width();
+  const int dest_height = dest.get_height();
+  if(!src_width || !src_height || !dest_width || !dest_height)
+    return;
+
+  std::vector<int> columns, column_weights, rows, row_weights;
+  compute_positions(src_width, dest_width, columns, column_weights);
+  compute_positions(src_height, dest_height, rows, row_weights);
+
+  // Two source rows scaled horizontally, and the destination row if its
+  // pixels have other samples between them.
+  const gsize row_size = static_cast<gsize>(dest_width) * channels;
+  std::vector<guint8> buffer(3 * row_size);
+  guint8* const cache[2] = { buffer.data(), buffer.data() + row_size };
+  guint8* const out_temp = buffer.data() + 2 * row_size;
+  int cached[2] = { -1, -1 };
+
+  const int src_stride = src.get_pixel_stride();
+  const int dest_stride = dest.get_pixel_stride();
+
+  // Returns source row @a row scaled horizontally, without evicting row
+  // @a keep from the cache.
+  auto get_scaled_row = [&](int row, int keep) -> const guint8*
+  {
+    for(int i = 0; i < 2; ++i)
+    {
+      if(cached[i] == row)
+        return cache[i];
+    }
+
+    const int slot = cached[0] == keep ? 1 : 0;
+    const guint8* const in = src.get_row(row);
+    guint8* const out = cache[slot];
+
+    for(int x = 0; x < dest_width; ++x)
+    {
+      const guint8* const left = in + columns[x] * src_stride;
+      const guint8* const right = in + std::min(columns[x] + 1, src_width - 1) * src_stride;
+      const int weight = column_weights[x];
+
+      for(int k = 0; k < channels; ++k)
+        out[x * channels + k] = static_cast<guint8>((left[k] * (256 - weight) + right[k] * weight + 128) >> 8);
+    }
+
+    cached[slot] = row;
+    return out;
+  };
+
+  for(int row = 0; row < dest_height; ++row)
+  {
+    const int top = rows[row];
+    const int bottom = std::min(top + 1, src_height - 1);
+    const guint8* const a = get_scaled_row(top, bottom);
+    const guint8* const b = get_scaled_row(bottom, top);
+
+    guint8* const out = dest.get_row(row);
+    if(dest_stride == channels)
+    {
+      lerp_(a, b, out, row_size, row_weights[row]);
+      continue;
+    }
+
+    lerp_(a, b, out_temp, row_size, row_weights[row]);
+    for(int x = 0; x < dest_width; ++x)
+    {
+      for(int k = 0; k < channels; ++k)
+        out[x * dest_stride + k] = out_temp[x * channels + k];
+    }
+  }
+}
+
+void VideoKernels::blend(const Gst::VideoFrame& src, Gst::VideoFrame& dest, int x, int y, double alpha) const
+{
+  const GstVideoFormat src_format = static_cast<GstVideoFormat>(src.get_format());
+  const GstVideoFormat dest_format = static_cast<GstVideoFormat>(dest.get_format());
+  if(!is_rgb(src_format) || !is_rgb(dest_format))
+    gstreamermm_handle_error("Gst::VideoKernels::blend() only supports RGBA and BGRx frames");
+
+  const Gst::ConstVideoPlane in = src.get_plane(0);
+  const Gst::VideoPlane out = dest.get_plane(0);
+
+  // The part of the source inside the destination.
+  const int left = std::max(0, -x);
+  const int top = std::max(0, -y);
+  const int width = std::min(in.get_width(), out.get_width() - x) - left;
+  const int height = std::min(in.get_height(), out.get_height() - y) - top;
+  if(width <= 0 || height <= 0)
+    return;
+
+  const int global_alpha = std::max(0, std::min(255, static_cast<int>(std::lround(alpha * 255))));
+  const bool swap = src_format != dest_format;
+  const bool opaque = src_format == GST_VIDEO_FORMAT_BGRx;
+  std::vector<guint8> temp(swap || opaque ? width * 4 : 0);
+
+  for(int row = 0; row < height; ++row)
+  {
+    const guint8* s = in.get_pixel(left, top + row);
+    guint8* const d = out.get_pixel(x + left, y + top + row);
+
+    // The kernels blend pixels of the same order with an alpha component.
+    if(swap || opaque)
+    {
+      const int r = swap ? 2 : 0;
+      const int b = swap ? 0 : 2;
+      for(int i = 0; i < width; ++i)
+      {
+        temp[i * 4] = s[i * 4 + r];
+        temp[i * 4 + 1] = s[i * 4 + 1];
+        temp[i * 4 + 2] = s[i * 4 + b];
+        temp[i * 4 + 3] = opaque ? 255 : s[i * 4 + 3];
+      }
+      s = temp.data();
+    }
+
+    blend_(s, d, width, global_alpha);
+  }
+}
+
+guint64 VideoKernels::hash(const Gst::VideoFrame& frame, int grid) const
+{
+  guint64 acc[4] = { 0, 0, 0, 0 };
+  for(guint plane = 0; plane < frame.get_n_planes(); ++plane)
+    hash_rows(frame.get_plane(plane), grid, acc);
+
+  return hash_finish(acc);
+}
+
+guint64 VideoKernels::hash_plane(const Gst::ConstVideoPlane& plane, int grid) const
+{
+  guint64 acc[4] = { 0, 0, 0, 0 };
+  hash_rows(plane, grid, acc);
+  return hash_finish(acc);
+}
+
+void VideoKernels::hash_rows(const Gst::ConstVideoPlane& plane, int grid, guint64* acc) const
+{
+  grid = std::max(1, grid);
+  const gsize size = std::max(0, plane.get_row_size());
+
+  for(int row = 0; row < plane.get_height(); row += grid)
+  {
+    hash_(plane.get_row(row), size, grid, acc);
+    hash_scramble(acc);
+  }
+}
+
+guint64 VideoKernels::sad_plane(const Gst::ConstVideoPlane& a, const Gst::ConstVideoPlane& b) const
+{
+  return sad_rows(a, b, nullptr);
+}
+
+guint64 VideoKernels::sad_update_plane(const Gst::ConstVideoPlane& src, const Gst::VideoPlane& reference) const
+{
+  return sad_rows(src, reference, reference.get_data());
+}
+
+guint64 VideoKernels::sad_rows(const Gst::ConstVideoPlane& a, const Gst::ConstVideoPlane& b, guint8* copy) const
+{
+  if(a.get_width() != b.get_width() || a.get_height() != b.get_height() ||
+    a.get_pixel_stride() != b.get_pixel_stride())
+  {
+    gstreamermm_handle_error("Gst::VideoKernels::sad_plane(): the planes have different sizes");
+  }
+
+  const gsize size = std::max(0, a.get_row_size());
+  guint64 sum = 0;
+  for(int row = 0; row < a.get_height(); ++row)
+  {
+    guint8* const copy_row = copy ? copy + static_cast<std::ptrdiff_t>(row) * b.get_stride() : nullptr;
+    sum += sad_(a.get_row(row), b.get_row(row), copy_row, size);
+  }
+
+  return sum;
+}
+
+} // namespace Gst
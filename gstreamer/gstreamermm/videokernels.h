@@ -0,0 +1,196 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_VIDEOKERNELS_H
+#define _GSTREAMERMM_VIDEOKERNELS_H
+
+#include <gstreamermm/videoframe.h>
+#include <gstreamermm/videoplane.h>
+
+namespace Gst
+{
+
+/** The instruction sets Gst::VideoKernels can use.
+ */
+enum VideoKernelsIsa
+{
+  /** Portable C++, used on all hosts. */
+  VIDEO_KERNELS_ISA_SCALAR,
+  /** SSE2, available on all x86-64 hosts. */
+  VIDEO_KERNELS_ISA_SSE2,
+  /** AVX2, selected at run time when the CPU supports it. */
+  VIDEO_KERNELS_ISA_AVX2,
+  /** NEON, available on all AArch64 hosts. */
+  VIDEO_KERNELS_ISA_NEON
+};
+
+/**
+ * Gst::VideoKernels provides optimized pixel loops for the common raw video
+ * operations on mapped Gst::VideoFrame objects: conversion between formats,
+ * bilinear scaling, alpha blending, content hashing and frame differences.
+ *
+ * The I420, NV12, YUY2, RGBA and BGRx formats are supported, in any
+ * combination for conversions. The kernels work on the Gst::VideoPlane
+ * views of the frames, so any stride and plane offset is handled:
+ * @code
+ * Gst::VideoKernels kernels;
+ * Gst::VideoFrame in, out;
+ * in.map(in_info, in_buffer, Gst::MAP_READ);
+ * out.map(out_info, out_buffer, Gst::MAP_WRITE);
+ * kernels.convert(in, out);
+ * @endcode
+ *
+ * The conversions between YUV and RGB use the color matrix and range of
+ * the YUV frame, BT.601 if it has none. Chroma is upsampled by repeating
+ * samples and downsampled by averaging them.
+ *
+ * The conversions from YUV to RGB, the vertical pass of scaling, the
+ * blending, the hashing and the differences have SSE2, AVX2 and NEON
+ * variants; the best instruction set supported by the CPU is chosen at run
+ * time, with a portable fallback. All variants give exactly the same
+ * results.
+ */
+class VideoKernels
+{
+public:
+  /** Selects the kernels.
+   *
+   * @param isa The instruction set to use; it is lowered to the best one
+   * supported by the CPU.
+   */
+  explicit VideoKernels(VideoKernelsIsa isa = get_best_isa());
+
+  /** Returns the best instruction set supported by the CPU.
+   */
+  static VideoKernelsIsa get_best_isa();
+
+  /** Checks whether the CPU supports @a isa.
+   */
+  static bool is_isa_supported(VideoKernelsIsa isa);
+
+  /** Returns a short name of @a isa, such as "avx2".
+   */
+  static const char* get_isa_name(VideoKernelsIsa isa);
+
+  /** Checks whether Gst::VideoKernels supports @a format.
+   */
+  static bool is_format_supported(Gst::VideoFormat format);
+
+  /** Returns the instruction set used by the kernels.
+   */
+  VideoKernelsIsa get_isa() const;
+
+  /** Converts @a src into @a dest, which has the same size and may have
+   * another format.
+   *
+   * @throw std::runtime_error if a format is not supported or the sizes
+   * differ.
+   */
+  void convert(const Gst::VideoFrame& src, Gst::VideoFrame& dest) const;
+
+  /** Scales @a src into @a dest, which has the same format and may have
+   * another size, with bilinear interpolation.
+   *
+   * @throw std::runtime_error if the format is not supported or the formats
+   * differ.
+   */
+  void scale(const Gst::VideoFrame& src, Gst::VideoFrame& dest) const;
+
+  /** Scales the pixels of @a src into @a dest with bilinear interpolation.
+   * Each byte of a pixel is interpolated separately, so the planes must
+   * have the same pixel stride and store one component per byte.
+   *
+   * @throw std::runtime_error if the pixel strides differ.
+   */
+  void scale_plane(const Gst::ConstVideoPlane& src, const Gst::VideoPlane& dest) const;
+
+  /** Blends @a src over @a dest, with the top left corner of @a src at
+   * @a x, @a y, which may be outside of @a dest. The pixels of @a src are
+   * weighted by their alpha component multiplied by @a alpha.
+   *
+   * @a src may be RGBA or BGRx, which is opaque, and @a dest RGBA or BGRx.
+   *
+   * @throw std::runtime_error if a format is not supported.
+   */
+  void blend(const Gst::VideoFrame& src, Gst::VideoFrame& dest, int x, int y, double alpha = 1.0) const;
+
+  /** Returns a 64 bit hash of the pixels of all the planes of @a frame,
+   * without the padding of the rows, to tell identical frames apart from
+   * different ones without comparing them. Any format whose planes have a
+   * pixel stride is supported.
+   *
+   * The rows are split into blocks of 32 bytes. With a @a grid above 1,
+   * only every @a grid th row and every @a grid th block of these rows are
+   * hashed, which reads a fraction of the frame: a change elsewhere is then
+   * missed.
+   *
+   * The hash is not cryptographic, and only meant to compare frames of the
+   * same format.
+   */
+  guint64 hash(const Gst::VideoFrame& frame, int grid = 1) const;
+
+  /** Returns a 64 bit hash of the pixels of @a plane, like hash().
+   */
+  guint64 hash_plane(const Gst::ConstVideoPlane& plane, int grid = 1) const;
+
+  /** Returns the sum of the absolute differences between the bytes of the
+   * pixels of @a a and @a b, such as the luma of two frames.
+   *
+   * @throw std::runtime_error if the planes differ in size or pixel stride.
+   */
+  guint64 sad_plane(const Gst::ConstVideoPlane& a, const Gst::ConstVideoPlane& b) const;
+
+  /** Returns the sum of the absolute differences between @a src and
+   * @a reference, like sad_plane(), and copies @a src into @a reference in
+   * the same pass: @a reference then holds the previous frame for the next
+   * call.
+   *
+   * @throw std::runtime_error if the planes differ in size or pixel stride.
+   */
+  guint64 sad_update_plane(const Gst::ConstVideoPlane& src, const Gst::VideoPlane& reference) const;
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  typedef void (*YuvToRgbFunc)(const guint8* y, const guint8* u, const guint8* v, guint8* rgb,
+    int width, const int* coefficients, bool bgr);
+  typedef void (*LerpFunc)(const guint8* a, const guint8* b, guint8* dest, gsize size, int weight);
+  typedef void (*BlendFunc)(const guint8* src, guint8* dest, int width, int alpha);
+  typedef void (*HashFunc)(const guint8* data, gsize size, gsize step, guint64* acc);
+  typedef guint64 (*SadFunc)(const guint8* a, const guint8* b, guint8* copy, gsize size);
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+private:
+  void convert_yuv_to_rgb(const Gst::VideoFrame& src, Gst::VideoFrame& dest) const;
+  void convert_rgb_to_yuv(const Gst::VideoFrame& src, Gst::VideoFrame& dest) const;
+  void convert_yuv_to_yuv(const Gst::VideoFrame& src, Gst::VideoFrame& dest) const;
+  void convert_rgb_to_rgb(const Gst::VideoFrame& src, Gst::VideoFrame& dest) const;
+  void scale_channels(const Gst::ConstVideoPlane& src, const Gst::VideoPlane& dest, int channels) const;
+  void hash_rows(const Gst::ConstVideoPlane& plane, int grid, guint64* acc) const;
+  guint64 sad_rows(const Gst::ConstVideoPlane& a, const Gst::ConstVideoPlane& b, guint8* copy) const;
+
+  VideoKernelsIsa isa_;
+  YuvToRgbFunc yuv_to_rgb_;
+  LerpFunc lerp_;
+  BlendFunc blend_;
+  HashFunc hash_;
+  SadFunc sad_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_VIDEOKERNELS_H */
@@ -0,0 +1,391 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/videolayout.h>
+#include <gstreamermm/handle_error.h>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+
+inline std::size_t combine(std::size_t seed, std::size_t value)
+{
+  return seed * 31 + value;
+}
+
+// The default layout is the one of a zero alignment, so all layouts share
+// one key type.
+struct LayoutKey
+{
+  GstVideoFormat format;
+  guint width;
+  guint height;
+  GstVideoAlignment align;
+
+  bool operator==(const LayoutKey& other) const
+  {
+    return format == other.format && width == other.width && height == other.height &&
+      !std::memcmp(&align, &other.align, sizeof(align));
+  }
+};
+
+// The fields of a video info which are described by its caps.
+struct InfoKey
+{
+  GstVideoFormat format;
+  GstVideoInterlaceMode interlace_mode;
+  GstVideoFlags flags;
+  gint width;
+  gint height;
+  gint views;
+  GstVideoChromaSite chroma_site;
+  GstVideoColorimetry colorimetry;
+  gint par_n;
+  gint par_d;
+  gint fps_n;
+  gint fps_d;
+  GstVideoMultiviewMode multiview_mode;
+  GstVideoMultiviewFlags multiview_flags;
+
+  explicit InfoKey(const GstVideoInfo* info)
+  : format(GST_VIDEO_INFO_FORMAT(info)),
+    interlace_mode(GST_VIDEO_INFO_INTERLACE_MODE(info)),
+    flags(GST_VIDEO_INFO_FLAGS(info)),
+    width(GST_VIDEO_INFO_WIDTH(info)),
+    height(GST_VIDEO_INFO_HEIGHT(info)),
+    views(GST_VIDEO_INFO_VIEWS(info)),
+    chroma_site(GST_VIDEO_INFO_CHROMA_SITE(info)),
+    colorimetry(GST_VIDEO_INFO_COLORIMETRY(info)),
+    par_n(GST_VIDEO_INFO_PAR_N(info)),
+    par_d(GST_VIDEO_INFO_PAR_D(info)),
+    fps_n(GST_VIDEO_INFO_FPS_N(info)),
+    fps_d(GST_VIDEO_INFO_FPS_D(info)),
+    multiview_mode(GST_VIDEO_INFO_MULTIVIEW_MODE(info)),
+    multiview_flags(GST_VIDEO_INFO_MULTIVIEW_FLAGS(info))
+  {}
+
+  bool operator==(const InfoKey& other) const
+  {
+    return format == other.format && interlace_mode == other.interlace_mode &&
+      flags == other.flags && width == other.width && height == other.height &&
+      views == other.views && chroma_site == other.chroma_site &&
+      gst_video_colorimetry_is_equal(&colorimetry, &other.colorimetry) &&
+      par_n == other.par_n && par_d == other.par_d && fps_n == other.fps_n &&
+      fps_d == other.fps_d && multiview_mode == other.multiview_mode &&
+      multiview_flags == other.multiview_flags;
+  }
+};
+
+struct KeyHasher
+{
+  std::size_t operator()(const LayoutKey& key) const
+  {
+    std::size_t hash = combine(combine(key.format, key.width), key.height);
+    hash = combine(combine(hash, key.align.padding_top), key.align.padding_bottom);
+    hash = combine(combine(hash, key.align.padding_left), key.align.padding_right);
+    for(guint plane = 0; plane < GST_VIDEO_MAX_PLANES; ++plane)
+      hash = combine(hash, key.align.stride_align[plane]);
+    return hash;
+  }
+
+  std::size_t operator()(const InfoKey& key) const
+  {
+    std::size_t hash = combine(combine(key.format, key.width), key.height);
+    hash = combine(combine(hash, key.fps_n), key.fps_d);
+    hash = combine(combine(hash, key.par_n), key.par_d);
+    return combine(combine(hash, key.interlace_mode), key.colorimetry.matrix);
+  }
+};
+
+// A map forgetting its least recently used entry once it holds
+// Gst::VideoLayout::MAX_CACHED_CAPS entries. Must be used with the mutex
+// locked.
+template<typename Key, typename Value, typename Hasher>
+class RecentMap
+{
+public:
+  const Value* find(const Key& key)
+  {
+    auto it = index_.find(key);
+    if(it == index_.end())
+      return nullptr;
+
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  // Returns the stored value, which is the one of another thread if it
+  // stored the same entry in the meantime.
+  const Value& insert(const Key& key, const Value& value)
+  {
+    if(const Value* stored = find(key))
+      return *stored;
+
+    entries_.push_front(std::make_pair(key, value));
+    index_.insert(std::make_pair(key, entries_.begin()));
+
+    if(entries_.size() > Gst::VideoLayout::MAX_CACHED_CAPS)
+    {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+
+    return entries_.front().second;
+  }
+
+  gsize size() const
+  {
+    return entries_.size();
+  }
+
+  // The entries are returned, so they can be freed outside of the lock.
+  void clear(std::list<std::pair<Key, Value>>& entries)
+  {
+    index_.clear();
+    entries.swap(entries_);
+  }
+
+private:
+  typedef std::list<std::pair<Key, Value>> EntryList;
+
+  EntryList entries_;
+  std::unordered_map<Key, typename EntryList::iterator, Hasher> index_;
+};
+
+// The result of parsing caps, which are kept referenced so their address
+// cannot be reused and they cannot be modified.
+struct ParsedCaps
+{
+  Glib::RefPtr<const Gst::Caps> caps;
+  bool valid;
+  GstVideoInfo info;
+};
+
+typedef RecentMap<const GstCaps*, ParsedCaps, std::hash<const GstCaps*>> ParsedCapsMap;
+typedef RecentMap<InfoKey, Glib::RefPtr<Gst::Caps>, KeyHasher> BuiltCapsMap;
+typedef RecentMap<LayoutKey, std::shared_ptr<const Gst::VideoLayout>, KeyHasher> LayoutMap;
+
+// Layouts which are forgotten stay valid for their users, and are only
+// computed again by the next get().
+std::mutex cache_mutex;
+LayoutMap layouts;
+ParsedCapsMap parsed_caps;
+BuiltCapsMap built_caps;
+
+bool parse_caps(const Glib::RefPtr<const Gst::Caps>& caps, GstVideoInfo& info)
+{
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if(const ParsedCaps* parsed = parsed_caps.find(caps->gobj()))
+    {
+      info = parsed->info;
+      return parsed->valid;
+    }
+  }
+
+  ParsedCaps parsed;
+  parsed.caps = caps;
+  gst_video_info_init(&parsed.info);
+  parsed.valid = gst_video_info_from_caps(&parsed.info, caps->gobj());
+  info = parsed.info;
+
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  parsed_caps.insert(caps->gobj(), parsed);
+  return parsed.valid;
+}
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+const gsize VideoLayout::MAX_CACHED_CAPS;
+
+std::shared_ptr<const VideoLayout> VideoLayout::get(Gst::VideoFormat format, guint width, guint height)
+{
+  GstVideoAlignment align;
+  gst_video_alignment_reset(&align);
+  return get(format, width, height, align);
+}
+
+std::shared_ptr<const VideoLayout> VideoLayout::get(Gst::VideoFormat format, guint width, guint height,
+  const GstVideoAlignment& align)
+{
+  LayoutKey key;
+  // Zero the padding of the key, which is compared and hashed as a whole.
+  std::memset(&key, 0, sizeof(key));
+  key.format = static_cast<GstVideoFormat>(format);
+  key.width = width;
+  key.height = height;
+  key.align = align;
+
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if(const std::shared_ptr<const VideoLayout>* layout = layouts.find(key))
+      return *layout;
+  }
+
+  // Another thread may compute the same layout in the meantime; the first
+  // one stored is kept.
+  std::shared_ptr<const VideoLayout> layout = std::make_shared<const VideoLayout>(format, width, height, &align);
+
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  return layouts.insert(key, layout);
+}
+
+std::shared_ptr<const VideoLayout> VideoLayout::get(const Glib::RefPtr<const Gst::Caps>& caps)
+{
+  GstVideoInfo info;
+  if(!parse_caps(caps, info))
+    return std::shared_ptr<const VideoLayout>();
+
+  return get(static_cast<Gst::VideoFormat>(GST_VIDEO_INFO_FORMAT(&info)),
+    GST_VIDEO_INFO_WIDTH(&info), GST_VIDEO_INFO_HEIGHT(&info));
+}
+
+bool VideoLayout::from_caps(const Glib::RefPtr<const Gst::Caps>& caps, Gst::VideoInfo& info)
+{
+  GstVideoInfo parsed;
+  if(!parse_caps(caps, parsed))
+    return false;
+
+  *info.gobj() = parsed;
+  return true;
+}
+
+Glib::RefPtr<Gst::Caps> VideoLayout::to_caps(const Gst::VideoInfo& info)
+{
+  const InfoKey key(info.gobj());
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if(const Glib::RefPtr<Gst::Caps>* caps = built_caps.find(key))
+      return *caps;
+  }
+
+  Glib::RefPtr<Gst::Caps> caps = Glib::wrap(gst_video_info_to_caps(const_cast<GstVideoInfo*>(info.gobj())), false);
+
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  built_caps.insert(key, caps);
+  return caps;
+}
+
+void VideoLayout::clear_cache()
+{
+  // Drop the references outside of the lock.
+  std::list<std::pair<LayoutKey, std::shared_ptr<const VideoLayout>>> old_layouts;
+  std::list<std::pair<const GstCaps*, ParsedCaps>> old_parsed_caps;
+  std::list<std::pair<InfoKey, Glib::RefPtr<Gst::Caps>>> old_built_caps;
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    layouts.clear(old_layouts);
+    parsed_caps.clear(old_parsed_caps);
+    built_caps.clear(old_built_caps);
+  }
+}
+
+gsize VideoLayout::get_cache_size()
+{
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  return layouts.size();
+}
+
+VideoLayout::VideoLayout(Gst::VideoFormat format, guint width, guint height, const GstVideoAlignment* align)
+{
+  const GstVideoFormat gst_format = static_cast<GstVideoFormat>(format);
+  if(gst_format == GST_VIDEO_FORMAT_UNKNOWN || gst_format == GST_VIDEO_FORMAT_ENCODED)
+    gstreamermm_handle_error("Gst::VideoLayout needs a raw video format");
+  if(!width || !height)
+    gstreamermm_handle_error("Gst::VideoLayout needs a non-zero size");
+
+  gst_video_info_init(&info_);
+  gst_video_info_set_format(&info_, gst_format, width, height);
+
+  GstVideoAlignment no_align;
+  gst_video_alignment_reset(&no_align);
+  if(align && std::memcmp(align, &no_align, sizeof(no_align)))
+  {
+    // gst_video_info_align() updates the alignment it is given.
+    GstVideoAlignment copy = *align;
+    gst_video_info_align(&info_, &copy);
+  }
+
+  caps_ = Glib::wrap(gst_video_info_to_caps(&info_), false);
+}
+
+Gst::VideoFormat VideoLayout::get_format() const
+{
+  return static_cast<Gst::VideoFormat>(GST_VIDEO_INFO_FORMAT(&info_));
+}
+
+guint VideoLayout::get_width() const
+{
+  return GST_VIDEO_INFO_WIDTH(&info_);
+}
+
+guint VideoLayout::get_height() const
+{
+  return GST_VIDEO_INFO_HEIGHT(&info_);
+}
+
+guint VideoLayout::get_n_planes() const
+{
+  return GST_VIDEO_INFO_N_PLANES(&info_);
+}
+
+int VideoLayout::get_stride(guint plane) const
+{
+  if(plane >= get_n_planes())
+    gstreamermm_handle_error("Gst::VideoLayout: invalid plane");
+
+  return GST_VIDEO_INFO_PLANE_STRIDE(&info_, plane);
+}
+
+gsize VideoLayout::get_offset(guint plane) const
+{
+  if(plane >= get_n_planes())
+    gstreamermm_handle_error("Gst::VideoLayout: invalid plane");
+
+  return GST_VIDEO_INFO_PLANE_OFFSET(&info_, plane);
+}
+
+gsize VideoLayout::get_size() const
+{
+  return GST_VIDEO_INFO_SIZE(&info_);
+}
+
+Glib::RefPtr<Gst::Caps> VideoLayout::get_caps() const
+{
+  return caps_;
+}
+
+void VideoLayout::fill_info(Gst::VideoInfo& info) const
+{
+  *info.gobj() = info_;
+}
+
+const GstVideoInfo* VideoLayout::get_info() const
+{
+  return &info_;
+}
+
+} // namespace Gst
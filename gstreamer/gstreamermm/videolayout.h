@@ -0,0 +1,159 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_VIDEOLAYOUT_H
+#define _GSTREAMERMM_VIDEOLAYOUT_H
+
+#include <gstreamermm/caps.h>
+#include <gstreamermm/videoinfo.h>
+#include <gst/video/video-info.h>
+#include <memory>
+
+namespace Gst
+{
+
+/**
+ * Gst::VideoLayout holds the memory layout of raw video frames of one
+ * format, size and alignment: the stride and offset of each plane, the
+ * frame size, and the canonical caps describing the frames.
+ *
+ * Layouts only depend on their key, so they are computed once by get() and
+ * shared by all elements, in all threads; looking up a known layout is a
+ * hash probe instead of the computation done by Gst::VideoInfo::set_format().
+ * A forgotten layout stays valid for as long as it is referenced.
+ *
+ * from_caps() and to_caps() give the same results as
+ * Gst::VideoInfo::from_caps() and Gst::VideoInfo::to_caps(), but remember
+ * the recently converted caps and video infos. Caps are looked up by
+ * identity: the cache keeps a reference to them, which makes them
+ * non-writable for as long as they are cached. The caps returned by
+ * to_caps() and get_caps() are shared with the cache and have to be made
+ * writable before they are modified.
+ */
+class VideoLayout
+{
+public:
+  /** The highest number of layouts remembered by get(), and of caps and
+   * video infos remembered by from_caps() and to_caps(); the least recently
+   * used ones are forgotten first.
+   */
+  static const gsize MAX_CACHED_CAPS = 64;
+
+  /** Returns the layout of frames of @a format and @a width by @a height
+   * pixels, with the default alignment of Gst::VideoInfo::set_format().
+   *
+   * @throw std::runtime_error if the format is unknown or encoded, or a
+   * size is zero.
+   */
+  static std::shared_ptr<const VideoLayout> get(Gst::VideoFormat format, guint width, guint height);
+
+  /** Returns the layout of frames of @a format and @a width by @a height
+   * pixels, with the padding and stride alignment of @a align, as applied
+   * by gst_video_info_align().
+   *
+   * @throw std::runtime_error if the format is unknown or encoded, or a
+   * size is zero.
+   */
+  static std::shared_ptr<const VideoLayout> get(Gst::VideoFormat format, guint width, guint height,
+    const GstVideoAlignment& align);
+
+  /** Returns the layout of the raw video frames described by @a caps, or
+   * an empty pointer if @a caps do not describe raw video.
+   */
+  static std::shared_ptr<const VideoLayout> get(const Glib::RefPtr<const Gst::Caps>& caps);
+
+  /** Parses @a caps into @a info, like Gst::VideoInfo::from_caps().
+   *
+   * @return true if @a caps describe raw video.
+   */
+  static bool from_caps(const Glib::RefPtr<const Gst::Caps>& caps, Gst::VideoInfo& info);
+
+  /** Returns the caps describing @a info, like Gst::VideoInfo::to_caps().
+   */
+  static Glib::RefPtr<Gst::Caps> to_caps(const Gst::VideoInfo& info);
+
+  /** Forgets all layouts, caps and video infos. Layouts still in use stay
+   * valid.
+   */
+  static void clear_cache();
+
+  /** Returns the number of layouts in the cache.
+   */
+  static gsize get_cache_size();
+
+  /** Computes a layout; use get() to share it.
+   *
+   * @param align The alignment, or nullptr for the default one.
+   */
+  VideoLayout(Gst::VideoFormat format, guint width, guint height, const GstVideoAlignment* align);
+
+  VideoLayout(const VideoLayout&) = delete;
+  VideoLayout& operator=(const VideoLayout&) = delete;
+
+  /** Returns the format of the frames.
+   */
+  Gst::VideoFormat get_format() const;
+
+  /** Returns the width of the frames, in pixels.
+   */
+  guint get_width() const;
+
+  /** Returns the height of the frames, in pixels.
+   */
+  guint get_height() const;
+
+  /** Returns the number of planes of the frames.
+   */
+  guint get_n_planes() const;
+
+  /** Returns the distance between two rows of plane @a plane, in bytes.
+   */
+  int get_stride(guint plane) const;
+
+  /** Returns the offset of plane @a plane from the start of the frame, in
+   * bytes. With padding, it is the offset of the first visible pixel.
+   */
+  gsize get_offset(guint plane) const;
+
+  /** Returns the size of a frame, in bytes.
+   */
+  gsize get_size() const;
+
+  /** Returns the canonical caps of the frames, with no framerate and square
+   * pixels.
+   */
+  Glib::RefPtr<Gst::Caps> get_caps() const;
+
+  /** Sets @a info to the layout, with no framerate and square pixels.
+   */
+  void fill_info(Gst::VideoInfo& info) const;
+
+  /** Returns the video info of the layout, with no framerate and square
+   * pixels.
+   */
+  const GstVideoInfo* get_info() const;
+
+private:
+  GstVideoInfo info_;
+  Glib::RefPtr<Gst::Caps> caps_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_VIDEOLAYOUT_H */
@@ -0,0 +1,185 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_VIDEOPLANE_H
+#define _GSTREAMERMM_VIDEOPLANE_H
+
+#include <glib.h>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+namespace Gst
+{
+
+/**
+ * Gst::VideoPlaneView is a view of the rows of one plane, or of one
+ * component, of a mapped video frame. It does not own the memory, and is
+ * only valid while the frame it was taken from stays mapped.
+ *
+ * The width and height are in pixels of the plane, which are subsampled for
+ * the chroma planes of YUV formats. A pixel takes get_pixel_stride() bytes;
+ * a row takes get_stride() bytes, including the padding after the
+ * get_row_size() bytes of pixels.
+ *
+ * The rows can be iterated:
+ * @code
+ * Gst::VideoPlane plane = frame.get_plane(0);
+ * for(guint8* row : plane)
+ *   std::fill(row, row + plane.get_row_size(), 16);
+ * @endcode
+ *
+ * Gst::VideoPlane gives write access to the pixels, Gst::ConstVideoPlane
+ * only read access; a Gst::VideoPlane converts to a Gst::ConstVideoPlane.
+ */
+template<typename T>
+class VideoPlaneView
+{
+public:
+  /** Iterates the rows of a plane, from the top.
+   */
+  class iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T* value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T* const* pointer;
+    typedef T* reference;
+
+    iterator(T* row, int stride)
+    : row_(row), stride_(stride)
+    {}
+
+    T* operator*() const { return row_; }
+
+    iterator& operator++()
+    {
+      row_ += stride_;
+      return *this;
+    }
+
+    iterator operator++(int)
+    {
+      iterator old = *this;
+      row_ += stride_;
+      return old;
+    }
+
+    bool operator==(const iterator& other) const { return row_ == other.row_; }
+    bool operator!=(const iterator& other) const { return row_ != other.row_; }
+
+  private:
+    T* row_;
+    int stride_;
+  };
+
+  /** Creates an empty view.
+   */
+  VideoPlaneView()
+  : data_(nullptr), stride_(0), width_(0), height_(0), pixel_stride_(0)
+  {}
+
+  /** Creates a view of @a height rows of @a width pixels of
+   * @a pixel_stride bytes, starting at @a data and @a stride bytes apart.
+   */
+  VideoPlaneView(T* data, int stride, int width, int height, int pixel_stride)
+  : data_(data), stride_(stride), width_(width), height_(height), pixel_stride_(pixel_stride)
+  {}
+
+  /** Converts a writable view into a read-only one.
+   */
+  template<typename U>
+  VideoPlaneView(const VideoPlaneView<U>& other)
+  : data_(other.get_data()), stride_(other.get_stride()), width_(other.get_width()),
+    height_(other.get_height()), pixel_stride_(other.get_pixel_stride())
+  {}
+
+  /** Returns the first byte of the first row.
+   */
+  T* get_data() const { return data_; }
+
+  /** Returns the distance between two rows, in bytes.
+   */
+  int get_stride() const { return stride_; }
+
+  /** Returns the number of pixels of a row.
+   */
+  int get_width() const { return width_; }
+
+  /** Returns the number of rows.
+   */
+  int get_height() const { return height_; }
+
+  /** Returns the distance between two pixels of a row, in bytes.
+   */
+  int get_pixel_stride() const { return pixel_stride_; }
+
+  /** Returns the number of bytes of the pixels of a row, without padding.
+   */
+  int get_row_size() const { return width_ * pixel_stride_; }
+
+  /** Returns the first byte of row @a y.
+   */
+  T* get_row(int y) const { return data_ + static_cast<std::ptrdiff_t>(y) * stride_; }
+
+  /** Returns the first byte of the pixel at @a x, @a y.
+   */
+  T* get_pixel(int x, int y) const { return get_row(y) + x * pixel_stride_; }
+
+  /** Returns a view of the @a width by @a height pixels at @a x, @a y,
+   * clipped to this view, so that a kernel only touches the rows and pixels
+   * of a region.
+   */
+  VideoPlaneView get_region(int x, int y, int width, int height) const
+  {
+    const int left = std::max(0, std::min(x, width_));
+    const int top = std::max(0, std::min(y, height_));
+    const int right = std::max(left, std::min(x + width, width_));
+    const int bottom = std::max(top, std::min(y + height, height_));
+    return VideoPlaneView(get_pixel(left, top), stride_, right - left, bottom - top, pixel_stride_);
+  }
+
+  /** Returns an iterator to the first row.
+   */
+  iterator begin() const { return iterator(data_, stride_); }
+
+  /** Returns an iterator past the last row.
+   */
+  iterator end() const { return iterator(get_row(height_), stride_); }
+
+private:
+  T* data_;
+  int stride_;
+  int width_;
+  int height_;
+  int pixel_stride_;
+};
+
+/** A writable view of a plane of a mapped Gst::VideoFrame.
+ */
+typedef VideoPlaneView<guint8> VideoPlane;
+
+/** A read-only view of a plane of a mapped Gst::VideoFrame.
+ */
+typedef VideoPlaneView<const guint8> ConstVideoPlane;
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_VIDEOPLANE_H */
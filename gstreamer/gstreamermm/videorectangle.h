@@ -0,0 +1,46 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_VIDEORECTANGLE_H
+#define _GSTREAMERMM_VIDEORECTANGLE_H
+
+namespace Gst
+{
+
+/** A helper structure representing a rectangular area of a video frame,
+ * used by Gst::VideoSink, Gst::VideoFrame and Gst::VideoRegionOfInterest.
+ */
+struct VideoRectangle
+{
+  /// The X coordinate of the rectangle's top-left point.
+  int x;
+
+  /// The Y coordinate of rectangle's top-left point.
+  int y;
+
+  /// The width of the rectangle.
+  int w;
+
+  /// The height of the rectangle.
+  int h;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_VIDEORECTANGLE_H */
@@ -0,0 +1,174 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/videoregionfilter.h>
+#include <gstreamermm/videolayout.h>
+#include <algorithm>
+
+namespace Gst
+{
+
+Glib::RefPtr<Gst::Caps> VideoRegionFilter::create_caps(const std::vector<Gst::VideoFormat>& formats)
+{
+  GstStructure* structure = gst_structure_new_empty("video/x-raw");
+  GValue list = G_VALUE_INIT;
+
+  g_value_init(&list, GST_TYPE_LIST);
+  for(Gst::VideoFormat format : formats)
+  {
+    GValue value = G_VALUE_INIT;
+    g_value_init(&value, G_TYPE_STRING);
+    g_value_set_static_string(&value, gst_video_format_to_string(static_cast<GstVideoFormat>(format)));
+    gst_value_list_append_and_take_value(&list, &value);
+  }
+  gst_structure_take_value(structure, "format", &list);
+
+  gst_structure_set(structure,
+    "width", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+    "height", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+    "framerate", GST_TYPE_FRACTION_RANGE, 0, 1, G_MAXINT, 1,
+    nullptr);
+
+  return Glib::wrap(gst_caps_new_full(structure, nullptr), false);
+}
+
+VideoRegionFilter::VideoRegionFilter(GstBaseTransform* gobj)
+: Gst::BaseTransform(gobj),
+  region_types_(*this, "region-types", ""),
+  types_changed_(true)
+{
+  set_in_place(true);
+  property_region_types().signal_changed().connect(
+    sigc::mem_fun(*this, &VideoRegionFilter::on_region_types_changed));
+}
+
+Glib::PropertyProxy<Glib::ustring> VideoRegionFilter::property_region_types()
+{
+  return region_types_.get_proxy();
+}
+
+const Gst::VideoInfo& VideoRegionFilter::get_video_info() const
+{
+  return info_;
+}
+
+bool VideoRegionFilter::setup_vfunc(const Gst::VideoInfo&)
+{
+  return true;
+}
+
+bool VideoRegionFilter::set_caps_vfunc(const Glib::RefPtr<Gst::Caps>& incaps, const Glib::RefPtr<Gst::Caps>&)
+{
+  if(!Gst::VideoLayout::from_caps(incaps, info_))
+    return false;
+
+  return setup_vfunc(info_);
+}
+
+void VideoRegionFilter::on_region_types_changed()
+{
+  types_changed_ = true;
+}
+
+void VideoRegionFilter::update_types()
+{
+  if(!types_changed_.exchange(false))
+    return;
+
+  types_.clear();
+  gchar** const names = g_strsplit(region_types_.get_value().c_str(), ",", -1);
+  for(gchar** name = names; *name; ++name)
+  {
+    g_strstrip(*name);
+    if(**name)
+      types_.push_back(g_quark_from_string(*name));
+  }
+  g_strfreev(names);
+}
+
+Gst::FlowReturn VideoRegionFilter::prepare_output_buffer_vfunc(const Glib::RefPtr<Gst::Buffer>& input,
+  Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  update_types();
+
+  // A frame without a region to process is pushed as it is, instead of
+  // being made writable, which would copy it if it is shared.
+  if(!Gst::VideoRegionOfInterest::has_any(input, types_))
+  {
+    buffer = input;
+    // The output takes over the reference of the input, as when the
+    // default implementation makes it writable.
+    buffer->unreference();
+    return Gst::FLOW_OK;
+  }
+
+  return Gst::BaseTransform::prepare_output_buffer_vfunc(input, buffer);
+}
+
+Gst::FlowReturn VideoRegionFilter::transform_ip_vfunc(const Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  Gst::VideoRegionOfInterest::get_all(buffer, regions_, types_);
+  if(regions_.empty())
+    return Gst::FLOW_OK;
+
+  Gst::VideoFrame frame;
+  if(!frame.map(info_, buffer, Gst::MAP_READWRITE))
+  {
+    GST_ELEMENT_ERROR(gobj(), RESOURCE, WRITE, (nullptr), ("Could not map the frame"));
+    return Gst::FLOW_ERROR;
+  }
+
+  const int width = GST_VIDEO_INFO_WIDTH(info_.gobj());
+  const int height = GST_VIDEO_INFO_HEIGHT(info_.gobj());
+  Gst::FlowReturn result = Gst::FLOW_OK;
+
+  for(Gst::VideoRegionOfInterest& region : regions_)
+  {
+    // Clips the region to the frame.
+    const int left = std::max(0, region.rect.x);
+    const int top = std::max(0, region.rect.y);
+    const int right = std::min(width, region.rect.x + region.rect.w);
+    const int bottom = std::min(height, region.rect.y + region.rect.h);
+    if(left >= right || top >= bottom)
+      continue;
+
+    region.rect.x = left;
+    region.rect.y = top;
+    region.rect.w = right - left;
+    region.rect.h = bottom - top;
+
+    try
+    {
+      result = transform_region_vfunc(frame, region);
+    }
+    catch(...)
+    {
+      frame.unmap();
+      throw;
+    }
+
+    if(result != Gst::FLOW_OK)
+      break;
+  }
+
+  frame.unmap();
+  return result;
+}
+
+} // namespace Gst
@@ -0,0 +1,130 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_VIDEOREGIONFILTER_H
+#define _GSTREAMERMM_VIDEOREGIONFILTER_H
+
+#include <gstreamermm/basetransform.h>
+#include <gstreamermm/caps.h>
+#include <gstreamermm/padtemplate.h>
+#include <gstreamermm/register.h>
+#include <gstreamermm/videoformat.h>
+#include <gstreamermm/videoframe.h>
+#include <gstreamermm/videoinfo.h>
+#include <gstreamermm/videoregionofinterest.h>
+#include <glibmm/property.h>
+#include <atomic>
+#include <vector>
+
+namespace Gst
+{
+
+/**
+ * Gst::VideoRegionFilter is a base class for in-place video filters which
+ * only process the regions of interest of each frame, such as faces or
+ * license plates to blur, listed by the GstVideoRegionOfInterestMeta of
+ * the buffers.
+ *
+ * transform_region_vfunc() is called for each region of a frame, with the
+ * region clipped to the frame; it processes the pixels of the region with
+ * the views returned by Gst::VideoFrame::get_component() for a rectangle:
+ * @code
+ * Gst::FlowReturn MyBlur::transform_region_vfunc(Gst::VideoFrame& frame,
+ *   const Gst::VideoRegionOfInterest& region)
+ * {
+ *   for(guint8* row : frame.get_component(0, region.rect))
+ *     ...
+ *   return Gst::FLOW_OK;
+ * }
+ * @endcode
+ *
+ * The rest of the frame is passed through untouched. A frame without a
+ * region to process is neither mapped nor made writable, so it is pushed
+ * without being copied even if it is shared.
+ *
+ * The "region-types" property selects the types of regions processed.
+ *
+ * The subclass adds its pad templates with add_pad_templates() in its
+ * class_init().
+ */
+class VideoRegionFilter : public Gst::BaseTransform
+{
+public:
+  /** Creates caps for raw video in any of @a formats, with any size and
+   * framerate, for the pad templates of a filter.
+   */
+  static Glib::RefPtr<Gst::Caps> create_caps(const std::vector<Gst::VideoFormat>& formats);
+
+  /** Adds the "sink" and "src" pad templates with @a caps to the class of a
+   * filter, from its class_init() function.
+   */
+  template<class DerivedCppType>
+  static void add_pad_templates(Gst::ElementClass<DerivedCppType>* klass, const Glib::RefPtr<Gst::Caps>& caps)
+  {
+    klass->add_pad_template(Gst::PadTemplate::create("sink", Gst::PAD_SINK, Gst::PAD_ALWAYS, caps));
+    klass->add_pad_template(Gst::PadTemplate::create("src", Gst::PAD_SRC, Gst::PAD_ALWAYS, caps));
+  }
+
+  /** The comma-separated types of the regions to process, such as
+   * "face,license-plate", or an empty string for all types.
+   */
+  Glib::PropertyProxy<Glib::ustring> property_region_types();
+
+  /** Returns the format of the frames, set when the caps are.
+   */
+  const Gst::VideoInfo& get_video_info() const;
+
+protected:
+  explicit VideoRegionFilter(GstBaseTransform* gobj);
+
+  /** Processes @a region of @a frame, which is mapped for reading and
+   * writing. The rectangle of @a region is clipped to the frame and not
+   * empty.
+   *
+   * @return Gst::FLOW_OK to go on with the next region, or an error.
+   */
+  virtual Gst::FlowReturn transform_region_vfunc(Gst::VideoFrame& frame,
+    const Gst::VideoRegionOfInterest& region) = 0;
+
+  /** Called when the format of the frames changes. The default
+   * implementation returns true.
+   */
+  virtual bool setup_vfunc(const Gst::VideoInfo& info);
+
+  bool set_caps_vfunc(const Glib::RefPtr<Gst::Caps>& incaps, const Glib::RefPtr<Gst::Caps>& outcaps) override;
+  Gst::FlowReturn prepare_output_buffer_vfunc(const Glib::RefPtr<Gst::Buffer>& input,
+    Glib::RefPtr<Gst::Buffer>& buffer) override;
+  Gst::FlowReturn transform_ip_vfunc(const Glib::RefPtr<Gst::Buffer>& buffer) override;
+
+private:
+  void on_region_types_changed();
+  void update_types();
+
+  Glib::Property<Glib::ustring> region_types_;
+  // Set when "region-types" changes, so that it is parsed again by the
+  // streaming thread.
+  std::atomic<bool> types_changed_;
+  std::vector<GQuark> types_;
+  Gst::VideoInfo info_;
+  std::vector<Gst::VideoRegionOfInterest> regions_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_VIDEOREGIONFILTER_H */
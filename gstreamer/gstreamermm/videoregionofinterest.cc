@@ -0,0 +1,99 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/videoregionofinterest.h>
+#include <gst/video/gstvideometa.h>
+#include <glibmm/utility.h>
+#include <algorithm>
+
+namespace
+{
+
+bool has_type(const std::vector<GQuark>& types, GQuark type)
+{
+  return types.empty() || std::find(types.begin(), types.end(), type) != types.end();
+}
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+Glib::ustring VideoRegionOfInterest::get_type_name() const
+{
+  return Glib::convert_const_gchar_ptr_to_ustring(g_quark_to_string(type));
+}
+
+void VideoRegionOfInterest::get_all(const Glib::RefPtr<Gst::Buffer>& buffer,
+  std::vector<VideoRegionOfInterest>& regions, const std::vector<GQuark>& types)
+{
+  regions.clear();
+
+  gpointer state = nullptr;
+  GstMeta* meta = nullptr;
+  while((meta = gst_buffer_iterate_meta(buffer->gobj(), &state)))
+  {
+    if(meta->info->api != GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE)
+      continue;
+
+    const GstVideoRegionOfInterestMeta* const roi = reinterpret_cast<GstVideoRegionOfInterestMeta*>(meta);
+    if(!has_type(types, roi->roi_type))
+      continue;
+
+    VideoRegionOfInterest region;
+    region.type = roi->roi_type;
+    region.id = roi->id;
+    region.parent_id = roi->parent_id;
+    region.rect.x = roi->x;
+    region.rect.y = roi->y;
+    region.rect.w = roi->w;
+    region.rect.h = roi->h;
+    regions.push_back(region);
+  }
+}
+
+bool VideoRegionOfInterest::has_any(const Glib::RefPtr<Gst::Buffer>& buffer, const std::vector<GQuark>& types)
+{
+  gpointer state = nullptr;
+  GstMeta* meta = nullptr;
+  while((meta = gst_buffer_iterate_meta(buffer->gobj(), &state)))
+  {
+    if(meta->info->api == GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE &&
+      has_type(types, reinterpret_cast<GstVideoRegionOfInterestMeta*>(meta)->roi_type))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void VideoRegionOfInterest::add(const Glib::RefPtr<Gst::Buffer>& buffer, const Glib::ustring& type,
+  const Gst::VideoRectangle& rect, int id, int parent_id)
+{
+  GstVideoRegionOfInterestMeta* const meta = gst_buffer_add_video_region_of_interest_meta(buffer->gobj(),
+    type.c_str(), rect.x, rect.y, rect.w, rect.h);
+  if(meta)
+  {
+    meta->id = id;
+    meta->parent_id = parent_id;
+  }
+}
+
+} // namespace Gst
@@ -0,0 +1,85 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_VIDEOREGIONOFINTEREST_H
+#define _GSTREAMERMM_VIDEOREGIONOFINTEREST_H
+
+#include <gstreamermm/buffer.h>
+#include <gstreamermm/videorectangle.h>
+#include <vector>
+
+namespace Gst
+{
+
+/**
+ * Gst::VideoRegionOfInterest describes a region of interest of a video
+ * frame, such as a face or a license plate found by a detector. The regions
+ * of a frame are carried by the GstVideoRegionOfInterestMeta of its buffer,
+ * which get_all() reads and add() attaches.
+ *
+ * The type of a region is an interned string, so that regions are filtered
+ * by type without comparing strings:
+ * @code
+ * std::vector<Gst::VideoRegionOfInterest> regions;
+ * Gst::VideoRegionOfInterest::get_all(buffer, regions, { g_quark_from_static_string("face") });
+ * for(const Gst::VideoRegionOfInterest& region : regions)
+ *   blur(frame, region.rect);
+ * @endcode
+ */
+struct VideoRegionOfInterest
+{
+  /** The type of the region, such as "face", as a quark. */
+  GQuark type;
+  /** The identifier of the region. */
+  int id;
+  /** The identifier of the region containing this one, or -1. */
+  int parent_id;
+  /** The rectangle of the region, in pixels of the frame. */
+  Gst::VideoRectangle rect;
+
+  /** Returns the type of the region as a string.
+   */
+  Glib::ustring get_type_name() const;
+
+  /** Reads the regions of interest of @a buffer into @a regions, in the
+   * order they were added. @a regions is cleared first; its capacity is
+   * reused.
+   *
+   * @param types The types of the regions to read, or an empty vector for
+   * all types.
+   */
+  static void get_all(const Glib::RefPtr<Gst::Buffer>& buffer, std::vector<VideoRegionOfInterest>& regions,
+    const std::vector<GQuark>& types = std::vector<GQuark>());
+
+  /** Checks whether @a buffer has a region of interest of one of @a types,
+   * or of any type if @a types is empty.
+   */
+  static bool has_any(const Glib::RefPtr<Gst::Buffer>& buffer,
+    const std::vector<GQuark>& types = std::vector<GQuark>());
+
+  /** Adds a region of interest of type @a type to @a buffer, which must be
+   * writable.
+   */
+  static void add(const Glib::RefPtr<Gst::Buffer>& buffer, const Glib::ustring& type,
+    const Gst::VideoRectangle& rect, int id = 0, int parent_id = -1);
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_VIDEOREGIONOFINTEREST_H */
@@ -0,0 +1,290 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gstreamermm/videoscenedetect.h>
+#include <gstreamermm/elementfactory.h>
+#include <gstreamermm/message.h>
+#include <gstreamermm/padtemplate.h>
+#include <gstreamermm/structure.h>
+#include <gstreamermm/videoframe.h>
+#include <gstreamermm/videolayout.h>
+#include <algorithm>
+
+namespace
+{
+
+// The histograms count the 6 high bits of the luma samples.
+const int histogram_bins = 64;
+const int histogram_shift = 2;
+
+// Counts the samples of a row into four partial histograms, so that runs of
+// equal samples do not wait on the previous increment of the same counter.
+void add_to_histogram(const guint8* row, int width, guint32* histogram)
+{
+  guint32* const h0 = histogram;
+  guint32* const h1 = histogram + histogram_bins;
+  guint32* const h2 = histogram + 2 * histogram_bins;
+  guint32* const h3 = histogram + 3 * histogram_bins;
+  int x = 0;
+
+  for(; x + 4 <= width; x += 4)
+  {
+    ++h0[row[x] >> histogram_shift];
+    ++h1[row[x + 1] >> histogram_shift];
+    ++h2[row[x + 2] >> histogram_shift];
+    ++h3[row[x + 3] >> histogram_shift];
+  }
+  for(; x < width; ++x)
+    ++h0[row[x] >> histogram_shift];
+}
+
+gboolean motion_meta_init(GstMeta* meta, gpointer, GstBuffer*)
+{
+  Gst::VideoMotionMeta* const motion = reinterpret_cast<Gst::VideoMotionMeta*>(meta);
+  motion->motion = motion->histogram_delta = 0.0;
+  motion->scene_change = false;
+  return TRUE;
+}
+
+gboolean motion_meta_transform(GstBuffer* dest, GstMeta* meta, GstBuffer*, GQuark type, gpointer)
+{
+  // Copies keep the measurement; the other transformations change the
+  // pixels, which drops the metadata thanks to its video tag.
+  if(GST_META_TRANSFORM_IS_COPY(type))
+  {
+    const Gst::VideoMotionMeta* const source = reinterpret_cast<Gst::VideoMotionMeta*>(meta);
+    Gst::VideoMotionMeta* const copy = reinterpret_cast<Gst::VideoMotionMeta*>(
+      gst_buffer_add_meta(dest, Gst::VideoMotionMeta::get_info(), nullptr));
+    copy->motion = source->motion;
+    copy->histogram_delta = source->histogram_delta;
+    copy->scene_change = source->scene_change;
+  }
+  return TRUE;
+}
+
+} // anonymous namespace
+
+namespace Gst
+{
+
+GType VideoMotionMeta::get_api_type()
+{
+  static const gchar* tags[] = { GST_META_TAG_VIDEO_STR, nullptr };
+  static const GType type = gst_meta_api_type_register("GstMMVideoMotionMetaAPI", tags);
+  return type;
+}
+
+const GstMetaInfo* VideoMotionMeta::get_info()
+{
+  static const GstMetaInfo* const info = gst_meta_register(get_api_type(), "GstMMVideoMotionMeta",
+    sizeof(VideoMotionMeta), &motion_meta_init, nullptr, &motion_meta_transform);
+  return info;
+}
+
+VideoMotionMeta* VideoMotionMeta::add(const Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  return reinterpret_cast<VideoMotionMeta*>(gst_buffer_add_meta(buffer->gobj(), get_info(), nullptr));
+}
+
+VideoMotionMeta* VideoMotionMeta::get(const Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  return reinterpret_cast<VideoMotionMeta*>(gst_buffer_get_meta(buffer->gobj(), get_api_type()));
+}
+
+bool VideoSceneDetect::register_element(Glib::RefPtr<Gst::Plugin> plugin)
+{
+  return Gst::ElementFactory::register_element(plugin, "mmvideoscenedetect", Gst::RANK_NONE,
+    Gst::register_mm_type<VideoSceneDetect>("gstreamermm__VideoSceneDetect"));
+}
+
+void VideoSceneDetect::class_init(Gst::ElementClass<VideoSceneDetect>* klass)
+{
+  klass->set_metadata("Video scene detector", "Filter/Analyzer/Video",
+    "Measures the motion between frames and detects the scene changes",
+    "The gstreamermm Development Team");
+
+  // The formats with a plane of 8 bit luma samples.
+  const Glib::RefPtr<Gst::Caps> caps = Gst::Caps::create_from_string(GST_VIDEO_CAPS_MAKE(
+    "{ I420, YV12, NV12, NV21, Y41B, Y42B, Y444, GRAY8 }"));
+  klass->add_pad_template(Gst::PadTemplate::create("sink", Gst::PAD_SINK, Gst::PAD_ALWAYS, caps));
+  klass->add_pad_template(Gst::PadTemplate::create("src", Gst::PAD_SRC, Gst::PAD_ALWAYS, caps));
+}
+
+VideoSceneDetect::VideoSceneDetect(GstBaseTransform* gobj)
+: Glib::ObjectBase(typeid (VideoSceneDetect)),
+  Gst::BaseTransform(gobj),
+  threshold_(*this, "threshold", 0.3),
+  min_motion_(*this, "min-motion", 8.0),
+  post_messages_(*this, "post-messages", true),
+  attach_meta_(*this, "attach-meta", true),
+  negotiated_(false),
+  has_reference_(false),
+  histogram_(4 * histogram_bins),
+  previous_histogram_(histogram_bins),
+  scene_changes_(0)
+{
+  set_in_place(true);
+  property_attach_meta().signal_changed().connect(
+    sigc::mem_fun(*this, &VideoSceneDetect::on_attach_meta_changed));
+}
+
+Glib::PropertyProxy<double> VideoSceneDetect::property_threshold()
+{
+  return threshold_.get_proxy();
+}
+
+Glib::PropertyProxy<double> VideoSceneDetect::property_min_motion()
+{
+  return min_motion_.get_proxy();
+}
+
+Glib::PropertyProxy<bool> VideoSceneDetect::property_post_messages()
+{
+  return post_messages_.get_proxy();
+}
+
+Glib::PropertyProxy<bool> VideoSceneDetect::property_attach_meta()
+{
+  return attach_meta_.get_proxy();
+}
+
+guint64 VideoSceneDetect::get_scene_changes() const
+{
+  return scene_changes_.load();
+}
+
+bool VideoSceneDetect::set_caps_vfunc(const Glib::RefPtr<Gst::Caps>& incaps, const Glib::RefPtr<Gst::Caps>&)
+{
+  negotiated_ = Gst::VideoLayout::from_caps(incaps, info_);
+  if(!negotiated_)
+    return false;
+
+  // The frames of another size are compared from the next one on.
+  reference_.assign(static_cast<gsize>(GST_VIDEO_INFO_COMP_WIDTH(info_.gobj(), 0)) *
+    GST_VIDEO_INFO_COMP_HEIGHT(info_.gobj(), 0), 0);
+  has_reference_ = false;
+
+  on_attach_meta_changed();
+  return true;
+}
+
+void VideoSceneDetect::on_attach_meta_changed()
+{
+  // Frames are only written to when they carry the meta.
+  set_passthrough(!attach_meta_.get_value());
+}
+
+Gst::FlowReturn VideoSceneDetect::transform_ip_vfunc(const Glib::RefPtr<Gst::Buffer>& buffer)
+{
+  if(!negotiated_)
+    return Gst::FLOW_NOT_NEGOTIATED;
+
+  Gst::VideoFrame frame;
+  if(!frame.map(info_, buffer, Gst::MAP_READ))
+  {
+    GST_ELEMENT_ERROR(gobj(), RESOURCE, READ, (nullptr), ("Could not map the frame"));
+    return Gst::FLOW_ERROR;
+  }
+
+  const Gst::ConstVideoPlane luma = const_cast<const Gst::VideoFrame&>(frame).get_component(0);
+  const int width = luma.get_width();
+  const int height = luma.get_height();
+  const Gst::VideoPlane reference(reference_.data(), width, width, height, 1);
+
+  // Each row is compared, copied and counted while it is in the cache.
+  guint64 sad = 0;
+  std::fill(histogram_.begin(), histogram_.end(), 0);
+  for(int y = 0; y < height; ++y)
+  {
+    sad += kernels_.sad_update_plane(luma.get_region(0, y, width, 1), reference.get_region(0, y, width, 1));
+    add_to_histogram(luma.get_row(y), width, histogram_.data());
+  }
+  frame.unmap();
+
+  guint64 changed = 0;
+  for(int bin = 0; bin < histogram_bins; ++bin)
+  {
+    const guint32 count = histogram_[bin] + histogram_[bin + histogram_bins] +
+      histogram_[bin + 2 * histogram_bins] + histogram_[bin + 3 * histogram_bins];
+    changed += count > previous_histogram_[bin] ? count - previous_histogram_[bin] :
+      previous_histogram_[bin] - count;
+    previous_histogram_[bin] = count;
+  }
+
+  // The first frame has nothing to be compared with.
+  const double pixels = static_cast<double>(width) * height;
+  const double motion = has_reference_ && pixels > 0.0 ? sad / pixels : 0.0;
+  const double histogram_delta = has_reference_ && pixels > 0.0 ? changed / (2.0 * pixels) : 0.0;
+  const bool scene_change = has_reference_ && histogram_delta >= threshold_.get_value() &&
+    motion >= min_motion_.get_value();
+  has_reference_ = true;
+
+  if(attach_meta_.get_value() && gst_buffer_is_writable(buffer->gobj()))
+  {
+    VideoMotionMeta* const meta = VideoMotionMeta::add(buffer);
+    meta->motion = motion;
+    meta->histogram_delta = histogram_delta;
+    meta->scene_change = scene_change;
+  }
+
+  if(scene_change)
+  {
+    ++scene_changes_;
+    if(post_messages_.get_value())
+      post_scene_change(buffer, motion, histogram_delta);
+  }
+
+  return Gst::FLOW_OK;
+}
+
+void VideoSceneDetect::post_scene_change(const Glib::RefPtr<Gst::Buffer>& buffer, double motion,
+  double histogram_delta)
+{
+  const Gst::ClockTime pts = buffer->get_pts();
+  const Gst::ClockTime running_time = pts != Gst::CLOCK_TIME_NONE ?
+    gst_segment_to_running_time(&gobj()->segment, GST_FORMAT_TIME, pts) : Gst::CLOCK_TIME_NONE;
+
+  Gst::Structure structure("scene-change");
+  structure.set_field("timestamp", static_cast<guint64>(pts));
+  structure.set_field("running-time", static_cast<guint64>(running_time));
+  structure.set_field("motion", motion);
+  structure.set_field("histogram-delta", histogram_delta);
+
+  post_message(Gst::MessageElement::create(
+    Glib::wrap(GST_OBJECT(gobj()), true), std::move(structure)));
+}
+
+bool VideoSceneDetect::sink_event_vfunc(const Glib::RefPtr<Gst::Event>& event)
+{
+  // The frames after a flush are not compared with the ones before.
+  if(event->get_event_type() == Gst::EVENT_FLUSH_STOP)
+    has_reference_ = false;
+
+  return Gst::BaseTransform::sink_event_vfunc(event);
+}
+
+bool VideoSceneDetect::stop_vfunc()
+{
+  negotiated_ = false;
+  has_reference_ = false;
+  std::vector<guint8>().swap(reference_);
+  return Gst::BaseTransform::stop_vfunc();
+}
+
+} // namespace Gst
@@ -0,0 +1,159 @@
+/* gstreamermm - a C++ wrapper for gstreamer
+ *
+ * Copyright 2016 The gstreamermm Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GSTREAMERMM_VIDEOSCENEDETECT_H
+#define _GSTREAMERMM_VIDEOSCENEDETECT_H
+
+#include <gstreamermm/basetransform.h>
+#include <gstreamermm/register.h>
+#include <gstreamermm/videoinfo.h>
+#include <gstreamermm/videokernels.h>
+#include <glibmm/property.h>
+#include <atomic>
+#include <vector>
+
+namespace Gst
+{
+
+/**
+ * Gst::VideoMotionMeta holds the differences measured by
+ * Gst::VideoSceneDetect between a frame and the previous one.
+ *
+ * @code
+ * Gst::VideoMotionMeta* meta = Gst::VideoMotionMeta::get(buffer);
+ * if(meta && meta->scene_change)
+ *   request_keyframe();
+ * @endcode
+ */
+struct VideoMotionMeta
+{
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  GstMeta meta;
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+  /** The mean absolute difference of the luma samples, from 0 to 255. */
+  double motion;
+  /** The part of the luma histogram which changed, from 0 to 1. */
+  double histogram_delta;
+  /** Whether the frame starts a new scene. */
+  bool scene_change;
+
+  /** Returns the API type of the metadata.
+   */
+  static GType get_api_type();
+
+  /** Returns the registered implementation of the metadata.
+   */
+  static const GstMetaInfo* get_info();
+
+  /** Adds a Gst::VideoMotionMeta to @a buffer, which must be writable.
+   */
+  static VideoMotionMeta* add(const Glib::RefPtr<Gst::Buffer>& buffer);
+
+  /** Returns the Gst::VideoMotionMeta of @a buffer, or nullptr.
+   */
+  static VideoMotionMeta* get(const Glib::RefPtr<Gst::Buffer>& buffer);
+};
+
+/**
+ * Gst::VideoSceneDetect is an in-place element measuring the motion between
+ * consecutive frames and detecting the scene changes, for example to
+ * request keyframes or take thumbnails.
+ *
+ * It is registered as "mmvideoscenedetect" by register_element(), and
+ * accepts the formats with a plane of 8 bit luma samples. The luma of each
+ * frame is compared with a copy of the previous one, kept by the element:
+ * the sum of the absolute differences, computed with
+ * Gst::VideoKernels::sad_update_plane(), gives the motion, and the
+ * difference between the histograms of the two frames tells a cut apart
+ * from fast motion. A frame starts a new scene when its histogram delta
+ * reaches "threshold" and its motion reaches "min-motion".
+ *
+ * On a scene change, it posts a Gst::MessageElement with a "scene-change"
+ * structure holding the "timestamp" and "running-time" of the frame, as
+ * guint64, and its "motion" and "histogram-delta", as doubles. When
+ * "attach-meta" is true, each frame also gets a Gst::VideoMotionMeta; the
+ * frames are otherwise passed through unchanged, without being copied.
+ */
+class VideoSceneDetect : public Gst::BaseTransform
+{
+public:
+  /** Registers the element as "mmvideoscenedetect" in @a plugin.
+   */
+  static bool register_element(Glib::RefPtr<Gst::Plugin> plugin);
+
+  /** The part of the luma histogram which must change for a scene change,
+   * from 0 to 1.
+   */
+  Glib::PropertyProxy<double> property_threshold();
+
+  /** The mean absolute difference of the luma samples needed for a scene
+   * change, from 0 to 255.
+   */
+  Glib::PropertyProxy<double> property_min_motion();
+
+  /** Whether to post the messages.
+   */
+  Glib::PropertyProxy<bool> property_post_messages();
+
+  /** Whether to attach a Gst::VideoMotionMeta to each frame. Takes effect
+   * from the next frame on.
+   */
+  Glib::PropertyProxy<bool> property_attach_meta();
+
+  /** Returns the number of scene changes detected.
+   */
+  guint64 get_scene_changes() const;
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  static void class_init(Gst::ElementClass<VideoSceneDetect>* klass);
+
+  explicit VideoSceneDetect(GstBaseTransform* gobj);
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+protected:
+  bool set_caps_vfunc(const Glib::RefPtr<Gst::Caps>& incaps, const Glib::RefPtr<Gst::Caps>& outcaps) override;
+  Gst::FlowReturn transform_ip_vfunc(const Glib::RefPtr<Gst::Buffer>& buffer) override;
+  bool sink_event_vfunc(const Glib::RefPtr<Gst::Event>& event) override;
+  bool stop_vfunc() override;
+
+private:
+  void on_attach_meta_changed();
+  void post_scene_change(const Glib::RefPtr<Gst::Buffer>& buffer, double motion, double histogram_delta);
+
+  Glib::Property<double> threshold_;
+  Glib::Property<double> min_motion_;
+  Glib::Property<bool> post_messages_;
+  Glib::Property<bool> attach_meta_;
+
+  VideoKernels kernels_;
+  Gst::VideoInfo info_;
+  bool negotiated_;
+  // The luma and the histogram of the previous frame.
+  bool has_reference_;
+  std::vector<guint8> reference_;
+  std::vector<guint32> histogram_;
+  std::vector<guint32> previous_histogram_;
+
+  std::atomic<guint64> scene_changes_;
+};
+
+} // namespace Gst
+
+#endif /* _GSTREAMERMM_VIDEOSCENEDETECT_H */
@@ -0,0 +1,210 @@
+/*
+ * test-plugin-aggregator.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "utils.h"
+#include <sstream>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+// Outputs one 10 ms buffer per set of inputs, whose size is the number of
+// inputs which had a buffer.
+class TestAggregator : public Aggregator
+{
+public:
+  static const ClockTime duration = 10 * MILLI_SECOND;
+
+  guint timeouts = 0;
+
+  static void class_init(ElementClass<TestAggregator>* klass)
+  {
+    klass->set_metadata("Test aggregator", "Generic", "Counts its inputs", "The gstreamermm Development Team");
+    klass->add_pad_template(PadTemplate::create("src", PAD_SRC, PAD_ALWAYS, Caps::create_any()));
+    klass->add_pad_template(PadTemplate::create("sink_%u", PAD_SINK, PAD_REQUEST, Caps::create_any()));
+  }
+
+  static bool register_element(RefPtr<Plugin> plugin)
+  {
+    return ElementFactory::register_element(plugin, "mmtestaggregator", RANK_NONE,
+      register_mm_type<TestAggregator>("gstreamermm__TestAggregator"));
+  }
+
+  explicit TestAggregator(GstElement* gobj)
+  : Glib::ObjectBase(typeid (TestAggregator)),
+    Aggregator(gobj),
+    position(0)
+  {}
+
+protected:
+  bool start_vfunc() override
+  {
+    position = 0;
+    set_latency(5 * MILLI_SECOND, 5 * MILLI_SECOND);
+    set_src_caps(Caps::create_simple("application/x-inputs"));
+    return true;
+  }
+
+  FlowReturn aggregate_vfunc(bool timeout) override
+  {
+    if(timeout)
+      ++timeouts;
+
+    gsize inputs = 0;
+    for(const RefPtr<AggregatorPad>& pad : get_sink_pads())
+    {
+      if(pad->pop_buffer())
+        ++inputs;
+    }
+
+    RefPtr<Buffer> buffer = Buffer::create(inputs);
+    buffer->set_pts(position);
+    buffer->set_duration(duration);
+    position += duration;
+    return finish_buffer(buffer);
+  }
+
+  ClockTime get_next_time_vfunc() override
+  {
+    return position;
+  }
+
+private:
+  ClockTime position;
+};
+
+class AggregatorTest : public PluginPipelineTest
+{
+protected:
+  guint buffers = 0;
+  gsize last_size = 0;
+
+  static void SetUpTestCase()
+  {
+    RegisterPlugin("mmtestaggregator", "test aggregator", sigc::ptr_fun(&TestAggregator::register_element));
+  }
+
+  void OnBuffer(const RefPtr<Pad>&, const RefPtr<Buffer>& buffer) override
+  {
+    ++buffers;
+    last_size = buffer->get_size();
+  }
+
+  RefPtr<Bin> LaunchInputs(const Glib::ustring& inputs)
+  {
+    return Launch("mmtestaggregator name=agg ! fakesink name=sink " + inputs);
+  }
+};
+
+TEST_F(AggregatorTest, InputsAreAggregatedUntilEos)
+{
+  RefPtr<Bin> pipeline = LaunchInputs("fakesrc num-buffers=10 ! agg. fakesrc num-buffers=10 ! agg.");
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(10u, buffers);
+  ASSERT_EQ(2u, last_size);
+}
+
+TEST_F(AggregatorTest, EndedInputsAreSkipped)
+{
+  RefPtr<Bin> pipeline = LaunchInputs("fakesrc num-buffers=10 ! agg. fakesrc num-buffers=4 ! agg.");
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(10u, buffers);
+  ASSERT_EQ(1u, last_size);
+}
+
+TEST_F(AggregatorTest, GapsCoverSparseInputs)
+{
+  // The second input only sends gaps, which stand for its buffers.
+  RefPtr<Bin> pipeline = LaunchInputs("fakesrc num-buffers=10 ! agg.");
+  RefPtr<Pad> sparse = pipeline->get_element("agg")->get_request_pad("sink_%u");
+  MM_ASSERT_TRUE(sparse);
+
+  pipeline->set_state(STATE_PLAYING);
+  GstSegment segment;
+  gst_segment_init(&segment, GST_FORMAT_TIME);
+  MM_ASSERT_TRUE(sparse->send_event(EventStreamStart::create("sparse")));
+  MM_ASSERT_TRUE(sparse->send_event(EventSegment::create(Segment(&segment, true))));
+  for(int i = 0; i < 10; ++i)
+    MM_ASSERT_TRUE(sparse->send_event(EventGap::create(i * TestAggregator::duration, TestAggregator::duration)));
+  MM_ASSERT_TRUE(sparse->send_event(EventEos::create()));
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(10u, buffers);
+  ASSERT_EQ(2u, last_size);
+}
+
+TEST_F(AggregatorTest, ManyInputsAreAggregated)
+{
+  std::ostringstream inputs;
+  for(int i = 0; i < 64; ++i)
+    inputs << "fakesrc num-buffers=5 ! queue ! agg. ";
+  RefPtr<Bin> pipeline = LaunchInputs(inputs.str());
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(5u, buffers);
+  ASSERT_EQ(64u, last_size);
+}
+
+TEST_F(AggregatorTest, RequestedPadsFollowTheTemplate)
+{
+  RefPtr<Element> aggregator = ElementFactory::create_element("mmtestaggregator");
+  MM_ASSERT_TRUE(aggregator);
+
+  RefPtr<Pad> named = aggregator->get_request_pad("sink_7");
+  MM_ASSERT_TRUE(named);
+  ASSERT_EQ("sink_7", named->get_name());
+
+  RefPtr<Pad> next = aggregator->get_request_pad("sink_%u");
+  MM_ASSERT_TRUE(next);
+  ASSERT_EQ("sink_8", next->get_name());
+  MM_ASSERT_TRUE(RefPtr<AggregatorPad>::cast_dynamic(next));
+  ASSERT_EQ(2u, RefPtr<TestAggregator>::cast_static(aggregator)->get_sink_pads().size());
+
+  aggregator->release_request_pad(named);
+  ASSERT_EQ(1u, RefPtr<TestAggregator>::cast_static(aggregator)->get_sink_pads().size());
+  MM_ASSERT_FALSE(aggregator->get_static_pad("sink_7"));
+}
+
+TEST_F(AggregatorTest, LatencyIncludesSubclassAndProperty)
+{
+  // 441 samples at 44.1 kHz: 10 ms of upstream latency.
+  RefPtr<Bin> pipeline = LaunchInputs("audiotestsrc is-live=true samplesperbuffer=441 ! "
+    "audio/x-raw,rate=44100 ! agg.");
+  RefPtr<Element> aggregator = pipeline->get_element("agg");
+  aggregator->set_property<guint64>("latency", 20 * MILLI_SECOND);
+  pipeline->set_state(STATE_PLAYING);
+  State state, pending;
+  ASSERT_EQ(STATE_CHANGE_SUCCESS, pipeline->get_state(state, pending, 10 * SECOND));
+
+  RefPtr<QueryLatency> query = QueryLatency::create();
+  MM_ASSERT_TRUE(aggregator->get_static_pad("src")->query(query));
+
+  bool live = false;
+  ClockTime min_latency = 0, max_latency = 0;
+  query->parse(live, min_latency, max_latency);
+  pipeline->set_state(STATE_NULL);
+
+  MM_ASSERT_TRUE(live);
+  ASSERT_EQ(35 * MILLI_SECOND, min_latency);
+  ASSERT_EQ(CLOCK_TIME_NONE, max_latency);
+}
+
+TEST_F(AggregatorTest, LiveTimeoutSkipsMissingInputs)
+{
+  // The second input never gets data: the live aggregator outputs anyway
+  // once the clock passes the latency.
+  RefPtr<Bin> pipeline = LaunchInputs("audiotestsrc is-live=true samplesperbuffer=441 ! "
+    "audio/x-raw,rate=44100 ! agg.");
+  RefPtr<Element> aggregator = pipeline->get_element("agg");
+  MM_ASSERT_TRUE(aggregator->get_request_pad("sink_%u"));
+
+  ASSERT_EQ(MESSAGE_UNKNOWN, RunToEnd(pipeline, 500 * MILLI_SECOND));
+  ASSERT_LT(10u, buffers);
+  ASSERT_EQ(1u, last_size);
+  ASSERT_LT(0u, RefPtr<TestAggregator>::cast_static(aggregator)->timeouts);
+}
@@ -0,0 +1,89 @@
+/*
+ * test-plugin-loudnessmeter.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "utils.h"
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class LoudnessLevelTest : public PluginPipelineTest
+{
+protected:
+  guint buffers = 0;
+  guint buffers_with_meta = 0;
+  double last_momentary = 0.0;
+  guint messages = 0;
+  double integrated = 0.0;
+
+  static void SetUpTestCase()
+  {
+    RegisterPlugin("mmloudnesslevel", "loudness level", sigc::ptr_fun(&LoudnessLevel::register_element));
+  }
+
+  void OnBuffer(const RefPtr<Pad>&, const RefPtr<Buffer>& buffer) override
+  {
+    ++buffers;
+    LoudnessMeta* meta = LoudnessMeta::get(buffer);
+    if(meta)
+    {
+      ++buffers_with_meta;
+      last_momentary = meta->momentary;
+    }
+  }
+
+  void OnElementMessage(const RefPtr<Message>& message) override
+  {
+    const Structure structure = message->get_structure();
+    EXPECT_EQ("loudness", structure.get_name());
+    EXPECT_TRUE(structure.get_field("integrated", integrated));
+    ++messages;
+  }
+
+  // 2 s of a 1 kHz sine with a peak level of -20 dBFS.
+  RefPtr<Bin> LaunchSine(const Glib::ustring& properties)
+  {
+    return Launch("audiotestsrc num-buffers=20 samplesperbuffer=4800 freq=1000 volume=0.1 ! "
+      "audio/x-raw,format=S16LE,rate=48000,channels=2 ! "
+      "mmloudnesslevel name=level " + properties + " ! fakesink name=sink");
+  }
+};
+
+TEST_F(LoudnessLevelTest, ElementPostsMessagesAndAttachesMeta)
+{
+  RefPtr<Bin> pipeline = LaunchSine("interval=500000000");
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(4u, messages);
+  ASSERT_NEAR(-20.0, integrated, 0.2);
+  ASSERT_EQ(20u, buffers_with_meta);
+  ASSERT_NEAR(-20.0, last_momentary, 0.2);
+}
+
+class LoudnessLevelToggleTest : public LoudnessLevelTest
+{
+protected:
+  RefPtr<Element> level;
+
+  // Attaches the meta from the 11th buffer on.
+  void OnBuffer(const RefPtr<Pad>& pad, const RefPtr<Buffer>& buffer) override
+  {
+    LoudnessLevelTest::OnBuffer(pad, buffer);
+    if(buffers == 10)
+      level->set_property("attach-meta", true);
+  }
+};
+
+TEST_F(LoudnessLevelToggleTest, MetaCanBeAttachedWhilePlaying)
+{
+  RefPtr<Bin> pipeline = LaunchSine("attach-meta=false post-messages=false");
+  level = pipeline->get_element("level");
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(0u, messages);
+  ASSERT_EQ(20u, buffers);
+  ASSERT_EQ(10u, buffers_with_meta);
+}
@@ -0,0 +1,94 @@
+/*
+ * test-plugin-polyphaseresampler.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "utils.h"
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class PolyphaseResampleTest : public PluginPipelineTest
+{
+protected:
+  gsize out_frames = 0;
+  ClockTime next_pts = 0;
+  bool contiguous = true;
+
+  static void SetUpTestCase()
+  {
+    RegisterPlugin("mmpolyphaseresample", "polyphase resampler", sigc::ptr_fun(&PolyphaseResample::register_element));
+  }
+
+  void OnBuffer(const RefPtr<Pad>& pad, const RefPtr<Buffer>& buffer) override
+  {
+    AudioInfo audio_info(pad->get_current_caps());
+    out_frames += buffer->get_size() / audio_info.get_bpf();
+
+    contiguous = contiguous && buffer->get_pts() == next_pts;
+    next_pts = buffer->get_pts() + buffer->get_duration();
+  }
+
+  static PadProbeReturn ClearTimestamps(const RefPtr<Pad>&, const PadProbeInfo& info)
+  {
+    GstPadProbeInfo* probe_info = const_cast<GstPadProbeInfo*>(info.gobj());
+    GstBuffer* buffer = gst_buffer_make_writable(GST_PAD_PROBE_INFO_BUFFER(probe_info));
+    GST_BUFFER_PTS(buffer) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_DURATION(buffer) = GST_CLOCK_TIME_NONE;
+    GST_PAD_PROBE_INFO_DATA(probe_info) = buffer;
+    return PAD_PROBE_OK;
+  }
+
+  // One second of stereo audio at 44.1 kHz, resampled to 48 kHz.
+  RefPtr<Bin> LaunchResample(const Glib::ustring& properties = "")
+  {
+    return Launch("audiotestsrc num-buffers=10 samplesperbuffer=4410 ! "
+      "audio/x-raw,format=" GST_AUDIO_NE(F32) ",rate=44100,channels=2 ! "
+      "mmpolyphaseresample name=resample " + properties + " ! audio/x-raw,rate=48000 ! fakesink name=sink");
+  }
+};
+
+TEST_F(PolyphaseResampleTest, ElementResamplesStream)
+{
+  RefPtr<Bin> pipeline = LaunchResample("quality=6");
+
+  RefPtr<Element> resample = pipeline->get_element("resample");
+  MM_ASSERT_TRUE(resample);
+  int quality = 0;
+  resample->get_property("quality", quality);
+  ASSERT_EQ(6, quality);
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(48000u, out_frames);
+}
+
+TEST_F(PolyphaseResampleTest, ElementKeepsTimelineWithoutTimestamps)
+{
+  RefPtr<Bin> pipeline = LaunchResample();
+  pipeline->get_element("resample")->get_static_pad("sink")->add_probe(PAD_PROBE_TYPE_BUFFER,
+    sigc::ptr_fun(&PolyphaseResampleTest::ClearTimestamps));
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  // A restarted filter would lose its history, and the output length with it.
+  ASSERT_EQ(48000u, out_frames);
+  ASSERT_TRUE(contiguous);
+  ASSERT_EQ(SECOND, next_pts);
+}
+
+TEST_F(PolyphaseResampleTest, FilterDelayIsAddedToLatency)
+{
+  RefPtr<Bin> pipeline = LaunchResample();
+  pipeline->set_state(STATE_PAUSED);
+  State state, pending;
+  ASSERT_EQ(STATE_CHANGE_SUCCESS, pipeline->get_state(state, pending, 10 * SECOND));
+
+  std::shared_ptr<const PolyphaseFilterBank> bank =
+    PolyphaseFilterBank::get(44100, 48000, PolyphaseFilterBank::QUALITY_DEFAULT);
+  RefPtr<QueryLatency> query = QueryLatency::create();
+  MM_ASSERT_TRUE(pipeline->get_element("resample")->get_static_pad("src")->query(query));
+  EXPECT_EQ(gst_util_uint64_scale_int(bank->get_n_taps() / 2, SECOND, 44100), query->parse_min());
+
+  pipeline->set_state(STATE_NULL);
+}
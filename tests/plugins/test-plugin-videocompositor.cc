@@ -0,0 +1,171 @@
+/*
+ * test-plugin-videocompositor.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "utils.h"
+#include <vector>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class VideoCompositorTest : public PluginPipelineTest
+{
+protected:
+  guint frames = 0;
+  // The Y, U and V samples of the last output frame, and their widths.
+  std::vector<guint8> planes[3];
+  int widths[3] = { 0, 0, 0 };
+  guint64 checksum = 0;
+
+  static void SetUpTestCase()
+  {
+    RegisterPlugin("mmvideocompositor", "video compositor", sigc::ptr_fun(&VideoCompositor::register_element));
+  }
+
+  void OnBuffer(const RefPtr<Pad>& pad, const RefPtr<Buffer>& buffer) override
+  {
+    VideoInfo video_info;
+    EXPECT_TRUE(VideoLayout::from_caps(pad->get_current_caps(), video_info));
+
+    VideoFrame frame;
+    EXPECT_TRUE(frame.map(video_info, buffer, MAP_READ));
+
+    checksum = 0;
+    for(guint c = 0; c < 3; ++c)
+    {
+      const ConstVideoPlane component = const_cast<const VideoFrame&>(frame).get_component(c);
+      widths[c] = component.get_width();
+      planes[c].clear();
+      for(int y = 0; y < component.get_height(); ++y)
+      {
+        for(int x = 0; x < component.get_width(); ++x)
+        {
+          planes[c].push_back(*component.get_pixel(x, y));
+          checksum = checksum * 31 + planes[c].back();
+        }
+      }
+    }
+
+    frame.unmap();
+    ++frames;
+  }
+
+  int Sample(guint component, int x, int y) const
+  {
+    return planes[component][y * widths[component] + x];
+  }
+
+  // A black 320x240 background on sink_0 and the layers on the next pads.
+  RefPtr<Bin> LaunchLayers(const Glib::ustring& format, const Glib::ustring& layers)
+  {
+    return Launch("videotestsrc num-buffers=3 pattern=black ! video/x-raw,format=" + format +
+      ",width=320,height=240,framerate=25/1 ! mmvideocompositor name=comp ! fakesink name=sink " + layers);
+  }
+
+  static RefPtr<Pad> GetPad(const RefPtr<Bin>& pipeline, const Glib::ustring& name)
+  {
+    return pipeline->get_element("comp")->get_static_pad(name);
+  }
+};
+
+TEST_F(VideoCompositorTest, LayerIsBlendedAtItsPosition)
+{
+  RefPtr<Bin> pipeline = LaunchLayers("I420", "videotestsrc num-buffers=3 pattern=red ! "
+    "video/x-raw,format=RGBA,width=64,height=32,framerate=25/1 ! comp.");
+  RefPtr<Pad> layer = GetPad(pipeline, "sink_1");
+  layer->set_property("xpos", 33);
+  layer->set_property("ypos", 17);
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(3u, frames);
+
+  // BT.601 red, limited range, on black.
+  EXPECT_NEAR(81, Sample(0, 33, 17), 1);
+  EXPECT_NEAR(81, Sample(0, 96, 48), 1);
+  EXPECT_EQ(16, Sample(0, 32, 17));
+  EXPECT_EQ(16, Sample(0, 97, 17));
+  EXPECT_EQ(16, Sample(0, 40, 16));
+  EXPECT_EQ(16, Sample(0, 40, 49));
+
+  EXPECT_NEAR(90, Sample(1, 20, 10), 1);
+  EXPECT_NEAR(240, Sample(2, 20, 10), 1);
+  EXPECT_EQ(128, Sample(1, 10, 10));
+
+  // A chroma sample covered by one of its four pixels.
+  EXPECT_NEAR(118.5, Sample(1, 16, 8), 1);
+}
+
+TEST_F(VideoCompositorTest, PadAlphaWeightsLayer)
+{
+  RefPtr<Bin> pipeline = LaunchLayers("NV12", "videotestsrc num-buffers=3 pattern=red ! "
+    "video/x-raw,format=RGBA,width=64,height=32,framerate=25/1 ! comp.");
+  GetPad(pipeline, "sink_1")->set_property("alpha", 0.5);
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(3u, frames);
+
+  EXPECT_NEAR(48.6, Sample(0, 10, 10), 1);
+  EXPECT_NEAR(109, Sample(1, 5, 5), 1);
+  EXPECT_EQ(16, Sample(0, 64, 10));
+}
+
+TEST_F(VideoCompositorTest, TransparentTilesAreSkipped)
+{
+  RefPtr<Bin> pipeline = LaunchLayers("I420", "videotestsrc num-buffers=3 pattern=red alpha=0 ! "
+    "video/x-raw,format=RGBA,width=64,height=32,framerate=25/1 ! comp.");
+  RefPtr<VideoCompositor> compositor = RefPtr<VideoCompositor>::cast_dynamic(pipeline->get_element("comp"));
+  ASSERT_TRUE(compositor);
+  compositor->property_tile_size() = 32;
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(3u, frames);
+
+  EXPECT_EQ(16, Sample(0, 10, 10));
+  EXPECT_EQ(0u, compositor->get_blended_tiles());
+  EXPECT_EQ(6u, compositor->get_skipped_tiles());
+}
+
+TEST_F(VideoCompositorTest, ThreadsGiveSameFrames)
+{
+  const Glib::ustring layers =
+    "videotestsrc num-buffers=3 pattern=smpte alpha=0.6 ! "
+    "video/x-raw,format=AYUV,width=200,height=150,framerate=25/1 ! comp. "
+    "videotestsrc num-buffers=3 pattern=circular ! "
+    "video/x-raw,format=RGBA,width=101,height=99,framerate=25/1 ! comp.";
+
+  guint64 checksums[2];
+  for(int i = 0; i < 2; ++i)
+  {
+    RefPtr<Bin> pipeline = LaunchLayers("NV12", layers);
+    RefPtr<VideoCompositor> compositor = RefPtr<VideoCompositor>::cast_dynamic(pipeline->get_element("comp"));
+    compositor->property_threads() = i ? 4 : 1;
+    compositor->property_tile_size() = i ? 16 : 0;
+
+    RefPtr<Pad> first = GetPad(pipeline, "sink_1");
+    first->set_property("xpos", -7);
+    first->set_property("ypos", 13);
+    first->set_property("zorder", 1u);
+    RefPtr<Pad> second = GetPad(pipeline, "sink_2");
+    second->set_property("xpos", 151);
+    second->set_property("ypos", 100);
+
+    ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+    ASSERT_EQ(3u, frames);
+    EXPECT_LT(0u, compositor->get_blended_tiles());
+    checksums[i] = checksum;
+    frames = 0;
+  }
+
+  ASSERT_EQ(checksums[0], checksums[1]);
+}
+
+TEST_F(VideoCompositorTest, SecondBackgroundIsRejected)
+{
+  RefPtr<Bin> pipeline = LaunchLayers("I420", "videotestsrc num-buffers=3 ! "
+    "video/x-raw,format=NV12,width=64,height=32,framerate=25/1 ! comp.");
+
+  ASSERT_EQ(MESSAGE_ERROR, RunToEnd(pipeline));
+}
@@ -0,0 +1,205 @@
+/*
+ * test-plugin-videodecoder.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+// "Decodes" each GRAY8 input frame into a frame filled with its number.
+// Some frames can be made to be dropped, or to fail.
+class TestDecoder : public VideoDecoder
+{
+public:
+  std::atomic<int> running;
+  std::atomic<int> max_running;
+  guint32 drop_modulo = 0;
+  guint32 error_frame = G_MAXUINT32;
+  bool negotiate = true;
+
+  static void class_init(ElementClass<TestDecoder>* klass)
+  {
+    klass->set_metadata("Test decoder", "Codec/Decoder/Video", "Numbers frames", "The gstreamermm Development Team");
+    klass->add_pad_template(PadTemplate::create("sink", PAD_SINK, PAD_ALWAYS,
+      Caps::create_from_string("video/x-raw,format=GRAY8")));
+    klass->add_pad_template(PadTemplate::create("src", PAD_SRC, PAD_ALWAYS,
+      Caps::create_from_string("video/x-raw,format=GRAY8")));
+  }
+
+  static bool register_element(RefPtr<Plugin> plugin)
+  {
+    return ElementFactory::register_element(plugin, "mmtestdecoder", RANK_NONE,
+      register_mm_type<TestDecoder>("gstreamermm__TestDecoder"));
+  }
+
+  explicit TestDecoder(GstVideoDecoder* gobj)
+  : Glib::ObjectBase(typeid (TestDecoder)),
+    VideoDecoder(gobj),
+    running(0),
+    max_running(0)
+  {
+    set_packetized(true);
+  }
+
+protected:
+  bool set_format_vfunc(const RefPtr<VideoCodecState>& state) override
+  {
+    if(negotiate)
+      set_output_state(VIDEO_FORMAT_GRAY8, 8, 8, state);
+    return true;
+  }
+
+  FlowReturn handle_frame_vfunc(const RefPtr<VideoCodecFrame>& frame) override
+  {
+    const bool threaded = get_frame_threads();
+    const guint32 number = frame->get_system_frame_number();
+
+    const int now_running = ++running;
+    int max = max_running;
+    while(now_running > max && !max_running.compare_exchange_weak(max, now_running))
+      ;
+
+    // Each group of four frames completes in reverse order.
+    if(threaded)
+      g_usleep((3 - number % 4) * 2000);
+    --running;
+
+    if(number == error_frame)
+      return FLOW_ERROR;
+
+    if(drop_modulo && number % drop_modulo)
+    {
+      if(threaded)
+      {
+        frame->set_output_buffer(RefPtr<Buffer>());
+        return FLOW_OK;
+      }
+      return drop_frame(frame);
+    }
+
+    if(!threaded)
+    {
+      const FlowReturn result = allocate_output_frame(frame);
+      if(result != FLOW_OK)
+        return result;
+    }
+
+    RefPtr<Buffer> buffer = frame->get_output_buffer();
+    MapInfo map;
+    buffer->map(map, MAP_WRITE);
+    std::fill(map.get_data(), map.get_data() + map.get_size(), static_cast<guint8>(number));
+    buffer->unmap(map);
+
+    return threaded ? FLOW_OK : finish_frame(frame);
+  }
+};
+
+class VideoDecoderTest : public PluginPipelineTest
+{
+protected:
+  std::vector<guint8> values;
+  std::vector<ClockTime> timestamps;
+  std::vector<gint64> output_times;
+  RefPtr<Bin> pipeline;
+  RefPtr<TestDecoder> decoder;
+
+  static void SetUpTestCase()
+  {
+    RegisterPlugin("mmtestdecoder", "test decoder", sigc::ptr_fun(&TestDecoder::register_element));
+  }
+
+  void SetUp() override
+  {
+    LaunchDecoder("videotestsrc num-buffers=20 ! video/x-raw,format=GRAY8,width=8,height=8,framerate=25/1");
+  }
+
+  // Decodes the output of @a source.
+  void LaunchDecoder(const Glib::ustring& source)
+  {
+    pipeline = Launch(source + " ! mmtestdecoder name=dec ! fakesink name=sink");
+    decoder = RefPtr<TestDecoder>::cast_dynamic(pipeline->get_element("dec"));
+    MM_ASSERT_TRUE(decoder);
+  }
+
+  void OnBuffer(const RefPtr<Pad>&, const RefPtr<Buffer>& buffer) override
+  {
+    MapInfo map;
+    buffer->map(map, MAP_READ);
+    values.push_back(map.get_data()[0]);
+    buffer->unmap(map);
+    timestamps.push_back(buffer->get_pts());
+    output_times.push_back(g_get_monotonic_time());
+  }
+
+  void ExpectFramesInOrder(guint count, guint step = 1)
+  {
+    ASSERT_EQ(count, values.size());
+    for(guint i = 0; i < count; ++i)
+    {
+      ASSERT_EQ(i * step, values[i]);
+      ASSERT_EQ(i * step * 40 * MILLI_SECOND, timestamps[i]);
+    }
+  }
+};
+
+TEST_F(VideoDecoderTest, FramesAreDecodedInStreamingThread)
+{
+  ASSERT_EQ(0u, decoder->get_frame_threads());
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ExpectFramesInOrder(20);
+  ASSERT_EQ(1, decoder->max_running.load());
+}
+
+TEST_F(VideoDecoderTest, FrameThreadsFinishFramesInInputOrder)
+{
+  decoder->set_frame_threads(4);
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ExpectFramesInOrder(20);
+  ASSERT_LT(1, decoder->max_running.load());
+}
+
+TEST_F(VideoDecoderTest, FramesWithoutOutputAreDropped)
+{
+  decoder->set_frame_threads(4);
+  decoder->drop_modulo = 2;
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ExpectFramesInOrder(10, 2);
+}
+
+TEST_F(VideoDecoderTest, FrameErrorStopsTheStream)
+{
+  decoder->set_frame_threads(4);
+  decoder->error_frame = 5;
+  ASSERT_EQ(MESSAGE_ERROR, RunToEnd(pipeline));
+  ASSERT_GE(5u, values.size());
+}
+
+TEST_F(VideoDecoderTest, FrameThreadsNeedOutputState)
+{
+  decoder->set_frame_threads(4);
+  decoder->negotiate = false;
+  ASSERT_EQ(MESSAGE_ERROR, RunToEnd(pipeline));
+  ASSERT_TRUE(values.empty());
+}
+
+TEST_F(VideoDecoderTest, FrameThreadsFinishFramesAsTheyComplete)
+{
+  // The second frame comes a second after the first one, which must not
+  // wait for it.
+  LaunchDecoder("videotestsrc is-live=true num-buffers=2 ! "
+    "video/x-raw,format=GRAY8,width=8,height=8,framerate=1/1");
+  decoder->set_frame_threads(4);
+
+  const gint64 start = g_get_monotonic_time();
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(2u, values.size());
+  ASSERT_EQ(0u, values[0]);
+  ASSERT_EQ(1u, values[1]);
+  ASSERT_GT(start + 500 * G_TIME_SPAN_MILLISECOND, output_times[0]);
+}
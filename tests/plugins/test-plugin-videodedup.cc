@@ -0,0 +1,139 @@
+/*
+ * test-plugin-videodedup.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "utils.h"
+#include <vector>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class VideoDedupTest : public PluginPipelineTest
+{
+protected:
+  std::vector<ClockTime> timestamps;
+  std::vector<ClockTime> durations;
+  guint droppable = 0;
+
+  static void SetUpTestCase()
+  {
+    RegisterPlugin("mmvideodedup", "video deduplicator", sigc::ptr_fun(&VideoDedup::register_element));
+  }
+
+  void OnBuffer(const RefPtr<Pad>&, const RefPtr<Buffer>& buffer) override
+  {
+    timestamps.push_back(buffer->get_pts());
+    durations.push_back(buffer->get_duration());
+    if(GST_BUFFER_FLAG_IS_SET(buffer->gobj(), GST_BUFFER_FLAG_DROPPABLE))
+      ++droppable;
+  }
+
+  // Ten frames of 100 ms of @a pattern.
+  RefPtr<Bin> LaunchPattern(const Glib::ustring& pattern, const Glib::ustring& properties = "")
+  {
+    return Launch("videotestsrc num-buffers=10 pattern=" + pattern + " ! "
+      "video/x-raw,format=I420,width=320,height=240,framerate=10/1 ! "
+      "mmvideodedup name=dedup " + properties + " ! fakesink name=sink");
+  }
+
+  static RefPtr<VideoDedup> GetDedup(const RefPtr<Bin>& pipeline)
+  {
+    return RefPtr<VideoDedup>::cast_dynamic(pipeline->get_element("dedup"));
+  }
+};
+
+TEST_F(VideoDedupTest, RepeatsAreDroppedAndDurationExtended)
+{
+  RefPtr<Bin> pipeline = LaunchPattern("red");
+  RefPtr<VideoDedup> dedup = GetDedup(pipeline);
+  ASSERT_TRUE(dedup);
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(1u, timestamps.size());
+  EXPECT_EQ(0u, timestamps[0]);
+  EXPECT_EQ(SECOND, durations[0]);
+  EXPECT_EQ(10u, dedup->get_frames());
+  EXPECT_EQ(9u, dedup->get_repeats());
+}
+
+TEST_F(VideoDedupTest, TagsDoNotEndARun)
+{
+  RefPtr<Bin> pipeline = LaunchPattern("red");
+  guint inputs = 0;
+
+  // Tags arrive in the middle of the repeats.
+  GetDedup(pipeline)->get_static_pad("sink")->add_probe(PAD_PROBE_TYPE_BUFFER,
+    [&inputs](const RefPtr<Pad>& pad, const PadProbeInfo&)
+    {
+      if(++inputs == 5)
+      {
+        TagList tags;
+        tags.add(TAG_TITLE, "Slides");
+        pad->send_event(EventTag::create(tags));
+      }
+      return PAD_PROBE_OK;
+    });
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(1u, timestamps.size());
+  EXPECT_EQ(SECOND, durations[0]);
+}
+
+TEST_F(VideoDedupTest, ChangingFramesArePushed)
+{
+  RefPtr<Bin> pipeline = LaunchPattern("ball");
+  RefPtr<VideoDedup> dedup = GetDedup(pipeline);
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(10u, timestamps.size());
+  for(guint i = 0; i < timestamps.size(); ++i)
+  {
+    EXPECT_EQ(i * 100 * MILLI_SECOND, timestamps[i]);
+    EXPECT_EQ(100 * MILLI_SECOND, durations[i]);
+  }
+  EXPECT_EQ(0u, dedup->get_repeats());
+}
+
+TEST_F(VideoDedupTest, MaxRepeatsForcesFrames)
+{
+  RefPtr<Bin> pipeline = LaunchPattern("red", "max-repeats=3");
+  RefPtr<VideoDedup> dedup = GetDedup(pipeline);
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(3u, timestamps.size());
+  EXPECT_EQ(400 * MILLI_SECOND, timestamps[1]);
+  EXPECT_EQ(800 * MILLI_SECOND, timestamps[2]);
+  EXPECT_EQ(400 * MILLI_SECOND, durations[0]);
+  EXPECT_EQ(400 * MILLI_SECOND, durations[1]);
+  EXPECT_EQ(200 * MILLI_SECOND, durations[2]);
+  EXPECT_EQ(7u, dedup->get_repeats());
+}
+
+TEST_F(VideoDedupTest, RepeatsAreFlaggedWithoutDrop)
+{
+  RefPtr<Bin> pipeline = LaunchPattern("red", "drop=false grid=4");
+  RefPtr<VideoDedup> dedup = GetDedup(pipeline);
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(10u, timestamps.size());
+  EXPECT_EQ(9u, droppable);
+  EXPECT_EQ(100 * MILLI_SECOND, durations[0]);
+  EXPECT_EQ(9u, dedup->get_repeats());
+}
+
+TEST_F(VideoDedupTest, DroppingAddsOneFrameOfLatency)
+{
+  RefPtr<Bin> pipeline = LaunchPattern("ball");
+  pipeline->set_state(STATE_PAUSED);
+  State state, pending;
+  ASSERT_EQ(STATE_CHANGE_SUCCESS, pipeline->get_state(state, pending, 10 * SECOND));
+
+  RefPtr<QueryLatency> query = QueryLatency::create();
+  MM_ASSERT_TRUE(pipeline->get_element("dedup")->get_static_pad("src")->query(query));
+  EXPECT_EQ(100 * MILLI_SECOND, query->parse_min());
+
+  pipeline->set_state(STATE_NULL);
+}
@@ -0,0 +1,140 @@
+/*
+ * test-plugin-videoencoder.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "utils.h"
+#include <atomic>
+#include <cstring>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+// "Encodes" each GRAY8 frame into its number, on four bytes. Every fifth
+// frame is a keyframe, preceded by a two bytes header.
+class TestEncoder : public VideoEncoder
+{
+public:
+  std::atomic<int> running;
+  std::atomic<int> max_running;
+
+  static void class_init(ElementClass<TestEncoder>* klass)
+  {
+    klass->set_metadata("Test encoder", "Codec/Encoder/Video", "Numbers frames", "The gstreamermm Development Team");
+    klass->add_pad_template(PadTemplate::create("sink", PAD_SINK, PAD_ALWAYS,
+      Caps::create_from_string("video/x-raw,format=GRAY8")));
+    klass->add_pad_template(PadTemplate::create("src", PAD_SRC, PAD_ALWAYS,
+      Caps::create_from_string("application/x-mmtest-numbers")));
+  }
+
+  static bool register_element(RefPtr<Plugin> plugin)
+  {
+    return ElementFactory::register_element(plugin, "mmtestencoder", RANK_NONE,
+      register_mm_type<TestEncoder>("gstreamermm__TestEncoder"));
+  }
+
+  explicit TestEncoder(GstVideoEncoder* gobj)
+  : Glib::ObjectBase(typeid (TestEncoder)),
+    VideoEncoder(gobj),
+    running(0),
+    max_running(0)
+  {}
+
+protected:
+  bool set_format_vfunc(const RefPtr<VideoCodecState>& state) override
+  {
+    set_output_state(Caps::create_simple("application/x-mmtest-numbers"), state);
+    set_headers({ Buffer::create(2) });
+    return true;
+  }
+
+  FlowReturn handle_frame_vfunc(const RefPtr<VideoCodecFrame>& frame) override
+  {
+    const bool threaded = get_frame_threads();
+    const guint32 number = frame->get_system_frame_number();
+
+    const int now_running = ++running;
+    int max = max_running;
+    while(now_running > max && !max_running.compare_exchange_weak(max, now_running))
+      ;
+
+    // Each group of four frames completes in reverse order.
+    if(threaded)
+      g_usleep((3 - number % 4) * 2000);
+    --running;
+
+    RefPtr<Buffer> buffer = Buffer::create(sizeof(number));
+    MapInfo map;
+    buffer->map(map, MAP_WRITE);
+    std::memcpy(map.get_data(), &number, sizeof(number));
+    buffer->unmap(map);
+
+    frame->set_output_buffer(buffer);
+    if(number % 5 == 0)
+      frame->set_flag(VIDEO_CODEC_FRAME_FLAG_SYNC_POINT);
+
+    return threaded ? FLOW_OK : finish_frame(frame);
+  }
+};
+
+class VideoEncoderTest : public PluginPipelineTest
+{
+protected:
+  std::vector<guint32> numbers;
+  guint headers = 0;
+  RefPtr<Bin> pipeline;
+  RefPtr<TestEncoder> encoder;
+
+  static void SetUpTestCase()
+  {
+    RegisterPlugin("mmtestencoder", "test encoder", sigc::ptr_fun(&TestEncoder::register_element));
+  }
+
+  void SetUp() override
+  {
+    pipeline = Launch("videotestsrc num-buffers=20 ! video/x-raw,format=GRAY8,width=8,height=8,framerate=25/1 ! "
+      "mmtestencoder name=enc ! fakesink name=sink");
+    encoder = RefPtr<TestEncoder>::cast_dynamic(pipeline->get_element("enc"));
+    MM_ASSERT_TRUE(encoder);
+  }
+
+  void OnBuffer(const RefPtr<Pad>&, const RefPtr<Buffer>& buffer) override
+  {
+    if(buffer->get_size() != sizeof(guint32))
+    {
+      ++headers;
+      return;
+    }
+
+    guint32 number = 0;
+    buffer->extract(0, &number, sizeof(number));
+    numbers.push_back(number);
+  }
+
+  void ExpectFramesInOrder()
+  {
+    ASSERT_EQ(20u, numbers.size());
+    for(guint32 i = 0; i < numbers.size(); ++i)
+      ASSERT_EQ(i, numbers[i]);
+  }
+};
+
+TEST_F(VideoEncoderTest, FramesAreEncodedInStreamingThread)
+{
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ExpectFramesInOrder();
+  ASSERT_EQ(1, encoder->max_running.load());
+  ASSERT_EQ(1u, headers);
+}
+
+TEST_F(VideoEncoderTest, FrameThreadsFinishFramesInInputOrder)
+{
+  encoder->set_frame_threads(4);
+  ASSERT_EQ(4u, encoder->get_frame_threads());
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ExpectFramesInOrder();
+  ASSERT_LT(1, encoder->max_running.load());
+  ASSERT_EQ(1u, headers);
+}
@@ -0,0 +1,232 @@
+/*
+ * test-plugin-videoregionfilter.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "utils.h"
+#include <vector>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+// Adds a "face" and a "plate" region to each frame; the plate goes past
+// the bottom right corner of 64x48 frames.
+class TestRegionMarker : public BaseTransform
+{
+public:
+  static void class_init(ElementClass<TestRegionMarker>* klass)
+  {
+    klass->set_metadata("Test region marker", "Filter/Video", "Adds regions of interest",
+      "The gstreamermm Development Team");
+    klass->add_pad_template(PadTemplate::create("sink", PAD_SINK, PAD_ALWAYS, Caps::create_any()));
+    klass->add_pad_template(PadTemplate::create("src", PAD_SRC, PAD_ALWAYS, Caps::create_any()));
+  }
+
+  explicit TestRegionMarker(GstBaseTransform* gobj)
+  : Glib::ObjectBase(typeid (TestRegionMarker)),
+    BaseTransform(gobj)
+  {
+    set_in_place(true);
+  }
+
+protected:
+  FlowReturn transform_ip_vfunc(const RefPtr<Buffer>& buffer) override
+  {
+    VideoRegionOfInterest::add(buffer, "face", { 8, 4, 16, 8 }, 1);
+    VideoRegionOfInterest::add(buffer, "plate", { 40, 30, 30, 30 }, 2);
+    return FLOW_OK;
+  }
+};
+
+// Fills the regions with white luma and chroma of 200.
+class TestRegionFilter : public VideoRegionFilter
+{
+public:
+  guint regions = 0;
+
+  static void class_init(ElementClass<TestRegionFilter>* klass)
+  {
+    klass->set_metadata("Test region filter", "Filter/Video", "Fills regions of interest",
+      "The gstreamermm Development Team");
+    add_pad_templates(klass, create_caps({ VIDEO_FORMAT_I420, VIDEO_FORMAT_NV12 }));
+  }
+
+  explicit TestRegionFilter(GstBaseTransform* gobj)
+  : Glib::ObjectBase(typeid (TestRegionFilter)),
+    VideoRegionFilter(gobj)
+  {}
+
+protected:
+  FlowReturn transform_region_vfunc(VideoFrame& frame, const VideoRegionOfInterest& region) override
+  {
+    for(guint c = 0; c < 3; ++c)
+    {
+      VideoPlane plane = frame.get_component(c, region.rect);
+      for(guint8* row : plane)
+      {
+        for(int x = 0; x < plane.get_width(); ++x)
+          row[x * plane.get_pixel_stride()] = c ? 200 : 235;
+      }
+    }
+
+    ++regions;
+    return FLOW_OK;
+  }
+};
+
+bool register_elements(RefPtr<Plugin> plugin)
+{
+  return ElementFactory::register_element(plugin, "mmtestregionmarker", RANK_NONE,
+      register_mm_type<TestRegionMarker>("gstreamermm__TestRegionMarker")) &&
+    ElementFactory::register_element(plugin, "mmtestregionfilter", RANK_NONE,
+      register_mm_type<TestRegionFilter>("gstreamermm__TestRegionFilter"));
+}
+
+class VideoRegionFilterTest : public PluginPipelineTest
+{
+protected:
+  // The Y and U samples of the last output frame.
+  std::vector<guint8> planes[2];
+  int widths[2] = { 0, 0 };
+  std::vector<GstBuffer*> inputs;
+  std::vector<GstBuffer*> outputs;
+
+  static void SetUpTestCase()
+  {
+    RegisterPlugin("mmtestregionfilter", "region filter", sigc::ptr_fun(&register_elements));
+  }
+
+  void OnBuffer(const RefPtr<Pad>& pad, const RefPtr<Buffer>& buffer) override
+  {
+    VideoInfo video_info;
+    EXPECT_TRUE(VideoLayout::from_caps(pad->get_current_caps(), video_info));
+
+    VideoFrame frame;
+    EXPECT_TRUE(frame.map(video_info, buffer, MAP_READ));
+    for(guint c = 0; c < 2; ++c)
+    {
+      const ConstVideoPlane component = const_cast<const VideoFrame&>(frame).get_component(c);
+      widths[c] = component.get_width();
+      planes[c].clear();
+      for(const guint8* row : component)
+      {
+        for(int x = 0; x < component.get_width(); ++x)
+          planes[c].push_back(row[x * component.get_pixel_stride()]);
+      }
+    }
+    frame.unmap();
+  }
+
+  PadProbeReturn OnFilterInput(const RefPtr<Pad>&, const PadProbeInfo& info)
+  {
+    inputs.push_back(info.get_buffer()->gobj());
+    return PAD_PROBE_OK;
+  }
+
+  PadProbeReturn OnFilterOutput(const RefPtr<Pad>&, const PadProbeInfo& info)
+  {
+    outputs.push_back(info.get_buffer()->gobj());
+    return PAD_PROBE_OK;
+  }
+
+  int Sample(guint component, int x, int y) const
+  {
+    return planes[component][y * widths[component] + x];
+  }
+
+  RefPtr<Bin> LaunchFormat(const Glib::ustring& format)
+  {
+    return Launch("videotestsrc num-buffers=3 pattern=black ! video/x-raw,format=" + format + ",width=64,height=48 ! "
+      "mmtestregionmarker ! mmtestregionfilter name=filter ! fakesink name=sink");
+  }
+
+  static RefPtr<TestRegionFilter> GetFilter(const RefPtr<Bin>& pipeline)
+  {
+    return RefPtr<TestRegionFilter>::cast_dynamic(pipeline->get_element("filter"));
+  }
+};
+
+TEST_F(VideoRegionFilterTest, RegionsAreReadFromBuffer)
+{
+  RefPtr<Buffer> buffer = Buffer::create(16);
+  VideoRegionOfInterest::add(buffer, "face", { 1, 2, 3, 4 }, 7);
+  VideoRegionOfInterest::add(buffer, "plate", { 5, 6, 7, 8 }, 8, 7);
+
+  std::vector<VideoRegionOfInterest> regions;
+  VideoRegionOfInterest::get_all(buffer, regions);
+  ASSERT_EQ(2u, regions.size());
+  EXPECT_EQ("face", regions[0].get_type_name());
+  EXPECT_EQ(7, regions[0].id);
+  EXPECT_EQ(-1, regions[0].parent_id);
+  EXPECT_EQ(4, regions[0].rect.h);
+  EXPECT_EQ("plate", regions[1].get_type_name());
+  EXPECT_EQ(7, regions[1].parent_id);
+  EXPECT_EQ(5, regions[1].rect.x);
+
+  const std::vector<GQuark> plates = { g_quark_from_static_string("plate") };
+  VideoRegionOfInterest::get_all(buffer, regions, plates);
+  ASSERT_EQ(1u, regions.size());
+  EXPECT_EQ(8, regions[0].id);
+
+  MM_ASSERT_TRUE(VideoRegionOfInterest::has_any(buffer, plates));
+  MM_ASSERT_FALSE(VideoRegionOfInterest::has_any(buffer, { g_quark_from_static_string("ticker") }));
+  MM_ASSERT_FALSE(VideoRegionOfInterest::has_any(Buffer::create(16)));
+}
+
+TEST_F(VideoRegionFilterTest, OnlyRegionsAreProcessed)
+{
+  RefPtr<Bin> pipeline = LaunchFormat("I420");
+  RefPtr<TestRegionFilter> filter = GetFilter(pipeline);
+  ASSERT_TRUE(filter);
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  EXPECT_EQ(6u, filter->regions);
+
+  EXPECT_EQ(235, Sample(0, 8, 4));
+  EXPECT_EQ(235, Sample(0, 23, 11));
+  EXPECT_EQ(16, Sample(0, 24, 11));
+  EXPECT_EQ(16, Sample(0, 7, 4));
+  EXPECT_EQ(16, Sample(0, 8, 12));
+  EXPECT_EQ(200, Sample(1, 4, 2));
+  EXPECT_EQ(200, Sample(1, 11, 5));
+  EXPECT_EQ(128, Sample(1, 12, 5));
+
+  // The plate is clipped to the frame.
+  EXPECT_EQ(235, Sample(0, 63, 47));
+  EXPECT_EQ(16, Sample(0, 39, 30));
+}
+
+TEST_F(VideoRegionFilterTest, RegionTypesSelectRegions)
+{
+  RefPtr<Bin> pipeline = LaunchFormat("NV12");
+  RefPtr<TestRegionFilter> filter = GetFilter(pipeline);
+  filter->property_region_types() = " face ";
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  EXPECT_EQ(3u, filter->regions);
+  EXPECT_EQ(235, Sample(0, 8, 4));
+  EXPECT_EQ(200, Sample(1, 4, 2));
+  EXPECT_EQ(16, Sample(0, 63, 47));
+}
+
+TEST_F(VideoRegionFilterTest, FramesWithoutRegionsAreNotCopied)
+{
+  // The tee shares the frames between its branches.
+  RefPtr<Bin> pipeline = RefPtr<Bin>::cast_dynamic(Parse::launch(
+    "videotestsrc num-buffers=3 ! video/x-raw,format=I420,width=64,height=48 ! tee name=t ! "
+    "queue ! mmtestregionfilter name=filter ! fakesink t. ! queue ! fakesink"));
+  ASSERT_TRUE(pipeline);
+
+  RefPtr<TestRegionFilter> filter = GetFilter(pipeline);
+  filter->get_static_pad("sink")->add_probe(PAD_PROBE_TYPE_BUFFER,
+    sigc::mem_fun(*this, &VideoRegionFilterTest::OnFilterInput));
+  filter->get_static_pad("src")->add_probe(PAD_PROBE_TYPE_BUFFER,
+    sigc::mem_fun(*this, &VideoRegionFilterTest::OnFilterOutput));
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  EXPECT_EQ(0u, filter->regions);
+  ASSERT_EQ(3u, inputs.size());
+  ASSERT_TRUE(inputs == outputs);
+}
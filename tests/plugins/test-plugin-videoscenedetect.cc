@@ -0,0 +1,132 @@
+/*
+ * test-plugin-videoscenedetect.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "utils.h"
+#include <vector>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class VideoSceneDetectTest : public PluginPipelineTest
+{
+protected:
+  guint frames = 0;
+  std::vector<double> motions;
+  std::vector<bool> scene_changes;
+  std::vector<Structure> messages;
+
+  static void SetUpTestCase()
+  {
+    RegisterPlugin("mmvideoscenedetect", "video scene detector", sigc::ptr_fun(&VideoSceneDetect::register_element));
+  }
+
+  void OnBuffer(const RefPtr<Pad>&, const RefPtr<Buffer>& buffer) override
+  {
+    ++frames;
+    VideoMotionMeta* meta = VideoMotionMeta::get(buffer);
+    if(meta)
+    {
+      motions.push_back(meta->motion);
+      scene_changes.push_back(meta->scene_change);
+    }
+  }
+
+  void OnElementMessage(const RefPtr<Message>& message) override
+  {
+    messages.push_back(message->get_structure());
+  }
+
+  // Five frames of 100 ms of @a first followed by five frames of @a second.
+  RefPtr<Bin> LaunchPatterns(const Glib::ustring& first, const Glib::ustring& second,
+    const Glib::ustring& properties = "")
+  {
+    const Glib::ustring caps = "video/x-raw,format=I420,width=320,height=240,framerate=10/1";
+    return Launch("concat name=c ! mmvideoscenedetect name=detect " + properties + " ! fakesink name=sink "
+      "videotestsrc num-buffers=5 pattern=" + first + " ! " + caps + " ! c. "
+      "videotestsrc num-buffers=5 pattern=" + second + " ! " + caps + " ! c.");
+  }
+};
+
+TEST_F(VideoSceneDetectTest, CutIsDetected)
+{
+  RefPtr<Bin> pipeline = LaunchPatterns("smpte", "black");
+  RefPtr<VideoSceneDetect> detect = RefPtr<VideoSceneDetect>::cast_dynamic(pipeline->get_element("detect"));
+  ASSERT_TRUE(detect);
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(10u, frames);
+  ASSERT_EQ(10u, motions.size());
+  for(guint i = 0; i < motions.size(); ++i)
+  {
+    EXPECT_EQ(i == 5, scene_changes[i]);
+    if(i != 5)
+      EXPECT_EQ(0.0, motions[i]);
+  }
+  EXPECT_GT(motions[5], 8.0);
+
+  ASSERT_EQ(1u, messages.size());
+  EXPECT_EQ("scene-change", messages[0].get_name());
+  guint64 running_time = 0;
+  double histogram_delta = 0.0;
+  ASSERT_TRUE(messages[0].get_field("running-time", running_time));
+  ASSERT_TRUE(messages[0].get_field("histogram-delta", histogram_delta));
+  EXPECT_EQ(500 * MILLI_SECOND, running_time);
+  EXPECT_GT(histogram_delta, 0.3);
+  EXPECT_EQ(1u, detect->get_scene_changes());
+}
+
+TEST_F(VideoSceneDetectTest, MotionIsNotASceneChange)
+{
+  RefPtr<Bin> pipeline = LaunchPatterns("ball", "ball");
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  ASSERT_EQ(10u, motions.size());
+  EXPECT_EQ(0.0, motions[0]);
+  for(guint i = 1; i < motions.size(); ++i)
+  {
+    EXPECT_GT(motions[i], 0.0);
+    EXPECT_FALSE(scene_changes[i]);
+  }
+  EXPECT_TRUE(messages.empty());
+}
+
+TEST_F(VideoSceneDetectTest, MetaCanBeDisabled)
+{
+  RefPtr<Bin> pipeline = LaunchPatterns("smpte", "black", "attach-meta=false threshold=0.2");
+  RefPtr<VideoSceneDetect> detect = RefPtr<VideoSceneDetect>::cast_dynamic(pipeline->get_element("detect"));
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  EXPECT_EQ(10u, frames);
+  EXPECT_TRUE(motions.empty());
+  EXPECT_EQ(1u, messages.size());
+  EXPECT_EQ(1u, detect->get_scene_changes());
+}
+
+class VideoSceneDetectToggleTest : public VideoSceneDetectTest
+{
+protected:
+  RefPtr<Element> detect;
+
+  // Attaches the meta from the sixth frame on.
+  void OnBuffer(const RefPtr<Pad>& pad, const RefPtr<Buffer>& buffer) override
+  {
+    VideoSceneDetectTest::OnBuffer(pad, buffer);
+    if(frames == 5)
+      detect->set_property("attach-meta", true);
+  }
+};
+
+TEST_F(VideoSceneDetectToggleTest, MetaCanBeEnabledWhilePlaying)
+{
+  RefPtr<Bin> pipeline = LaunchPatterns("smpte", "black", "attach-meta=false");
+  detect = pipeline->get_element("detect");
+
+  ASSERT_EQ(MESSAGE_EOS, RunToEnd(pipeline));
+  EXPECT_EQ(10u, frames);
+  ASSERT_EQ(5u, motions.size());
+  EXPECT_TRUE(scene_changes[0]);
+}
@@ -0,0 +1,62 @@
+/*
+ * utils.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "utils.h"
+
+using namespace Gst;
+using Glib::RefPtr;
+
+void PluginPipelineTest::RegisterPlugin(const Glib::ustring& name, const Glib::ustring& description,
+  const Plugin::SlotInit& init)
+{
+  Plugin::register_static(GST_VERSION_MAJOR, GST_VERSION_MINOR, name, description, init, "0.123",
+    "LGPL", "source?", "package?", "http://example.com");
+}
+
+RefPtr<Bin> PluginPipelineTest::Launch(const Glib::ustring& description)
+{
+  RefPtr<Bin> pipeline = RefPtr<Bin>::cast_dynamic(Parse::launch(description));
+  EXPECT_TRUE(pipeline);
+
+  pipeline->get_element("sink")->get_static_pad("sink")->add_probe(PAD_PROBE_TYPE_BUFFER,
+    sigc::mem_fun(*this, &PluginPipelineTest::OnProbe));
+  return pipeline;
+}
+
+MessageType PluginPipelineTest::RunToEnd(const RefPtr<Bin>& pipeline, ClockTime timeout)
+{
+  RefPtr<Bus> bus = pipeline->get_bus();
+  pipeline->set_state(STATE_PLAYING);
+
+  MessageType type = MESSAGE_UNKNOWN;
+  while(RefPtr<Message> message = bus->poll(MessageType(MESSAGE_ELEMENT | MESSAGE_EOS | MESSAGE_ERROR),
+    timeout))
+  {
+    type = message->get_message_type();
+    if(type != MESSAGE_ELEMENT)
+      break;
+    OnElementMessage(message);
+    type = MESSAGE_UNKNOWN;
+  }
+
+  pipeline->set_state(STATE_NULL);
+  return type;
+}
+
+void PluginPipelineTest::OnBuffer(const RefPtr<Pad>&, const RefPtr<Buffer>&)
+{
+}
+
+void PluginPipelineTest::OnElementMessage(const RefPtr<Message>&)
+{
+}
+
+PadProbeReturn PluginPipelineTest::OnProbe(const RefPtr<Pad>& pad, const PadProbeInfo& info)
+{
+  OnBuffer(pad, info.get_buffer());
+  return PAD_PROBE_OK;
+}
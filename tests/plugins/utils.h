@@ -0,0 +1,42 @@
+/*
+ * utils.h
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#ifndef TESTS_PLUGINS_UTILS_H_
+#define TESTS_PLUGINS_UTILS_H_
+
+#include "mmtest.h"
+#include <gstreamermm.h>
+
+// A fixture running pipelines built around the elements under test.
+class PluginPipelineTest : public ::testing::Test
+{
+protected:
+  // Registers a static plugin named @a name, whose @a init registers its
+  // elements.
+  static void RegisterPlugin(const Glib::ustring& name, const Glib::ustring& description,
+    const Gst::Plugin::SlotInit& init);
+
+  // Parses @a description; OnBuffer() is called for each buffer reaching
+  // the element named "sink".
+  Glib::RefPtr<Gst::Bin> Launch(const Glib::ustring& description);
+
+  // Plays @a pipeline until EOS or an error, or until no message came for
+  // @a timeout. OnElementMessage() is called for the element messages.
+  //
+  // Returns the type of the last message, or Gst::MESSAGE_UNKNOWN after a
+  // timeout.
+  Gst::MessageType RunToEnd(const Glib::RefPtr<Gst::Bin>& pipeline,
+    Gst::ClockTime timeout = 10 * Gst::SECOND);
+
+  virtual void OnBuffer(const Glib::RefPtr<Gst::Pad>& pad, const Glib::RefPtr<Gst::Buffer>& buffer);
+  virtual void OnElementMessage(const Glib::RefPtr<Gst::Message>& message);
+
+private:
+  Gst::PadProbeReturn OnProbe(const Glib::RefPtr<Gst::Pad>& pad, const Gst::PadProbeInfo& info);
+};
+
+#endif /* TESTS_PLUGINS_UTILS_H_ */
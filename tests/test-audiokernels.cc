@@ -0,0 +1,183 @@
+/*
+ * test-audiokernels.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "mmtest.h"
+#include <gstreamermm.h>
+#include <cmath>
+#include <vector>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class AudioKernelsTest : public ::testing::Test
+{
+protected:
+  // An odd number of stereo frames, so the SIMD kernels also run their
+  // scalar tails.
+  static const gsize frames = 1001;
+
+  std::vector<gint16> s16_a, s16_b;
+  std::vector<float> f32_a, f32_b;
+
+  void SetUp() override
+  {
+    for(gsize i = 0; i < frames * 2; ++i)
+    {
+      // Out of range floats test the clipping.
+      f32_a.push_back(1.2f * std::sin(i * 0.05f));
+      f32_b.push_back(0.9f * std::cos(i * 0.03f));
+      s16_a.push_back(static_cast<gint16>(32767 * std::sin(i * 0.07f)));
+      s16_b.push_back(static_cast<gint16>(-20000 * std::cos(i * 0.02f)));
+    }
+    s16_a[3] = -32768;
+  }
+
+  template<typename T>
+  void CheckSameAsScalar(AudioFormat format, const std::vector<T>& a, const std::vector<T>& b,
+    AudioKernelsIsa isa)
+  {
+    AudioKernels scalar(format, 2, AUDIO_KERNELS_ISA_SCALAR);
+    AudioKernels simd(format, 2, isa);
+    ASSERT_EQ(isa, simd.get_isa());
+
+    std::vector<T> expected = a, actual = a;
+    scalar.apply_gain(expected.data(), frames, 1.7);
+    simd.apply_gain(actual.data(), frames, 1.7);
+    ASSERT_TRUE(expected == actual);
+
+    const gconstpointer sources[] = { a.data(), b.data(), a.data() };
+    scalar.mix(expected.data(), sources, 3, frames);
+    simd.mix(actual.data(), sources, 3, frames);
+    ASSERT_TRUE(expected == actual);
+
+    const AudioFormat other = format == AUDIO_FORMAT_S16 ? AUDIO_FORMAT_F32 : AUDIO_FORMAT_S16;
+    std::vector<guint8> expected_converted(frames * 2 * 4), actual_converted(frames * 2 * 4);
+    scalar.convert(a.data(), other, expected_converted.data(), frames);
+    simd.convert(a.data(), other, actual_converted.data(), frames);
+    ASSERT_TRUE(expected_converted == actual_converted);
+
+    double expected_peak, expected_rms, actual_peak, actual_rms;
+    scalar.measure(a.data(), frames, expected_peak, expected_rms);
+    simd.measure(a.data(), frames, actual_peak, actual_rms);
+    ASSERT_EQ(expected_peak, actual_peak);
+    ASSERT_NEAR(expected_rms, actual_rms, 1e-9);
+  }
+};
+
+TEST_F(AudioKernelsTest, SimdKernelsMatchScalarKernels)
+{
+  const AudioKernelsIsa isas[] = {
+    AUDIO_KERNELS_ISA_SSE2, AUDIO_KERNELS_ISA_AVX2, AUDIO_KERNELS_ISA_NEON
+  };
+
+  for(AudioKernelsIsa isa : isas)
+  {
+    if(!AudioKernels::is_isa_supported(isa))
+      continue;
+
+    SCOPED_TRACE(AudioKernels::get_isa_name(isa));
+    CheckSameAsScalar(AUDIO_FORMAT_S16, s16_a, s16_b, isa);
+    CheckSameAsScalar(AUDIO_FORMAT_F32, f32_a, f32_b, isa);
+  }
+}
+
+TEST_F(AudioKernelsTest, IntegerSamplesSaturate)
+{
+  AudioKernels kernels(AUDIO_FORMAT_S16, 1);
+  std::vector<gint16> samples = { 30000, -30000, 100 };
+
+  kernels.apply_gain(samples.data(), samples.size(), 2.0);
+  ASSERT_EQ(32767, samples[0]);
+  ASSERT_EQ(-32768, samples[1]);
+  ASSERT_EQ(200, samples[2]);
+
+  // The sum is clipped once, not after each addition.
+  const gint16 a[] = { 30000 }, b[] = { 30000 }, c[] = { -30000 };
+  const gconstpointer sources[] = { a, b, c };
+  gint16 mixed = 0;
+  kernels.mix(&mixed, sources, 3, 1);
+  ASSERT_EQ(30000, mixed);
+}
+
+TEST_F(AudioKernelsTest, ConversionsRoundTrip)
+{
+  AudioKernels kernels(AUDIO_FORMAT_S16, 2);
+  std::vector<float> f32(frames * 2);
+  std::vector<double> f64(frames * 2);
+  std::vector<gint32> s32(frames * 2);
+  std::vector<gint16> s16(frames * 2);
+
+  kernels.convert(s16_a.data(), AUDIO_FORMAT_F32, f32.data(), frames);
+  AudioKernels(AUDIO_FORMAT_F32, 2).convert(f32.data(), AUDIO_FORMAT_F64, f64.data(), frames);
+  AudioKernels(AUDIO_FORMAT_F64, 2).convert(f64.data(), AUDIO_FORMAT_S32, s32.data(), frames);
+  AudioKernels(AUDIO_FORMAT_S32, 2).convert(s32.data(), AUDIO_FORMAT_S16, s16.data(), frames);
+
+  ASSERT_TRUE(s16 == s16_a);
+  ASSERT_EQ(G_MININT32, s32[3]);
+}
+
+TEST_F(AudioKernelsTest, InterleaveRestoresDeinterleavedSamples)
+{
+  AudioKernels kernels(AUDIO_FORMAT_F32, 2);
+  std::vector<float> left(frames), right(frames), interleaved(frames * 2);
+  const gpointer planes[] = { left.data(), right.data() };
+  const gconstpointer const_planes[] = { left.data(), right.data() };
+
+  kernels.deinterleave(f32_a.data(), planes, frames);
+  ASSERT_EQ(f32_a[2], left[1]);
+  ASSERT_EQ(f32_a[3], right[1]);
+
+  kernels.interleave(const_planes, interleaved.data(), frames);
+  ASSERT_TRUE(interleaved == f32_a);
+}
+
+TEST_F(AudioKernelsTest, MeasureReportsNormalizedLevels)
+{
+  // A full scale square wave on the left, silence on the right.
+  std::vector<gint16> samples;
+  for(int i = 0; i < 100; ++i)
+  {
+    samples.push_back(i % 2 ? -32768 : 32767);
+    samples.push_back(0);
+  }
+
+  AudioKernels kernels(AUDIO_FORMAT_S16, 2);
+  double peak, rms;
+  kernels.measure(samples.data(), 100, peak, rms);
+  ASSERT_DOUBLE_EQ(1.0, peak);
+  ASSERT_NEAR(std::sqrt(0.5), rms, 1e-4);
+
+  double peaks[2], levels[2];
+  kernels.measure_channels(samples.data(), 100, peaks, levels);
+  ASSERT_DOUBLE_EQ(1.0, peaks[0]);
+  ASSERT_NEAR(1.0, levels[0], 1e-4);
+  ASSERT_EQ(0.0, peaks[1]);
+  ASSERT_EQ(0.0, levels[1]);
+}
+
+TEST_F(AudioKernelsTest, KernelsAreSelectedFromAudioInfo)
+{
+  RefPtr<Caps> caps = Caps::create_simple("audio/x-raw",
+    "format", Glib::ustring(GST_AUDIO_NE(F32)), "layout", Glib::ustring("interleaved"),
+    "rate", 48000, "channels", 2);
+  AudioInfo info(caps);
+
+  AudioKernels kernels(info);
+  ASSERT_EQ(AUDIO_FORMAT_F32, kernels.get_format());
+  ASSERT_EQ(2, kernels.get_channels());
+  ASSERT_EQ(AudioKernels::get_best_isa(), kernels.get_isa());
+}
+
+TEST_F(AudioKernelsTest, UnsupportedFormatsThrow)
+{
+  ASSERT_FALSE(AudioKernels::is_format_supported(AUDIO_FORMAT_U8));
+  EXPECT_THROW(AudioKernels(AUDIO_FORMAT_U8, 2), std::runtime_error);
+
+  AudioKernels kernels(AUDIO_FORMAT_F32, 2);
+  guint8 dest[8];
+  EXPECT_THROW(kernels.convert(f32_a.data(), AUDIO_FORMAT_U8, dest, 1), std::runtime_error);
+}
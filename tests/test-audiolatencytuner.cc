@@ -0,0 +1,223 @@
+/*
+ * test-audiolatencytuner.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "mmtest.h"
+#include <gstreamermm.h>
+#include <vector>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class AudioLatencyTunerTest : public ::testing::Test
+{
+protected:
+  static const int rate = 48000;
+
+  AudioLatencyTuner tuner;
+  RefPtr<CallbackAudioRingBuffer> ring_buffer;
+
+  // The fake backend: a device which consumes or produces the frames at the
+  // nominal rate of its clock, and whose calls complete late every
+  // late_period calls.
+  ClockTime now = 0;
+  guint calls = 0;
+  guint late_period = 0;
+  ClockTime late_by = 0;
+
+  AudioLatencyTunerTest()
+  : tuner(20 * MILLI_SECOND)
+  {}
+
+  ClockTime OnClock()
+  {
+    return now;
+  }
+
+  int OnIO(guint8*, guint length)
+  {
+    now += gst_util_uint64_scale(length / sizeof(gint16), GST_SECOND, rate);
+
+    // A late call is followed by one catching up.
+    if(late_period && calls % late_period == late_period - 1)
+      now += late_by;
+    else if(late_period && calls && calls % late_period == 0)
+      now -= late_by;
+
+    ++calls;
+    return length;
+  }
+
+  // 2 ms of frames queued in the device.
+  guint OnDelay()
+  {
+    return rate / 500;
+  }
+
+  void Attach(AudioRingBufferDirection direction)
+  {
+    ring_buffer = CallbackAudioRingBuffer::create(direction, false);
+    tuner.set_clock_slot(sigc::mem_fun(*this, &AudioLatencyTunerTest::OnClock));
+    tuner.attach(ring_buffer, sigc::mem_fun(*this, &AudioLatencyTunerTest::OnIO),
+      CallbackAudioRingBuffer::SlotPrepare(), CallbackAudioRingBuffer::SlotDevice(),
+      sigc::mem_fun(*this, &AudioLatencyTunerTest::OnDelay));
+  }
+
+  // Acquires 48 kHz mono S16 audio and starts the ring buffer, like the
+  // audio base classes do.
+  AudioRingBufferSpec Start()
+  {
+    RefPtr<Caps> caps = Caps::create_simple("audio/x-raw",
+      "format", Glib::ustring(GST_AUDIO_NE(S16)), "layout", Glib::ustring("interleaved"),
+      "rate", rate, "channels", 1);
+
+    AudioRingBufferSpec spec(ring_buffer->gobj()->spec);
+    EXPECT_TRUE(AudioRingBuffer::parse_caps(spec, caps));
+    EXPECT_TRUE(ring_buffer->open_device());
+    EXPECT_TRUE(ring_buffer->acquire(spec));
+    EXPECT_TRUE(ring_buffer->activate(true));
+    ring_buffer->set_may_start(true);
+    EXPECT_TRUE(ring_buffer->start());
+    return spec;
+  }
+
+  void Stop()
+  {
+    ring_buffer->stop();
+    ring_buffer->release();
+    ring_buffer->close_device();
+  }
+
+  // Commits one segment before the device plays it, like a sink keeping
+  // up, and lets the device play it.
+  void Play(guint segments)
+  {
+    const int frames = ring_buffer->gobj()->samples_per_seg;
+    std::vector<gint16> samples(frames, 1000);
+
+    for(guint i = 0; i < segments; ++i)
+    {
+      guint64 sample = ring_buffer->get_samples_done();
+      int accum = 0;
+      ASSERT_EQ(static_cast<guint>(frames), ring_buffer->commit(sample, samples.data(), frames, frames, accum));
+      MM_ASSERT_TRUE(ring_buffer->process());
+    }
+  }
+};
+
+TEST_F(AudioLatencyTunerTest, InitialLayoutMeetsTarget)
+{
+  Attach(AUDIO_RING_BUFFER_PLAYBACK);
+  AudioRingBufferSpec spec = Start();
+
+  // 20 ms minus the 2 ms of the device, in two segments.
+  EXPECT_EQ(9 * 48 * 2, spec.get_segsize());
+  EXPECT_EQ(2, spec.get_segtotal());
+  EXPECT_EQ(2, spec.get_seglatency());
+  EXPECT_EQ(9000u, spec.get_latency_time());
+  EXPECT_EQ(18000u, spec.get_buffer_time());
+
+  EXPECT_EQ(2 * MILLI_SECOND, tuner.get_device_latency());
+  EXPECT_EQ(20 * MILLI_SECOND, tuner.get_latency());
+  MM_ASSERT_TRUE(tuner.is_target_met());
+  MM_ASSERT_FALSE(tuner.is_calibrated());
+  MM_ASSERT_FALSE(tuner.needs_retune());
+
+  Stop();
+  EXPECT_EQ(0, tuner.get_segments());
+}
+
+TEST_F(AudioLatencyTunerTest, MeasuredJitterSplitsSegments)
+{
+  Attach(AUDIO_RING_BUFFER_PLAYBACK);
+  tuner.set_measure_periods(20);
+  Start();
+
+  late_period = 5;
+  late_by = 8 * MILLI_SECOND;
+  Play(20);
+
+  MM_ASSERT_TRUE(tuner.is_calibrated());
+  EXPECT_EQ(8 * MILLI_SECOND, tuner.get_jitter());
+  EXPECT_EQ(0u, ring_buffer->get_underruns());
+  MM_ASSERT_TRUE(tuner.needs_retune());
+  Stop();
+
+  // 12 ms of headroom still fit in 18 ms, with three segments of 6 ms.
+  AudioRingBufferSpec spec = Start();
+  EXPECT_EQ(6 * 48 * 2, spec.get_segsize());
+  EXPECT_EQ(3, spec.get_segtotal());
+  EXPECT_EQ(6 * MILLI_SECOND, tuner.get_segment_time());
+  EXPECT_EQ(20 * MILLI_SECOND, tuner.get_latency());
+  MM_ASSERT_TRUE(tuner.is_target_met());
+  MM_ASSERT_FALSE(tuner.needs_retune());
+
+  Stop();
+}
+
+TEST_F(AudioLatencyTunerTest, XrunsGrowLatency)
+{
+  Attach(AUDIO_RING_BUFFER_PLAYBACK);
+  tuner.set_measure_periods(10);
+  Start();
+
+  // Nothing is committed: every segment underruns.
+  for(int i = 0; i < 10; ++i)
+    MM_ASSERT_TRUE(ring_buffer->process());
+
+  EXPECT_EQ(10u, ring_buffer->get_underruns());
+  EXPECT_EQ(0u, tuner.get_jitter());
+  MM_ASSERT_TRUE(tuner.needs_retune());
+  Stop();
+
+  // One more segment of 9 ms, beyond the target.
+  AudioRingBufferSpec spec = Start();
+  EXPECT_EQ(9 * 48 * 2, spec.get_segsize());
+  EXPECT_EQ(3, spec.get_segtotal());
+  EXPECT_EQ(29 * MILLI_SECOND, tuner.get_latency());
+  MM_ASSERT_FALSE(tuner.is_target_met());
+
+  tuner.reset();
+  MM_ASSERT_TRUE(tuner.needs_retune());
+  Stop();
+}
+
+TEST_F(AudioLatencyTunerTest, CaptureLatencyIsOneSegment)
+{
+  Attach(AUDIO_RING_BUFFER_CAPTURE);
+  AudioRingBufferSpec spec = Start();
+
+  EXPECT_EQ(18 * 48 * 2, spec.get_segsize());
+  EXPECT_EQ(2, spec.get_segtotal());
+  EXPECT_EQ(20 * MILLI_SECOND, tuner.get_latency());
+  EXPECT_EQ(38 * MILLI_SECOND, tuner.get_max_latency());
+
+  Stop();
+}
+
+TEST_F(AudioLatencyTunerTest, LatencyIsAddedToQuery)
+{
+  Attach(AUDIO_RING_BUFFER_PLAYBACK);
+  Start();
+
+  RefPtr<QueryLatency> query = QueryLatency::create();
+  query->set(false, 5 * MILLI_SECOND, 50 * MILLI_SECOND);
+  tuner.add_to_query(query);
+
+  bool live = false;
+  ClockTime min_latency = 0, max_latency = 0;
+  query->parse(live, min_latency, max_latency);
+  MM_ASSERT_TRUE(live);
+  EXPECT_EQ(25 * MILLI_SECOND, min_latency);
+  EXPECT_EQ(70 * MILLI_SECOND, max_latency);
+
+  query->set(true, 0, CLOCK_TIME_NONE);
+  tuner.add_to_query(query);
+  EXPECT_EQ(20 * MILLI_SECOND, query->parse_min());
+  EXPECT_EQ(CLOCK_TIME_NONE, query->parse_max());
+
+  Stop();
+}
@@ -0,0 +1,93 @@
+/*
+ * test-binaryformat.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "mmtest.h"
+#include <gstreamermm.h>
+
+using namespace Gst;
+
+TEST(BinaryFormatTest, EncodeAndDecodeStructure)
+{
+  Structure structure("test-struct", "int", 42, "string", std::string("sample"),
+    "fraction", Fraction(30000, 1001), "range", Range<int>(8000, 48000));
+  structure.set_field("double", -0.25);
+  structure.set_field("int64", G_GINT64_CONSTANT(-1) << 40);
+
+  std::vector<guint8> data = BinaryEncoder::encode_to_vector(structure);
+
+  BinaryDecoder decoder(data.data(), data.size());
+  Structure decoded = decoder.decode_structure();
+  MM_ASSERT_TRUE(decoder.at_end());
+  MM_ASSERT_TRUE(decoded.is_equal(structure));
+}
+
+TEST(BinaryFormatTest, EncodeIntoTooSmallBuffer)
+{
+  Structure structure("test-struct", "string", std::string("a longer sample string"));
+
+  guint8 buffer[8];
+  BinaryEncoder encoder(buffer, sizeof(buffer));
+  encoder.encode(structure);
+  MM_ASSERT_FALSE(encoder.is_complete());
+
+  std::vector<guint8> data(encoder.get_size());
+  BinaryEncoder retry(data.data(), data.size());
+  retry.encode(structure);
+  MM_ASSERT_TRUE(retry.is_complete());
+  EXPECT_EQ(data.size(), retry.get_size());
+}
+
+TEST(BinaryFormatTest, DecodeWithBorrowedStrings)
+{
+  Structure structure("test-struct", "string", std::string("borrowed"));
+  std::vector<guint8> data = BinaryEncoder::encode_to_vector(structure);
+
+  BinaryDecoder decoder(data.data(), data.size(), BINARY_DECODE_BORROW_STRINGS);
+  Structure decoded = decoder.decode_structure();
+
+  const gchar* str = gst_structure_get_string(decoded.gobj(), "string");
+  ASSERT_STREQ("borrowed", str);
+  MM_ASSERT_TRUE(reinterpret_cast<const guint8*>(str) >= data.data());
+  MM_ASSERT_TRUE(reinterpret_cast<const guint8*>(str) < data.data() + data.size());
+}
+
+TEST(BinaryFormatTest, EncodeAndDecodeCaps)
+{
+  Glib::RefPtr<Caps> caps = Caps::create_from_string(
+    "video/x-raw, format=(string){ I420, NV12 }, width=(int)[ 16, 4096 ]; "
+    "audio/x-raw(memory:GLMemory), rate=(int)44100");
+
+  std::vector<guint8> data = BinaryEncoder::encode_to_vector(caps);
+  BinaryDecoder decoder(data.data(), data.size());
+  Glib::RefPtr<Caps> decoded = decoder.decode_caps();
+
+  MM_ASSERT_TRUE(decoded->is_strictly_equal(caps));
+}
+
+TEST(BinaryFormatTest, EncodeAndDecodeTagList)
+{
+  TagList tag_list;
+  tag_list.add(TAG_TITLE, "Funky Song");
+  tag_list.add(TAG_ARTIST, "First Artist");
+  tag_list.add(TAG_ARTIST, "Second Artist", TAG_MERGE_APPEND);
+  tag_list.add(TAG_DURATION, guint64(120));
+
+  std::vector<guint8> data = BinaryEncoder::encode_to_vector(tag_list);
+  BinaryDecoder decoder(data.data(), data.size());
+  TagList decoded = decoder.decode_taglist();
+
+  MM_ASSERT_TRUE(gst_tag_list_is_equal(decoded.gobj(), tag_list.gobj()));
+}
+
+TEST(BinaryFormatTest, RejectTruncatedData)
+{
+  Structure structure("test-struct", "int", 42);
+  std::vector<guint8> data = BinaryEncoder::encode_to_vector(structure);
+
+  BinaryDecoder decoder(data.data(), data.size() - 1);
+  EXPECT_THROW(decoder.decode_structure(), std::runtime_error);
+}
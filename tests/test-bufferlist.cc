@@ -21,3 +21,19 @@ TEST(BufferTest, BufferShouldBeReleasedAfterAddToAList)
   buff = list->get(0);
   MM_ASSERT_TRUE(buff == buff2);
 }
+
+static bool CheckBorrowedBuffer(BorrowedRef<Buffer> buffer, guint /* idx */)
+{
+  EXPECT_EQ(2, buffer->get_refcount()); // one held by the list, one by the test
+  return true;
+}
+
+TEST(BufferTest, ForeachBorrowedDoesNotTakeReferences)
+{
+  Glib::RefPtr<Gst::BufferList> list = Gst::BufferList::create();
+  Glib::RefPtr<Gst::Buffer> buff = Gst::Buffer::create();
+  list->insert(0, buff);
+
+  list->foreach_borrowed(sigc::ptr_fun(&CheckBorrowedBuffer));
+  ASSERT_EQ(2, buff->get_refcount());
+}
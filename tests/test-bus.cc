@@ -27,6 +27,16 @@ protected:
     bool have_pending = bus->have_pending();
     EXPECT_EQ(expected, have_pending);
   }
+
+  gint borrowed_message_refcount = 0;
+  gint borrowed_bus_refcount = 0;
+
+  BusSyncReply OnBorrowedSyncMessage(BorrowedRef<Bus> sync_bus, BorrowedRef<Message> sync_message)
+  {
+    borrowed_bus_refcount = G_OBJECT(sync_bus->gobj())->ref_count;
+    borrowed_message_refcount = sync_message->get_refcount();
+    return BUS_DROP;
+  }
 };
 
 TEST_F(BusTest, CorrectCreateBus)
@@ -61,3 +71,16 @@ TEST_F(BusTest, PostMessageAndPopIt)
 
   CheckPending(false);
 }
+
+TEST_F(BusTest, BorrowedSyncHandlerDoesNotTakeReferences)
+{
+  bus = Bus::create();
+  gint bus_refcount = G_OBJECT(bus->gobj())->ref_count;
+
+  bus->set_sync_handler_borrowed(sigc::mem_fun(*this, &BusTest::OnBorrowedSyncMessage));
+  PostMessage();
+
+  EXPECT_EQ(1, borrowed_message_refcount);
+  EXPECT_EQ(bus_refcount, borrowed_bus_refcount);
+  CheckPending(false);
+}
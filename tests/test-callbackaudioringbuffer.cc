@@ -0,0 +1,178 @@
+/*
+ * test-callbackaudioringbuffer.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "mmtest.h"
+#include <gstreamermm.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class CallbackAudioRingBufferTest : public ::testing::Test
+{
+protected:
+  RefPtr<CallbackAudioRingBuffer> ring_buffer;
+  std::vector<guint8> played;
+
+  int OnIO(guint8* data, guint length)
+  {
+    played.assign(data, data + length);
+    return length;
+  }
+
+  // Reads at most half a segment of 48 bytes.
+  int OnShortRead(guint8* data, guint length)
+  {
+    const guint done = std::min(length, 48u);
+    std::fill(data, data + done, 0x11);
+    return done;
+  }
+
+  int OnFailedRead(guint8* data, guint)
+  {
+    data[0] = 0x11;
+    return -1;
+  }
+
+  // Configures 48 kHz mono S16 audio in 1 ms segments, like the audio base
+  // classes do, and starts the ring buffer.
+  void Start()
+  {
+    RefPtr<Caps> caps = Caps::create_simple("audio/x-raw",
+      "format", Glib::ustring(GST_AUDIO_NE(S16)), "layout", Glib::ustring("interleaved"),
+      "rate", 48000, "channels", 1);
+
+    GstAudioRingBufferSpec* c_spec = &ring_buffer->gobj()->spec;
+    gst_caps_replace(&c_spec->caps, caps->gobj());
+    c_spec->latency_time = 1000;
+    c_spec->buffer_time = 4000;
+
+    AudioRingBufferSpec spec(*c_spec);
+    MM_ASSERT_TRUE(AudioRingBuffer::parse_caps(spec, caps));
+    MM_ASSERT_TRUE(ring_buffer->open_device());
+    MM_ASSERT_TRUE(ring_buffer->acquire(spec));
+    MM_ASSERT_TRUE(ring_buffer->activate(true));
+    ring_buffer->set_may_start(true);
+    MM_ASSERT_TRUE(ring_buffer->start());
+  }
+
+  void Stop()
+  {
+    ring_buffer->stop();
+    ring_buffer->release();
+    ring_buffer->close_device();
+  }
+};
+
+TEST_F(CallbackAudioRingBufferTest, ProcessHandsCommittedSegmentsToTheDevice)
+{
+  ring_buffer = CallbackAudioRingBuffer::create(AUDIO_RING_BUFFER_PLAYBACK, false);
+  ring_buffer->set_io_slot(sigc::mem_fun(*this, &CallbackAudioRingBufferTest::OnIO));
+  Start();
+
+  std::vector<gint16> samples(48, 1000);
+  guint64 sample = 0;
+  int accum = 0;
+  ASSERT_EQ(48u, ring_buffer->commit(sample, samples.data(), 48, 48, accum));
+
+  MM_ASSERT_TRUE(ring_buffer->process());
+  ASSERT_EQ(samples.size() * sizeof(gint16), played.size());
+  EXPECT_EQ(1000, reinterpret_cast<const gint16*>(played.data())[47]);
+  EXPECT_EQ(0u, ring_buffer->get_underruns());
+  EXPECT_EQ(48u, ring_buffer->get_samples_done());
+
+  // Nothing was committed for the second segment.
+  MM_ASSERT_TRUE(ring_buffer->process());
+  EXPECT_EQ(0, reinterpret_cast<const gint16*>(played.data())[0]);
+  EXPECT_EQ(1u, ring_buffer->get_underruns());
+  EXPECT_EQ(0u, ring_buffer->get_device_xruns());
+
+  Stop();
+  MM_ASSERT_FALSE(ring_buffer->process());
+}
+
+TEST_F(CallbackAudioRingBufferTest, ShortDeviceReadsAreContinued)
+{
+  ring_buffer = CallbackAudioRingBuffer::create(AUDIO_RING_BUFFER_CAPTURE, false);
+  ring_buffer->set_io_slot(sigc::mem_fun(*this, &CallbackAudioRingBufferTest::OnShortRead));
+  Start();
+
+  MM_ASSERT_TRUE(ring_buffer->process());
+  EXPECT_EQ(0u, ring_buffer->get_samples_done());
+
+  MM_ASSERT_TRUE(ring_buffer->process());
+  EXPECT_EQ(48u, ring_buffer->get_samples_done());
+  EXPECT_EQ(0u, ring_buffer->get_device_xruns());
+
+  std::vector<gint16> samples(48, -1);
+  ClockTime timestamp = CLOCK_TIME_NONE;
+  ASSERT_EQ(48u, ring_buffer->read(0, samples.data(), 48, timestamp));
+  EXPECT_EQ(0x1111, samples[0]);
+  EXPECT_EQ(0x1111, samples[47]);
+
+  Stop();
+}
+
+TEST_F(CallbackAudioRingBufferTest, FailedDeviceReadsAreCountedAndSilenced)
+{
+  ring_buffer = CallbackAudioRingBuffer::create(AUDIO_RING_BUFFER_CAPTURE, false);
+  ring_buffer->set_io_slot(sigc::mem_fun(*this, &CallbackAudioRingBufferTest::OnFailedRead));
+  Start();
+
+  MM_ASSERT_TRUE(ring_buffer->process());
+  EXPECT_EQ(1u, ring_buffer->get_device_xruns());
+  EXPECT_EQ(48u, ring_buffer->get_samples_done());
+
+  std::vector<gint16> samples(48, -1);
+  ClockTime timestamp = CLOCK_TIME_NONE;
+  ASSERT_EQ(48u, ring_buffer->read(0, samples.data(), 48, timestamp));
+  EXPECT_EQ(0, samples[0]);
+
+  ring_buffer->reset_xruns();
+  EXPECT_EQ(0u, ring_buffer->get_device_xruns());
+
+  Stop();
+}
+
+TEST_F(CallbackAudioRingBufferTest, CommittedPeriodsAreBatched)
+{
+  ring_buffer = CallbackAudioRingBuffer::create(AUDIO_RING_BUFFER_PLAYBACK, false);
+  ring_buffer->set_io_slot(sigc::mem_fun(*this, &CallbackAudioRingBufferTest::OnIO));
+  ring_buffer->set_max_periods(8);
+  Start();
+
+  std::vector<gint16> samples(3 * 48, 1000);
+  guint64 sample = 0;
+  int accum = 0;
+  ASSERT_EQ(3u * 48, ring_buffer->commit(sample, samples.data(), 3 * 48, 3 * 48, accum));
+
+  // Three committed periods in one call, the fourth one is not ready.
+  MM_ASSERT_TRUE(ring_buffer->process());
+  EXPECT_EQ(samples.size() * sizeof(gint16), played.size());
+  EXPECT_EQ(3u * 48, ring_buffer->get_samples_done());
+  EXPECT_EQ(0u, ring_buffer->get_underruns());
+
+  Stop();
+}
+
+TEST_F(CallbackAudioRingBufferTest, DeviceThreadWithoutIOSlotRunsInRealTime)
+{
+  ring_buffer = CallbackAudioRingBuffer::create(AUDIO_RING_BUFFER_CAPTURE);
+  Start();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // About 20 segments of 48 samples, far from a busy loop.
+  const guint64 done = ring_buffer->get_samples_done();
+  EXPECT_GT(done, 0u);
+  EXPECT_LT(done, 100u * 48);
+
+  Stop();
+}
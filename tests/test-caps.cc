@@ -62,6 +62,19 @@ TEST_F(CapsTest, CapsCreateUsingStructure)
   CheckCaps("framerate", framerate);
 }
 
+TEST_F(CapsTest, CapsCreateByMovingStructure)
+{
+  Structure caps_struct("test-struct");
+  caps_struct.set_field("width", width);
+  const GstStructure* c_struct = caps_struct.gobj();
+
+  caps = Caps::create(std::move(caps_struct));
+
+  MM_ASSERT_FALSE(caps_struct);
+  ASSERT_EQ(c_struct, gst_caps_get_structure(caps->gobj(), 0));
+  CheckCaps("width", width);
+}
+
 TEST_F(CapsTest, AppendStructureToCaps)
 {
   caps = Caps::create_simple("video/x-raw");
@@ -187,3 +200,70 @@ TEST_F(CapsTest, CreateWithManyCustomTypeParameters)
   ASSERT_STREQ("dummy3", d3.get().b.c_str());
   ASSERT_EQ(63, d3.get().a);
 }
+
+TEST_F(CapsTest, HashIsStructural)
+{
+  Glib::RefPtr<Caps> caps1 = Caps::create_from_string("video/x-raw, width=(int)640, height=(int)480");
+  Glib::RefPtr<Caps> caps2 = Caps::create_from_string("video/x-raw, height=(int)480, width=(int)640");
+  Glib::RefPtr<Caps> caps3 = Caps::create_from_string("video/x-raw, height=(int)480, width=(int)720");
+
+  EXPECT_EQ(caps1->hash(), caps2->hash());
+  EXPECT_NE(caps1->hash(), caps3->hash());
+}
+
+TEST_F(CapsTest, CapsCacheCountsHitsAndMisses)
+{
+  CapsCache cache(2);
+  Glib::RefPtr<Caps> caps1 = Caps::create_from_string("video/x-raw, width=(int)[ 1, 1000 ]");
+  Glib::RefPtr<Caps> caps2 = Caps::create_from_string("video/x-raw, width=(int)640");
+  Glib::RefPtr<Caps> caps2_copy = Caps::create_from_string("video/x-raw, width=(int)640");
+
+  MM_ASSERT_TRUE(cache.is_subset(caps2, caps1));
+  MM_ASSERT_TRUE(cache.is_subset(caps2, caps1));
+  MM_ASSERT_TRUE(cache.is_subset(caps2_copy, caps1));
+  EXPECT_EQ(1u, cache.get_misses());
+  EXPECT_EQ(2u, cache.get_hits());
+
+  Glib::RefPtr<Caps> intersection = cache.intersect(caps1, caps2);
+  MM_ASSERT_TRUE(intersection->is_strictly_equal(caps2));
+  EXPECT_EQ(intersection, cache.intersect(caps1, caps2));
+
+  MM_ASSERT_TRUE(cache.can_intersect(caps1, caps2));
+  EXPECT_EQ(2u, cache.get_size());
+
+  cache.clear();
+  EXPECT_EQ(0u, cache.get_size());
+}
+
+static const char* const test_audio_formats[] = { "S16LE", "F32LE" };
+static const int test_audio_channels[] = { 1, 2 };
+
+static constexpr CapsField test_audio_fields[] = {
+  CapsField::string_list("format", test_audio_formats),
+  CapsField::string("layout", "interleaved"),
+  CapsField::int_range("rate", 1, 192000),
+  CapsField::int_list("channels", test_audio_channels)
+};
+
+static constexpr CapsField test_video_fields[] = {
+  CapsField::fraction_range("framerate", 0, 1, 60, 1)
+};
+
+static const CapsStructureDescription test_structures[] = {
+  CapsStructureDescription("audio/x-raw", test_audio_fields),
+  CapsStructureDescription("video/x-raw", test_video_fields, "memory:GLMemory")
+};
+
+static const StaticCapsDescription test_static_caps(test_structures);
+
+TEST_F(CapsTest, StaticCapsDescriptionIsBuiltOnce)
+{
+  Glib::RefPtr<Caps> expected = Caps::create_from_string(
+    "audio/x-raw, format=(string){ S16LE, F32LE }, layout=(string)interleaved, "
+    "rate=(int)[ 1, 192000 ], channels=(int){ 1, 2 }; "
+    "video/x-raw(memory:GLMemory), framerate=(fraction)[ 0/1, 60/1 ]");
+
+  caps = test_static_caps.get();
+  MM_ASSERT_TRUE(caps->is_strictly_equal(expected));
+  EXPECT_EQ(caps, test_static_caps.get());
+}
@@ -0,0 +1,117 @@
+/*
+ * test-loudnessmeter.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "mmtest.h"
+#include <gstreamermm.h>
+#include <cmath>
+#include <vector>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class LoudnessMeterTest : public ::testing::Test
+{
+protected:
+  static const int rate = 48000;
+
+  // @a seconds of a stereo sine of @a frequency, with a peak level of
+  // @a level dBFS.
+  static std::vector<float> CreateSine(double frequency, double level, double seconds)
+  {
+    const double amplitude = std::pow(10.0, level / 20.0);
+    std::vector<float> samples;
+    for(int i = 0; i < seconds * rate; ++i)
+    {
+      const float value = amplitude * std::sin(2 * G_PI * frequency * i / rate);
+      samples.push_back(value);
+      samples.push_back(value);
+    }
+    return samples;
+  }
+
+  static void Measure(LoudnessMeter& meter, const std::vector<float>& samples)
+  {
+    // 10 ms buffers, which do not match the blocks of 100 ms.
+    const gsize block = rate / 100 + 7;
+    const gsize frames = samples.size() / 2;
+    for(gsize i = 0; i < frames; i += block)
+      meter.process(&samples[i * 2], std::min(block, frames - i));
+  }
+};
+
+TEST_F(LoudnessMeterTest, SineAtMinus23DbfsIsMinus23Lufs)
+{
+  // EBU Tech 3341, test case 1.
+  LoudnessMeter meter(rate, 2);
+  Measure(meter, CreateSine(1000, -23.0, 20.0));
+
+  ASSERT_NEAR(-23.0, meter.get_momentary(), 0.1);
+  ASSERT_NEAR(-23.0, meter.get_short_term(), 0.1);
+  ASSERT_NEAR(-23.0, meter.get_integrated(), 0.1);
+  ASSERT_NEAR(-23.0, meter.get_max_true_peak(), 0.2);
+}
+
+TEST_F(LoudnessMeterTest, QuietPartsAreGated)
+{
+  // EBU Tech 3341, test case 3: the -36 dBFS part is below the relative
+  // gate, and the silence below the absolute one.
+  LoudnessMeter meter(rate, 2);
+  Measure(meter, CreateSine(1000, -36.0, 10.0));
+  Measure(meter, CreateSine(1000, -23.0, 60.0));
+  Measure(meter, std::vector<float>(rate * 2 * 10, 0.0f));
+  Measure(meter, CreateSine(1000, -36.0, 10.0));
+
+  ASSERT_NEAR(-23.0, meter.get_integrated(), 0.1);
+  ASSERT_NEAR(-36.0, meter.get_short_term(), 0.1);
+}
+
+TEST_F(LoudnessMeterTest, SilenceHasNoLoudness)
+{
+  LoudnessMeter meter(rate, 2);
+  Measure(meter, std::vector<float>(rate * 2, 0.0f));
+
+  ASSERT_TRUE(std::isinf(meter.get_momentary()));
+  ASSERT_TRUE(std::isinf(meter.get_integrated()));
+  ASSERT_TRUE(std::isinf(meter.get_true_peak()));
+}
+
+TEST_F(LoudnessMeterTest, TruePeakIsFoundBetweenSamples)
+{
+  // A sine at a quarter of the rate, sampled 45 degrees off its peaks: the
+  // samples are 3 dB below the true peak.
+  std::vector<float> samples;
+  for(int i = 0; i < rate; ++i)
+  {
+    const float value = 0.5f * std::sin(G_PI / 2 * i + G_PI / 4);
+    samples.push_back(value);
+    samples.push_back(value);
+  }
+
+  LoudnessMeter meter(rate, 2);
+  Measure(meter, samples);
+  ASSERT_NEAR(20 * std::log10(0.5), meter.get_max_true_peak(), 0.5);
+
+  meter.reset_true_peak();
+  ASSERT_TRUE(std::isinf(meter.get_true_peak()));
+  ASSERT_NEAR(20 * std::log10(0.5), meter.get_max_true_peak(), 0.5);
+}
+
+TEST_F(LoudnessMeterTest, SurroundChannelsAreWeighted)
+{
+  const AudioChannelPosition positions[] = {
+    AUDIO_CHANNEL_POSITION_FRONT_LEFT, AUDIO_CHANNEL_POSITION_FRONT_RIGHT,
+    AUDIO_CHANNEL_POSITION_FRONT_CENTER, AUDIO_CHANNEL_POSITION_LFE1,
+    AUDIO_CHANNEL_POSITION_REAR_LEFT, AUDIO_CHANNEL_POSITION_REAR_RIGHT
+  };
+  AudioInfo info;
+  info.set_format(AUDIO_FORMAT_F32, rate, 6, positions);
+
+  LoudnessMeter meter(info);
+  ASSERT_EQ(1.0, meter.get_channel_weight(2));
+  ASSERT_EQ(0.0, meter.get_channel_weight(3));
+  ASSERT_DOUBLE_EQ(1.41, meter.get_channel_weight(5));
+}
@@ -0,0 +1,116 @@
+/*
+ * test-mappedaudiobuffer.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "mmtest.h"
+#include <gstreamermm.h>
+#include <vector>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class MappedAudioBufferTest : public ::testing::Test
+{
+protected:
+  static const int channels = 4;
+  static const int frames = 8;
+
+  AudioInfo info;
+  RefPtr<Buffer> buffer;
+
+  // Fills the buffer with the sample value 100 * channel + frame.
+  void CreateBuffer(AudioLayout layout)
+  {
+    info.set_format(AUDIO_FORMAT_S16, 48000, channels, layout);
+    buffer = Buffer::create(frames * info.get_bpf());
+
+    MapInfo map;
+    buffer->map(map, MAP_WRITE);
+    gint16* samples = reinterpret_cast<gint16*>(map.get_data());
+    for(int c = 0; c < channels; ++c)
+    {
+      for(int i = 0; i < frames; ++i)
+      {
+        const int index = layout == AUDIO_LAYOUT_INTERLEAVED ? i * channels + c : c * frames + i;
+        samples[index] = 100 * c + i;
+      }
+    }
+    buffer->unmap(map);
+  }
+};
+
+TEST_F(MappedAudioBufferTest, NonInterleavedChannelsAreContiguous)
+{
+  CreateBuffer(AUDIO_LAYOUT_NON_INTERLEAVED);
+  ASSERT_FALSE(info.is_interleaved());
+  ASSERT_EQ(channels, info.get_n_planes());
+
+  MappedAudioBuffer audio(info, buffer, MAP_READ);
+  ASSERT_TRUE(audio.is_planar());
+  ASSERT_EQ(static_cast<gsize>(frames), audio.get_n_frames());
+  ASSERT_EQ(channels, audio.get_n_planes());
+
+  for(int c = 0; c < channels; ++c)
+  {
+    AudioChannelView<gint16> channel = audio.get_channel<gint16>(c);
+    ASSERT_TRUE(channel.is_contiguous());
+    ASSERT_EQ(audio.get_plane(c), channel.data());
+    ASSERT_EQ(100 * c + 5, channel[5]);
+  }
+}
+
+TEST_F(MappedAudioBufferTest, InterleavedChannelsAreStrided)
+{
+  CreateBuffer(AUDIO_LAYOUT_INTERLEAVED);
+  ASSERT_TRUE(info.is_interleaved());
+
+  MappedAudioBuffer audio(info, buffer, MAP_READ);
+  ASSERT_FALSE(audio.is_planar());
+  ASSERT_EQ(1, audio.get_n_planes());
+
+  AudioChannelView<gint16> channel = audio.get_channel<gint16>(2);
+  ASSERT_FALSE(channel.is_contiguous());
+  ASSERT_EQ(static_cast<gsize>(channels), channel.get_stride());
+  ASSERT_EQ(205, channel[5]);
+}
+
+TEST_F(MappedAudioBufferTest, ChannelsAreModifiedInPlace)
+{
+  CreateBuffer(AUDIO_LAYOUT_NON_INTERLEAVED);
+
+  {
+    MappedAudioBuffer audio(info, buffer, MAP_READWRITE);
+    AudioChannelView<gint16> channel = audio.get_channel<gint16>(1);
+    for(gsize i = 0; i < channel.size(); ++i)
+      channel[i] = -channel[i];
+  }
+
+  MappedAudioBuffer audio(info, buffer, MAP_READ);
+  ASSERT_EQ(-103, audio.get_channel<gint16>(1)[3]);
+  ASSERT_EQ(203, audio.get_channel<gint16>(2)[3]);
+}
+
+TEST_F(MappedAudioBufferTest, PlanarLayoutRoundTripsThroughCaps)
+{
+  RefPtr<Caps> caps = AudioFilter::create_caps({ AUDIO_FORMAT_S16, AUDIO_FORMAT_F32 },
+    AUDIO_LAYOUT_NON_INTERLEAVED);
+  Glib::ustring layout;
+  ASSERT_TRUE(caps->get_structure(0).get_field("layout", layout));
+  ASSERT_EQ("non-interleaved", layout);
+
+  CreateBuffer(AUDIO_LAYOUT_NON_INTERLEAVED);
+  AudioInfo parsed(info.to_caps());
+  ASSERT_FALSE(parsed.is_interleaved());
+  ASSERT_TRUE(caps->can_intersect(info.to_caps()));
+}
+
+TEST_F(MappedAudioBufferTest, PartialFramesAreRejected)
+{
+  info.set_format(AUDIO_FORMAT_S16, 48000, channels, AUDIO_LAYOUT_NON_INTERLEAVED);
+  buffer = Buffer::create(info.get_bpf() + 2);
+
+  EXPECT_THROW(MappedAudioBuffer(info, buffer, MAP_READ), std::runtime_error);
+}
@@ -14,3 +14,15 @@ TEST(MessageTest, CheckDerivedMessageRefcount)
   Glib::RefPtr<MessageStateDirty> msg = MessageStateDirty::create(Glib::RefPtr<Object>());
   ASSERT_EQ(1, msg->get_refcount());
 }
+
+TEST(MessageTest, CreateElementMessageByMovingStructure)
+{
+  Structure structure("test-struct");
+  structure.set_field("width", 500);
+  const GstStructure* c_struct = structure.gobj();
+
+  Glib::RefPtr<MessageElement> msg = MessageElement::create(Glib::RefPtr<Object>(), std::move(structure));
+
+  MM_ASSERT_FALSE(structure);
+  ASSERT_EQ(c_struct, gst_message_get_structure(msg->gobj()));
+}
@@ -18,6 +18,19 @@ protected:
   static Glib::ustring pad_name;
   static PadDirection pad_direction;
 
+  int accept_caps_calls = 0;
+
+  gboolean OnAcceptCapsQuery(const Glib::RefPtr<Pad>&, Glib::RefPtr<Query>& query)
+  {
+    if(query->get_query_type() != QUERY_ACCEPT_CAPS)
+      return false;
+
+    ++accept_caps_calls;
+    Glib::RefPtr<QueryAcceptCaps> accept_caps = Glib::RefPtr<QueryAcceptCaps>::cast_static(query);
+    accept_caps->set_accept_caps_result(accept_caps->parse_accept_caps()->is_fixed());
+    return true;
+  }
+
   void CheckPad()
   {
     MM_ASSERT_TRUE(pad);
@@ -79,3 +92,22 @@ TEST_F(PadTest, PadEventDefault)
   pad->event_default(std::move(event));
   MM_ASSERT_FALSE(event);
 }
+
+TEST_F(PadTest, AcceptCapsCacheAnswersRepeatedQueries)
+{
+  pad = Pad::create(pad_name, pad_direction);
+  pad->set_query_function(sigc::mem_fun(*this, &PadTest::OnAcceptCapsQuery));
+  pad->enable_accept_caps_cache();
+
+  Glib::RefPtr<Caps> fixed = Caps::create_from_string("audio/x-raw, rate=(int)48000");
+  Glib::RefPtr<Caps> unfixed = Caps::create_from_string("audio/x-raw, rate=(int)[ 1, 48000 ]");
+
+  MM_ASSERT_TRUE(pad->query_accept_caps(fixed));
+  MM_ASSERT_TRUE(pad->query_accept_caps(fixed));
+  MM_ASSERT_FALSE(pad->query_accept_caps(unfixed));
+  MM_ASSERT_FALSE(pad->query_accept_caps(unfixed));
+
+  EXPECT_EQ(2, accept_caps_calls);
+  EXPECT_EQ(2u, pad->get_accept_caps_cache()->get_hits());
+  EXPECT_EQ(2u, pad->get_accept_caps_cache()->get_misses());
+}
@@ -0,0 +1,125 @@
+/*
+ * test-polyphaseresampler.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "mmtest.h"
+#include <gstreamermm.h>
+#include <cmath>
+#include <vector>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class PolyphaseResamplerTest : public ::testing::Test
+{
+protected:
+  // Resamples @a in in blocks of @a block frames, then drains the filter.
+  std::vector<float> Resample(PolyphaseResampler& resampler, const std::vector<float>& in,
+    gsize block)
+  {
+    const int channels = resampler.get_channels();
+    const gsize in_frames = in.size() / channels;
+    std::vector<float> out;
+
+    for(gsize i = 0; i < in_frames; i += block)
+    {
+      const gsize frames = std::min(block, in_frames - i);
+      const gsize begin = out.size();
+      out.resize(begin + resampler.get_out_frames(frames) * channels);
+      resampler.process(&in[i * channels], frames, out.data() + begin);
+    }
+
+    const gsize begin = out.size();
+    out.resize(begin + resampler.get_drain_frames() * channels);
+    resampler.drain(out.data() + begin);
+    return out;
+  }
+
+  // One second of a 1 kHz stereo sine at 44.1 kHz, with the right channel
+  // inverted.
+  static std::vector<float> CreateSine()
+  {
+    std::vector<float> samples;
+    for(int i = 0; i < 44100; ++i)
+    {
+      const float value = 0.5f * std::sin(2 * G_PI * 1000 * i / 44100.0);
+      samples.push_back(value);
+      samples.push_back(-value);
+    }
+    return samples;
+  }
+};
+
+TEST_F(PolyphaseResamplerTest, FilterBanksAreShared)
+{
+  std::shared_ptr<const PolyphaseFilterBank> bank = PolyphaseFilterBank::get(44100, 48000);
+  ASSERT_EQ(160u, bank->get_n_phases());
+  ASSERT_EQ(147u, bank->get_step());
+  ASSERT_EQ(0u, bank->get_n_taps() % 8);
+
+  PolyphaseResampler first(bank, 2), second(PolyphaseFilterBank::get(88200, 96000), 1);
+  ASSERT_EQ(bank, second.get_filter_bank());
+  ASSERT_NE(bank, PolyphaseFilterBank::get(44100, 48000, PolyphaseFilterBank::QUALITY_MAX));
+
+  EXPECT_THROW(PolyphaseFilterBank::get(0, 48000), std::runtime_error);
+  EXPECT_THROW(PolyphaseFilterBank::get(44100, 48017), std::runtime_error);
+}
+
+TEST_F(PolyphaseResamplerTest, OutputLengthFollowsRatio)
+{
+  const std::vector<float> in = CreateSine();
+
+  // Odd block sizes leave partial output frames between calls.
+  for(gsize block : { gsize(1), gsize(441), gsize(1000), gsize(44100) })
+  {
+    PolyphaseResampler resampler(PolyphaseFilterBank::get(44100, 48000), 2);
+    ASSERT_EQ(48000u * 2, Resample(resampler, in, block).size());
+  }
+
+  PolyphaseResampler down(PolyphaseFilterBank::get(44100, 8000), 2);
+  ASSERT_EQ(8000u * 2, Resample(down, in, 1000).size());
+}
+
+TEST_F(PolyphaseResamplerTest, SineIsPreserved)
+{
+  PolyphaseResampler resampler(PolyphaseFilterBank::get(44100, 48000), 2);
+  const std::vector<float> out = Resample(resampler, CreateSine(), 1024);
+
+  // The first and last milliseconds are shaped by the silence around the
+  // stream.
+  for(gsize i = 480; i < 48000 - 480; ++i)
+  {
+    const float expected = 0.5f * std::sin(2 * G_PI * 1000 * i / 48000.0);
+    ASSERT_NEAR(expected, out[i * 2], 2e-3);
+    ASSERT_NEAR(-expected, out[i * 2 + 1], 2e-3);
+  }
+}
+
+TEST_F(PolyphaseResamplerTest, SimdFiltersMatchScalarFilter)
+{
+  const std::vector<float> in = CreateSine();
+  PolyphaseResampler scalar(PolyphaseFilterBank::get(44100, 48000), 2, AUDIO_KERNELS_ISA_SCALAR);
+  const std::vector<float> expected = Resample(scalar, in, 1024);
+
+  const AudioKernelsIsa isas[] = {
+    AUDIO_KERNELS_ISA_SSE2, AUDIO_KERNELS_ISA_AVX2, AUDIO_KERNELS_ISA_NEON
+  };
+
+  for(AudioKernelsIsa isa : isas)
+  {
+    if(!AudioKernels::is_isa_supported(isa))
+      continue;
+
+    SCOPED_TRACE(AudioKernels::get_isa_name(isa));
+    PolyphaseResampler simd(PolyphaseFilterBank::get(44100, 48000), 2, isa);
+    ASSERT_EQ(isa, simd.get_isa());
+
+    const std::vector<float> actual = Resample(simd, in, 1024);
+    ASSERT_EQ(expected.size(), actual.size());
+    for(gsize i = 0; i < expected.size(); ++i)
+      ASSERT_NEAR(expected[i], actual[i], 1e-5);
+  }
+}
@@ -147,3 +147,124 @@ TEST_F(StructureTest, UseStructureWithGlibValue)
   structure.get_field("field1", read_value);
   ASSERT_EQ(123, read_value.get());
 }
+
+TEST_F(StructureTest, ViewMessageStructureWithoutCopying)
+{
+  structure = Structure("view-test", "field1", 12, "field2", std::string("sample string"));
+  const GstStructure* c_struct = structure.gobj();
+  Glib::RefPtr<MessageElement> msg = MessageElement::create(Glib::RefPtr<Object>(), std::move(structure));
+
+  StructureView view = msg->get_structure_view();
+  ASSERT_EQ(c_struct, view.gobj());
+  MM_ASSERT_TRUE(view.has_name("view-test"));
+  MM_ASSERT_TRUE(view.has_field("field1", G_TYPE_INT));
+  EXPECT_EQ(2, view.size());
+
+  int field1 = 0;
+  std::string field2;
+  MM_ASSERT_TRUE(view.get_field("field1", field1));
+  MM_ASSERT_TRUE(view.get_field("field2", field2));
+  EXPECT_EQ(12, field1);
+  EXPECT_EQ("sample string", field2);
+}
+
+TEST_F(StructureTest, GetSetFieldUsingFieldKey)
+{
+  static const FieldKey width_key("width");
+  static const FieldKey format_key("format");
+
+  structure.set_field(width_key, 640);
+  structure.set_field(format_key, "I420");
+
+  MM_ASSERT_TRUE(structure.has_field(width_key, G_TYPE_INT));
+  MM_ASSERT_TRUE(structure.has_field("width"));
+  EXPECT_EQ(G_TYPE_STRING, structure.get_field_type(format_key));
+
+  int width = 0;
+  std::string format;
+  MM_ASSERT_TRUE(structure.get_field(width_key, width));
+  MM_ASSERT_TRUE(structure.get_view().get_field(format_key, format));
+  EXPECT_EQ(640, width);
+  EXPECT_EQ("I420", format);
+  EXPECT_EQ(g_quark_from_string("width"), width_key.get_quark());
+
+  structure.remove_field(width_key);
+  MM_ASSERT_FALSE(structure.has_field(width_key));
+}
+
+TEST_F(StructureTest, VisitFieldsWithoutCopyingNames)
+{
+  structure = Structure("visit-test", "field1", 12, "field2", 34);
+
+  int sum = 0;
+  std::vector<std::string> names;
+  MM_ASSERT_TRUE(structure.visit([&](const FieldKey& key, const Glib::ValueBase& value)
+  {
+    names.push_back(key.get_name());
+    sum += g_value_get_int(value.gobj());
+    return true;
+  }));
+  ASSERT_EQ(2u, names.size());
+  EXPECT_EQ("field1", names[0]);
+  EXPECT_EQ("field2", names[1]);
+  EXPECT_EQ(46, sum);
+
+  MM_ASSERT_TRUE(structure.visit_in_place([](const FieldKey&, Glib::ValueBase& value)
+  {
+    g_value_set_int(value.gobj(), g_value_get_int(value.gobj()) * 2);
+    return true;
+  }));
+  int field2 = 0;
+  structure.get_field("field2", field2);
+  EXPECT_EQ(68, field2);
+
+  int visited = 0;
+  MM_ASSERT_FALSE(structure.get_view().visit([&](const FieldKey&, const Glib::ValueBase&)
+  {
+    return ++visited < 1;
+  }));
+  EXPECT_EQ(1, visited);
+}
+
+TEST_F(StructureTest, SetAndGetArrayInOnePass)
+{
+  std::vector<double> input = { 0.5, 1.5, -2.25 };
+  structure.set_array("scores", input);
+  MM_ASSERT_TRUE(structure.has_field("scores", GST_TYPE_ARRAY));
+
+  std::vector<double> output;
+  MM_ASSERT_TRUE(structure.get_array("scores", output));
+  EXPECT_EQ(input, output);
+
+  std::vector<int> wrong_type;
+  MM_ASSERT_FALSE(structure.get_array("scores", wrong_type));
+  MM_ASSERT_TRUE(wrong_type.empty());
+
+  const int ids[] = { 3, 1, 4 };
+  structure.set_list("ids", ids, G_N_ELEMENTS(ids));
+  std::vector<int> read_ids;
+  MM_ASSERT_TRUE(structure.get_array("ids", read_ids));
+  EXPECT_EQ(std::vector<int>({ 3, 1, 4 }), read_ids);
+}
+
+TEST_F(StructureTest, SetAndGetBlob)
+{
+  std::vector<float> input(4096);
+  for(gsize i = 0; i < input.size(); ++i)
+    input[i] = i * 0.5f;
+  const float* storage = input.data();
+
+  structure.set_blob("samples", std::move(input));
+  MM_ASSERT_TRUE(structure.has_field("samples", GST_TYPE_BUFFER));
+
+  GstBuffer* buffer = gst_value_get_buffer(gst_structure_get_value(structure.gobj(), "samples"));
+  GstMapInfo info;
+  ASSERT_TRUE(gst_buffer_map(buffer, &info, GST_MAP_READ));
+  EXPECT_EQ(static_cast<const void*>(storage), static_cast<const void*>(info.data));
+  gst_buffer_unmap(buffer, &info);
+
+  std::vector<float> output;
+  MM_ASSERT_TRUE(structure.get_blob("samples", output));
+  ASSERT_EQ(4096u, output.size());
+  EXPECT_EQ(2047.5f, output[4095]);
+}
@@ -0,0 +1,192 @@
+/*
+ * test-videoframe.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "mmtest.h"
+#include <gstreamermm.h>
+#include <algorithm>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class VideoFrameTest : public ::testing::Test
+{
+protected:
+  VideoInfo info;
+  RefPtr<Buffer> buffer;
+  VideoFrame frame;
+
+  void Map(VideoFormat format, guint width, guint height)
+  {
+    info.set_format(format, width, height);
+    buffer = Buffer::create(info.get_size());
+    MM_ASSERT_TRUE(frame.map(info, buffer, MAP_READ | MAP_WRITE));
+  }
+
+  virtual void TearDown()
+  {
+    if(buffer)
+      frame.unmap();
+  }
+};
+
+TEST_F(VideoFrameTest, I420HasThreePlanes)
+{
+  Map(VIDEO_FORMAT_I420, 63, 33);
+
+  EXPECT_EQ(VIDEO_FORMAT_I420, frame.get_format());
+  EXPECT_EQ(63, frame.get_width());
+  EXPECT_EQ(33, frame.get_height());
+  EXPECT_EQ(3u, frame.get_n_planes());
+  EXPECT_EQ(3u, frame.get_n_components());
+
+  VideoPlane y = frame.get_plane(0);
+  EXPECT_EQ(63, y.get_width());
+  EXPECT_EQ(33, y.get_height());
+  EXPECT_EQ(1, y.get_pixel_stride());
+  EXPECT_EQ(64, y.get_stride());
+  EXPECT_EQ(frame.gobj()->data[0], y.get_data());
+
+  // Odd sizes round the subsampled planes up.
+  VideoPlane u = frame.get_plane(1);
+  EXPECT_EQ(32, u.get_width());
+  EXPECT_EQ(17, u.get_height());
+  EXPECT_EQ(32, u.get_stride());
+  EXPECT_EQ(2u, frame.get_component_plane(2));
+}
+
+TEST_F(VideoFrameTest, NV12InterleavesChroma)
+{
+  Map(VIDEO_FORMAT_NV12, 64, 32);
+
+  EXPECT_EQ(2u, frame.get_n_planes());
+
+  VideoPlane uv = frame.get_plane(1);
+  EXPECT_EQ(32, uv.get_width());
+  EXPECT_EQ(16, uv.get_height());
+  EXPECT_EQ(2, uv.get_pixel_stride());
+  EXPECT_EQ(64, uv.get_row_size());
+
+  VideoPlane u = frame.get_component(1);
+  VideoPlane v = frame.get_component(2);
+  EXPECT_EQ(2, v.get_pixel_stride());
+  EXPECT_EQ(u.get_data() + 1, v.get_data());
+  EXPECT_EQ(frame.get_component_offset(1) + 1, frame.get_component_offset(2));
+}
+
+TEST_F(VideoFrameTest, YUY2PacksComponents)
+{
+  Map(VIDEO_FORMAT_YUY2, 16, 4);
+
+  EXPECT_EQ(1u, frame.get_n_planes());
+
+  VideoPlane plane = frame.get_plane(0);
+  EXPECT_EQ(16, plane.get_width());
+  EXPECT_EQ(2, plane.get_pixel_stride());
+  EXPECT_EQ(32, plane.get_stride());
+
+  VideoPlane y = frame.get_component(0);
+  VideoPlane u = frame.get_component(1);
+  VideoPlane v = frame.get_component(2);
+  EXPECT_EQ(16, y.get_width());
+  EXPECT_EQ(2, y.get_pixel_stride());
+  EXPECT_EQ(8, u.get_width());
+  EXPECT_EQ(4, u.get_pixel_stride());
+  EXPECT_EQ(plane.get_data() + 1, u.get_data());
+  EXPECT_EQ(plane.get_data() + 3, v.get_data());
+}
+
+TEST_F(VideoFrameTest, RowsCanBeIterated)
+{
+  Map(VIDEO_FORMAT_RGBA, 5, 3);
+
+  VideoPlane plane = frame.get_plane(0);
+  EXPECT_EQ(20, plane.get_row_size());
+
+  int rows = 0;
+  for(guint8* row : plane)
+  {
+    EXPECT_EQ(plane.get_row(rows), row);
+    std::fill(row, row + plane.get_row_size(), rows);
+    ++rows;
+  }
+  EXPECT_EQ(3, rows);
+
+  const VideoFrame& const_frame = frame;
+  ConstVideoPlane const_plane = const_frame.get_plane(0);
+  EXPECT_EQ(2, const_plane.get_pixel(4, 2)[3]);
+  EXPECT_EQ(plane.get_pixel(1, 1), const_plane.get_pixel(1, 1));
+}
+
+TEST_F(VideoFrameTest, RegionViewsCoverSubsampledSamples)
+{
+  Map(VIDEO_FORMAT_I420, 63, 33);
+
+  const VideoRectangle rect = { 5, 3, 10, 6 };
+  VideoPlane y = frame.get_component(0, rect);
+  EXPECT_EQ(10, y.get_width());
+  EXPECT_EQ(6, y.get_height());
+  EXPECT_EQ(64, y.get_stride());
+  EXPECT_EQ(frame.get_component(0).get_pixel(5, 3), y.get_data());
+
+  // Chroma samples 2 to 7 and rows 1 to 4 touch the rectangle.
+  VideoPlane u = frame.get_component(1, rect);
+  EXPECT_EQ(6, u.get_width());
+  EXPECT_EQ(4, u.get_height());
+  EXPECT_EQ(frame.get_component(1).get_pixel(2, 1), u.get_data());
+
+  int rows = 0;
+  for(guint8* row : u)
+  {
+    EXPECT_EQ(frame.get_component(1).get_pixel(2, 1 + rows), row);
+    ++rows;
+  }
+  EXPECT_EQ(4, rows);
+}
+
+TEST_F(VideoFrameTest, RegionViewsAreClipped)
+{
+  Map(VIDEO_FORMAT_NV12, 64, 32);
+
+  const VideoRectangle corner = { 60, -2, 10, 5 };
+  VideoPlane y = frame.get_component(0, corner);
+  EXPECT_EQ(4, y.get_width());
+  EXPECT_EQ(3, y.get_height());
+  EXPECT_EQ(frame.get_component(0).get_pixel(60, 0), y.get_data());
+
+  VideoPlane v = frame.get_component(2, corner);
+  EXPECT_EQ(2, v.get_width());
+  EXPECT_EQ(2, v.get_height());
+  EXPECT_EQ(2, v.get_pixel_stride());
+  EXPECT_EQ(frame.get_component(2).get_pixel(30, 0), v.get_data());
+
+  const VideoRectangle outside = { 70, 0, 5, 5 };
+  EXPECT_EQ(0, frame.get_component(0, outside).get_width());
+  EXPECT_EQ(0, frame.get_component(1, outside).get_row_size());
+}
+
+TEST_F(VideoFrameTest, InvalidPlaneThrows)
+{
+  Map(VIDEO_FORMAT_NV12, 16, 16);
+
+  EXPECT_THROW(frame.get_plane(2), std::runtime_error);
+  EXPECT_THROW(frame.get_component(3), std::runtime_error);
+  EXPECT_THROW(frame.get_component_plane(3), std::runtime_error);
+  EXPECT_THROW(frame.get_component_offset(3), std::runtime_error);
+}
+
+TEST_F(VideoFrameTest, PaletteIsOneRow)
+{
+  // The palette plane stores no component.
+  Map(VIDEO_FORMAT_RGB8P, 16, 16);
+  ASSERT_EQ(2u, frame.get_n_planes());
+
+  VideoPlane palette = frame.get_plane(1);
+  EXPECT_EQ(256, palette.get_width());
+  EXPECT_EQ(1, palette.get_height());
+  EXPECT_EQ(4, palette.get_pixel_stride());
+  EXPECT_EQ(frame.gobj()->data[1], palette.get_data());
+}
@@ -0,0 +1,345 @@
+/*
+ * test-videokernels.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "mmtest.h"
+#include <gstreamermm.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+namespace
+{
+
+// A mapped frame which owns its buffer.
+struct Frame
+{
+  VideoInfo info;
+  RefPtr<Buffer> buffer;
+  VideoFrame frame;
+
+  Frame(VideoFormat format, int width, int height)
+  {
+    info.set_format(format, width, height);
+    buffer = Buffer::create(info.get_size());
+    buffer->memset(0, 0, info.get_size());
+    frame.map(info, buffer, MAP_READ | MAP_WRITE);
+  }
+
+  ~Frame()
+  {
+    frame.unmap();
+  }
+
+  // Compares the pixels, without the padding of the rows.
+  bool operator==(const Frame& other) const
+  {
+    for(guint plane = 0; plane < frame.get_n_planes(); ++plane)
+    {
+      const ConstVideoPlane a = frame.get_plane(plane);
+      const ConstVideoPlane b = other.frame.get_plane(plane);
+      for(int row = 0; row < a.get_height(); ++row)
+      {
+        if(std::memcmp(a.get_row(row), b.get_row(row), a.get_row_size()))
+          return false;
+      }
+    }
+    return true;
+  }
+};
+
+const VideoFormat formats[] = {
+  VIDEO_FORMAT_I420, VIDEO_FORMAT_NV12, VIDEO_FORMAT_YUY2, VIDEO_FORMAT_RGBA, VIDEO_FORMAT_BGRx
+};
+
+const VideoKernelsIsa simd_isas[] = {
+  VIDEO_KERNELS_ISA_SSE2, VIDEO_KERNELS_ISA_AVX2, VIDEO_KERNELS_ISA_NEON
+};
+
+}
+
+class VideoKernelsTest : public ::testing::Test
+{
+protected:
+  // Odd sizes, so the SIMD kernels also run their scalar tails and the
+  // subsampled planes have partial pixels.
+  static const int width = 61;
+  static const int height = 17;
+
+  VideoKernels kernels;
+
+  // Fills an RGBA frame with gradients and a varying alpha.
+  static void FillPattern(Frame& frame)
+  {
+    const VideoPlane plane = frame.frame.get_plane(0);
+    for(int y = 0; y < plane.get_height(); ++y)
+    {
+      for(int x = 0; x < plane.get_width(); ++x)
+      {
+        guint8* const p = plane.get_pixel(x, y);
+        p[0] = (x * 255) / plane.get_width();
+        p[1] = (y * 255) / plane.get_height();
+        p[2] = ((x + y) * 37) & 0xff;
+        p[3] = (x * 13 + y * 7) & 0xff;
+      }
+    }
+  }
+
+  // Fills @a frame with the pattern converted to its format.
+  static void FillPattern(Frame& frame, const VideoKernels& kernels)
+  {
+    Frame rgba(VIDEO_FORMAT_RGBA, frame.frame.get_width(), frame.frame.get_height());
+    FillPattern(rgba);
+    kernels.convert(rgba.frame, frame.frame);
+  }
+};
+
+TEST_F(VideoKernelsTest, WhiteConvertsToStudioRange)
+{
+  Frame rgba(VIDEO_FORMAT_RGBA, width, height);
+  Frame i420(VIDEO_FORMAT_I420, width, height);
+  for(guint8* row : rgba.frame.get_plane(0))
+    std::memset(row, 255, width * 4);
+
+  kernels.convert(rgba.frame, i420.frame);
+
+  EXPECT_EQ(235, i420.frame.get_plane(0).get_pixel(width - 1, height - 1)[0]);
+  EXPECT_EQ(128, i420.frame.get_plane(1).get_pixel(3, 2)[0]);
+  EXPECT_EQ(128, i420.frame.get_plane(2).get_pixel(30, 8)[0]);
+}
+
+TEST_F(VideoKernelsTest, RoundTripKeepsColors)
+{
+  // The chroma is subsampled: flat colors survive a round trip through
+  // every YUV format.
+  const VideoFormat yuv_formats[] = { VIDEO_FORMAT_I420, VIDEO_FORMAT_NV12, VIDEO_FORMAT_YUY2 };
+  const guint8 color[] = { 200, 40, 90, 255 };
+
+  for(VideoFormat format : yuv_formats)
+  {
+    Frame rgba(VIDEO_FORMAT_RGBA, width, height);
+    Frame yuv(format, width, height);
+    Frame result(VIDEO_FORMAT_RGBA, width, height);
+    const VideoPlane plane = rgba.frame.get_plane(0);
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+        std::memcpy(plane.get_pixel(x, y), color, 4);
+    }
+
+    kernels.convert(rgba.frame, yuv.frame);
+    kernels.convert(yuv.frame, result.frame);
+
+    const ConstVideoPlane out = result.frame.get_plane(0);
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        for(int k = 0; k < 4; ++k)
+          ASSERT_LE(std::abs(out.get_pixel(x, y)[k] - color[k]), 2);
+      }
+    }
+  }
+}
+
+TEST_F(VideoKernelsTest, SimdKernelsMatchScalarKernels)
+{
+  const VideoKernels scalar(VIDEO_KERNELS_ISA_SCALAR);
+
+  for(VideoKernelsIsa isa : simd_isas)
+  {
+    if(!VideoKernels::is_isa_supported(isa))
+      continue;
+
+    const VideoKernels simd(isa);
+    ASSERT_EQ(isa, simd.get_isa());
+
+    for(VideoFormat in_format : formats)
+    {
+      Frame in(in_format, width, height);
+      FillPattern(in, scalar);
+
+      for(VideoFormat out_format : formats)
+      {
+        Frame expected(out_format, width, height), actual(out_format, width, height);
+        scalar.convert(in.frame, expected.frame);
+        simd.convert(in.frame, actual.frame);
+        ASSERT_TRUE(expected == actual);
+      }
+
+      Frame expected(in_format, 37, 29), actual(in_format, 37, 29);
+      scalar.scale(in.frame, expected.frame);
+      simd.scale(in.frame, actual.frame);
+      ASSERT_TRUE(expected == actual);
+
+      ASSERT_EQ(scalar.hash(in.frame), simd.hash(in.frame));
+      ASSERT_EQ(scalar.hash(in.frame, 3), simd.hash(in.frame, 3));
+    }
+
+    Frame src(VIDEO_FORMAT_RGBA, width, height);
+    FillPattern(src);
+    Frame expected(VIDEO_FORMAT_RGBA, 80, 40), actual(VIDEO_FORMAT_RGBA, 80, 40);
+    FillPattern(expected, scalar);
+    FillPattern(actual, scalar);
+    scalar.blend(src.frame, expected.frame, 5, 3, 0.7);
+    simd.blend(src.frame, actual.frame, 5, 3, 0.7);
+    ASSERT_TRUE(expected == actual);
+
+    Frame other(VIDEO_FORMAT_RGBA, width, height);
+    FillPattern(other);
+    scalar.blend(src.frame, other.frame, 7, 2, 0.6);
+    const guint64 sad = scalar.sad_plane(src.frame.get_plane(0), other.frame.get_plane(0));
+    ASSERT_EQ(sad, simd.sad_plane(src.frame.get_plane(0), other.frame.get_plane(0)));
+    ASSERT_EQ(sad, simd.sad_update_plane(src.frame.get_plane(0), other.frame.get_plane(0)));
+    ASSERT_TRUE(src == other);
+  }
+}
+
+TEST_F(VideoKernelsTest, ScalingKeepsFlatColors)
+{
+  for(VideoFormat format : formats)
+  {
+    Frame in(format, width, height);
+    for(guint plane = 0; plane < in.frame.get_n_planes(); ++plane)
+    {
+      for(guint8* row : in.frame.get_plane(plane))
+        std::memset(row, 100 + plane, in.frame.get_plane(plane).get_row_size());
+    }
+
+    Frame up(format, 2 * width, 3 * height);
+    kernels.scale(in.frame, up.frame);
+    Frame down(format, 10, 6);
+    kernels.scale(up.frame, down.frame);
+
+    for(guint plane = 0; plane < down.frame.get_n_planes(); ++plane)
+    {
+      for(guint8* row : down.frame.get_plane(plane))
+      {
+        for(int i = 0; i < down.frame.get_plane(plane).get_row_size(); ++i)
+          ASSERT_EQ(100 + static_cast<int>(plane), row[i]);
+      }
+    }
+  }
+}
+
+TEST_F(VideoKernelsTest, ScalingToSameSizeCopies)
+{
+  for(VideoFormat format : formats)
+  {
+    Frame in(format, width, height);
+    FillPattern(in, kernels);
+    Frame out(format, width, height);
+
+    kernels.scale(in.frame, out.frame);
+    ASSERT_TRUE(in == out);
+  }
+}
+
+TEST_F(VideoKernelsTest, BlendWeightsPixels)
+{
+  Frame src(VIDEO_FORMAT_RGBA, 4, 4);
+  Frame dest(VIDEO_FORMAT_BGRx, 8, 8);
+  for(guint8* row : src.frame.get_plane(0))
+  {
+    for(int x = 0; x < 4; ++x)
+    {
+      const guint8 pixel[] = { 255, 0, 0, 255 };
+      std::memcpy(row + x * 4, pixel, 4);
+    }
+  }
+
+  // Half of the source is outside of the destination.
+  kernels.blend(src.frame, dest.frame, -2, 6, 0.5);
+
+  const ConstVideoPlane out = dest.frame.get_plane(0);
+  // BGRx: red is the third byte.
+  EXPECT_EQ(128, out.get_pixel(0, 6)[2]);
+  EXPECT_EQ(0, out.get_pixel(0, 6)[0]);
+  EXPECT_EQ(128, out.get_pixel(1, 7)[2]);
+  EXPECT_EQ(0, out.get_pixel(2, 6)[2]);
+  EXPECT_EQ(0, out.get_pixel(0, 5)[2]);
+}
+
+TEST_F(VideoKernelsTest, HashDependsOnEveryPixel)
+{
+  // Wide enough for full stripes of 32 bytes and a partial one.
+  Frame frame(VIDEO_FORMAT_NV12, 100, height);
+  FillPattern(frame, kernels);
+  const guint64 original = kernels.hash(frame.frame);
+  EXPECT_EQ(original, kernels.hash(frame.frame));
+
+  for(guint plane = 0; plane < frame.frame.get_n_planes(); ++plane)
+  {
+    const VideoPlane view = frame.frame.get_plane(plane);
+    for(int y = 0; y < view.get_height(); y += 5)
+    {
+      for(int x = 0; x < view.get_row_size(); x += 7)
+      {
+        view.get_row(y)[x] ^= 1;
+        ASSERT_NE(original, kernels.hash(frame.frame));
+        view.get_row(y)[x] ^= 1;
+      }
+    }
+  }
+
+  // Swapping two rows changes the hash too.
+  const VideoPlane luma = frame.frame.get_plane(0);
+  std::vector<guint8> row(luma.get_row(0), luma.get_row(0) + luma.get_row_size());
+  std::memcpy(luma.get_row(0), luma.get_row(1), row.size());
+  std::memcpy(luma.get_row(1), row.data(), row.size());
+  EXPECT_NE(original, kernels.hash(frame.frame));
+}
+
+TEST_F(VideoKernelsTest, HashGridSkipsPixels)
+{
+  Frame frame(VIDEO_FORMAT_RGBA, 64, 8);
+  FillPattern(frame);
+  const guint64 original = kernels.hash(frame.frame, 2);
+  const VideoPlane plane = frame.frame.get_plane(0);
+
+  // Odd rows, and the second stripe of 32 bytes of even rows, are skipped.
+  plane.get_pixel(3, 1)[0] ^= 1;
+  plane.get_pixel(9, 2)[0] ^= 1;
+  EXPECT_EQ(original, kernels.hash(frame.frame, 2));
+
+  plane.get_pixel(3, 2)[0] ^= 1;
+  EXPECT_NE(original, kernels.hash(frame.frame, 2));
+}
+
+TEST_F(VideoKernelsTest, SadSumsDifferencesAndUpdatesReference)
+{
+  Frame frame(VIDEO_FORMAT_GRAY8, width, height);
+  Frame reference(VIDEO_FORMAT_GRAY8, width, height);
+  for(guint8* row : frame.frame.get_plane(0))
+    std::memset(row, 10, width);
+  reference.frame.get_plane(0).get_pixel(3, 4)[0] = 40;
+
+  // 30 less for one pixel, 10 more for all the others.
+  const guint64 expected = 30 + 10 * (width * height - 1);
+  EXPECT_EQ(expected, kernels.sad_plane(frame.frame.get_plane(0), reference.frame.get_plane(0)));
+  EXPECT_EQ(expected, kernels.sad_update_plane(frame.frame.get_plane(0), reference.frame.get_plane(0)));
+  EXPECT_EQ(0u, kernels.sad_plane(frame.frame.get_plane(0), reference.frame.get_plane(0)));
+
+  Frame small(VIDEO_FORMAT_GRAY8, 8, 8);
+  EXPECT_THROW(kernels.sad_plane(frame.frame.get_plane(0), small.frame.get_plane(0)), std::runtime_error);
+}
+
+TEST_F(VideoKernelsTest, UnsupportedFormatsThrow)
+{
+  Frame gray(VIDEO_FORMAT_GRAY8, 16, 16);
+  Frame rgba(VIDEO_FORMAT_RGBA, 16, 16);
+  Frame small(VIDEO_FORMAT_RGBA, 8, 8);
+  Frame i420(VIDEO_FORMAT_I420, 16, 16);
+
+  MM_ASSERT_FALSE(VideoKernels::is_format_supported(VIDEO_FORMAT_GRAY8));
+  EXPECT_THROW(kernels.convert(gray.frame, rgba.frame), std::runtime_error);
+  EXPECT_THROW(kernels.convert(rgba.frame, small.frame), std::runtime_error);
+  EXPECT_THROW(kernels.scale(rgba.frame, i420.frame), std::runtime_error);
+  EXPECT_THROW(kernels.blend(i420.frame, rgba.frame, 0, 0), std::runtime_error);
+}
@@ -0,0 +1,130 @@
+/*
+ * test-videolayout.cc
+ *
+ *  Created on: 2016
+ *    Author: The gstreamermm Development Team
+ */
+
+#include "mmtest.h"
+#include <gstreamermm.h>
+
+using namespace Gst;
+using Glib::RefPtr;
+
+class VideoLayoutTest : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    VideoLayout::clear_cache();
+  }
+};
+
+TEST_F(VideoLayoutTest, LayoutsAreShared)
+{
+  std::shared_ptr<const VideoLayout> layout = VideoLayout::get(VIDEO_FORMAT_I420, 320, 240);
+  EXPECT_EQ(layout, VideoLayout::get(VIDEO_FORMAT_I420, 320, 240));
+  EXPECT_NE(layout, VideoLayout::get(VIDEO_FORMAT_I420, 320, 242));
+  EXPECT_NE(layout, VideoLayout::get(VIDEO_FORMAT_NV12, 320, 240));
+  EXPECT_EQ(3u, VideoLayout::get_cache_size());
+
+  VideoLayout::clear_cache();
+  EXPECT_EQ(0u, VideoLayout::get_cache_size());
+  EXPECT_EQ(320u, layout->get_width());
+  EXPECT_NE(layout, VideoLayout::get(VIDEO_FORMAT_I420, 320, 240));
+}
+
+TEST_F(VideoLayoutTest, LeastRecentlyUsedLayoutsAreForgotten)
+{
+  std::shared_ptr<const VideoLayout> first = VideoLayout::get(VIDEO_FORMAT_I420, 16, 16);
+  std::shared_ptr<const VideoLayout> second = VideoLayout::get(VIDEO_FORMAT_I420, 16, 18);
+  for(guint i = 0; i < VideoLayout::MAX_CACHED_CAPS - 1; ++i)
+  {
+    EXPECT_EQ(first, VideoLayout::get(VIDEO_FORMAT_I420, 16, 16));
+    VideoLayout::get(VIDEO_FORMAT_I420, 32, 2 * (i + 1));
+  }
+
+  EXPECT_EQ(VideoLayout::MAX_CACHED_CAPS, VideoLayout::get_cache_size());
+  EXPECT_EQ(first, VideoLayout::get(VIDEO_FORMAT_I420, 16, 16));
+  EXPECT_NE(second, VideoLayout::get(VIDEO_FORMAT_I420, 16, 18));
+  EXPECT_EQ(18u, second->get_height());
+}
+
+TEST_F(VideoLayoutTest, LayoutMatchesVideoInfo)
+{
+  VideoInfo info;
+  info.set_format(VIDEO_FORMAT_I420, 99, 51);
+  std::shared_ptr<const VideoLayout> layout = VideoLayout::get(VIDEO_FORMAT_I420, 99, 51);
+
+  EXPECT_EQ(VIDEO_FORMAT_I420, layout->get_format());
+  EXPECT_EQ(51u, layout->get_height());
+  ASSERT_EQ(3u, layout->get_n_planes());
+  for(guint plane = 0; plane < 3; ++plane)
+  {
+    EXPECT_EQ(GST_VIDEO_INFO_PLANE_STRIDE(info.gobj(), plane), layout->get_stride(plane));
+    EXPECT_EQ(GST_VIDEO_INFO_PLANE_OFFSET(info.gobj(), plane), layout->get_offset(plane));
+  }
+  EXPECT_EQ(info.get_size(), layout->get_size());
+  MM_ASSERT_TRUE(layout->get_caps()->equals(info.to_caps()));
+
+  VideoInfo filled;
+  layout->fill_info(filled);
+  MM_ASSERT_TRUE(filled.is_equal(info));
+
+  EXPECT_THROW(layout->get_stride(3), std::runtime_error);
+}
+
+TEST_F(VideoLayoutTest, AlignmentPadsRows)
+{
+  GstVideoAlignment align;
+  gst_video_alignment_reset(&align);
+  for(guint plane = 0; plane < GST_VIDEO_MAX_PLANES; ++plane)
+    align.stride_align[plane] = 63;
+  align.padding_top = 2;
+
+  std::shared_ptr<const VideoLayout> layout = VideoLayout::get(VIDEO_FORMAT_RGBA, 100, 10, align);
+  EXPECT_NE(layout, VideoLayout::get(VIDEO_FORMAT_RGBA, 100, 10));
+  EXPECT_EQ(layout, VideoLayout::get(VIDEO_FORMAT_RGBA, 100, 10, align));
+
+  EXPECT_EQ(448, layout->get_stride(0));
+  EXPECT_EQ(2u * 448, layout->get_offset(0));
+  EXPECT_EQ(12u * 448, layout->get_size());
+}
+
+TEST_F(VideoLayoutTest, CapsConversionsAreCached)
+{
+  RefPtr<Caps> caps = Caps::create_from_string(
+    "video/x-raw, format=(string)NV12, width=(int)640, height=(int)480, framerate=(fraction)30/1");
+
+  VideoInfo info;
+  MM_ASSERT_TRUE(VideoLayout::from_caps(caps, info));
+  EXPECT_EQ(640, info.get_width());
+  EXPECT_EQ(30, info.get_fps_n());
+  MM_ASSERT_FALSE(caps->is_writable());
+
+  VideoInfo again;
+  MM_ASSERT_TRUE(VideoLayout::from_caps(caps, again));
+  MM_ASSERT_TRUE(again.is_equal(info));
+
+  EXPECT_EQ(VideoLayout::get(VIDEO_FORMAT_NV12, 640, 480), VideoLayout::get(caps));
+
+  RefPtr<Caps> built = VideoLayout::to_caps(info);
+  VideoInfo rebuilt;
+  MM_ASSERT_TRUE(rebuilt.from_caps(built));
+  MM_ASSERT_TRUE(rebuilt.is_equal(info));
+  EXPECT_EQ(built->gobj(), VideoLayout::to_caps(again)->gobj());
+
+  info.set_fps_n(25);
+  EXPECT_NE(built->gobj(), VideoLayout::to_caps(info)->gobj());
+}
+
+TEST_F(VideoLayoutTest, NonVideoCapsAreRejected)
+{
+  RefPtr<Caps> caps = Caps::create_from_string("audio/x-raw, rate=(int)48000");
+
+  VideoInfo info;
+  MM_ASSERT_FALSE(VideoLayout::from_caps(caps, info));
+  MM_ASSERT_FALSE(VideoLayout::get(caps));
+  EXPECT_THROW(VideoLayout::get(VIDEO_FORMAT_UNKNOWN, 16, 16), std::runtime_error);
+  EXPECT_THROW(VideoLayout::get(VIDEO_FORMAT_RGBA, 0, 16), std::runtime_error);
+}
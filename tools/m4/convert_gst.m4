@@ -76,6 +76,7 @@ _CONV_ENUM(Gst,TunerChannelFlags)
 _CONV_ENUM(Gst,URIType)
 _CONV_ENUM(Gst,VideoBufferFlags)
 _CONV_ENUM(Gst,VideoChromaSite)
+_CONV_ENUM(Gst,VideoCodecFrameFlags)
 _CONV_ENUM(Gst,VideoFlags)
 _CONV_ENUM(Gst,VideoFormat)
 _CONV_ENUM(Gst,VideoFormatFlags)
@@ -341,6 +342,16 @@ _CONVERSION(`Gst::TocLoopType&',`GstTocLoopType*',`reinterpret_cast<GstTocLoopTy
 dnl TypeFind
 _CONVERSION(`Gst::TypeFind&',`GstTypeFind*',`$3.gobj()')
 
+dnl VideoCodecFrame
+_CONVERSION(`GstVideoCodecFrame*',`Glib::RefPtr<Gst::VideoCodecFrame>',`Glib::wrap($3)')
+_CONVERSION(`GstVideoCodecFrame*',`const Glib::RefPtr<Gst::VideoCodecFrame>&',`Glib::wrap($3, true)')
+_CONVERSION(`const Glib::RefPtr<Gst::VideoCodecFrame>&',`GstVideoCodecFrame*',`Glib::unwrap($3)')
+
+dnl VideoCodecState
+_CONVERSION(`GstVideoCodecState*',`Glib::RefPtr<Gst::VideoCodecState>',`Glib::wrap($3)')
+_CONVERSION(`GstVideoCodecState*',`const Glib::RefPtr<Gst::VideoCodecState>&',`Glib::wrap($3, true)')
+_CONVERSION(`const Glib::RefPtr<Gst::VideoCodecState>&',`GstVideoCodecState*',`Glib::unwrap($3)')
+
 dnl VideoInfo
 _CONVERSION(`Gst::VideoInfo', `GstVideoInfo*', `$3.gobj()')
 _CONVERSION(`const Gst::VideoInfo&', `const GstVideoInfo*', `$3.gobj()')
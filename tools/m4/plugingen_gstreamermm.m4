@@ -10,6 +10,9 @@ _TRANSLATION(`GstPlayFlags',`Gst::PlayFlags',`Gst::PlayFlags',,`<gstreamermm/enu
 _TRANSLATION(`GstTCPProtocol',`Gst::TCPProtocol',`Gst::TCPProtocol',,`<gstreamermm/enums.h>')
 _TRANSLATION(`GstMultiHandleSinkClientStatus',`Gst::MultiHandleSinkClientStatus',`Gst::MultiHandleSinkClientStatus',,`<gstreamermm/enums.h>')
 _TRANSLATION(`GstMultiHandleSinkSyncMethod',`Gst::MultiHandleSinkSyncMethod',`Gst::MultiHandleSinkSyncMethod',,`<gstreamermm/enums.h>')
+_TRANSLATION(`GstAudioResamplerMethod',`Gst::AudioResamplerMethod',`Gst::AudioResamplerMethod',,`<gstreamermm/enums.h>')
+_TRANSLATION(`GstAudioResamplerFilterMode',`Gst::AudioResamplerFilterMode',`Gst::AudioResamplerFilterMode',,`<gstreamermm/enums.h>')
+_TRANSLATION(`GstAudioResamplerFilterInterpolation',`Gst::AudioResamplerFilterInterpolation',`Gst::AudioResamplerFilterInterpolation',,`<gstreamermm/enums.h>')
 _TRANSLATION(`GstAutoplugSelectResult',`Gst::AutoplugSelectResult',`Gst::AutoplugSelectResult',,`<gstreamermm/enums.h>')
 _TRANSLATION(`GstFlowReturn',`Gst::FlowReturn',`Gst::FlowReturn',,`<gstreamermm/pad.h>')
 _TRANSLATION(`GstVideoMultiviewFramePacking',`Gst::VideoMultiviewFramePacking',`Gst::VideoMultiviewFramePacking',,`<gstreamermm/videoinfo.h>')
@@ -60,6 +63,9 @@ _ENUM_IS_WRAPPED(GstAudioBaseSinkSlaveMethod)
 _ENUM_IS_WRAPPED(GstAudioBaseSrcSlaveMethod)
 _ENUM_IS_WRAPPED(GstAudioFormat)
 _ENUM_IS_WRAPPED(GstAudioFormatFlags)
+_ENUM_IS_WRAPPED(GstAudioResamplerFilterInterpolation)
+_ENUM_IS_WRAPPED(GstAudioResamplerFilterMode)
+_ENUM_IS_WRAPPED(GstAudioResamplerMethod)
 _ENUM_IS_WRAPPED(GstAudioRingBufferFormatType)
 _ENUM_IS_WRAPPED(GstAutoplugSelectResult)
 _ENUM_IS_WRAPPED(GstBufferCopyFlags)